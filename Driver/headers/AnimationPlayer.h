@@ -0,0 +1,185 @@
+#pragma once
+#include <openvr_driver.h>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+#include "DeviceTypes.h"
+#include "LogManager.h"
+#include "Utils.h"
+
+/**
+ * @brief Holds the keyframe tracks uploaded by clients and plays them back inside the hooks, sampling and
+ * interpolating each track at whatever rate the device updates so clients can go idle during playback. Each playback
+ * remembers the keyframe it last sampled, so sampling costs the same on every frame regardless of track length
+ */
+class AnimationPlayer {
+public:
+	/**
+	 * @brief Returns the singleton AnimationPlayer instance
+	 * @return The singleton instance
+	 */
+	static AnimationPlayer& getInstance();
+
+	/**
+	 * @brief Validates and copies a keyframe track out of its upload slot, replacing the track with the same id.
+	 * Playbacks already running keep the track they started with
+	 * @param trackId The id of the track
+	 * @param type The type of the track
+	 * @param keyframes Pointer to the upload slot of the track
+	 * @param keyframeCount The number of keyframes in the slot
+	 * @return True if the track was loaded, false if it is invalid or doesn't fit in its slot
+	 */
+	bool loadTrack(uint32_t trackId, AnimationTrackType type, const uint8_t* keyframes, uint32_t keyframeCount);
+
+	/**
+	 * @brief Starts playing a pose track on a device, or blends out its current playback
+	 * @param deviceIndex The device index of the device
+	 * @param trackId The id of the pose track, or NO_ANIMATION_TRACK to stop playback
+	 * @param config The playback configuration
+	 * @return True if playback started or stopped, false if the track isn't a loaded pose track
+	 */
+	bool playPoseTrack(uint32_t deviceIndex, uint32_t trackId, const AnimationPlaybackConfig& config);
+
+	/**
+	 * @brief Starts playing a scalar or skeleton track on an input, or blends out its current playback
+	 * @param componentHandle The component handle of the input
+	 * @param type The type of track the input accepts
+	 * @param trackId The id of the track, or NO_ANIMATION_TRACK to stop playback
+	 * @param config The playback configuration
+	 * @return True if playback started or stopped, false if the track isn't a loaded track of type <type>
+	 */
+	bool playInputTrack(
+		vr::VRInputComponentHandle_t componentHandle,
+		AnimationTrackType type,
+		uint32_t trackId,
+		const AnimationPlaybackConfig& config
+	);
+
+	/**
+	 * @brief Samples the pose playback of a device, blended over the natural pose
+	 * @param deviceIndex The device index of the device
+	 * @param pose The natural pose, after smoothing and rules
+	 * @param outPose The output animated pose, only valid if the method returns true
+	 * @return True if the device has a playback and <outPose> was written, false otherwise
+	 */
+	bool samplePose(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose);
+
+	/**
+	 * @brief Samples the playback of a scalar input, blended over the natural value
+	 * @param componentHandle The component handle of the input
+	 * @param value The natural value, which is replaced by the animated value
+	 * @return True if the input has a playback and <value> was replaced, false otherwise
+	 */
+	bool sampleScalar(vr::VRInputComponentHandle_t componentHandle, float& value);
+
+	/**
+	 * @brief Samples the playback of a skeleton input, blended over the natural bone transforms
+	 * @param componentHandle The component handle of the input
+	 * @param transforms Pointer to the natural bone transforms
+	 * @param transformCount The number of natural bone transforms
+	 * @param motionRange The natural motion range, which is replaced by the animated motion range
+	 * @param outTransforms The output animated bone transforms, with room for 31 transforms
+	 * @param outTransformCount The output number of animated bone transforms
+	 * @return True if the input has a playback and the outputs were written, false otherwise
+	 */
+	bool sampleSkeleton(
+		vr::VRInputComponentHandle_t componentHandle,
+		const vr::VRBoneTransform_t* transforms,
+		uint32_t transformCount,
+		vr::EVRSkeletalMotionRange& motionRange,
+		vr::VRBoneTransform_t* outTransforms,
+		uint32_t& outTransformCount
+	);
+
+private:
+	/** @brief A single skeleton keyframe, converted to the OpenVR layout when the track is loaded */
+	struct SkeletonFrame {
+		vr::EVRSkeletalMotionRange motionRange;
+		uint32_t boneCount;
+		vr::VRBoneTransform_t bones[31];
+	};
+
+	/** @brief A loaded keyframe track, where only the array matching <type> is filled */
+	struct AnimationTrack {
+		AnimationTrackType type;
+		std::vector<double> times;
+		std::vector<vr::DriverPose_t> poses;
+		std::vector<float> scalars;
+		std::vector<SkeletonFrame> skeletons;
+	};
+
+	/** @brief The state of a track being played on a device pose or input */
+	struct Playback {
+		std::shared_ptr<const AnimationTrack> track;
+		AnimationPlaybackConfig config;
+		std::chrono::steady_clock::time_point startTime;
+		bool stopping = false;
+		std::chrono::steady_clock::time_point stopTime;
+		/** @brief The blend weight when playback was stopped, which the blend out fades from */
+		double stopWeight = 1.0;
+		/** @brief The index of the keyframe last sampled, where the next search starts */
+		uint32_t cursor = 0;
+	};
+
+	/** @brief The location of a sample within a track */
+	struct SamplePoint {
+		/** @brief The keyframe at or before the sample time */
+		uint32_t index;
+		/** @brief The keyframe after <index>, or <index> itself at the end of the track */
+		uint32_t next;
+		/** @brief The interpolation factor between <index> and <next> */
+		double t;
+		/** @brief The blend weight of the track over the natural state */
+		double weight;
+	};
+
+	/** @brief Guards all tracks and playbacks, held only while they are updated or sampled */
+	std::mutex playerMutex;
+
+	/** @brief The loaded tracks by id */
+	std::shared_ptr<const AnimationTrack> tracks[MAX_ANIMATION_TRACKS];
+
+	/** @brief Whether each device index has a pose playback, readable without the lock */
+	std::atomic<bool> posePlaybackActive[vr::k_unMaxTrackedDeviceCount] = {};
+
+	/** @brief The pose playback of each device index */
+	Playback posePlaybacks[vr::k_unMaxTrackedDeviceCount];
+
+	/** @brief The number of input playbacks, readable without the lock */
+	std::atomic<uint32_t> inputPlaybackCount = 0;
+
+	/** @brief Maps component handles to their input playbacks */
+	std::unordered_map<vr::VRInputComponentHandle_t, Playback> inputPlaybacks;
+
+	/** @brief Private empty constructor for the singleton pattern */
+	AnimationPlayer() = default;
+
+	/**
+	 * @brief Starts or stops a playback, assuming the caller holds <playerMutex>
+	 * @param playback The playback to update
+	 * @param trackId The id of the track to play, or NO_ANIMATION_TRACK to stop playback
+	 * @param config The playback configuration
+	 * @return True if the playback is active afterwards, false otherwise
+	 */
+	bool startPlayback(Playback& playback, uint32_t trackId, const AnimationPlaybackConfig& config);
+
+	/**
+	 * @brief Finds where a playback currently is in its track, advancing its cursor, assuming the caller holds
+	 * <playerMutex>
+	 * @param playback The playback
+	 * @param point The output sample point, only valid if the method returns true
+	 * @return True if the playback is still running, false if it has finished
+	 */
+	static bool locate(Playback& playback, SamplePoint& point);
+
+	/**
+	 * @brief Returns the Catmull-Rom interpolation through four values
+	 */
+	static double interpolateCubic(double p0, double p1, double p2, double p3, double t);
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+#include "DeviceTypes.h"
+
+/**
+ * @brief Holds client commands that carry a future apply time, and applies them from the first hook call at or after
+ * that time. Clients can then send commands a few frames ahead, so IPC and poll loop jitter never shows up in when
+ * the commands take effect
+ */
+class CommandScheduler {
+public:
+	/**
+	 * @brief Returns the singleton CommandScheduler instance
+	 * @return The singleton instance
+	 */
+	static CommandScheduler& getInstance();
+
+	/**
+	 * @brief Returns the current steady clock time in nanoseconds, the clock apply times are measured against
+	 * @return The current time
+	 */
+	static int64_t now();
+
+	/**
+	 * @brief Holds a command until its apply time
+	 * @param header The header of the command, where <applyTimeNanoseconds> is the time to apply it at
+	 * @param params The command parameters as raw bytes
+	 * @return True if the command was scheduled, false if MAX_SCHEDULED_COMMANDS are already waiting
+	 */
+	bool schedule(const ClientCommandHeaderData& header, std::unique_ptr<uint8_t[]> params);
+
+	/**
+	 * @brief Applies and acknowledges every scheduled command whose apply time has been reached. Called at the start
+	 * of every hook and poll, and costs a single atomic load while nothing is scheduled. Must not be called while
+	 * holding the batch mutex of the model
+	 */
+	void applyDueCommands();
+
+private:
+	/** @brief Guards <heap>, held only while commands are pushed or popped */
+	std::mutex heapMutex;
+
+	/** @brief Held while due commands are applied, so they apply in order even when several hooks find them due */
+	std::mutex applyMutex;
+
+	/**
+	 * @brief The scheduled commands as a min-heap on apply time, ties broken by lane version so commands scheduled
+	 * for the same time apply in the order they were sent
+	 */
+	std::vector<std::pair<ClientCommandHeaderData, std::unique_ptr<uint8_t[]>>> heap;
+
+	/** @brief The apply time of the earliest scheduled command, or INT64_MAX if none, readable without the lock */
+	std::atomic<int64_t> nextApplyTime = INT64_MAX;
+
+	/** @brief Private empty constructor for the singleton pattern */
+	CommandScheduler() = default;
+
+	/**
+	 * @brief Orders the heap so the command with the earliest apply time is at the front
+	 */
+	static bool isLater(
+		const std::pair<ClientCommandHeaderData, std::unique_ptr<uint8_t[]>>& a,
+		const std::pair<ClientCommandHeaderData, std::unique_ptr<uint8_t[]>>& b
+	);
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * The C ABI between the Conduit driver and in-process driver plugins. Plugins are DLLs placed in the Conduit plugin
+ * directory and listed in the "plugins" driver setting, and are loaded once at startup. Each plugin exports a
+ * ConduitPluginInitFunction named CONDUIT_PLUGIN_INIT_SYMBOL, which fills in its callbacks. The callbacks are then
+ * called directly from the update hooks, on the thread of the vendor driver, with the value about to be sent to
+ * OpenVR, so they can change it without any IPC. This header only uses C types so plugins can be built with any
+ * compiler, and only grows by appending to its structs
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The version of this header, which plugins receive and must support to be loaded */
+#define CONDUIT_PLUGIN_API_VERSION 1
+
+/** @brief The name of the ConduitPluginInitFunction every plugin exports */
+#define CONDUIT_PLUGIN_INIT_SYMBOL "ConduitPluginInit"
+
+/**
+ * @brief A device pose as passed to plugins, mirroring the fields of vr::DriverPose_t that describe the pose itself
+ */
+typedef struct ConduitDevicePose {
+	int32_t poseIsValid;
+	int32_t deviceIsConnected;
+	double poseTimeOffset;
+	double position[3];
+	double velocity[3];
+	double acceleration[3];
+	/** @brief The rotation quaternion as w, x, y, z */
+	double rotation[4];
+	double angularVelocity[3];
+	double angularAcceleration[3];
+} ConduitDevicePose;
+
+/** @brief A single bone transform, laid out like vr::VRBoneTransform_t */
+typedef struct ConduitBoneTransform {
+	float position[4];
+	/** @brief The orientation quaternion as w, x, y, z */
+	float orientation[4];
+} ConduitBoneTransform;
+
+/**
+ * @brief Functions the driver offers plugins to read and write its device state model. They may only be called from
+ * within a plugin callback, and return nonzero on success. Overrides are queued and take effect from the next hook
+ * call once the current one returns, so a callback never changes the model other hooks are reading
+ */
+typedef struct ConduitHostApi {
+	/** @brief The CONDUIT_PLUGIN_API_VERSION of the driver */
+	uint32_t apiVersion;
+
+	/** @brief Looks up the component handle of an input by device index and input path */
+	int32_t (*getComponentHandle)(uint32_t deviceIndex, const char* path, uint64_t* outComponentHandle);
+
+	/** @brief Reads the last natural pose the vendor driver reported for a device, before any override */
+	int32_t (*getNaturalDevicePose)(uint32_t deviceIndex, ConduitDevicePose* outPose);
+
+	/** @brief Reads the last natural value of a boolean input recorded by the model */
+	int32_t (*getNaturalBoolean)(uint64_t componentHandle, int32_t* outValue);
+
+	/** @brief Reads the last natural value of a scalar input recorded by the model */
+	int32_t (*getNaturalScalar)(uint64_t componentHandle, float* outValue);
+
+	/** @brief Sets the overridden pose of a device and whether it is used, as a client command would */
+	int32_t (*setOverriddenDevicePose)(uint32_t deviceIndex, const ConduitDevicePose* pose, int32_t useOverride);
+
+	/** @brief Sets the overridden value of a boolean input and whether it is used, as a client command would */
+	int32_t (*setOverriddenBoolean)(uint64_t componentHandle, int32_t value, int32_t useOverride);
+
+	/** @brief Sets the overridden value of a scalar input and whether it is used, as a client command would */
+	int32_t (*setOverriddenScalar)(uint64_t componentHandle, float value, int32_t useOverride);
+
+	/** @brief Writes a line to the Conduit driver log */
+	void (*log)(const char* message);
+} ConduitHostApi;
+
+/**
+ * @brief The callbacks of a plugin, filled in by its init function. Any callback may be left null. Update callbacks
+ * return nonzero if they changed the value, which is then sent to OpenVR in place of the original
+ */
+typedef struct ConduitPluginCallbacks {
+	/** @brief The name of the plugin, used in the driver log */
+	const char* name;
+
+	/**
+	 * @brief The time in microseconds a single callback may take, or 0 for the driver default. A plugin that overruns
+	 * it several calls in a row is disabled
+	 */
+	uint32_t budgetMicroseconds;
+
+	/** @brief Passed back to every callback */
+	void* userData;
+
+	int32_t (*onDevicePose)(void* userData, uint32_t deviceIndex, ConduitDevicePose* pose);
+	int32_t (*onBooleanInput)(void* userData, uint64_t componentHandle, int32_t* value, double* timeOffset);
+	int32_t (*onScalarInput)(void* userData, uint64_t componentHandle, float* value, double* timeOffset);
+	int32_t (*onSkeletonInput)(
+		void* userData,
+		uint64_t componentHandle,
+		int32_t motionRange,
+		ConduitBoneTransform* transforms,
+		uint32_t transformCount
+	);
+
+	/** @brief Called once when the driver shuts down or disables the plugin, after which no callback is made */
+	void (*shutdown)(void* userData);
+} ConduitPluginCallbacks;
+
+/**
+ * @brief The init function every plugin exports
+ * @param apiVersion The CONDUIT_PLUGIN_API_VERSION of the driver
+ * @param host The host functions, valid until shutdown
+ * @param callbacks The callbacks to fill in, zeroed by the driver
+ * @return Nonzero if the plugin initialized and should be used
+ */
+typedef int32_t (*ConduitPluginInitFunction)(
+	uint32_t apiVersion,
+	const ConduitHostApi* host,
+	ConduitPluginCallbacks* callbacks
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,6 +3,8 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include <array>
+#include <shared_mutex>
 
 #include "SharedDeviceMemoryDriver.h"
 #include "ObjectSchemas.h"
@@ -51,6 +53,45 @@ public:
 	 */
 	vr::PropertyContainerHandle_t* getPropertyContainerFromDeviceIndex(uint32_t deviceIndex);
 
+	/**
+	 * @brief Returns the component handle of any registered input of a device
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the input (ex. '/input/trigger/value')
+	 * @param componentHandle A pointer to where to write the component handle, only written if successful
+	 * @return True if the input exists, false otherwise
+	 */
+	bool getComponentHandle(
+		uint32_t deviceIndex,
+		const std::string& path,
+		vr::VRInputComponentHandle_t* componentHandle
+	);
+
+	/**
+	 * @brief Returns the lock that makes client command batches atomic. Update hooks hold it shared while they read
+	 * and forward state, and batches hold it exclusively while they apply, so a hook sees either none or all of a batch
+	 * @return The batch lock
+	 */
+	std::shared_mutex& getBatchMutex();
+
+	/**
+	 * @brief Writes the state of every device pose and input in the model to the driver-client lane, assuming the
+	 * caller holds the batch mutex. Used when a client attaches, since nothing is published while none is attached
+	 */
+	void syncSnapshotToSharedMemory();
+
+	/**************************************************
+	* @brief Device lifecycle
+	**************************************************/
+
+	/**
+	 * @brief Removes a device OpenVR deactivated, assuming the caller holds the batch mutex exclusively. Frees its
+	 * pose, inputs and property container mapping, clears the rules, filters, playbacks and dead reckoning configured
+	 * for it, drops it from the device registry and the HapticsManager, and publishes a removal packet for every input
+	 * followed by one for the pose, so client models only hold devices that are still connected
+	 * @param deviceIndex The device index of the device
+	 */
+	void removeDevice(uint32_t deviceIndex);
+
 	/**************************************************
 	* @brief Device Poses
 	**************************************************/
@@ -68,6 +109,29 @@ public:
 	 */
 	void setDevicePoseChanged(uint32_t deviceIndex);
 
+	/**
+	 * @brief Sets the overridden pose of a device, caching it in native OpenVR layout so the pose hook can forward it
+	 * without converting on every update
+	 * @param deviceIndex The device index of the device
+	 * @param pose The new overridden pose
+	 * @param fieldMask The PoseOverrideField's taken from <pose>, where the rest follow the natural pose
+	 */
+	void setOverriddenDevicePose(uint32_t deviceIndex, const DevicePose& pose, uint32_t fieldMask);
+
+	/**
+	 * @brief Returns the pose to forward for a device while its pose is overridden, which is the cached overridden
+	 * pose, dead reckoned if enabled, with the fields outside its field mask taken from the natural pose
+	 * @param deviceIndex The device index of the device
+	 * @param naturalPose The natural pose of the device
+	 * @param outPose Storage for the pose if it has to be built, which the returned pointer may point to
+	 * @return A pointer to the pose to forward if <deviceIndex> is in range, nullptr otherwise
+	 */
+	const vr::DriverPose_t* resolveOverriddenDriverPose(
+		uint32_t deviceIndex,
+		const vr::DriverPose_t& naturalPose,
+		vr::DriverPose_t& outPose
+	);
+
 	/**
 	 * @brief Registers a new device pose
 	 * @param deviceIndex The device index of the device
@@ -211,6 +275,43 @@ public:
 	 */
 	void setInputSkeletonChanged(vr::VRInputComponentHandle_t componentHandle);
 
+	/**
+	 * @brief Sets the overridden state of a skeleton input, caching its bones in native OpenVR layout so the skeleton
+	 * hook can forward them without converting on every update
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the input (ex. '/input/skeleton/left')
+	 * @param input The new overridden skeleton state
+	 * @param boneMask The bones taken from <input>, where bit i selects bone i and the rest follow the natural skeleton
+	 */
+	void setOverriddenSkeletonInput(
+		uint32_t deviceIndex,
+		const std::string& path,
+		const SkeletonInput& input,
+		uint32_t boneMask
+	);
+
+	/**
+	 * @brief Returns the bone transforms to forward for a skeleton input while it is overridden. A full override
+	 * forwards the cached bones with the overridden motion range and bone count, while a partial override keeps the
+	 * natural motion range and bone count and only replaces the bones in its bone mask
+	 * @param componentHandle The component handle
+	 * @param input The skeleton input of <componentHandle>
+	 * @param transforms Pointer to the natural bone transforms
+	 * @param transformCount The natural bone count, replaced by the bone count to forward
+	 * @param motionRange The natural motion range, replaced by the motion range to forward
+	 * @param outTransforms Storage for 31 bone transforms if they have to be merged, which the returned pointer may
+	 * point to
+	 * @return A pointer to the bone transforms to forward if successful, nullptr otherwise
+	 */
+	const vr::VRBoneTransform_t* resolveOverriddenBoneTransforms(
+		vr::VRInputComponentHandle_t componentHandle,
+		const ModelDeviceInputSkeletonSerialized& input,
+		const vr::VRBoneTransform_t* transforms,
+		uint32_t& transformCount,
+		vr::EVRSkeletalMotionRange& motionRange,
+		vr::VRBoneTransform_t* outTransforms
+	);
+
 	/**
 	 * @brief Registers a new skeleton input
 	 * @param deviceIndex The device index of the device
@@ -327,12 +428,30 @@ public:
 	void removeEyeTrackingInput(uint32_t deviceIndex, const std::string& path);
 
 private:
+	/** @brief Held shared by update hooks and exclusively while a client command batch applies */
+	std::shared_mutex batchMutex;
+
+	/**
+	 * @brief Guards the structure of the maps below, taken exclusively to insert or erase and shared to look up or
+	 * iterate. Devices and components are added from OpenVR threads that only hold the batch mutex shared, if at all,
+	 * so the batch mutex alone does not keep a rehash away from a concurrent lookup. It is only held around the map
+	 * access and lane writes, never across a call into a vendor driver or another manager, and entries stay where they
+	 * are across a rehash, so the pointers the getters return remain valid until the device is removed
+	 */
+	std::shared_mutex structureMutex;
+
 	/** @brief Maps device indexes to unique PropertyContainerHandle_t's */
 	std::unordered_map<uint32_t, vr::PropertyContainerHandle_t> indexTable;
 
 	/** @brief Maps device indexes to device pose states */
 	std::unordered_map<uint32_t, ModelDevicePoseSerialized> devicePoses;
 
+	/** @brief The overridden pose of each device index in native OpenVR layout, updated only when overrides change */
+	vr::DriverPose_t overriddenDriverPoses[vr::k_unMaxTrackedDeviceCount] = {};
+
+	/** @brief The PoseOverrideField mask of the overridden pose of each device index, PoseField_All until set */
+	uint32_t overriddenPoseFieldMasks[vr::k_unMaxTrackedDeviceCount] = {};
+
 	/** @brief Maps device indexes and paths to both the associated component handle and boolean input */
 	std::unordered_map<uint32_t, 
 		std::unordered_map<std::string, 
@@ -354,6 +473,15 @@ private:
 		>
 	> skeletonInputs;
 
+	/**
+	 * @brief Maps skeleton component handles to their overridden bone transforms in native OpenVR layout, updated only
+	 * when overrides change
+	 */
+	std::unordered_map<vr::VRInputComponentHandle_t, std::array<vr::VRBoneTransform_t, 31>> overriddenBoneTransforms;
+
+	/** @brief Maps skeleton component handles to the bone mask of their overrides, created alongside the cache */
+	std::unordered_map<vr::VRInputComponentHandle_t, uint32_t> overriddenBoneMasks;
+
 	/** @brief Maps device indexes and paths to both the associated component handle and pose input */
 	std::unordered_map<uint32_t, 
 		std::unordered_map<std::string, 
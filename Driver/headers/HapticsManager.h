@@ -0,0 +1,142 @@
+#pragma once
+#include <openvr_driver.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+
+/**
+ * @brief Tracks the haptic components of every device and sits between OpenVR and the vendor drivers on the haptic
+ * event path. Every vibration sent to a device is published to the haptics lane as it is polled by its driver, can be
+ * suppressed per component, and clients can inject their own pulses which are handed to the driver on its next poll
+ */
+class HapticsManager {
+public:
+	/**
+	 * @brief Returns the singleton HapticsManager instance
+	 * @return The singleton instance
+	 */
+	static HapticsManager& getInstance();
+
+	/**
+	 * @brief Starts tracking a haptic component, called from the create hook once the component has its handle
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the haptic component
+	 * @param containerHandle The property container of the device
+	 * @param componentHandle The component handle of the haptic component
+	 */
+	void addHapticComponent(
+		uint32_t deviceIndex,
+		const std::string& path,
+		vr::PropertyContainerHandle_t containerHandle,
+		vr::VRInputComponentHandle_t componentHandle
+	);
+
+	/**
+	 * @brief Sets whether vibrations sent by applications to a haptic component are kept from the device. Suppressed
+	 * vibrations are still published, and pulses injected by clients are never suppressed
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the haptic component
+	 * @param suppressed Whether to suppress vibrations
+	 * @return True if the haptic component exists, false otherwise
+	 */
+	bool setSuppressed(uint32_t deviceIndex, const std::string& path, bool suppressed);
+
+	/**
+	 * @brief Queues a vibration for a haptic component, delivered the next time its driver polls for events
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the haptic component
+	 * @param durationSeconds The duration of the vibration
+	 * @param frequency The frequency of the vibration
+	 * @param amplitude The amplitude of the vibration
+	 * @return True if the haptic component exists and the vibration was queued, false otherwise
+	 */
+	bool injectPulse(
+		uint32_t deviceIndex,
+		const std::string& path,
+		float durationSeconds,
+		float frequency,
+		float amplitude
+	);
+
+	/**
+	 * @brief Records the driver host a device reports its poses through, so pulses injected before the device
+	 * vibrated for the first time still go to the driver that owns it. Called from the pose hook
+	 * @param deviceIndex The device index of the device
+	 * @param host The IVRServerDriverHost the pose was reported through
+	 */
+	void recordDeviceHost(uint32_t deviceIndex, void* host);
+
+	/**
+	 * @brief Publishes a vibration polled by a driver, and learns which driver host the haptic component belongs to
+	 * @param host The IVRServerDriverHost the event was polled from
+	 * @param event The VREvent_Input_HapticVibration event
+	 * @return True if the event should be delivered to the driver, false if it is suppressed
+	 */
+	bool processHapticEvent(void* host, const vr::VREvent_t& event);
+
+	/**
+	 * @brief Takes the oldest injected vibration for a driver host, called before the driver polls OpenVR so injected
+	 * pulses skip the OpenVR event queue. Pulses for a device whose host isn't known yet stay pending until it is
+	 * @param host The IVRServerDriverHost being polled
+	 * @param event The output event, only valid if the method returns true
+	 * @return True if a vibration was pending for the host and <event> was written, false otherwise
+	 */
+	bool takeInjectedEvent(void* host, vr::VREvent_t& event);
+
+	/**
+	 * @brief Stops tracking the haptic components of a device and drops its pending pulses
+	 * @param deviceIndex The device index of the device
+	 */
+	void removeDevice(uint32_t deviceIndex);
+
+private:
+	/** @brief A tracked haptic component */
+	struct HapticComponent {
+		uint32_t deviceIndex = 0;
+		std::string path;
+		vr::PropertyContainerHandle_t containerHandle = vr::k_ulInvalidPropertyContainer;
+		vr::VRInputComponentHandle_t componentHandle = vr::k_ulInvalidInputComponentHandle;
+		bool suppressed = false;
+
+		/** @brief The driver host that polled the last vibration for the component, or null until one was polled */
+		void* host = nullptr;
+	};
+
+	/** @brief An injected vibration waiting for its driver host to poll */
+	struct PendingPulse {
+		/** @brief The driver host to deliver the vibration to, or null until the host of the device is known */
+		void* host = nullptr;
+		vr::VREvent_t event = {};
+	};
+
+	/** @brief Guards the haptic components and the pending pulses, never held while calling into OpenVR */
+	std::mutex hapticsMutex;
+
+	/** @brief The tracked haptic components of the devices that are currently active, which are few */
+	std::vector<HapticComponent> components;
+
+	/** @brief The injected vibrations in the order they were injected */
+	std::deque<PendingPulse> pendingPulses;
+
+	/** @brief The size of <pendingPulses>, readable without the lock so polls with nothing pending stay cheap */
+	std::atomic<uint32_t> pendingPulseCount = 0;
+
+	/** @brief The driver host each device index reports its poses through, or null until its first pose */
+	std::atomic<void*> deviceHosts[vr::k_unMaxTrackedDeviceCount] = {};
+
+	/** @brief Private empty constructor for the singleton pattern */
+	HapticsManager() = default;
+
+	/**
+	 * @brief Returns a tracked haptic component, assuming the caller holds the haptics mutex
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the haptic component
+	 * @return The haptic component, or null if it isn't tracked
+	 */
+	HapticComponent* findComponent(uint32_t deviceIndex, const std::string& path);
+};
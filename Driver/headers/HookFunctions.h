@@ -17,6 +17,7 @@ extern void* IVRDriverInput;
  */
 
 void overrideTrackedDevicePoseUpdated(void* _this, uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize);
+bool overridePollNextEvent(void* _this, vr::VREvent_t* pEvent, uint32_t uncbVREvent);
 vr::EVRInputError overrideCreateBooleanComponent(void* _this, vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle);
 vr::EVRInputError overrideUpdateBooleanComponent(void* _this, vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset);
 vr::EVRInputError overrideCreateScalarComponent(void* _this, vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle, vr::EVRScalarType eType, vr::EVRScalarUnits eUnits);
@@ -37,6 +38,7 @@ vr::PropertyContainerHandle_t overrideTrackedDeviceToPropertyContainer(void* _th
  */
 
 void callTrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize);
+bool callPollNextEvent(vr::VREvent_t* pEvent, uint32_t uncbVREvent);
 vr::EVRInputError callUpdateBooleanComponent(vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset);
 vr::EVRInputError callUpdateScalarComponent(vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset);
 vr::EVRInputError callUpdateSkeletonComponent(vr::VRInputComponentHandle_t ulComponent, vr::EVRSkeletalMotionRange eMotionRange, const vr::VRBoneTransform_t* pTransforms, uint32_t unTransformCount);
@@ -52,6 +54,9 @@ vr::EVRInputError callUpdateEyeTrackingComponent(vr::VRInputComponentHandle_t ul
 typedef void(*_TrackedDevicePoseUpdated)(void* _this, uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize);
 extern _TrackedDevicePoseUpdated originalTrackedDevicePoseUpdated;
 
+typedef bool(*_PollNextEvent)(void* _this, vr::VREvent_t* pEvent, uint32_t uncbVREvent);
+extern _PollNextEvent originalPollNextEvent;
+
 typedef vr::EVRInputError(*_CreateBooleanComponent)(void* _this, vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle);
 extern _CreateBooleanComponent originalCreateBooleanComponent;
 
@@ -16,7 +16,8 @@
  * second entry under IVRServerDriverHost, so it's index is 1
  */
 enum VTableOffsets_IVRServerDriverHost {
-	Offset_TrackedDevicePoseUpdated = 1		// IVRServerDriverHost->TrackedDevicePoseUpdated()
+	Offset_TrackedDevicePoseUpdated = 1,	// IVRServerDriverHost->TrackedDevicePoseUpdated()
+	Offset_PollNextEvent = 5				// IVRServerDriverHost->PollNextEvent()
 };
 
 enum VTableOffsets_IVRDriverInput {
@@ -0,0 +1,195 @@
+#pragma once
+#include <openvr_driver.h>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+#include "DeviceTypes.h"
+
+/** @brief The kinds of raw values the hooks hand to the publishing worker */
+enum HookUpdateType : uint32_t {
+	HookUpdate_DevicePose,
+	HookUpdate_InputBoolean,
+	HookUpdate_InputScalar,
+	HookUpdate_InputSkeleton,
+	HookUpdate_InputPose,
+	HookUpdate_InputEyeTracking
+};
+
+/**
+ * @brief A raw value as a hook received it from a vendor driver, before it is converted and written to the model
+ * and the driver-client lane
+ */
+struct HookUpdate {
+	HookUpdateType type;
+
+	/** @brief The device index of the device, only used by HookUpdate_DevicePose */
+	uint32_t deviceIndex;
+
+	/** @brief The component handle of the input, unused by HookUpdate_DevicePose */
+	vr::VRInputComponentHandle_t componentHandle;
+
+	/** @brief The time offset the value was reported with */
+	double timeOffset;
+
+	/** @brief The steady clock time in nanoseconds when the hook was called, only used by HookUpdate_DevicePose */
+	int64_t timestampNanoseconds;
+
+	struct SkeletonValue {
+		vr::EVRSkeletalMotionRange motionRange;
+		uint32_t transformCount;
+		vr::VRBoneTransform_t transforms[31];
+	};
+
+	struct PoseValue {
+		bool hasPoseOffset;
+		vr::HmdMatrix34_t poseOffset;
+	};
+
+	/** @brief The raw value, matching <type> */
+	union {
+		vr::DriverPose_t devicePose;
+		bool booleanValue;
+		float scalarValue;
+		SkeletonValue skeleton;
+		PoseValue pose;
+		vr::VREyeTrackingData_t eyeTrackingData;
+	};
+};
+
+/**
+ * @brief Moves model updates, type conversion and driver-client lane publishing off the vendor driver threads. Each
+ * hook thread gets its own single-producer single-consumer queue of raw values, which a Conduit worker drains into
+ * the model and the lane, so a hook only resolves its override and copies the raw value before calling the original
+ */
+class HookUpdateQueue {
+public:
+	/**
+	 * @brief Returns the singleton HookUpdateQueue instance
+	 * @return The singleton instance
+	 */
+	static HookUpdateQueue& getInstance();
+
+	/**
+	 * @brief Queues a natural device pose
+	 * @param deviceIndex The device index of the device
+	 * @param pose The natural pose as reported by OpenVR
+	 */
+	void pushDevicePose(uint32_t deviceIndex, const vr::DriverPose_t& pose);
+
+	/**
+	 * @brief Queues a natural boolean input value
+	 * @param componentHandle The component handle of the input
+	 * @param value The natural value
+	 * @param timeOffset The time offset of the value
+	 */
+	void pushBoolean(vr::VRInputComponentHandle_t componentHandle, bool value, double timeOffset);
+
+	/**
+	 * @brief Queues a natural scalar input value
+	 * @param componentHandle The component handle of the input
+	 * @param value The natural value
+	 * @param timeOffset The time offset of the value
+	 */
+	void pushScalar(vr::VRInputComponentHandle_t componentHandle, float value, double timeOffset);
+
+	/**
+	 * @brief Queues natural skeleton bone transforms
+	 * @param componentHandle The component handle of the input
+	 * @param motionRange The motion range of the transforms
+	 * @param transforms The bone transforms, of which at most 31 are kept
+	 * @param transformCount The number of bone transforms
+	 */
+	void pushSkeleton(
+		vr::VRInputComponentHandle_t componentHandle,
+		vr::EVRSkeletalMotionRange motionRange,
+		const vr::VRBoneTransform_t* transforms,
+		uint32_t transformCount
+	);
+
+	/**
+	 * @brief Queues a natural pose input value
+	 * @param componentHandle The component handle of the input
+	 * @param poseOffset The pose offset, or nullptr if the driver sent none
+	 * @param timeOffset The time offset of the value
+	 */
+	void pushPose(vr::VRInputComponentHandle_t componentHandle, const vr::HmdMatrix34_t* poseOffset, double timeOffset);
+
+	/**
+	 * @brief Queues a natural eye tracking input value
+	 * @param componentHandle The component handle of the input
+	 * @param eyeTrackingData The eye tracking data
+	 * @param timeOffset The time offset of the value
+	 */
+	void pushEyeTracking(
+		vr::VRInputComponentHandle_t componentHandle,
+		const vr::VREyeTrackingData_t& eyeTrackingData,
+		double timeOffset
+	);
+
+	/**
+	 * @brief The worker loop, to be ran in a separate thread. Drains every queue in turn, and sleeps while all of
+	 * them are empty until a hook queues a value
+	 */
+	void run();
+
+private:
+	/** @brief The queue of a single hook thread, with its cursors on separate cache lines */
+	struct ProducerQueue {
+		/** @brief The number of updates the worker has taken, only written by the worker */
+		alignas(64) std::atomic<uint32_t> readCount = 0;
+
+		/** @brief The number of updates the hook thread has queued, only written by the hook thread */
+		alignas(64) std::atomic<uint32_t> writeCount = 0;
+
+		alignas(64) HookUpdate slots[HOOK_UPDATE_QUEUE_SIZE];
+	};
+
+	/** @brief The queues of every hook thread seen so far, registered once and never removed */
+	std::atomic<ProducerQueue*> queues[MAX_HOOK_UPDATE_QUEUES] = {};
+
+	/** @brief The number of registered queues in <queues> */
+	std::atomic<uint32_t> queueCount = 0;
+
+	/** @brief Guards queue registration */
+	std::mutex registrationMutex;
+
+	/** @brief True while the worker waits for a hook to queue a value, cleared by the hook that wakes it */
+	std::atomic<bool> workerSleeping = false;
+
+	/** @brief Private empty constructor for the singleton pattern */
+	HookUpdateQueue() = default;
+
+	/**
+	 * @brief Returns the queue of the calling thread, registering one on its first call
+	 * @return The queue, or nullptr if MAX_HOOK_UPDATE_QUEUES threads already have one
+	 */
+	ProducerQueue* getThreadQueue();
+
+	/**
+	 * @brief Returns the next free slot in the queue of the calling thread
+	 * @return The slot, or nullptr if the queue is full or the thread has no queue
+	 */
+	HookUpdate* beginPush();
+
+	/**
+	 * @brief Publishes an update written to a slot from beginPush, or applies it directly if there was no slot
+	 * @param update The update, either the slot returned by beginPush or a local fallback
+	 * @param queued Whether <update> is the slot returned by beginPush
+	 */
+	void endPush(HookUpdate& update, bool queued);
+
+	/**
+	 * @brief Drains every registered queue
+	 * @return The number of updates applied
+	 */
+	uint32_t drainQueues();
+
+	/**
+	 * @brief Writes a raw value to the model and publishes it on the driver-client lane. The caller must hold the
+	 * batch mutex of the model, at least shared
+	 * @param update The update to apply
+	 */
+	static void applyUpdate(const HookUpdate& update);
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <openvr_driver.h>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+#include "DeviceTypes.h"
+#include "LogManager.h"
+
+/**
+ * @brief Verifies and executes client supplied input filter programs inside the input hooks. Programs are verified
+ * once when loaded so that execution needs no bounds checks: jumps only go forward, so every instruction runs at most
+ * once per sample, and the stack depth at each instruction is known ahead of time
+ */
+class InputFilterEngine {
+public:
+	/**
+	 * @brief Returns the singleton InputFilterEngine instance
+	 * @return The singleton instance
+	 */
+	static InputFilterEngine& getInstance();
+
+	/**
+	 * @brief Verifies and loads a program for a boolean or scalar input, replacing any program it already has
+	 * @param componentHandle The component handle of the input
+	 * @param isBoolean True if the input is a boolean input, false if it is a scalar input
+	 * @param instructions Pointer to the program bytecode
+	 * @param instructionCount The number of instructions, where 0 unloads the program of the input
+	 * @param bindingHandles Pointer to the component handles of the inputs readable through Filter_LoadBinding
+	 * @param bindingCount The number of bindings
+	 * @return True if the program was loaded or unloaded, false if it failed verification
+	 */
+	bool loadProgram(
+		vr::VRInputComponentHandle_t componentHandle,
+		bool isBoolean,
+		const FilterInstruction* instructions,
+		uint32_t instructionCount,
+		const vr::VRInputComponentHandle_t* bindingHandles,
+		uint32_t bindingCount
+	);
+
+	/**
+	 * @brief Runs the program of a boolean input on its natural value
+	 * @param componentHandle The component handle of the input
+	 * @param value The natural value, which is replaced by the program output
+	 * @param timeOffset The time offset of the update, reused when a binding reruns the program
+	 * @return True if the input has a program and <value> was replaced, false otherwise
+	 */
+	bool filterBoolean(vr::VRInputComponentHandle_t componentHandle, bool& value, double timeOffset);
+
+	/**
+	 * @brief Runs the program of a scalar input on its natural value
+	 * @param componentHandle The component handle of the input
+	 * @param value The natural value, which is replaced by the program output
+	 * @param timeOffset The time offset of the update, reused when a binding reruns the program
+	 * @return True if the input has a program and <value> was replaced, false otherwise
+	 */
+	bool filterScalar(vr::VRInputComponentHandle_t componentHandle, float& value, double timeOffset);
+
+	/**
+	 * @brief Records the processed value of an input for every program bound to it, and reruns those programs so that
+	 * their inputs follow the binding without waiting for their own next update. A rerun input is sent on through
+	 * the plugins and to OpenVR as its own hook would, unless it is overridden or has never updated. Must not be
+	 * called while holding the batch mutex of the model, which it takes shared only to check for overrides
+	 * @param componentHandle The component handle of the input that updated
+	 * @param value The value the input's override, smoothing, rules and own program produced, before plugins, where
+	 * booleans are passed as 0 or 1
+	 */
+	void notifyInputUpdated(vr::VRInputComponentHandle_t componentHandle, double value);
+
+private:
+	/** @brief A loaded program along with its preallocated execution state */
+	struct FilterProgram {
+		bool isBoolean = false;
+		uint32_t instructionCount = 0;
+		FilterInstruction instructions[MAX_FILTER_INSTRUCTIONS];
+		uint32_t bindingCount = 0;
+		vr::VRInputComponentHandle_t bindingHandles[MAX_FILTER_BINDINGS] = {};
+		double bindingValues[MAX_FILTER_BINDINGS] = {};
+		double registers[MAX_FILTER_REGISTERS] = {};
+		double lastInputValue = 0.0;
+		double lastTimeOffset = 0.0;
+		bool hasRun = false;
+		std::chrono::steady_clock::time_point lastRunTime;
+	};
+
+	/** @brief The output of a program rerun by a binding, sent once <programMutex> is released */
+	struct FilterRerun {
+		vr::VRInputComponentHandle_t componentHandle;
+		bool isBoolean;
+		double output;
+		double timeOffset;
+	};
+
+	/** @brief Guards all programs, held only while programs are loaded or executed, never while calling OpenVR */
+	std::mutex programMutex;
+
+	/** @brief The number of loaded programs, readable without the lock so inputs without programs cost nothing */
+	std::atomic<uint32_t> programCount = 0;
+
+	/** @brief Maps component handles to their loaded programs */
+	std::unordered_map<vr::VRInputComponentHandle_t, FilterProgram> programs;
+
+	/** @brief Maps the component handles of bound inputs to the inputs whose programs read them */
+	std::unordered_map<vr::VRInputComponentHandle_t, std::vector<vr::VRInputComponentHandle_t>> bindingTargets;
+
+	/** @brief Private empty constructor for the singleton pattern */
+	InputFilterEngine() = default;
+
+	/**
+	 * @brief Checks that a program only uses valid opcodes and operands, only jumps forward, never underflows or
+	 * overflows the stack, and always ends with a value on the stack
+	 * @param instructions Pointer to the program bytecode
+	 * @param instructionCount The number of instructions
+	 * @param bindingCount The number of bindings available to the program
+	 * @return True if the program is valid, false otherwise
+	 */
+	bool verifyProgram(const FilterInstruction* instructions, uint32_t instructionCount, uint32_t bindingCount);
+
+	/**
+	 * @brief Executes a verified program, assuming the caller holds <programMutex>
+	 * @param program The program to execute
+	 * @param inputValue The value of the input the program is bound to, after its smoothing, rules and animation
+	 * @return The program output
+	 */
+	double execute(FilterProgram& program, double inputValue);
+
+	/**
+	 * @brief Removes the binding entries of a program, assuming the caller holds <programMutex>
+	 * @param componentHandle The component handle of the input the program is bound to
+	 * @param program The program
+	 */
+	void removeBindings(vr::VRInputComponentHandle_t componentHandle, const FilterProgram& program);
+};
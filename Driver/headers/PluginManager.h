@@ -0,0 +1,226 @@
+#pragma once
+#include <windows.h>
+#include <openvr_driver.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "ConduitPluginApi.h"
+#include "ObjectSchemas.h"
+
+/**
+ * @brief Loads in-process driver plugins and runs their callbacks inside the hooks, so latency critical override
+ * logic can change values on their way to OpenVR without a round trip through the client. Every callback is timed
+ * against the budget of its plugin, and a plugin that keeps overrunning it is disabled
+ */
+class PluginManager {
+public:
+	/**
+	 * @brief Returns the singleton PluginManager instance
+	 * @return The singleton instance
+	 */
+	static PluginManager& getInstance();
+
+	/**
+	 * @brief Loads the listed plugins from the Conduit plugin directory, should be called once before the hooks are
+	 * installed. Only bare DLL file names are accepted, so plugins can't be loaded from anywhere else
+	 * @param pluginList The file names of the plugins, separated by semicolons
+	 */
+	void loadPlugins(const std::string& pluginList);
+
+	/**
+	 * @brief Registers a plugin that is linked into the process instead of loaded from a DLL, such as the mock plugins
+	 * of the plugin tests. Like loadPlugins(), should be called before the hooks are installed
+	 * @param name The name of the plugin, used in the driver log unless the plugin names itself
+	 * @param init The init function of the plugin
+	 * @return True if the plugin initialized and was registered, false otherwise
+	 */
+	bool registerPlugin(const std::string& name, ConduitPluginInitFunction init);
+
+	/**
+	 * @brief Shuts down and unloads every plugin, should be called once the hooks are disabled. Waits for hook threads
+	 * still inside a plugin callback to leave it before unloading the plugin
+	 */
+	void unloadPlugins();
+
+	/**
+	 * @brief Records the latest natural pose of a device for getNaturalDevicePose. Does nothing unless a plugin is
+	 * loaded
+	 * @param deviceIndex The device index of the device
+	 * @param pose The natural pose as reported by OpenVR
+	 */
+	void recordNaturalPose(uint32_t deviceIndex, const vr::DriverPose_t& pose);
+
+	/**
+	 * @brief Applies the overrides plugins set since the last call. Plugin callbacks run on the hook threads, so
+	 * their overrides are queued instead of waiting on the exclusive batch mutex there, and applied here under it.
+	 * Called at the start of every hook and poll, and costs a single atomic load while nothing is queued. Must not be
+	 * called while holding the batch mutex of the model
+	 */
+	void applyPendingOverrides();
+
+	/**
+	 * @brief Runs the device pose callbacks of every enabled plugin
+	 * @param deviceIndex The device index of the device
+	 * @param pose The pose about to be sent to OpenVR
+	 * @param outPose The output pose, only valid if the method returns true
+	 * @return True if a plugin changed the pose and <outPose> was written, false otherwise
+	 */
+	bool processDevicePose(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose);
+
+	/**
+	 * @brief Runs the boolean input callbacks of every enabled plugin
+	 * @param componentHandle The component handle of the input
+	 * @param value The value about to be sent to OpenVR, which is replaced by the plugin value
+	 * @param timeOffset The time offset about to be sent to OpenVR, which is replaced by the plugin value
+	 * @return True if a plugin changed the value, false otherwise
+	 */
+	bool processBoolean(vr::VRInputComponentHandle_t componentHandle, bool& value, double& timeOffset);
+
+	/**
+	 * @brief Runs the scalar input callbacks of every enabled plugin
+	 * @param componentHandle The component handle of the input
+	 * @param value The value about to be sent to OpenVR, which is replaced by the plugin value
+	 * @param timeOffset The time offset about to be sent to OpenVR, which is replaced by the plugin value
+	 * @return True if a plugin changed the value, false otherwise
+	 */
+	bool processScalar(vr::VRInputComponentHandle_t componentHandle, float& value, double& timeOffset);
+
+	/**
+	 * @brief Runs the skeleton input callbacks of every enabled plugin
+	 * @param componentHandle The component handle of the input
+	 * @param motionRange The motion range of the transforms
+	 * @param transforms The bone transforms about to be sent to OpenVR
+	 * @param transformCount The number of bone transforms, of which at most 31 are passed to plugins
+	 * @param outTransforms The output bone transforms, with room for 31 transforms, only valid if the method returns
+	 * true
+	 * @return True if a plugin changed the transforms and <outTransforms> was written, false otherwise
+	 */
+	bool processSkeleton(
+		vr::VRInputComponentHandle_t componentHandle,
+		vr::EVRSkeletalMotionRange motionRange,
+		const vr::VRBoneTransform_t* transforms,
+		uint32_t transformCount,
+		vr::VRBoneTransform_t* outTransforms
+	);
+
+private:
+	/** @brief A loaded plugin and the timing of its callbacks */
+	struct LoadedPlugin {
+		HMODULE module = nullptr;
+		ConduitPluginCallbacks callbacks = {};
+		std::string name;
+		int64_t budgetNanoseconds = 0;
+
+		/** @brief Cleared once the plugin overran its budget too often, after which it is never called again */
+		std::atomic<bool> enabled = true;
+
+		/** @brief The number of calls in a row that overran the budget */
+		std::atomic<uint32_t> consecutiveOverruns = 0;
+
+		/** @brief The longest call so far in nanoseconds, reported when the plugin is disabled */
+		std::atomic<int64_t> longestCallNanoseconds = 0;
+
+		/** @brief The number of hook threads currently inside a callback of the plugin */
+		std::atomic<uint32_t> activeCalls = 0;
+
+		/** @brief Set once shutdown was called, so it is called exactly once */
+		std::atomic<bool> shutDown = false;
+
+		/** @brief Set once shutdown returned, so the plugin is never unloaded while its shutdown is still running */
+		std::atomic<bool> shutdownFinished = false;
+	};
+
+	/** @brief The latest natural pose of a device, written by its pose hook and read by plugins on any hook thread */
+	struct NaturalPose {
+		std::mutex poseMutex;
+		vr::DriverPose_t pose = {};
+		bool recorded = false;
+	};
+
+	/** @brief An override set by a plugin, waiting for the next hook or poll to apply it */
+	struct PendingOverride {
+		ObjectType type = Object_DevicePose;
+		uint32_t deviceIndex = 0;
+		vr::VRInputComponentHandle_t componentHandle = 0;
+		vr::DriverPose_t pose = {};
+		float value = 0.0f;
+		bool useOverride = false;
+	};
+
+	/** @brief The loaded plugins, only changed before the hooks are installed and after they are disabled */
+	std::vector<std::unique_ptr<LoadedPlugin>> plugins;
+
+	/** @brief The latest natural pose of each device index, recorded only while a plugin is loaded */
+	NaturalPose naturalPoses[vr::k_unMaxTrackedDeviceCount];
+
+	/** @brief Guards <pendingOverrides>, held only while an override is queued or the queue is taken */
+	std::mutex pendingOverrideMutex;
+
+	/** @brief The overrides plugins set since they were last applied, in the order they were set */
+	std::vector<PendingOverride> pendingOverrides;
+
+	/** @brief Whether <pendingOverrides> holds anything, readable without the lock */
+	std::atomic<bool> hasPendingOverrides = false;
+
+	/** @brief The host functions handed to every plugin */
+	static const ConduitHostApi hostApi;
+
+	/** @brief Private empty constructor for the singleton pattern */
+	PluginManager() = default;
+
+	/**
+	 * @brief Loads a single plugin
+	 * @param fileName The file name of the plugin in the plugin directory
+	 */
+	void loadPlugin(const std::string& fileName);
+
+	/**
+	 * @brief Initializes a plugin and adds it to the loaded plugins
+	 * @param module The module of the plugin, or nullptr if it is linked into the process
+	 * @param init The init function of the plugin
+	 * @param fileName The file name of the plugin, used in the driver log unless the plugin names itself
+	 * @return True if the plugin initialized, false otherwise
+	 */
+	bool initializePlugin(HMODULE module, ConduitPluginInitFunction init, const std::string& fileName);
+
+	/**
+	 * @brief Times a single plugin callback against the budget of the plugin, disabling the plugin once it overran
+	 * the budget too many times in a row. A disabled plugin is shut down by the last hook thread to leave its
+	 * callbacks, so shutdown never runs alongside a callback
+	 * @param plugin The plugin
+	 * @param call Calls the callback, returning its result
+	 * @return The result of the callback, or 0 if the plugin was disabled before it could be called
+	 */
+	template <typename Call>
+	int32_t runCallback(LoadedPlugin& plugin, Call call);
+
+	/**
+	 * @brief Queues an override set by a plugin until applyPendingOverrides()
+	 * @param pendingOverride The override
+	 */
+	void queueOverride(const PendingOverride& pendingOverride);
+
+	/**
+	 * @brief Calls the shutdown callback of a plugin unless it was already called
+	 * @param plugin The plugin
+	 */
+	static void shutdownPlugin(LoadedPlugin& plugin);
+
+	/** @brief Host API implementations, see ConduitHostApi */
+	static int32_t hostGetComponentHandle(uint32_t deviceIndex, const char* path, uint64_t* outComponentHandle);
+	static int32_t hostGetNaturalDevicePose(uint32_t deviceIndex, ConduitDevicePose* outPose);
+	static int32_t hostGetNaturalBoolean(uint64_t componentHandle, int32_t* outValue);
+	static int32_t hostGetNaturalScalar(uint64_t componentHandle, float* outValue);
+	static int32_t hostSetOverriddenDevicePose(
+		uint32_t deviceIndex,
+		const ConduitDevicePose* pose,
+		int32_t useOverride
+	);
+	static int32_t hostSetOverriddenBoolean(uint64_t componentHandle, int32_t value, int32_t useOverride);
+	static int32_t hostSetOverriddenScalar(uint64_t componentHandle, float value, int32_t useOverride);
+	static void hostLog(const char* message);
+};
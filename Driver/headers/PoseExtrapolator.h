@@ -0,0 +1,76 @@
+#pragma once
+#include <openvr_driver.h>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+#include "DeviceTypes.h"
+#include "Utils.h"
+
+/**
+ * @brief Dead reckons overridden device poses inside the hooks. Each override is extrapolated along its own velocities
+ * to the time of every pose update, and the gap to the next override is blended out instead of snapped, so overrides
+ * sent at a low rate still come out smooth on devices that update at a much higher rate
+ */
+class PoseExtrapolator {
+public:
+	/**
+	 * @brief Returns the singleton PoseExtrapolator instance
+	 * @return The singleton instance
+	 */
+	static PoseExtrapolator& getInstance();
+
+	/**
+	 * @brief Sets the dead reckoning of a device, resetting its extrapolation state
+	 * @param deviceIndex The device index of the device
+	 * @param config The extrapolation configuration
+	 */
+	void setConfig(uint32_t deviceIndex, const PoseExtrapolationConfig& config);
+
+	/**
+	 * @brief Records that a device received a new overridden pose, capturing the gap between the pose last sent for
+	 * the device and the new override so it can be blended out
+	 * @param deviceIndex The device index of the device
+	 * @param pose The new overridden pose
+	 */
+	void recordOverride(uint32_t deviceIndex, const vr::DriverPose_t& pose);
+
+	/**
+	 * @brief Extrapolates the overridden pose of a device to the current time
+	 * @param deviceIndex The device index of the device
+	 * @param pose The overridden pose, as last received from the client
+	 * @param outPose The output extrapolated pose, only valid if the method returns true
+	 * @return True if the device is dead reckoned and <outPose> was written, false otherwise
+	 */
+	bool extrapolate(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose);
+
+private:
+	/** @brief The extrapolation state of a single device, owning its cache lines like the smoothing filter states */
+	struct alignas(64) ExtrapolationState {
+		PoseExtrapolationConfig config;
+		/** @brief When the current override was received */
+		std::chrono::steady_clock::time_point overrideTime;
+		/** @brief Whether <lastPosition> and <lastRotation> hold the last pose sent for the device */
+		bool hasOutput = false;
+		std::chrono::steady_clock::time_point outputTime;
+		double lastPosition[3] = {};
+		vr::HmdQuaternion_t lastRotation = { 1.0, 0.0, 0.0, 0.0 };
+		/** @brief The gap from the current override to the pose sent just before it, faded out over time */
+		double positionError[3] = {};
+		vr::HmdQuaternion_t rotationError = { 1.0, 0.0, 0.0, 0.0 };
+	};
+
+	/** @brief Guards all extrapolation configurations and states, held only while they are updated or evaluated */
+	std::mutex extrapolatorMutex;
+
+	/** @brief Whether each device index is dead reckoned, readable without the lock */
+	std::atomic<bool> extrapolationEnabled[vr::k_unMaxTrackedDeviceCount] = {};
+
+	/** @brief The extrapolation state of each device index */
+	ExtrapolationState states[vr::k_unMaxTrackedDeviceCount];
+
+	/** @brief Private empty constructor for the singleton pattern */
+	PoseExtrapolator() = default;
+};
@@ -4,8 +4,14 @@
 #include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <utility>
 
 #include "ObjectSchemas.h"
+#include "LaneFraming.h"
 #include "DeviceTypes.h"
 #include "LogManager.h"
 #include "DeviceStateModelDriver.h"
@@ -29,15 +35,49 @@ public:
 
 	/**
 	 * @brief Initializes shared memory related tasks, should be called exactly once
+	 * @param lockedMapping Whether to back the shared memory with large pages when available, and to prefault and lock
+	 * every page at startup so hook threads never take a page fault on it
+	 * @param mirroredLanes Whether to map each lane twice back to back when the OS supports it, so packets never
+	 * wrap or skip padding
 	 * @return True if initialization was successful, false otherwise
 	 */
-	bool initialize();
+	bool initialize(bool lockedMapping, bool mirroredLanes);
 
 	/**
 	 * @brief Checks for updates from the client in the client-driver lane, and notifies relavent objects
 	 */
 	void pollForClientUpdates();
 
+	/**
+	 * @brief Reads and applies pending commands from the client-driver lane without blocking. Called from the poll
+	 * loop and at the start of every update hook, so commands apply on the next device update instead of waiting for
+	 * the poll period. Must not be called while holding the batch mutex of the model
+	 * @param maxPackets The maximum number of packets to read, the rest is left for the next call
+	 * @param lightCommandsOnly Whether to stop at the first heavy command, as the hooks do, leaving it and everything
+	 * after it for the poll thread
+	 */
+	void drainClientDriverLane(uint32_t maxPackets, bool lightCommandsOnly);
+
+	/**
+	 * @brief Returns whether a client is attached, as of the last poll. While no client is attached the hooks skip
+	 * publishing state to the driver-client lane entirely
+	 * @return True if a client has polled within CLIENT_HEARTBEAT_TIMEOUT_MS, false otherwise
+	 */
+	bool isClientAttached();
+
+	/**
+	 * @brief Lets clients know that plugins overrode device state, replacing what earlier client commands set
+	 */
+	void countPluginOverrides();
+
+	/**
+	 * @brief Applies a command whose scheduled apply time has been reached and acknowledges it, assuming the caller
+	 * holds the batch mutex of the model
+	 * @param header The header of the command
+	 * @param paramsBuf The command parameters as raw bytes, interpreted according to the command type
+	 */
+	void applyScheduledCommand(const ClientCommandHeaderData& header, uint8_t* paramsBuf);
+
 	/**
 	 * @brief Writes a packet encoding the state of a device pose to the driver-client lane
 	 * @param packet The device pose to be written
@@ -105,6 +145,58 @@ public:
 		const std::string&
 	);
 
+	/**
+	 * @brief Writes a removal packet for a device pose or input to the driver-client lane, after which clients drop it
+	 * from their models
+	 * @param type The type of the removed object
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the input, unused for Object_DevicePose
+	 */
+	void syncObjectRemovalToSharedMemory(ObjectType type, uint32_t deviceIndex, const std::string& path);
+
+	/**
+	 * @brief Writes the properties of a device to its slot in the device registry
+	 * @param info The properties of the device
+	 */
+	void registerDevice(const DeviceInfo& info);
+
+	/**
+	 * @brief Appends a component to the device registry, logging an error if the registry is full
+	 * @param info The metadata of the component, where at most 31 grip limit transforms are kept
+	 */
+	void registerComponent(const ComponentInfo& info);
+
+	/**
+	 * @brief Returns the class of a device from the device registry, without querying OpenVR
+	 * @param deviceIndex The device index of the device
+	 * @return The class of the device, or DeviceClass_Invalid if the driver hasn't seen it yet
+	 */
+	DeviceClass getRegisteredDeviceClass(uint32_t deviceIndex);
+
+	/**
+	 * @brief Clears the slot of a device in the device registry and removes its components, compacting the rest and
+	 * freeing their grip limit slots for reuse
+	 * @param deviceIndex The device index of the device
+	 */
+	void unregisterDevice(uint32_t deviceIndex);
+
+	/**
+	 * @brief Writes a vibration to the haptics lane. Safe to call from any number of threads at once, each producer
+	 * claims its own record
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the haptic component
+	 * @param componentHandle The component handle of the haptic component
+	 * @param vibration The vibration
+	 * @param flags The HapticEventFlag's of the vibration
+	 */
+	void writeHapticEvent(
+		uint32_t deviceIndex,
+		const std::string& path,
+		vr::VRInputComponentHandle_t componentHandle,
+		const vr::VREvent_HapticVibration_t& vibration,
+		uint8_t flags
+	);
+
 private:
 	/** @brief The handle for the shared memory */
 	HANDLE sharedMemoryHandle;
@@ -118,36 +210,136 @@ private:
 	/** @brief A map of paths to their offsets in the path table */
 	std::unordered_map<std::string, uint32_t> pathTableOffsets;
 
+	/** @brief Guards the path table, shared for lookups and exclusive while a path is appended */
+	std::shared_mutex pathTableMutex;
+
 	/** @brief The offset in bytes in the path table where the driver is currently appending new paths */
 	uint32_t currentPathTableWriteOffset;
 
 	/** @brief The offset in bytes of the driver-client lane from the start of the shared memory */
 	uint32_t driverClientLaneStart;
 
-	/** @brief The offset in bytes of where the driver is currently writing in the driver-client lane */
-	uint32_t driverClientLaneWriteOffset;
+	/** @brief A pointer to the start of the driver-client lane, in the shared memory or in its mirrored section */
+	uint8_t* driverClientLane = nullptr;
+
+	/**
+	 * @brief The next free space in the driver-client lane, claimed by producer threads with a compare-exchange. The
+	 * low 32 bits hold the write offset and the high 32 bits the low 32 bits of the last reserved packet version
+	 */
+	alignas(64) std::atomic<uint64_t> driverClientLaneReservation = 0;
+
+	/** @brief The cached read offset of the driver-client lane, reloaded only when the lane looks full */
+	std::atomic<uint32_t> cachedDriverClientReadOffset = 0;
 
-	/** @brief The version of the last written packet in the driver-client lane */
-	uint64_t driverClientLaneWriteCount;
+	/** @brief Whether a client is attached, set by the poll loop and read by the hooks without touching the header */
+	std::atomic<bool> clientAttached = false;
+
+	/** @brief The clientGeneration of the attached client */
+	uint32_t attachedClientGeneration = 0;
 
 	/** @brief The offset in bytes of the client-driver lane from the start of the shared memory */
 	uint32_t clientDriverLaneStart;
 
+	/** @brief A pointer to the start of the client-driver lane, in the shared memory or in its mirrored section */
+	uint8_t* clientDriverLane = nullptr;
+
+	/** @brief Whether both lanes are mirrored, see SharedMemoryMapping_MirroredLanes */
+	bool mirroredLanes = false;
+
+	/** @brief The handles of the sections holding the driver-client and client-driver lanes when they are mirrored */
+	HANDLE driverClientLaneHandle = nullptr;
+	HANDLE clientDriverLaneHandle = nullptr;
+
 	/** @brief The offset in bytes of where the driver is currently reading in the client-driver lane */
 	uint32_t clientDriverLaneReadOffset;
 
 	/** @brief The version of the last successfully read packet in the client-driver lane */
 	uint64_t clientDriverLaneReadCount;
 
+	/** @brief Held while the client-driver lane is read, only ever taken with try_lock */
+	std::mutex clientDriverReadMutex;
+
+	/** @brief <clientDriverLaneReadCount> as of the last drain, readable without the lock */
+	std::atomic<uint64_t> drainedClientDriverCount = 0;
+
+	/** @brief The cached write offset of the client-driver lane, reloaded only when the lane looks empty */
+	uint32_t cachedClientDriverWriteOffset = 0;
+
+	/** @brief The offset in bytes of the command status ring from the start of the shared memory */
+	uint32_t commandStatusRingStart;
+
+	/** @brief The offset in bytes of the animation blob region from the start of the shared memory */
+	uint32_t animationBlobStart;
+
+	/** @brief A pointer to the device registry in the shared memory */
+	DeviceRegistry* deviceRegistry = nullptr;
+
+	/** @brief Serializes writers of the device registry, which are the create hooks of any vendor driver thread */
+	std::mutex deviceRegistryMutex;
+
+	/** @brief Grip limit slots freed by unregistered devices, reused before new slots are taken */
+	std::vector<uint16_t> freeGripLimitSlots;
+
+	/** @brief A pointer to the first record of the haptics lane in the shared memory */
+	HapticEventRecord* hapticLane = nullptr;
+
+	/** @brief The size in bytes of the shared memory, rounded up to whole large pages if they are used */
+	uint32_t mappingSize = 0;
+
+	/** @brief The SharedMemoryMappingFlag's describing how the shared memory was mapped */
+	uint32_t mappingFlags = 0;
+
+	/** @brief True while commands are being staged between a BeginBatch and its CommitBatch */
+	bool batchOpen = false;
+
+	/** @brief The commands of the open batch, applied together when the batch commits */
+	std::vector<std::pair<ClientCommandHeaderData, std::unique_ptr<uint8_t[]>>> stagedBatchCommands;
+
+	/** @brief The number of commands the open batch declared in its BeginBatch */
+	uint32_t stagedBatchCommandCount = 0;
+
+	/** @brief Whether the open batch staged a heavy command, so a hook leaves committing it to the poll thread */
+	bool stagedBatchHasHeavyCommand = false;
+
+	/** @brief Set when the reader skipped packets to realign, so an open batch may have lost its commands or commit */
+	bool readerRealigned = false;
+
+	/** @brief A heavy command a hook read and left for the poll thread, applied before anything else is read */
+	std::pair<ClientCommandHeaderData, std::pair<ClientCommandType, std::unique_ptr<uint8_t[]>>> deferredPacket = {};
+
 	/** @brief Empty constructor for the SharedDeviceMemoryDriver class to prevent direct instantiaton */
 	SharedDeviceMemoryDriver() = default;
 
+	/**
+	 * @brief Creates the shared memory backed by large pages, which requires SeLockMemoryPrivilege
+	 * @return True if the large page mapping was created, false if the caller should fall back to regular pages
+	 */
+	bool createLargePageSharedMemory();
+
+	/**
+	 * @brief Touches every page of the shared memory so it is faulted in now instead of on the hook threads, then
+	 * locks it in memory unless large pages already keep it resident
+	 */
+	void prefaultSharedMemory();
+
+	/**
+	 * @brief Creates a section for each lane and maps it twice back to back
+	 * @return True if both lanes are mirrored, false if the caller should fall back to the lanes in the shared memory
+	 */
+	bool createMirroredLanes();
+
 	/** 
 	 * @brief Initializes important metadata in shared memory, such as creating the shared memory header
 	 * @return True if initialization was successful, false otherwise
 	 */
 	bool initializeSharedMemoryData();
 
+	/**
+	 * @brief Checks the client heartbeat, and publishes a snapshot of the model when a client attaches so it starts
+	 * with the full device state even though nothing was published while no client was attached
+	 */
+	void updateClientPresence();
+
 	/**
 	 * @brief Returns the path at an offset in the path table
 	 * @param offset The byte offset in the path table
@@ -163,9 +355,48 @@ private:
 	uint32_t getOffsetOfPath(const std::string& inputPath);
 
 	/**
-	 * @brief Writes a packet into the driver-client lane
+	 * @brief Hands a command with a future apply time to the CommandScheduler and acknowledges it as scheduled
+	 * @param header The header of the command
+	 * @param paramsBuf The command parameters, moved into the scheduler if the command is scheduled
+	 * @return True if the command has a future apply time and was handled, false if it should be applied now
+	 */
+	bool scheduleCommand(const ClientCommandHeaderData& header, std::unique_ptr<uint8_t[]>& paramsBuf);
+
+	/**
+	 * @brief Applies a single client command to the model and the driver side managers
+	 * @param header The header of the command
+	 * @param paramsBuf The command parameters as raw bytes, interpreted according to the command type
+	 * @return The status to acknowledge the command with
+	 */
+	CommandStatus applyCommand(const ClientCommandHeaderData& header, uint8_t* paramsBuf);
+
+	/**
+	 * @brief Returns why a command could not find its target input
+	 * @param deviceIndex The device index the command targets
+	 * @param inputPath The resolved input path, empty if the path table lookup failed
+	 * @return The status describing the missing target
+	 */
+	CommandStatus getMissingInputStatus(uint32_t deviceIndex, const std::string& inputPath);
+
+	/**
+	 * @brief Writes the status of a processed command to the command status ring
+	 * @param header The header of the command
+	 * @param status The status of the command
+	 */
+	void writeCommandStatus(const ClientCommandHeaderData& header, CommandStatus status);
+
+	/**
+	 * @brief Drops the commands of the open batch, reporting them as dropped, and closes the batch
+	 * @param reason Why the batch is discarded, for the driver log
+	 */
+	void discardStagedBatch(const char* reason);
+
+	/**
+	 * @brief Writes a packet into the driver-client lane. Safe to call from any number of threads at once: each
+	 * producer reserves its frame and version lock-free, copies the frame in parallel with the others, and then
+	 * publishes once every frame reserved before it is published, so the client always reads frames in version order
 	 * @param packet A pointer to the packet, where the ObjectEntry and relevant data are already aligned
-	 * and filled with required data
+	 * and filled with required data, except for the version which is assigned here
 	 * @param packetSize The total size of the packet
 	 */
 	void writePacketToDriverClientLane(void* packet, uint32_t packetSize);
@@ -180,9 +411,27 @@ private:
 	std::pair<ClientCommandHeaderData, std::pair<ClientCommandType, std::unique_ptr<uint8_t[]>>> readPacketFromClientDriverLane();
 	
 	/**
-	 * @brief Realigns the read header to a valid packet by forward searching for valid packets. If none are found
-	 * after a specified amount of bytes, the read header is advanced to the write header, dropping all packets in
-	 * between
+	 * @brief Returns the size in bytes of the command params that follow a command header of type <type>
+	 */
+	static uint32_t getCommandParamsSize(ClientCommandType type);
+
+	/**
+	 * @brief Returns whether applying a command costs far more than an override, such as copying an animation track
+	 * out of the blob or verifying a filter program, so that it is never applied on a hook thread
+	 * @param type The type of command
+	 * @return True if the command is heavy, false otherwise
+	 */
+	static bool isHeavyCommand(ClientCommandType type);
+
+	/**
+	 * @brief Returns the size in bytes of the serialized data that follows an ObjectEntry of type <type>
+	 */
+	static uint32_t getObjectDataSize(ObjectType type);
+
+	/**
+	 * @brief Realigns the read header to a valid packet by scanning frame boundaries up to the write header for a
+	 * frame with a valid checksum, following wrap markers. If none are found, the read header is advanced to the
+	 * write header, dropping all packets in between
 	 * @param headerPtr The shared memory header
 	 * @param laneStart The start of the shared memory lane
 	 * @param readStart A pointer to where to write the new read offset in the event that forward searching succeeded
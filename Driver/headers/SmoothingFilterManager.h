@@ -0,0 +1,99 @@
+#pragma once
+#include <openvr_driver.h>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+#include "DeviceTypes.h"
+#include "Utils.h"
+
+/**
+ * @brief Runs the smoothing filters configured by clients on natural device poses and scalar inputs inside the hooks,
+ * so smoothing adds no IPC latency on top of the filter's own
+ */
+class SmoothingFilterManager {
+public:
+	/**
+	 * @brief Returns the singleton SmoothingFilterManager instance
+	 * @return The singleton instance
+	 */
+	static SmoothingFilterManager& getInstance();
+
+	/**
+	 * @brief Sets the smoothing filter of a device pose, resetting its filter state
+	 * @param deviceIndex The device index of the device
+	 * @param config The filter configuration, where SmoothingFilter_None disables smoothing
+	 */
+	void setPoseFilter(uint32_t deviceIndex, const SmoothingFilterConfig& config);
+
+	/**
+	 * @brief Smooths a natural device pose
+	 * @param deviceIndex The device index of the device
+	 * @param pose The natural pose as reported by OpenVR
+	 * @param outPose The output smoothed pose, only valid if the method returns true
+	 * @return True if the device has a filter and <outPose> was written, false otherwise
+	 */
+	bool filterPose(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose);
+
+	/**
+	 * @brief Sets the smoothing filter of a scalar input, resetting its filter state
+	 * @param componentHandle The component handle of the input
+	 * @param config The filter configuration, where SmoothingFilter_None disables smoothing
+	 */
+	void setScalarFilter(vr::VRInputComponentHandle_t componentHandle, const SmoothingFilterConfig& config);
+
+	/**
+	 * @brief Smooths a natural scalar input value
+	 * @param componentHandle The component handle of the input
+	 * @param value The natural value, which is replaced by the smoothed value
+	 * @return True if the input has a filter and <value> was smoothed, false otherwise
+	 */
+	bool filterScalar(vr::VRInputComponentHandle_t componentHandle, float& value);
+
+private:
+	/**
+	 * @brief The filter state of a single device pose. Positions are padded to 4 lanes so the per-axis math maps onto
+	 * full vector registers, and each state owns its lock and cache lines so devices updated from different threads
+	 * don't contend
+	 */
+	struct alignas(64) PoseFilterState {
+		std::mutex stateMutex;
+		SmoothingFilterConfig config;
+		bool initialized = false;
+		std::chrono::steady_clock::time_point lastTime;
+		alignas(32) double position[4] = {};
+		alignas(32) double velocity[4] = {};
+		vr::HmdQuaternion_t rotation = { 1.0, 0.0, 0.0, 0.0 };
+		double angularSpeed = 0.0;
+	};
+
+	/** @brief The filter state of a single scalar input */
+	struct ScalarFilterState {
+		SmoothingFilterConfig config;
+		bool initialized = false;
+		std::chrono::steady_clock::time_point lastTime;
+		double value = 0.0;
+		double velocity = 0.0;
+	};
+
+	/** @brief Guards the scalar filter states, held only while filters are updated or evaluated */
+	std::mutex filterMutex;
+
+	/** @brief Whether each device index has a pose filter, readable without the lock */
+	std::atomic<bool> poseFilterEnabled[vr::k_unMaxTrackedDeviceCount] = {};
+
+	/** @brief The pose filter state of each device index */
+	PoseFilterState poseStates[vr::k_unMaxTrackedDeviceCount];
+
+	/** @brief The number of scalar inputs with filters, readable without the lock */
+	std::atomic<uint32_t> scalarFilterCount = 0;
+
+	/** @brief Maps component handles to their scalar filter states */
+	std::unordered_map<vr::VRInputComponentHandle_t, ScalarFilterState> scalarStates;
+
+	/** @brief Private empty constructor for the singleton pattern */
+	SmoothingFilterManager() = default;
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <openvr_driver.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+#include "DeviceTypes.h"
+#include "Utils.h"
+
+/**
+ * @brief Stores the declarative transform rules uploaded by clients and evaluates them on natural device state inside
+ * the hooks, so rule based overrides are applied on the same call instead of after a round trip through the client
+ */
+class TransformRuleManager {
+public:
+	/**
+	 * @brief Returns the singleton TransformRuleManager instance
+	 * @return The singleton instance
+	 */
+	static TransformRuleManager& getInstance();
+
+	/**
+	 * @brief Replaces the pose transform rules of a device
+	 * @param deviceIndex The device index of the device
+	 * @param rules Pointer to the rules, applied in order
+	 * @param ruleCount The number of rules, where 0 clears all rules of the device. Rules beyond
+	 * MAX_POSE_TRANSFORM_RULES are ignored
+	 */
+	void setPoseRules(uint32_t deviceIndex, const PoseTransformRule* rules, uint32_t ruleCount);
+
+	/**
+	 * @brief Applies the pose transform rules of a device to a natural pose
+	 * @param deviceIndex The device index of the device
+	 * @param pose The natural pose as reported by OpenVR
+	 * @param outPose The output transformed pose, only written if the method returns true
+	 * @return True if the device has rules and <outPose> was written, false otherwise
+	 */
+	bool applyPoseRules(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose);
+
+	/**
+	 * @brief Records the latest natural pose of a device for use as the source of remap rules. Does nothing unless a
+	 * remap rule is active on some device
+	 * @param deviceIndex The device index of the device
+	 * @param pose The natural pose as reported by OpenVR
+	 */
+	void recordNaturalPose(uint32_t deviceIndex, const vr::DriverPose_t& pose);
+
+	/**
+	 * @brief Replaces the input transform rules of a boolean or scalar input
+	 * @param componentHandle The component handle of the input
+	 * @param rules Pointer to the rules, applied in order
+	 * @param ruleCount The number of rules, where 0 clears all rules of the input. Rules beyond
+	 * MAX_INPUT_TRANSFORM_RULES are ignored
+	 */
+	void setInputRules(vr::VRInputComponentHandle_t componentHandle, const InputTransformRule* rules, uint32_t ruleCount);
+
+	/**
+	 * @brief Applies the input transform rules of a boolean input to its natural value
+	 * @param componentHandle The component handle of the input
+	 * @param value The natural value, which is transformed in place
+	 * @return True if the input has rules and <value> was transformed, false otherwise
+	 */
+	bool applyBooleanRules(vr::VRInputComponentHandle_t componentHandle, bool& value);
+
+	/**
+	 * @brief Applies the input transform rules of a scalar input to its natural value
+	 * @param componentHandle The component handle of the input
+	 * @param value The natural value, which is transformed in place
+	 * @return True if the input has rules and <value> was transformed, false otherwise
+	 */
+	bool applyScalarRules(vr::VRInputComponentHandle_t componentHandle, float& value);
+
+private:
+	/** @brief The active pose transform rules of a single device */
+	struct PoseRuleSet {
+		uint32_t ruleCount = 0;
+		uint32_t remapRuleCount = 0;
+		PoseTransformRule rules[MAX_POSE_TRANSFORM_RULES];
+	};
+
+	/** @brief The active input transform rules of a single input */
+	struct InputRuleSet {
+		uint32_t ruleCount = 0;
+		InputTransformRule rules[MAX_INPUT_TRANSFORM_RULES];
+	};
+
+	/** @brief Guards all rule sets and recorded natural poses, held only while rules are updated or evaluated */
+	std::mutex ruleMutex;
+
+	/** @brief The rule count of each device index, readable without the lock so devices without rules cost nothing */
+	std::atomic<uint32_t> poseRuleCounts[vr::k_unMaxTrackedDeviceCount] = {};
+
+	/** @brief The pose transform rules of each device index */
+	PoseRuleSet poseRules[vr::k_unMaxTrackedDeviceCount];
+
+	/** @brief The total number of remap rules across all devices, used to skip recording natural poses */
+	std::atomic<uint32_t> remapRuleCount = 0;
+
+	/** @brief The latest natural pose of each device index, recorded only while a remap rule is active */
+	vr::DriverPose_t naturalPoses[vr::k_unMaxTrackedDeviceCount] = {};
+
+	/** @brief The number of inputs with rules, readable without the lock so inputs without rules cost nothing */
+	std::atomic<uint32_t> inputRuleSetCount = 0;
+
+	/** @brief Maps component handles to their input transform rules */
+	std::unordered_map<vr::VRInputComponentHandle_t, InputRuleSet> inputRules;
+
+	/** @brief Private empty constructor for the singleton pattern */
+	TransformRuleManager() = default;
+
+	/**
+	 * @brief Finds the rules of an input, assuming the caller holds <ruleMutex>
+	 * @param componentHandle The component handle of the input
+	 * @return A pointer to the rules if the input has any, nullptr otherwise
+	 */
+	const InputRuleSet* findInputRules(vr::VRInputComponentHandle_t componentHandle);
+};
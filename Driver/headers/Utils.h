@@ -4,12 +4,19 @@
 #include "DeviceTypes.h"
 
 /**
- * @brief Returns the device class for a given device index (DEPRECATED)
+ * @brief Returns the device class for a given device index from the device registry, without querying OpenVR
  * @param deviceIndex The device index of the device
- * @return The class of the device
+ * @return The class of the device, or TrackedDeviceClass_Invalid if the driver hasn't seen it yet
  */
 vr::ETrackedDeviceClass getDeviceClass(uint32_t deviceIndex);
 
+/**
+ * @brief Reads the registry properties of a device from OpenVR, which should only be done once per device
+ * @param deviceIndex The device index of the device
+ * @return The properties of the device, where properties the device doesn't set are left at their defaults
+ */
+DeviceInfo ReadDeviceInfo(uint32_t deviceIndex);
+
 /**
  * @brief Converts an OpenVR DriverPose_t to a DevicePose
  * @param pose The OpenVR driver pose to convert
@@ -24,6 +31,22 @@ DevicePose FromDriverPose(const vr::DriverPose_t& pose);
  */
 vr::DriverPose_t ToDriverPose(const DevicePose& cp);
 
+/**
+ * @brief Converts a batch of OpenVR DriverPose_t's to DevicePose's using the widest available SIMD instruction set
+ * @param poses Pointer to the array of OpenVR driver poses to convert
+ * @param count The number of poses in the array
+ * @param outPoses Pointer to the output array of DevicePose's, with room for at least <count> poses
+ */
+void FromDriverPoses(const vr::DriverPose_t* poses, uint32_t count, DevicePose* outPoses);
+
+/**
+ * @brief Converts a batch of DevicePose's to OpenVR DriverPose_t's using the widest available SIMD instruction set
+ * @param poses Pointer to the array of DevicePose's to convert
+ * @param count The number of poses in the array
+ * @param outPoses Pointer to the output array of OpenVR driver poses, with room for at least <count> poses
+ */
+void ToDriverPoses(const DevicePose* poses, uint32_t count, vr::DriverPose_t* outPoses);
+
 /**
  * @brief Converts a DeviceMatrix34 to an OpenVR HmdMatrix34_t
  * @param mat The DeviceMatrix34 to convert
@@ -65,4 +88,51 @@ vr::VREyeTrackingData_t ToVREyeTrackingData(const EyeTrackingData& data);
  * @param data The OpenVR eye tracking data to convert
  * @return The converted EyeTrackingData
  */
-EyeTrackingData FromVREyeTrackingData(const vr::VREyeTrackingData_t& data);
\ No newline at end of file
+EyeTrackingData FromVREyeTrackingData(const vr::VREyeTrackingData_t& data);
+
+/**
+ * @brief Returns the Hamilton product of two quaternions, which applies <b> first and then <a>
+ * @param a The left hand quaternion
+ * @param b The right hand quaternion
+ * @return The product a * b
+ */
+vr::HmdQuaternion_t MultiplyQuaternions(const vr::HmdQuaternion_t& a, const vr::HmdQuaternion_t& b);
+
+/**
+ * @brief Rotates a 3D vector by a unit quaternion
+ * @param q The rotation to apply
+ * @param vector The vector to rotate
+ * @param outVector The output rotated vector, which may alias <vector>
+ */
+void RotateVector(const vr::HmdQuaternion_t& q, const double vector[3], double outVector[3]);
+
+/**
+ * @brief Spherically interpolates between two unit quaternions along the shortest arc
+ * @param a The quaternion at t = 0
+ * @param b The quaternion at t = 1
+ * @param t The interpolation factor
+ * @return The interpolated unit quaternion
+ */
+vr::HmdQuaternion_t SlerpQuaternions(const vr::HmdQuaternion_t& a, const vr::HmdQuaternion_t& b, double t);
+
+/**
+ * @brief Copies the fields of an overridden pose selected by a field mask over a natural pose
+ * @param overriddenPose The overridden pose
+ * @param fieldMask The PoseOverrideField's to copy
+ * @param pose The natural pose, which receives the copied fields
+ */
+void MergeDriverPose(const vr::DriverPose_t& overriddenPose, uint32_t fieldMask, vr::DriverPose_t& pose);
+
+/**
+ * @brief Copies the overridden bone transforms selected by a bone mask over natural bone transforms
+ * @param overriddenTransforms Pointer to the 31 overridden bone transforms
+ * @param boneMask The bones to copy, where bit i selects bone i
+ * @param count The number of natural bone transforms
+ * @param transforms Pointer to the natural bone transforms, which receive the copied bones
+ */
+void MergeBoneTransforms(
+	const vr::VRBoneTransform_t* overriddenTransforms,
+	uint32_t boneMask,
+	uint32_t count,
+	vr::VRBoneTransform_t* transforms
+);
\ No newline at end of file
@@ -24,7 +24,8 @@ public:
 
 private:
 	/**
-	 * @brief Checks for connect and disconnect events from OpenVR, currently unused
+	 * @brief Handles the device activation and deactivation events OpenVR sent to the Conduit driver since the last
+	 * call. Events are read past the PollNextEvent hook, so they never take pulses meant for other drivers
 	 */
 	void pollEvents();
 };
\ No newline at end of file
@@ -0,0 +1,411 @@
+#include "AnimationPlayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Returns the size in bytes of a single keyframe of a track type, or 0 if the type is invalid
+ */
+static size_t getKeyframeSize(AnimationTrackType type) {
+	switch (type) {
+		case AnimationTrack_Pose: return sizeof(PoseKeyframe);
+		case AnimationTrack_Scalar: return sizeof(ScalarKeyframe);
+		case AnimationTrack_Skeleton: return sizeof(SkeletonKeyframe);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Spherically interpolates between two single precision bone orientations
+ */
+static vr::HmdQuaternionf_t slerpBoneOrientation(
+	const vr::HmdQuaternionf_t& a,
+	const vr::HmdQuaternionf_t& b,
+	double t
+) {
+	vr::HmdQuaternion_t result = SlerpQuaternions({ a.w, a.x, a.y, a.z }, { b.w, b.x, b.y, b.z }, t);
+	return { (float)result.w, (float)result.x, (float)result.y, (float)result.z };
+}
+
+AnimationPlayer& AnimationPlayer::getInstance() {
+	static AnimationPlayer instance;
+	return instance;
+}
+
+bool AnimationPlayer::loadTrack(
+	uint32_t trackId,
+	AnimationTrackType type,
+	const uint8_t* keyframes,
+	uint32_t keyframeCount
+) {
+	size_t keyframeSize = getKeyframeSize(type);
+	if (trackId >= MAX_ANIMATION_TRACKS || keyframeSize == 0 || keyframeCount == 0) return false;
+	if (static_cast<uint64_t>(keyframeSize) * keyframeCount > ANIMATION_TRACK_SLOT_SIZE) return false;
+
+	auto track = std::make_shared<AnimationTrack>();
+	track->type = type;
+	track->times.resize(keyframeCount);
+
+	// The slot stays writable by the client, so keyframes are copied out once and only the copies are validated
+	switch (type) {
+		case AnimationTrack_Pose: {
+			std::vector<PoseKeyframe> source(keyframeCount);
+			memcpy(source.data(), keyframes, keyframeSize * keyframeCount);
+
+			std::vector<DevicePose> poses(keyframeCount);
+			for (uint32_t i = 0; i < keyframeCount; i++) {
+				track->times[i] = source[i].time;
+				poses[i] = source[i].pose;
+			}
+
+			track->poses.resize(keyframeCount);
+			ToDriverPoses(poses.data(), keyframeCount, track->poses.data());
+			break;
+		}
+		case AnimationTrack_Scalar: {
+			std::vector<ScalarKeyframe> source(keyframeCount);
+			memcpy(source.data(), keyframes, keyframeSize * keyframeCount);
+
+			track->scalars.resize(keyframeCount);
+			for (uint32_t i = 0; i < keyframeCount; i++) {
+				track->times[i] = source[i].time;
+				track->scalars[i] = source[i].value;
+			}
+			break;
+		}
+		case AnimationTrack_Skeleton: {
+			std::vector<SkeletonKeyframe> source(keyframeCount);
+			memcpy(source.data(), keyframes, keyframeSize * keyframeCount);
+
+			track->skeletons.resize(keyframeCount);
+			for (uint32_t i = 0; i < keyframeCount; i++) {
+				const SkeletonInput& skeleton = source[i].skeleton;
+				if (skeleton.motionRange != VRSkeletalMotionRange_WithController &&
+					skeleton.motionRange != VRSkeletalMotionRange_WithoutController
+				) {
+					LogManager::log(LOG_ERROR, "Animation track {} has an invalid motion range at {}", trackId, i);
+					return false;
+				}
+
+				SkeletonFrame& frame = track->skeletons[i];
+				frame.motionRange = static_cast<vr::EVRSkeletalMotionRange>(skeleton.motionRange);
+				frame.boneCount = (std::min)(skeleton.boneTransformCount, 31U);
+				ToVRBoneTransforms(skeleton, frame.bones);
+				track->times[i] = source[i].time;
+			}
+			break;
+		}
+	}
+
+	for (uint32_t i = 0; i < keyframeCount; i++) {
+		if (!std::isfinite(track->times[i]) || (i > 0 && track->times[i] < track->times[i - 1])) {
+			LogManager::log(LOG_ERROR, "Animation track {} has an unsorted keyframe time at {}", trackId, i);
+			return false;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(this->playerMutex);
+	this->tracks[trackId] = std::move(track);
+	return true;
+}
+
+bool AnimationPlayer::playPoseTrack(uint32_t deviceIndex, uint32_t trackId, const AnimationPlaybackConfig& config) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return false;
+
+	std::lock_guard<std::mutex> lock(this->playerMutex);
+
+	if (trackId != NO_ANIMATION_TRACK) {
+		if (trackId >= MAX_ANIMATION_TRACKS || !this->tracks[trackId]) return false;
+		if (this->tracks[trackId]->type != AnimationTrack_Pose) return false;
+	}
+
+	bool active = this->startPlayback(this->posePlaybacks[deviceIndex], trackId, config);
+	this->posePlaybackActive[deviceIndex].store(active, std::memory_order_release);
+	return true;
+}
+
+bool AnimationPlayer::playInputTrack(
+	vr::VRInputComponentHandle_t componentHandle,
+	AnimationTrackType type,
+	uint32_t trackId,
+	const AnimationPlaybackConfig& config
+) {
+	std::lock_guard<std::mutex> lock(this->playerMutex);
+
+	if (trackId != NO_ANIMATION_TRACK) {
+		if (trackId >= MAX_ANIMATION_TRACKS || !this->tracks[trackId]) return false;
+		if (this->tracks[trackId]->type != type) return false;
+	} else if (this->inputPlaybacks.find(componentHandle) == this->inputPlaybacks.end()) {
+		return true;
+	}
+
+	if (!this->startPlayback(this->inputPlaybacks[componentHandle], trackId, config)) {
+		this->inputPlaybacks.erase(componentHandle);
+	}
+
+	this->inputPlaybackCount.store(static_cast<uint32_t>(this->inputPlaybacks.size()), std::memory_order_release);
+	return true;
+}
+
+bool AnimationPlayer::startPlayback(Playback& playback, uint32_t trackId, const AnimationPlaybackConfig& config) {
+	auto now = std::chrono::steady_clock::now();
+
+	if (trackId == NO_ANIMATION_TRACK) {
+		if (!playback.track) return false;
+		if (playback.stopping) return true;
+
+		SamplePoint point;
+		if (!locate(playback, point) || config.blendOutSeconds <= 0.0) {
+			playback = Playback{};
+			return false;
+		}
+
+		playback.stopping = true;
+		playback.stopTime = now;
+		playback.stopWeight = point.weight;
+		playback.config.blendOutSeconds = config.blendOutSeconds;
+		return true;
+	}
+
+	playback = Playback{};
+	playback.track = this->tracks[trackId];
+	playback.config = config;
+	playback.config.speed = (std::max)(config.speed, 0.0);
+	playback.startTime = now;
+	return true;
+}
+
+bool AnimationPlayer::locate(Playback& playback, SamplePoint& point) {
+	auto now = std::chrono::steady_clock::now();
+	const AnimationPlaybackConfig& config = playback.config;
+	const std::vector<double>& times = playback.track->times;
+	uint32_t count = static_cast<uint32_t>(times.size());
+
+	double elapsed = std::chrono::duration<double>(now - playback.startTime).count();
+	double duration = times.back() - times.front();
+	double trackTime = elapsed * config.speed;
+
+	point.weight = config.blendInSeconds > 0.0 ? (std::min)(elapsed / config.blendInSeconds, 1.0) : 1.0;
+
+	if (config.mode == AnimationPlayback_Loop) {
+		trackTime = duration > 0.0 ? std::fmod(trackTime, duration) : 0.0;
+	} else {
+		if (trackTime >= duration) return false;
+
+		// One shots fade out over their final seconds, so they end on the natural state instead of jumping to it
+		if (config.blendOutSeconds > 0.0 && config.speed > 0.0) {
+			double remaining = (duration - trackTime) / config.speed;
+			point.weight = (std::min)(point.weight, remaining / config.blendOutSeconds);
+		}
+	}
+
+	if (playback.stopping) {
+		double sinceStop = std::chrono::duration<double>(now - playback.stopTime).count();
+		if (sinceStop >= config.blendOutSeconds) return false;
+
+		point.weight = (std::min)(point.weight, playback.stopWeight * (1.0 - sinceStop / config.blendOutSeconds));
+	}
+
+	// The cursor only moves forward between samples, and only restarts from the front when a loop wraps around
+	double sampleTime = times.front() + trackTime;
+	uint32_t& cursor = playback.cursor;
+	if (cursor >= count || times[cursor] > sampleTime) cursor = 0;
+	while (cursor + 1 < count && times[cursor + 1] <= sampleTime) cursor++;
+
+	point.index = cursor;
+	point.next = (std::min)(cursor + 1, count - 1);
+
+	double span = times[point.next] - times[point.index];
+	point.t = span > 0.0 ? std::clamp((sampleTime - times[point.index]) / span, 0.0, 1.0) : 0.0;
+	if (config.interpolation == AnimationInterpolation_Step) point.t = 0.0;
+
+	return true;
+}
+
+double AnimationPlayer::interpolateCubic(double p0, double p1, double p2, double p3, double t) {
+	double t2 = t * t;
+	double t3 = t2 * t;
+
+	return 0.5 * (
+		2.0 * p1 +
+		(p2 - p0) * t +
+		(2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * t2 +
+		(3.0 * p1 - p0 - 3.0 * p2 + p3) * t3
+	);
+}
+
+bool AnimationPlayer::samplePose(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return false;
+	if (!this->posePlaybackActive[deviceIndex].load(std::memory_order_acquire)) return false;
+
+	std::lock_guard<std::mutex> lock(this->playerMutex);
+
+	Playback& playback = this->posePlaybacks[deviceIndex];
+	if (!playback.track) return false;
+
+	SamplePoint point;
+	if (!locate(playback, point)) {
+		playback = Playback{};
+		this->posePlaybackActive[deviceIndex].store(false, std::memory_order_release);
+		return false;
+	}
+
+	const AnimationTrack& track = *playback.track;
+	const vr::DriverPose_t& from = track.poses[point.index];
+	const vr::DriverPose_t& to = track.poses[point.next];
+
+	outPose = from;
+
+	if (playback.config.interpolation == AnimationInterpolation_Cubic) {
+		const vr::DriverPose_t& before = track.poses[point.index > 0 ? point.index - 1 : 0];
+		const vr::DriverPose_t& after = track.poses[(std::min)(point.next + 1, (uint32_t)track.poses.size() - 1)];
+
+		for (int axis = 0; axis < 3; axis++) {
+			outPose.vecPosition[axis] = interpolateCubic(
+				before.vecPosition[axis],
+				from.vecPosition[axis],
+				to.vecPosition[axis],
+				after.vecPosition[axis],
+				point.t
+			);
+		}
+	} else {
+		for (int axis = 0; axis < 3; axis++) {
+			double delta = to.vecPosition[axis] - from.vecPosition[axis];
+			outPose.vecPosition[axis] = from.vecPosition[axis] + delta * point.t;
+		}
+	}
+
+	outPose.qRotation = SlerpQuaternions(from.qRotation, to.qRotation, point.t);
+
+	// The runtime extrapolates poses with their velocity, so report the motion of the track rather than the keyframe's
+	double span = (track.times[point.next] - track.times[point.index]) / (std::max)(playback.config.speed, 1e-6);
+	if (playback.config.interpolation != AnimationInterpolation_Step && span > 0.0) {
+		for (int axis = 0; axis < 3; axis++) {
+			outPose.vecVelocity[axis] = (to.vecPosition[axis] - from.vecPosition[axis]) / span;
+		}
+	}
+
+	if (point.weight < 1.0) {
+		double weight = (std::max)(point.weight, 0.0);
+
+		auto blend = [weight](double natural, double animated) { return natural + (animated - natural) * weight; };
+
+		for (int axis = 0; axis < 3; axis++) {
+			outPose.vecPosition[axis] = blend(pose.vecPosition[axis], outPose.vecPosition[axis]);
+			outPose.vecVelocity[axis] = blend(pose.vecVelocity[axis], outPose.vecVelocity[axis]);
+			outPose.vecAngularVelocity[axis] = blend(pose.vecAngularVelocity[axis], outPose.vecAngularVelocity[axis]);
+		}
+
+		outPose.qRotation = SlerpQuaternions(pose.qRotation, outPose.qRotation, weight);
+	}
+
+	return true;
+}
+
+bool AnimationPlayer::sampleScalar(vr::VRInputComponentHandle_t componentHandle, float& value) {
+	if (this->inputPlaybackCount.load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->playerMutex);
+
+	auto it = this->inputPlaybacks.find(componentHandle);
+	if (it == this->inputPlaybacks.end() || it->second.track->type != AnimationTrack_Scalar) return false;
+
+	Playback& playback = it->second;
+
+	SamplePoint point;
+	if (!locate(playback, point)) {
+		this->inputPlaybacks.erase(it);
+		this->inputPlaybackCount.store(static_cast<uint32_t>(this->inputPlaybacks.size()), std::memory_order_release);
+		return false;
+	}
+
+	const std::vector<float>& scalars = playback.track->scalars;
+	double from = scalars[point.index];
+	double to = scalars[point.next];
+
+	double animated;
+	if (playback.config.interpolation == AnimationInterpolation_Cubic) {
+		double before = scalars[point.index > 0 ? point.index - 1 : 0];
+		double after = scalars[(std::min)(point.next + 1, (uint32_t)scalars.size() - 1)];
+		animated = interpolateCubic(before, from, to, after, point.t);
+	} else {
+		animated = from + (to - from) * point.t;
+	}
+
+	double weight = std::clamp(point.weight, 0.0, 1.0);
+	value = static_cast<float>(value + (animated - value) * weight);
+	return true;
+}
+
+bool AnimationPlayer::sampleSkeleton(
+	vr::VRInputComponentHandle_t componentHandle,
+	const vr::VRBoneTransform_t* transforms,
+	uint32_t transformCount,
+	vr::EVRSkeletalMotionRange& motionRange,
+	vr::VRBoneTransform_t* outTransforms,
+	uint32_t& outTransformCount
+) {
+	if (this->inputPlaybackCount.load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->playerMutex);
+
+	auto it = this->inputPlaybacks.find(componentHandle);
+	if (it == this->inputPlaybacks.end() || it->second.track->type != AnimationTrack_Skeleton) return false;
+
+	Playback& playback = it->second;
+
+	SamplePoint point;
+	if (!locate(playback, point)) {
+		this->inputPlaybacks.erase(it);
+		this->inputPlaybackCount.store(static_cast<uint32_t>(this->inputPlaybacks.size()), std::memory_order_release);
+		return false;
+	}
+
+	const std::vector<SkeletonFrame>& frames = playback.track->skeletons;
+	const SkeletonFrame& from = frames[point.index];
+	const SkeletonFrame& to = frames[point.next];
+	const SkeletonFrame& before = frames[point.index > 0 ? point.index - 1 : 0];
+	const SkeletonFrame& after = frames[(std::min)(point.next + 1, (uint32_t)frames.size() - 1)];
+
+	bool cubic = playback.config.interpolation == AnimationInterpolation_Cubic;
+	uint32_t boneCount = (std::min)(from.boneCount, to.boneCount);
+	if (cubic) boneCount = (std::min)({ boneCount, before.boneCount, after.boneCount });
+
+	for (uint32_t bone = 0; bone < boneCount; bone++) {
+		vr::VRBoneTransform_t& out = outTransforms[bone];
+
+		for (int axis = 0; axis < 4; axis++) {
+			double p0 = before.bones[bone].position.v[axis];
+			double p1 = from.bones[bone].position.v[axis];
+			double p2 = to.bones[bone].position.v[axis];
+			double p3 = after.bones[bone].position.v[axis];
+			double position = cubic ? interpolateCubic(p0, p1, p2, p3, point.t) : p1 + (p2 - p1) * point.t;
+			out.position.v[axis] = static_cast<float>(position);
+		}
+
+		out.orientation = slerpBoneOrientation(from.bones[bone].orientation, to.bones[bone].orientation, point.t);
+	}
+
+	if (point.weight < 1.0) {
+		double weight = (std::max)(point.weight, 0.0);
+
+		for (uint32_t bone = 0; bone < (std::min)(boneCount, transformCount); bone++) {
+			vr::VRBoneTransform_t& out = outTransforms[bone];
+			const vr::VRBoneTransform_t& natural = transforms[bone];
+
+			for (int axis = 0; axis < 4; axis++) {
+				double position = natural.position.v[axis] + (out.position.v[axis] - natural.position.v[axis]) * weight;
+				out.position.v[axis] = static_cast<float>(position);
+			}
+
+			out.orientation = slerpBoneOrientation(natural.orientation, out.orientation, weight);
+		}
+	}
+
+	motionRange = from.motionRange;
+	outTransformCount = boneCount;
+	return true;
+}
@@ -0,0 +1,75 @@
+#include "CommandScheduler.h"
+#include "SharedDeviceMemoryDriver.h"
+#include "DeviceStateModelDriver.h"
+
+#include <algorithm>
+
+CommandScheduler& CommandScheduler::getInstance() {
+	static CommandScheduler instance;
+	return instance;
+}
+
+int64_t CommandScheduler::now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+}
+
+bool CommandScheduler::schedule(const ClientCommandHeaderData& header, std::unique_ptr<uint8_t[]> params) {
+	std::lock_guard<std::mutex> lock(this->heapMutex);
+
+	if (this->heap.size() >= MAX_SCHEDULED_COMMANDS) return false;
+
+	this->heap.emplace_back(header, std::move(params));
+	std::push_heap(this->heap.begin(), this->heap.end(), isLater);
+
+	this->nextApplyTime.store(this->heap.front().first.applyTimeNanoseconds, std::memory_order_release);
+	return true;
+}
+
+void CommandScheduler::applyDueCommands() {
+	int64_t nextTime = this->nextApplyTime.load(std::memory_order_acquire);
+	if (nextTime == INT64_MAX) return;
+
+	int64_t currentTime = now();
+	if (currentTime < nextTime) return;
+
+	// Whoever holds the lock is already applying the due commands, so other hooks carry on instead of queueing
+	std::unique_lock<std::mutex> applyLock(this->applyMutex, std::try_to_lock);
+	if (!applyLock.owns_lock()) return;
+
+	// Popping under the batch mutex keeps a batch that is still being scheduled from being applied in halves
+	std::unique_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+
+	std::vector<std::pair<ClientCommandHeaderData, std::unique_ptr<uint8_t[]>>> dueCommands;
+	{
+		std::lock_guard<std::mutex> lock(this->heapMutex);
+
+		while (!this->heap.empty() && this->heap.front().first.applyTimeNanoseconds <= currentTime) {
+			std::pop_heap(this->heap.begin(), this->heap.end(), isLater);
+			dueCommands.push_back(std::move(this->heap.back()));
+			this->heap.pop_back();
+		}
+
+		this->nextApplyTime.store(
+			this->heap.empty() ? INT64_MAX : this->heap.front().first.applyTimeNanoseconds,
+			std::memory_order_release
+		);
+	}
+
+	SharedDeviceMemoryDriver& sharedMemory = SharedDeviceMemoryDriver::getInstance();
+	for (auto& dueCommand : dueCommands) {
+		sharedMemory.applyScheduledCommand(dueCommand.first, dueCommand.second.get());
+	}
+}
+
+bool CommandScheduler::isLater(
+	const std::pair<ClientCommandHeaderData, std::unique_ptr<uint8_t[]>>& a,
+	const std::pair<ClientCommandHeaderData, std::unique_ptr<uint8_t[]>>& b
+) {
+	if (a.first.applyTimeNanoseconds != b.first.applyTimeNanoseconds) {
+		return a.first.applyTimeNanoseconds > b.first.applyTimeNanoseconds;
+	}
+
+	return a.first.version > b.first.version;
+}
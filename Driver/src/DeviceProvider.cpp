@@ -4,14 +4,27 @@
 
 #include "LogManager.h"
 #include "SharedDeviceMemoryDriver.h"
+#include "HookUpdateQueue.h"
+#include "PluginManager.h"
 #include "main.h"
 
+/** @brief The section of steamvr.vrsettings holding the Conduit driver settings */
+static const char* const SETTINGS_SECTION = "driver_conduit";
+
 std::thread mainThread;
+std::thread hookUpdateThread;
 
 vr::EVRInitError DeviceProvider::Init(vr::IVRDriverContext* pDriverContext) {
 	vr::InitServerDriverContext(pDriverContext);
 
 	LogManager::initialize(); // Initialize Log manager
+
+	// Load the plugins listed in "plugins" before the hooks can call into them, none are loaded if the setting is unset
+	vr::EVRSettingsError pluginSettingsError = vr::VRSettingsError_None;
+	char pluginList[1024] = {};
+	vr::VRSettings()->GetString(SETTINGS_SECTION, "plugins", pluginList, sizeof(pluginList), &pluginSettingsError);
+	if (pluginSettingsError == vr::VRSettingsError_None) PluginManager::getInstance().loadPlugins(pluginList);
+
 	HookManager::initializeMinHook(); // Initialize MinHook
 	HookManager::setupHooks_IVRServerDriverHost((void*)vr::VRServerDriverHost()); // IVRServerDriverHost hooks
 	HookManager::setupHooks_IVRDriverInput((void*)vr::VRDriverInput()); // IVRDriverInput hooks
@@ -26,8 +39,19 @@ vr::EVRInitError DeviceProvider::Init(vr::IVRDriverContext* pDriverContext) {
 	}
 	HookManager::setupHooks_IVRProperties(pProperties);
 
-	// Initialize shared memory
-	bool sharedMemoryInitializationResult = SharedDeviceMemoryDriver::getInstance().initialize(); 
+	// Initialize shared memory, where locking it and mirroring the lanes are opt in through "lockSharedMemory" and
+	// "mirrorLanes", and off if the settings are unset
+	vr::EVRSettingsError settingsError = vr::VRSettingsError_None;
+	bool lockSharedMemory = vr::VRSettings()->GetBool(SETTINGS_SECTION, "lockSharedMemory", &settingsError);
+	if (settingsError != vr::VRSettingsError_None) lockSharedMemory = false;
+
+	bool mirrorLanes = vr::VRSettings()->GetBool(SETTINGS_SECTION, "mirrorLanes", &settingsError);
+	if (settingsError != vr::VRSettingsError_None) mirrorLanes = false;
+
+	bool sharedMemoryInitializationResult = SharedDeviceMemoryDriver::getInstance().initialize(
+		lockSharedMemory,
+		mirrorLanes
+	);
 
 	LogManager::log(LOG_INFO, "Shared memory initialization {0}", 
 		sharedMemoryInitializationResult ? "succeeded" : "failed"
@@ -37,6 +61,10 @@ vr::EVRInitError DeviceProvider::Init(vr::IVRDriverContext* pDriverContext) {
 	mainThread = std::thread([] { Main::getInstance().main(); });
 	mainThread.detach();
 
+	// Start the worker publishing the values queued by the hooks
+	hookUpdateThread = std::thread([] { HookUpdateQueue::getInstance().run(); });
+	hookUpdateThread.detach();
+
 	LogManager::log(LOG_INFO, "Initialized Device Provider");
 
 	return vr::VRInitError_None;
@@ -49,6 +77,8 @@ void DeviceProvider::Cleanup() {
 
 	MH_DisableHook(MH_ALL_HOOKS);
 	MH_Uninitialize();
+
+	PluginManager::getInstance().unloadPlugins();
 }
 
 const char* const* DeviceProvider::GetInterfaceVersions() {
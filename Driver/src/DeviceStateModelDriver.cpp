@@ -1,4 +1,12 @@
 #include "DeviceStateModelDriver.h"
+#include "TransformRuleManager.h"
+#include "InputFilterEngine.h"
+#include "PoseExtrapolator.h"
+#include "SmoothingFilterManager.h"
+#include "AnimationPlayer.h"
+#include "HapticsManager.h"
+
+#include <algorithm>
 
 DeviceStateModel& DeviceStateModel::getInstance() {
 	static DeviceStateModel instance;
@@ -9,14 +17,17 @@ void DeviceStateModel::addDeviceIndexToContainerMapping(
 	uint32_t deviceIndex,
 	vr::PropertyContainerHandle_t propertyContainer
 ) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	this->indexTable[deviceIndex] = propertyContainer;
 }
 
 void DeviceStateModel::removeDeviceIndexToContainerMapping(uint32_t deviceIndex) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	this->indexTable.erase(deviceIndex);
 }
 
 uint32_t DeviceStateModel::getDeviceIndexFromPropertyContainer(vr::PropertyContainerHandle_t propertyContainer) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto it = this->indexTable.begin(); it != this->indexTable.end(); it++) {
 		if (it->second == propertyContainer) return it->first;
 	}
@@ -25,41 +36,241 @@ uint32_t DeviceStateModel::getDeviceIndexFromPropertyContainer(vr::PropertyConta
 }
 
 vr::PropertyContainerHandle_t* DeviceStateModel::getPropertyContainerFromDeviceIndex(uint32_t deviceIndex) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it = this->indexTable.find(deviceIndex);
 	if (it != this->indexTable.end()) return &(it->second);
 
 	return nullptr;
 }
 
+/**
+ * @brief Looks up the component handle of an input in one of the per-type input maps
+ */
+template <typename InputMap>
+static bool findComponentHandle(
+	InputMap& inputs,
+	uint32_t deviceIndex,
+	const std::string& path,
+	vr::VRInputComponentHandle_t* componentHandle
+) {
+	auto it1 = inputs.find(deviceIndex);
+	if (it1 == inputs.end()) return false;
+
+	auto it2 = it1->second.find(path);
+	if (it2 == it1->second.end()) return false;
+
+	*componentHandle = it2->second.first;
+	return true;
+}
+
+bool DeviceStateModel::getComponentHandle(
+	uint32_t deviceIndex,
+	const std::string& path,
+	vr::VRInputComponentHandle_t* componentHandle
+) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
+	return findComponentHandle(this->booleanInputs, deviceIndex, path, componentHandle) ||
+		findComponentHandle(this->scalarInputs, deviceIndex, path, componentHandle) ||
+		findComponentHandle(this->skeletonInputs, deviceIndex, path, componentHandle) ||
+		findComponentHandle(this->poseInputs, deviceIndex, path, componentHandle) ||
+		findComponentHandle(this->eyeTrackingInputs, deviceIndex, path, componentHandle);
+}
+
+std::shared_mutex& DeviceStateModel::getBatchMutex() {
+	return this->batchMutex;
+}
+
+void DeviceStateModel::syncSnapshotToSharedMemory() {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
+	SharedDeviceMemoryDriver& sharedMemory = SharedDeviceMemoryDriver::getInstance();
+
+	for (auto& posePair : this->devicePoses) {
+		sharedMemory.syncDevicePoseUpdateToSharedMemory(&posePair.second.data, posePair.first);
+	}
+
+	for (auto& devicePair : this->booleanInputs) {
+		for (auto& pathPair : devicePair.second) {
+			sharedMemory.syncDeviceInputBooleanUpdateToSharedMemory(
+				&pathPair.second.second.data,
+				devicePair.first,
+				pathPair.first
+			);
+		}
+	}
+
+	for (auto& devicePair : this->scalarInputs) {
+		for (auto& pathPair : devicePair.second) {
+			sharedMemory.syncDeviceInputScalarUpdateToSharedMemory(
+				&pathPair.second.second.data,
+				devicePair.first,
+				pathPair.first
+			);
+		}
+	}
+
+	for (auto& devicePair : this->skeletonInputs) {
+		for (auto& pathPair : devicePair.second) {
+			sharedMemory.syncDeviceInputSkeletonUpdateToSharedMemory(
+				&pathPair.second.second.data,
+				devicePair.first,
+				pathPair.first
+			);
+		}
+	}
+
+	for (auto& devicePair : this->poseInputs) {
+		for (auto& pathPair : devicePair.second) {
+			sharedMemory.syncDeviceInputPoseUpdateToSharedMemory(
+				&pathPair.second.second.data,
+				devicePair.first,
+				pathPair.first
+			);
+		}
+	}
+
+	for (auto& devicePair : this->eyeTrackingInputs) {
+		for (auto& pathPair : devicePair.second) {
+			sharedMemory.syncDeviceInputEyeTrackingUpdateToSharedMemory(
+				&pathPair.second.second.data,
+				devicePair.first,
+				pathPair.first
+			);
+		}
+	}
+}
+
+/**
+ * @brief Removes every input of a device from one of the per-type input maps, collecting their component handles and
+ * publishing a removal packet for each
+ */
+template <typename InputMap>
+static void removeDeviceInputs(
+	InputMap& inputs,
+	uint32_t deviceIndex,
+	ObjectType type,
+	std::vector<vr::VRInputComponentHandle_t>& componentHandles
+) {
+	auto it = inputs.find(deviceIndex);
+	if (it == inputs.end()) return;
+
+	for (auto& pathPair : it->second) {
+		componentHandles.push_back(pathPair.second.first);
+		SharedDeviceMemoryDriver::getInstance().syncObjectRemovalToSharedMemory(type, deviceIndex, pathPair.first);
+	}
+
+	inputs.erase(it);
+}
+
+void DeviceStateModel::removeDevice(uint32_t deviceIndex) {
+	std::vector<vr::VRInputComponentHandle_t> componentHandles;
+	{
+		std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
+		removeDeviceInputs(this->booleanInputs, deviceIndex, Object_InputBoolean, componentHandles);
+		removeDeviceInputs(this->scalarInputs, deviceIndex, Object_InputScalar, componentHandles);
+		removeDeviceInputs(this->skeletonInputs, deviceIndex, Object_InputSkeleton, componentHandles);
+		removeDeviceInputs(this->poseInputs, deviceIndex, Object_InputPose, componentHandles);
+		removeDeviceInputs(this->eyeTrackingInputs, deviceIndex, Object_InputEyeTracking, componentHandles);
+
+		for (vr::VRInputComponentHandle_t componentHandle : componentHandles) {
+			this->overriddenBoneTransforms.erase(componentHandle);
+			this->overriddenBoneMasks.erase(componentHandle);
+		}
+	}
+
+	// Component handles are never reused, so anything keyed by them would otherwise stay around forever
+	for (vr::VRInputComponentHandle_t componentHandle : componentHandles) {
+		TransformRuleManager::getInstance().setInputRules(componentHandle, nullptr, 0);
+		InputFilterEngine::getInstance().loadProgram(componentHandle, false, nullptr, 0, nullptr, 0);
+		SmoothingFilterManager::getInstance().setScalarFilter(componentHandle, SmoothingFilterConfig{});
+		AnimationPlayer::getInstance().playInputTrack(
+			componentHandle,
+			AnimationTrack_Scalar,
+			NO_ANIMATION_TRACK,
+			AnimationPlaybackConfig{}
+		);
+	}
+
+	// A device activated later at the same index starts from scratch, like a freshly added device
+	if (deviceIndex < vr::k_unMaxTrackedDeviceCount) {
+		TransformRuleManager::getInstance().setPoseRules(deviceIndex, nullptr, 0);
+		SmoothingFilterManager::getInstance().setPoseFilter(deviceIndex, SmoothingFilterConfig{});
+		AnimationPlayer::getInstance().playPoseTrack(deviceIndex, NO_ANIMATION_TRACK, AnimationPlaybackConfig{});
+		PoseExtrapolator::getInstance().setConfig(deviceIndex, PoseExtrapolationConfig{});
+		this->overriddenDriverPoses[deviceIndex] = {};
+		this->overriddenPoseFieldMasks[deviceIndex] = PoseField_All;
+	}
+
+	this->removeDevicePose(deviceIndex);
+	this->removeDeviceIndexToContainerMapping(deviceIndex);
+	HapticsManager::getInstance().removeDevice(deviceIndex);
+	SharedDeviceMemoryDriver::getInstance().unregisterDevice(deviceIndex);
+
+	// Sent last and even if the device never sent a pose, since it tells clients the whole device is gone
+	SharedDeviceMemoryDriver::getInstance().syncObjectRemovalToSharedMemory(Object_DevicePose, deviceIndex, "");
+}
+
 ModelDevicePoseSerialized* DeviceStateModel::getDevicePose(uint32_t deviceIndex) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it = this->devicePoses.find(deviceIndex);
 	return it == this->devicePoses.end() ? nullptr : &(it->second);
 }
 
 void DeviceStateModel::setDevicePoseChanged(uint32_t deviceIndex) {
+	// The overridden pose is not sent from here, the pose hook applies it on the next update of the device
 	ModelDevicePoseSerialized* pose = this->getDevicePose(deviceIndex);
-	if (pose != nullptr) {
-		SharedDeviceMemoryDriver::getInstance().syncDevicePoseUpdateToSharedMemory(&pose->data, deviceIndex);
-
-		if (pose->useOverriddenState) {
-			callTrackedDevicePoseUpdated(
-				deviceIndex,
-				ToDriverPose(pose->data.overwrittenPose),
-				sizeof(vr::DriverPose_t)
-			);
-		}
-	}
+	if (pose == nullptr) return;
+
+	SharedDeviceMemoryDriver::getInstance().syncDevicePoseUpdateToSharedMemory(&pose->data, deviceIndex);
+}
+
+void DeviceStateModel::setOverriddenDevicePose(uint32_t deviceIndex, const DevicePose& pose, uint32_t fieldMask) {
+	ModelDevicePoseSerialized* modelPose = this->getDevicePose(deviceIndex);
+	if (modelPose == nullptr || deviceIndex >= vr::k_unMaxTrackedDeviceCount) return;
+
+	modelPose->data.overwrittenPose = pose;
+	ToDriverPoses(&pose, 1, &this->overriddenDriverPoses[deviceIndex]);
+	this->overriddenPoseFieldMasks[deviceIndex] = fieldMask;
+	PoseExtrapolator::getInstance().recordOverride(deviceIndex, this->overriddenDriverPoses[deviceIndex]);
+}
+
+const vr::DriverPose_t* DeviceStateModel::resolveOverriddenDriverPose(
+	uint32_t deviceIndex,
+	const vr::DriverPose_t& naturalPose,
+	vr::DriverPose_t& outPose
+) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return nullptr;
+
+	const vr::DriverPose_t* pose = &this->overriddenDriverPoses[deviceIndex];
+
+	// Dead reckoning carries the override forward between client updates
+	if (PoseExtrapolator::getInstance().extrapolate(deviceIndex, *pose, outPose)) pose = &outPose;
+
+	// Partial overrides keep tracking the natural pose outside their field mask
+	uint32_t fieldMask = this->overriddenPoseFieldMasks[deviceIndex];
+	if (fieldMask == PoseField_All) return pose;
+
+	vr::DriverPose_t overriddenPose = *pose;
+	outPose = naturalPose;
+	MergeDriverPose(overriddenPose, fieldMask, outPose);
+	return &outPose;
 }
 
 void DeviceStateModel::addDevicePose(uint32_t deviceIndex) {
-	this->devicePoses[deviceIndex];
+	{
+		std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
+		this->devicePoses[deviceIndex];
+	}
+
+	if (deviceIndex < vr::k_unMaxTrackedDeviceCount) this->overriddenPoseFieldMasks[deviceIndex] = PoseField_All;
 }
 
 void DeviceStateModel::removeDevicePose(uint32_t deviceIndex) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	this->devicePoses.erase(deviceIndex);
 }
 
 ModelDeviceInputBooleanSerialized* DeviceStateModel::getBooleanInput(uint32_t deviceIndex, const std::string& path) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it1 = this->booleanInputs.find(deviceIndex);
 	if (it1 == this->booleanInputs.end()) return nullptr;
 
@@ -68,6 +279,7 @@ ModelDeviceInputBooleanSerialized* DeviceStateModel::getBooleanInput(uint32_t de
 }
 
 ModelDeviceInputBooleanSerialized* DeviceStateModel::getBooleanInput(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->booleanInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) return &(pathPair.second.second);
@@ -78,31 +290,19 @@ ModelDeviceInputBooleanSerialized* DeviceStateModel::getBooleanInput(vr::VRInput
 }
 
 void DeviceStateModel::setInputBooleanChanged(uint32_t deviceIndex, const std::string& path) {
+	// The overridden value is not sent from here, the boolean hook applies it on the next update of the component
 	ModelDeviceInputBooleanSerialized* inputBoolean = this->getBooleanInput(deviceIndex, path);
-	if (inputBoolean != nullptr) {
-		SharedDeviceMemoryDriver::getInstance().syncDeviceInputBooleanUpdateToSharedMemory(
-			&inputBoolean->data,
-			deviceIndex, 
-			path
-		);
+	if (inputBoolean == nullptr) return;
 
-		if (inputBoolean->useOverriddenState) {
-			callUpdateBooleanComponent(
-				this->booleanInputs[deviceIndex][path].first,
-				inputBoolean->data.overwrittenValue.value,
-				inputBoolean->data.overwrittenValue.timeOffset
-			);
-		} else {
-			callUpdateBooleanComponent(
-				this->booleanInputs[deviceIndex][path].first,
-				inputBoolean->data.value.value,
-				inputBoolean->data.value.timeOffset
-			);
-		}
-	}
+	SharedDeviceMemoryDriver::getInstance().syncDeviceInputBooleanUpdateToSharedMemory(
+		&inputBoolean->data,
+		deviceIndex,
+		path
+	);
 }
 
 void DeviceStateModel::setInputBooleanChanged(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->booleanInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) {
@@ -124,15 +324,18 @@ void DeviceStateModel::addBooleanInput(
 	const std::string& path,
 	vr::VRInputComponentHandle_t* componentHandle
 ) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	this->booleanInputs[deviceIndex][path] = std::make_pair(*componentHandle, ModelDeviceInputBooleanSerialized{});
 }
 
 void DeviceStateModel::removeBooleanInput(uint32_t deviceIndex, const std::string& path) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it = this->booleanInputs.find(deviceIndex);
 	if (it != this->booleanInputs.end()) it->second.erase(path);
 }
 
 ModelDeviceInputScalarSerialized* DeviceStateModel::getScalarInput(uint32_t deviceIndex, const std::string& path) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it1 = this->scalarInputs.find(deviceIndex);
 	if (it1 == this->scalarInputs.end()) return nullptr;
 
@@ -141,6 +344,7 @@ ModelDeviceInputScalarSerialized* DeviceStateModel::getScalarInput(uint32_t devi
 }
 
 ModelDeviceInputScalarSerialized* DeviceStateModel::getScalarInput(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->scalarInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) return &(pathPair.second.second);
@@ -151,31 +355,19 @@ ModelDeviceInputScalarSerialized* DeviceStateModel::getScalarInput(vr::VRInputCo
 }
 
 void DeviceStateModel::setInputScalarChanged(uint32_t deviceIndex, const std::string& path) {
+	// The overridden value is not sent from here, the scalar hook applies it on the next update of the component
 	ModelDeviceInputScalarSerialized* inputScalar = this->getScalarInput(deviceIndex, path);
-	if (inputScalar != nullptr) {
-		SharedDeviceMemoryDriver::getInstance().syncDeviceInputScalarUpdateToSharedMemory(
-			&inputScalar->data,
-			deviceIndex,
-			path
-		);
+	if (inputScalar == nullptr) return;
 
-		if (inputScalar->useOverriddenState) {
-			callUpdateScalarComponent(
-				this->scalarInputs[deviceIndex][path].first,
-				inputScalar->data.overwrittenValue.value,
-				inputScalar->data.overwrittenValue.timeOffset
-			);
-		} else {
-			callUpdateScalarComponent(
-				this->scalarInputs[deviceIndex][path].first,
-				inputScalar->data.value.value,
-				inputScalar->data.value.timeOffset
-			);
-		}
-	}
+	SharedDeviceMemoryDriver::getInstance().syncDeviceInputScalarUpdateToSharedMemory(
+		&inputScalar->data,
+		deviceIndex,
+		path
+	);
 }
 
 void DeviceStateModel::setInputScalarChanged(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->scalarInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) {
@@ -193,16 +385,19 @@ void DeviceStateModel::setInputScalarChanged(vr::VRInputComponentHandle_t compon
 }
 
 void DeviceStateModel::addScalarInput(uint32_t deviceIndex, const std::string& path, vr::VRInputComponentHandle_t* componentHandle) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	this->scalarInputs[deviceIndex][path] = std::make_pair(*componentHandle, ModelDeviceInputScalarSerialized{});
 }
 
 void DeviceStateModel::removeScalarInput(uint32_t deviceIndex, const std::string& path) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it = this->scalarInputs.find(deviceIndex);
 
 	if (it != this->scalarInputs.end()) it->second.erase(path);
 }
 
 ModelDeviceInputSkeletonSerialized* DeviceStateModel::getSkeletonInput(uint32_t deviceIndex, const std::string& path) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it1 = this->skeletonInputs.find(deviceIndex);
 	if (it1 == this->skeletonInputs.end()) return nullptr;
 
@@ -211,6 +406,7 @@ ModelDeviceInputSkeletonSerialized* DeviceStateModel::getSkeletonInput(uint32_t
 }
 
 ModelDeviceInputSkeletonSerialized* DeviceStateModel::getSkeletonInput(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->skeletonInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) return &(pathPair.second.second);
@@ -220,37 +416,19 @@ ModelDeviceInputSkeletonSerialized* DeviceStateModel::getSkeletonInput(vr::VRInp
 }
 
 void DeviceStateModel::setInputSkeletonChanged(uint32_t deviceIndex, const std::string& path) {
+	// The overridden value is not sent from here, the skeleton hook applies it on the next update of the component
 	ModelDeviceInputSkeletonSerialized* inputSkeleton = this->getSkeletonInput(deviceIndex, path);
-	if (inputSkeleton != nullptr) {
-		SharedDeviceMemoryDriver::getInstance().syncDeviceInputSkeletonUpdateToSharedMemory(
-			&inputSkeleton->data,
-			deviceIndex,
-			path
-		);
+	if (inputSkeleton == nullptr) return;
 
-		if (inputSkeleton->useOverriddenState) { 
-			vr::VRBoneTransform_t transforms[31];
-			ToVRBoneTransforms(inputSkeleton->data.overwrittenValue, transforms);
-			callUpdateSkeletonComponent(
-				this->skeletonInputs[deviceIndex][path].first,
-				static_cast<vr::EVRSkeletalMotionRange>(inputSkeleton->data.overwrittenValue.motionRange),
-				transforms,
-				inputSkeleton->data.overwrittenValue.boneTransformCount
-			);
-		} else {
-			vr::VRBoneTransform_t transforms[31];
-			ToVRBoneTransforms(inputSkeleton->data.value, transforms);
-			callUpdateSkeletonComponent(
-				this->skeletonInputs[deviceIndex][path].first,
-				static_cast<vr::EVRSkeletalMotionRange>(inputSkeleton->data.value.motionRange),
-				transforms,
-				inputSkeleton->data.value.boneTransformCount
-			);
-		}
-	}
+	SharedDeviceMemoryDriver::getInstance().syncDeviceInputSkeletonUpdateToSharedMemory(
+		&inputSkeleton->data,
+		deviceIndex,
+		path
+	);
 }
 
 void DeviceStateModel::setInputSkeletonChanged(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->skeletonInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) {
@@ -267,20 +445,82 @@ void DeviceStateModel::setInputSkeletonChanged(vr::VRInputComponentHandle_t comp
 	}
 }
 
+void DeviceStateModel::setOverriddenSkeletonInput(
+	uint32_t deviceIndex,
+	const std::string& path,
+	const SkeletonInput& input,
+	uint32_t boneMask
+) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
+	auto it1 = this->skeletonInputs.find(deviceIndex);
+	if (it1 == this->skeletonInputs.end()) return;
+
+	auto it2 = it1->second.find(path);
+	if (it2 == it1->second.end()) return;
+
+	it2->second.second.data.overwrittenValue = input;
+
+	auto cached = this->overriddenBoneTransforms.find(it2->second.first);
+	if (cached != this->overriddenBoneTransforms.end()) ToVRBoneTransforms(input, cached->second.data());
+
+	auto cachedMask = this->overriddenBoneMasks.find(it2->second.first);
+	if (cachedMask != this->overriddenBoneMasks.end()) cachedMask->second = boneMask;
+}
+
+const vr::VRBoneTransform_t* DeviceStateModel::resolveOverriddenBoneTransforms(
+	vr::VRInputComponentHandle_t componentHandle,
+	const ModelDeviceInputSkeletonSerialized& input,
+	const vr::VRBoneTransform_t* transforms,
+	uint32_t& transformCount,
+	vr::EVRSkeletalMotionRange& motionRange,
+	vr::VRBoneTransform_t* outTransforms
+) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
+	auto cached = this->overriddenBoneTransforms.find(componentHandle);
+	auto cachedMask = this->overriddenBoneMasks.find(componentHandle);
+	if (cached == this->overriddenBoneTransforms.end() || cachedMask == this->overriddenBoneMasks.end()) return nullptr;
+
+	if (cachedMask->second == ALL_SKELETON_BONES) {
+		motionRange = static_cast<vr::EVRSkeletalMotionRange>(input.data.overwrittenValue.motionRange);
+		transformCount = input.data.overwrittenValue.boneTransformCount;
+		return cached->second.data();
+	}
+
+	// Partial overrides keep tracking the natural skeleton, replacing only the bones in their mask
+	transformCount = (std::min)(transformCount, 31U);
+	std::copy(transforms, transforms + transformCount, outTransforms);
+	MergeBoneTransforms(cached->second.data(), cachedMask->second, transformCount, outTransforms);
+	return outTransforms;
+}
+
 void DeviceStateModel::addSkeletonInput(
 	uint32_t deviceIndex,
 	const std::string& path,
 	vr::VRInputComponentHandle_t* componentHandle
 ) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	this->skeletonInputs[deviceIndex][path] = std::make_pair(*componentHandle, ModelDeviceInputSkeletonSerialized{});
+
+	// The cache entry is created here on the hook thread so overrides only ever write into an existing entry
+	this->overriddenBoneTransforms[*componentHandle] = {};
+	this->overriddenBoneMasks[*componentHandle] = ALL_SKELETON_BONES;
 }
 
 void DeviceStateModel::removeSkeletonInput(uint32_t deviceIndex, const std::string& path) {
-	auto it = this->skeletonInputs.find(deviceIndex);
-	if (it != this->skeletonInputs.end()) it->second.erase(path);
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
+	auto it1 = this->skeletonInputs.find(deviceIndex);
+	if (it1 == this->skeletonInputs.end()) return;
+
+	auto it2 = it1->second.find(path);
+	if (it2 == it1->second.end()) return;
+
+	this->overriddenBoneTransforms.erase(it2->second.first);
+	this->overriddenBoneMasks.erase(it2->second.first);
+	it1->second.erase(it2);
 }
 
 ModelDeviceInputPoseSerialized* DeviceStateModel::getPoseInput(uint32_t deviceIndex, const std::string& path) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it1 = this->poseInputs.find(deviceIndex);
 	if (it1 == this->poseInputs.end()) return nullptr;
 
@@ -289,6 +529,7 @@ ModelDeviceInputPoseSerialized* DeviceStateModel::getPoseInput(uint32_t deviceIn
 }
 
 ModelDeviceInputPoseSerialized* DeviceStateModel::getPoseInput(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->poseInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) return &(pathPair.second.second);
@@ -299,29 +540,19 @@ ModelDeviceInputPoseSerialized* DeviceStateModel::getPoseInput(vr::VRInputCompon
 }
 
 void DeviceStateModel::setInputPoseChanged(uint32_t deviceIndex, const std::string& path) {
+	// The overridden value is not sent from here, the pose hook applies it on the next update of the component
 	ModelDeviceInputPoseSerialized* inputPose = this->getPoseInput(deviceIndex, path);
-	if (inputPose != nullptr) {
-		SharedDeviceMemoryDriver::getInstance().syncDeviceInputPoseUpdateToSharedMemory(&inputPose->data, deviceIndex, path);
-
-		if (inputPose->useOverriddenState) {
-			vr::HmdMatrix34_t poseOffset = ToHmdMatrix34(inputPose->data.overwrittenValue.poseOffset);
-			callUpdatePoseComponent(
-				this->poseInputs[deviceIndex][path].first,
-				&poseOffset,
-				inputPose->data.overwrittenValue.timeOffset
-			);
-		} else {
-			vr::HmdMatrix34_t poseOffset = ToHmdMatrix34(inputPose->data.value.poseOffset);
-			callUpdatePoseComponent(
-				this->poseInputs[deviceIndex][path].first,
-				&poseOffset,
-				inputPose->data.value.timeOffset
-			);
-		}
-	}
+	if (inputPose == nullptr) return;
+
+	SharedDeviceMemoryDriver::getInstance().syncDeviceInputPoseUpdateToSharedMemory(
+		&inputPose->data,
+		deviceIndex,
+		path
+	);
 }
 
 void DeviceStateModel::setInputPoseChanged(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->poseInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) {
@@ -343,10 +574,12 @@ void DeviceStateModel::addPoseInput(
 	const std::string& path,
 	vr::VRInputComponentHandle_t* componentHandle
 ) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	this->poseInputs[deviceIndex][path] = std::make_pair(*componentHandle, ModelDeviceInputPoseSerialized{});
 }
 
 void DeviceStateModel::removePoseInput(uint32_t deviceIndex, const std::string& path) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it = this->poseInputs.find(deviceIndex);
 	if (it != this->poseInputs.end()) it->second.erase(path);
 }
@@ -355,6 +588,7 @@ ModelDeviceInputEyeTrackingSerialized* DeviceStateModel::getEyeTrackingInput(
 	uint32_t deviceIndex,
 	const std::string& path
 ) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it1 = this->eyeTrackingInputs.find(deviceIndex);
 	if (it1 == this->eyeTrackingInputs.end()) return nullptr;
 
@@ -365,6 +599,7 @@ ModelDeviceInputEyeTrackingSerialized* DeviceStateModel::getEyeTrackingInput(
 ModelDeviceInputEyeTrackingSerialized* DeviceStateModel::getEyeTrackingInput(
 	vr::VRInputComponentHandle_t componentHandle
 ) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->eyeTrackingInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) return &(pathPair.second.second);
@@ -375,35 +610,19 @@ ModelDeviceInputEyeTrackingSerialized* DeviceStateModel::getEyeTrackingInput(
 }
 
 void DeviceStateModel::setInputEyeTrackingChanged(uint32_t deviceIndex, const std::string& path) {
+	// The overridden value is not sent from here, the eye tracking hook applies it on the next update of the component
 	ModelDeviceInputEyeTrackingSerialized* inputEyeTracking = this->getEyeTrackingInput(deviceIndex, path);
-	if (inputEyeTracking != nullptr) {
-		SharedDeviceMemoryDriver::getInstance().syncDeviceInputEyeTrackingUpdateToSharedMemory(
-			&inputEyeTracking->data,
-			deviceIndex,
-			path
-		);
+	if (inputEyeTracking == nullptr) return;
 
-		if (inputEyeTracking->useOverriddenState) {
-			vr::VREyeTrackingData_t eyeData = ToVREyeTrackingData(
-				inputEyeTracking->data.overwrittenValue.eyeTrackingData
-			);
-			callUpdateEyeTrackingComponent(
-				this->eyeTrackingInputs[deviceIndex][path].first,
-				&eyeData,
-				inputEyeTracking->data.overwrittenValue.timeOffset
-			);
-		} else {
-			vr::VREyeTrackingData_t eyeData = ToVREyeTrackingData(inputEyeTracking->data.value.eyeTrackingData);
-			callUpdateEyeTrackingComponent(
-				this->eyeTrackingInputs[deviceIndex][path].first,
-				&eyeData,
-				inputEyeTracking->data.value.timeOffset
-			);
-		}
-	}
+	SharedDeviceMemoryDriver::getInstance().syncDeviceInputEyeTrackingUpdateToSharedMemory(
+		&inputEyeTracking->data,
+		deviceIndex,
+		path
+	);
 }
 
 void DeviceStateModel::setInputEyeTrackingChanged(vr::VRInputComponentHandle_t componentHandle) {
+	std::shared_lock<std::shared_mutex> structureLock(this->structureMutex);
 	for (auto& devicePair : this->eyeTrackingInputs) {
 		for (auto& pathPair : devicePair.second) {
 			if (pathPair.second.first == componentHandle) {
@@ -425,6 +644,7 @@ void DeviceStateModel::addEyeTrackingInput(
 	const std::string& path,
 	vr::VRInputComponentHandle_t* componentHandle
 ) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	this->eyeTrackingInputs[deviceIndex][path] = std::make_pair(
 		*componentHandle,
 		ModelDeviceInputEyeTrackingSerialized{}
@@ -432,6 +652,7 @@ void DeviceStateModel::addEyeTrackingInput(
 }
 
 void DeviceStateModel::removeEyeTrackingInput(uint32_t deviceIndex, const std::string& path) {
+	std::unique_lock<std::shared_mutex> structureLock(this->structureMutex);
 	auto it = this->eyeTrackingInputs.find(deviceIndex);
 	if (it != this->eyeTrackingInputs.end()) it->second.erase(path);
 }
\ No newline at end of file
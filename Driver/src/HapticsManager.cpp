@@ -0,0 +1,198 @@
+#include "HapticsManager.h"
+#include "SharedDeviceMemoryDriver.h"
+#include "LogManager.h"
+
+#include <algorithm>
+
+/** @brief The number of injected vibrations kept for drivers that haven't polled yet, older ones are dropped */
+static const uint32_t MAX_PENDING_HAPTIC_PULSES = 64;
+
+HapticsManager& HapticsManager::getInstance() {
+	static HapticsManager instance;
+	return instance;
+}
+
+void HapticsManager::addHapticComponent(
+	uint32_t deviceIndex,
+	const std::string& path,
+	vr::PropertyContainerHandle_t containerHandle,
+	vr::VRInputComponentHandle_t componentHandle
+) {
+	if (componentHandle == vr::k_ulInvalidInputComponentHandle) return;
+
+	std::lock_guard<std::mutex> lock(this->hapticsMutex);
+
+	HapticComponent component;
+	component.deviceIndex = deviceIndex;
+	component.path = path;
+	component.containerHandle = containerHandle;
+	component.componentHandle = componentHandle;
+	this->components.push_back(component);
+}
+
+bool HapticsManager::setSuppressed(uint32_t deviceIndex, const std::string& path, bool suppressed) {
+	std::lock_guard<std::mutex> lock(this->hapticsMutex);
+
+	HapticComponent* component = this->findComponent(deviceIndex, path);
+	if (!component) return false;
+
+	component->suppressed = suppressed;
+	return true;
+}
+
+bool HapticsManager::injectPulse(
+	uint32_t deviceIndex,
+	const std::string& path,
+	float durationSeconds,
+	float frequency,
+	float amplitude
+) {
+	PendingPulse pulse;
+	vr::VRInputComponentHandle_t componentHandle;
+
+	{
+		std::lock_guard<std::mutex> lock(this->hapticsMutex);
+
+		HapticComponent* component = this->findComponent(deviceIndex, path);
+		if (!component) return false;
+
+		componentHandle = component->componentHandle;
+
+		pulse.host = component->host;
+		if (!pulse.host && deviceIndex < vr::k_unMaxTrackedDeviceCount) {
+			pulse.host = this->deviceHosts[deviceIndex].load(std::memory_order_acquire);
+		}
+		pulse.event.eventType = vr::VREvent_Input_HapticVibration;
+		pulse.event.trackedDeviceIndex = deviceIndex;
+		pulse.event.eventAgeSeconds = 0.0f;
+		pulse.event.data.hapticVibration.containerHandle = component->containerHandle;
+		pulse.event.data.hapticVibration.componentHandle = component->componentHandle;
+		pulse.event.data.hapticVibration.fDurationSeconds = durationSeconds;
+		pulse.event.data.hapticVibration.fFrequency = frequency;
+		pulse.event.data.hapticVibration.fAmplitude = amplitude;
+
+		if (this->pendingPulses.size() >= MAX_PENDING_HAPTIC_PULSES) {
+			LogManager::log(LOG_ERROR, "Too many pending haptic pulses, dropping the oldest");
+			this->pendingPulses.pop_front();
+		}
+
+		this->pendingPulses.push_back(pulse);
+		this->pendingPulseCount.store(static_cast<uint32_t>(this->pendingPulses.size()), std::memory_order_release);
+	}
+
+	// Injected pulses are published when they are queued, so clients see them even if the driver is slow to poll
+	SharedDeviceMemoryDriver& sharedMemory = SharedDeviceMemoryDriver::getInstance();
+	if (sharedMemory.isClientAttached()) {
+		sharedMemory.writeHapticEvent(
+			deviceIndex,
+			path,
+			componentHandle,
+			pulse.event.data.hapticVibration,
+			HapticEvent_Injected
+		);
+	}
+
+	return true;
+}
+
+void HapticsManager::recordDeviceHost(uint32_t deviceIndex, void* host) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return;
+
+	// Poses arrive every frame, so the host is only stored when it changes to keep the cache line shared
+	std::atomic<void*>& deviceHost = this->deviceHosts[deviceIndex];
+	if (deviceHost.load(std::memory_order_relaxed) != host) deviceHost.store(host, std::memory_order_release);
+}
+
+bool HapticsManager::processHapticEvent(void* host, const vr::VREvent_t& event) {
+	const vr::VREvent_HapticVibration_t& vibration = event.data.hapticVibration;
+
+	uint32_t deviceIndex = 0;
+	std::string path;
+	bool suppressed = false;
+
+	{
+		std::lock_guard<std::mutex> lock(this->hapticsMutex);
+
+		auto it = std::find_if(this->components.begin(), this->components.end(),
+			[&vibration](const HapticComponent& component) {
+				return component.componentHandle == vibration.componentHandle;
+			}
+		);
+
+		// Components created before the hooks were installed are passed through untouched
+		if (it == this->components.end()) return true;
+
+		it->host = host;
+		deviceIndex = it->deviceIndex;
+		path = it->path;
+		suppressed = it->suppressed;
+	}
+
+	SharedDeviceMemoryDriver& sharedMemory = SharedDeviceMemoryDriver::getInstance();
+	if (sharedMemory.isClientAttached()) {
+		sharedMemory.writeHapticEvent(
+			deviceIndex,
+			path,
+			vibration.componentHandle,
+			vibration,
+			suppressed ? HapticEvent_Suppressed : 0
+		);
+	}
+
+	return !suppressed;
+}
+
+bool HapticsManager::takeInjectedEvent(void* host, vr::VREvent_t& event) {
+	if (this->pendingPulseCount.load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->hapticsMutex);
+
+	// Pulses queued before the host of their device was known are resolved now, and otherwise keep waiting, since
+	// handing them to another driver would vibrate nothing or the wrong device
+	auto it = std::find_if(this->pendingPulses.begin(), this->pendingPulses.end(),
+		[this, host](PendingPulse& pulse) {
+			uint32_t deviceIndex = pulse.event.trackedDeviceIndex;
+			if (!pulse.host && deviceIndex < vr::k_unMaxTrackedDeviceCount) {
+				pulse.host = this->deviceHosts[deviceIndex].load(std::memory_order_acquire);
+			}
+
+			return pulse.host == host;
+		}
+	);
+	if (it == this->pendingPulses.end()) return false;
+
+	event = it->event;
+	this->pendingPulses.erase(it);
+	this->pendingPulseCount.store(static_cast<uint32_t>(this->pendingPulses.size()), std::memory_order_release);
+
+	return true;
+}
+
+void HapticsManager::removeDevice(uint32_t deviceIndex) {
+	if (deviceIndex < vr::k_unMaxTrackedDeviceCount) this->deviceHosts[deviceIndex].store(nullptr);
+
+	std::lock_guard<std::mutex> lock(this->hapticsMutex);
+
+	this->components.erase(
+		std::remove_if(this->components.begin(), this->components.end(),
+			[deviceIndex](const HapticComponent& component) { return component.deviceIndex == deviceIndex; }
+		),
+		this->components.end()
+	);
+
+	this->pendingPulses.erase(
+		std::remove_if(this->pendingPulses.begin(), this->pendingPulses.end(),
+			[deviceIndex](const PendingPulse& pulse) { return pulse.event.trackedDeviceIndex == deviceIndex; }
+		),
+		this->pendingPulses.end()
+	);
+	this->pendingPulseCount.store(static_cast<uint32_t>(this->pendingPulses.size()), std::memory_order_release);
+}
+
+HapticsManager::HapticComponent* HapticsManager::findComponent(uint32_t deviceIndex, const std::string& path) {
+	for (HapticComponent& component : this->components) {
+		if (component.deviceIndex == deviceIndex && component.path == path) return &component;
+	}
+
+	return nullptr;
+}
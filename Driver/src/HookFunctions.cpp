@@ -1,9 +1,20 @@
 #include "HookFunctions.h"
+#include "TransformRuleManager.h"
+#include "InputFilterEngine.h"
+#include "SmoothingFilterManager.h"
+#include "CommandScheduler.h"
+#include "AnimationPlayer.h"
+#include "HookUpdateQueue.h"
+#include "PluginManager.h"
+#include "HapticsManager.h"
+
+#include <cstddef>
 
 void* IVRServerDriverHost = nullptr;
 void* IVRDriverInput = nullptr;
 
 _TrackedDevicePoseUpdated originalTrackedDevicePoseUpdated = nullptr;
+_PollNextEvent originalPollNextEvent = nullptr;
 _CreateBooleanComponent originalCreateBooleanComponent = nullptr;
 _UpdateBooleanComponent originalUpdateBooleanComponent = nullptr;
 _CreateScalarComponent originalCreateScalarComponent = nullptr;
@@ -17,12 +28,42 @@ _CreateEyeTrackingComponent originalCreateEyeTrackingComponent = nullptr;
 _UpdateEyeTrackingComponent originalUpdateEyeTrackingComponent = nullptr;
 _TrackedDeviceToPropertyContainer originalTrackedDeviceToPropertyContainer = nullptr;
 
+/**
+ * @brief Describes a component for the device registry from the arguments of its create hook
+ * @param deviceIndex The device index of the device
+ * @param type The type of the component
+ * @param pchName The input path of the component
+ * @param pHandle The component handle written by the original create function
+ * @return The component metadata shared by every component type
+ */
+static ComponentInfo MakeComponentInfo(
+	uint32_t deviceIndex,
+	DeviceComponentType type,
+	const char* pchName,
+	const vr::VRInputComponentHandle_t* pHandle
+) {
+	ComponentInfo info;
+	info.deviceIndex = deviceIndex;
+	info.type = type;
+	info.path = pchName ? pchName : "";
+	info.componentHandle = pHandle ? *pHandle : vr::k_ulInvalidInputComponentHandle;
+	return info;
+}
+
 void callTrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize) {
 	if (IVRServerDriverHost) {
 		originalTrackedDevicePoseUpdated(IVRServerDriverHost, unWhichDevice, newPose, unPoseStructSize);
 	}
 }
 
+bool callPollNextEvent(vr::VREvent_t* pEvent, uint32_t uncbVREvent) {
+	if (IVRServerDriverHost && originalPollNextEvent) {
+		return originalPollNextEvent(IVRServerDriverHost, pEvent, uncbVREvent);
+	}
+
+	return false;
+}
+
 vr::EVRInputError callUpdateBooleanComponent(
 	vr::VRInputComponentHandle_t ulComponent,
 	bool bNewValue,
@@ -91,28 +132,109 @@ void overrideTrackedDevicePoseUpdated(
 	const vr::DriverPose_t& newPose,
 	uint32_t unPoseStructSize
 ) {
-	ModelDevicePoseSerialized* posePointer = DeviceStateModel::getInstance().getDevicePose(unWhichDevice);
-	if (posePointer != nullptr) {
-		posePointer->data.pose = FromDriverPose(newPose);
-		DeviceStateModel::getInstance().setDevicePoseChanged(unWhichDevice);
-	} else {
-		DeviceStateModel::getInstance().addDevicePose(unWhichDevice); // Register a new device pose on first sighting
+	CommandScheduler::getInstance().applyDueCommands();
+	PluginManager::getInstance().applyPendingOverrides();
+	SharedDeviceMemoryDriver::getInstance().drainClientDriverLane(MAX_HOOK_COMMAND_DRAIN, true);
+
+	HapticsManager::getInstance().recordDeviceHost(unWhichDevice, _this);
+
+	TransformRuleManager& ruleManager = TransformRuleManager::getInstance();
+	ruleManager.recordNaturalPose(unWhichDevice, newPose);
+	PluginManager::getInstance().recordNaturalPose(unWhichDevice, newPose);
+
+	const vr::DriverPose_t* poseToSend = &newPose;
+	vr::DriverPose_t smoothedPose;
+	vr::DriverPose_t transformedPose;
+	vr::DriverPose_t animatedPose;
+	vr::DriverPose_t resolvedPose;
+	bool firstSighting = false;
+
+	// The pose is resolved into locals under the batch lock, which is released before any plugin or OpenVR call so
+	// commands applied from other drivers' hook threads never wait on this driver's runtime call
+	{
+		std::shared_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+
+		// Conversion, the model update and publishing to the client are left to the hook update worker. Poses stream
+		// every frame, so without a client they are skipped and the first pose after a client attaches refreshes them
+		ModelDevicePoseSerialized* posePointer = DeviceStateModel::getInstance().getDevicePose(unWhichDevice);
+		if (posePointer != nullptr) {
+			if (SharedDeviceMemoryDriver::getInstance().isClientAttached()) {
+				HookUpdateQueue::getInstance().pushDevicePose(unWhichDevice, newPose);
+			}
+		} else {
+			// Register a new device pose on first sighting
+			DeviceStateModel::getInstance().addDevicePose(unWhichDevice);
+			firstSighting = true;
+		}
+
+		if (posePointer && posePointer->useOverriddenState) {
+			// The resolved pose may point into the model, so it is copied out before the lock is released
+			const vr::DriverPose_t* overriddenPose =
+				DeviceStateModel::getInstance().resolveOverriddenDriverPose(unWhichDevice, newPose, resolvedPose);
+			if (overriddenPose) {
+				if (overriddenPose != &resolvedPose) resolvedPose = *overriddenPose;
+				poseToSend = &resolvedPose;
+			}
+		} else {
+			// Smoothing runs on the raw signal, before rules move the pose somewhere else
+			if (SmoothingFilterManager::getInstance().filterPose(unWhichDevice, newPose, smoothedPose)) {
+				poseToSend = &smoothedPose;
+			}
+
+			if (ruleManager.applyPoseRules(unWhichDevice, *poseToSend, transformedPose)) poseToSend = &transformedPose;
+
+			if (AnimationPlayer::getInstance().samplePose(unWhichDevice, *poseToSend, animatedPose)) {
+				poseToSend = &animatedPose;
+			}
+		}
 	}
 
-	vr::DriverPose_t poseToSend = newPose;
-	if (posePointer && posePointer->useOverriddenState) {
-		poseToSend = ToDriverPose(posePointer->data.overwrittenPose);
+	// The vendor driver has set the device properties by its first pose, so they are read once here
+	if (firstSighting) SharedDeviceMemoryDriver::getInstance().registerDevice(ReadDeviceInfo(unWhichDevice));
+
+	// Plugins see the pose last, so their logic acts on exactly what OpenVR would otherwise receive
+	vr::DriverPose_t pluginPose;
+	if (PluginManager::getInstance().processDevicePose(unWhichDevice, *poseToSend, pluginPose)) {
+		poseToSend = &pluginPose;
 	}
 
 	// Call the original TrackedDevicePoseUpdated()
 	if (originalTrackedDevicePoseUpdated) (originalTrackedDevicePoseUpdated)(
 		_this,
 		unWhichDevice,
-		poseToSend,
+		*poseToSend,
 		unPoseStructSize
 	);
 }
 
+bool overridePollNextEvent(void* _this, vr::VREvent_t* pEvent, uint32_t uncbVREvent) {
+	if (!originalPollNextEvent) return false;
+
+	// Drivers poll for events every frame, so draining here lets injected pulses skip waiting for an update hook
+	CommandScheduler::getInstance().applyDueCommands();
+	PluginManager::getInstance().applyPendingOverrides();
+	SharedDeviceMemoryDriver::getInstance().drainClientDriverLane(MAX_HOOK_COMMAND_DRAIN, true);
+
+	// Injected pulses go first, as long as the driver's event struct is large enough to hold them
+	bool fitsHapticEvent = pEvent &&
+		uncbVREvent >= offsetof(vr::VREvent_t, data) + sizeof(vr::VREvent_HapticVibration_t);
+	if (fitsHapticEvent) {
+		vr::VREvent_t injectedEvent;
+		if (HapticsManager::getInstance().takeInjectedEvent(_this, injectedEvent)) {
+			memcpy(pEvent, &injectedEvent, (std::min)(static_cast<size_t>(uncbVREvent), sizeof(vr::VREvent_t)));
+			return true;
+		}
+	}
+
+	// Call the original PollNextEvent(), skipping over suppressed vibrations
+	while ((originalPollNextEvent)(_this, pEvent, uncbVREvent)) {
+		if (!fitsHapticEvent || pEvent->eventType != vr::VREvent_Input_HapticVibration) return true;
+		if (HapticsManager::getInstance().processHapticEvent(_this, *pEvent)) return true;
+	}
+
+	return false;
+}
+
 vr::EVRInputError overrideCreateBooleanComponent(
 	void* _this,
 	vr::PropertyContainerHandle_t ulContainer,
@@ -130,7 +252,12 @@ vr::EVRInputError overrideCreateBooleanComponent(
 
 	// Register component to model
 	uint32_t deviceIndex = DeviceStateModel::getInstance().getDeviceIndexFromPropertyContainer(ulContainer);
-	if (deviceIndex != UINT32_MAX) DeviceStateModel::getInstance().addBooleanInput(deviceIndex, pchName, pHandle);
+	if (deviceIndex != UINT32_MAX) {
+		DeviceStateModel::getInstance().addBooleanInput(deviceIndex, pchName, pHandle);
+		SharedDeviceMemoryDriver::getInstance().registerComponent(
+			MakeComponentInfo(deviceIndex, DeviceComponent_Boolean, pchName, pHandle)
+		);
+	}
 
 	return result;
 }
@@ -141,18 +268,39 @@ vr::EVRInputError overrideUpdateBooleanComponent(
 	bool bNewValue,
 	double fTimeOffset
 ) {
-	ModelDeviceInputBooleanSerialized* input = DeviceStateModel::getInstance().getBooleanInput(ulComponent);
-
-	if (input != nullptr) {
-		input->data.value.value = bNewValue;
-		input->data.value.timeOffset = fTimeOffset;
-		DeviceStateModel::getInstance().setInputBooleanChanged(ulComponent);
+	CommandScheduler::getInstance().applyDueCommands();
+	PluginManager::getInstance().applyPendingOverrides();
+	SharedDeviceMemoryDriver::getInstance().drainClientDriverLane(MAX_HOOK_COMMAND_DRAIN, true);
+
+	// Resolved under the batch lock, which is released before any plugin or OpenVR call, like the pose hook
+	{
+		std::shared_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+
+		ModelDeviceInputBooleanSerialized* input = DeviceStateModel::getInstance().getBooleanInput(ulComponent);
+
+		if (input != nullptr) {
+			if (SharedDeviceMemoryDriver::getInstance().isClientAttached()) {
+				HookUpdateQueue::getInstance().pushBoolean(ulComponent, bNewValue, fTimeOffset);
+			} else {
+				// Without a client only the natural value is kept, for the snapshot published when one attaches
+				input->data.value.value = bNewValue;
+				input->data.value.timeOffset = fTimeOffset;
+			}
+		}
+
+		if (input && input->useOverriddenState) {
+			bNewValue = input->data.overwrittenValue.value;
+			fTimeOffset = input->data.overwrittenValue.timeOffset;
+		} else {
+			TransformRuleManager::getInstance().applyBooleanRules(ulComponent, bNewValue);
+			InputFilterEngine::getInstance().filterBoolean(ulComponent, bNewValue, fTimeOffset);
+		}
 	}
 
-	if (input && input->useOverriddenState) {
-		bNewValue = input->data.overwrittenValue.value;
-		fTimeOffset = input->data.overwrittenValue.timeOffset;
-	}
+	// Bindings follow what this input's own pipeline produced, the same stage their programs see their inputs at
+	InputFilterEngine::getInstance().notifyInputUpdated(ulComponent, bNewValue ? 1.0 : 0.0);
+
+	PluginManager::getInstance().processBoolean(ulComponent, bNewValue, fTimeOffset);
 
 	// Call the original UpdateBooleanComponent()
 	if (originalUpdateBooleanComponent) return (originalUpdateBooleanComponent)(
@@ -186,7 +334,14 @@ vr::EVRInputError overrideCreateScalarComponent(
 
 	// Register component to model
 	uint32_t deviceIndex = DeviceStateModel::getInstance().getDeviceIndexFromPropertyContainer(ulContainer);
-	if (deviceIndex != UINT32_MAX) DeviceStateModel::getInstance().addScalarInput(deviceIndex, pchName, pHandle);
+	if (deviceIndex != UINT32_MAX) {
+		DeviceStateModel::getInstance().addScalarInput(deviceIndex, pchName, pHandle);
+
+		ComponentInfo info = MakeComponentInfo(deviceIndex, DeviceComponent_Scalar, pchName, pHandle);
+		info.scalarType = static_cast<ScalarType>(eType);
+		info.scalarUnits = static_cast<ScalarUnits>(eUnits);
+		SharedDeviceMemoryDriver::getInstance().registerComponent(info);
+	}
 
 	return result;
 }
@@ -197,18 +352,41 @@ vr::EVRInputError overrideUpdateScalarComponent(
 	float fNewValue,
 	double fTimeOffset
 ) {
-	ModelDeviceInputScalarSerialized* input = DeviceStateModel::getInstance().getScalarInput(ulComponent);
-
-	if (input != nullptr) {
-		input->data.value.value = fNewValue;
-		input->data.value.timeOffset = fTimeOffset;
-		DeviceStateModel::getInstance().setInputScalarChanged(ulComponent);
+	CommandScheduler::getInstance().applyDueCommands();
+	PluginManager::getInstance().applyPendingOverrides();
+	SharedDeviceMemoryDriver::getInstance().drainClientDriverLane(MAX_HOOK_COMMAND_DRAIN, true);
+
+	// Resolved under the batch lock, which is released before any plugin or OpenVR call, like the pose hook
+	{
+		std::shared_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+
+		ModelDeviceInputScalarSerialized* input = DeviceStateModel::getInstance().getScalarInput(ulComponent);
+
+		if (input != nullptr) {
+			if (SharedDeviceMemoryDriver::getInstance().isClientAttached()) {
+				HookUpdateQueue::getInstance().pushScalar(ulComponent, fNewValue, fTimeOffset);
+			} else {
+				// Without a client only the natural value is kept, for the snapshot published when one attaches
+				input->data.value.value = fNewValue;
+				input->data.value.timeOffset = fTimeOffset;
+			}
+		}
+
+		if (input && input->useOverriddenState) {
+			fNewValue = input->data.overwrittenValue.value;
+			fTimeOffset = input->data.overwrittenValue.timeOffset;
+		} else {
+			SmoothingFilterManager::getInstance().filterScalar(ulComponent, fNewValue);
+			TransformRuleManager::getInstance().applyScalarRules(ulComponent, fNewValue);
+			AnimationPlayer::getInstance().sampleScalar(ulComponent, fNewValue);
+			InputFilterEngine::getInstance().filterScalar(ulComponent, fNewValue, fTimeOffset);
+		}
 	}
 
-	if (input && input->useOverriddenState) {
-		fNewValue = input->data.overwrittenValue.value;
-		fTimeOffset = input->data.overwrittenValue.timeOffset;
-	}
+	// Bindings follow what this input's own pipeline produced, the same stage their programs see their inputs at
+	InputFilterEngine::getInstance().notifyInputUpdated(ulComponent, fNewValue);
+
+	PluginManager::getInstance().processScalar(ulComponent, fNewValue, fTimeOffset);
 
 	// Call the original UpdateScalarComponent()
 	if (originalUpdateScalarComponent) return (originalUpdateScalarComponent)(
@@ -227,13 +405,25 @@ vr::EVRInputError overrideCreateHapticComponent(
 	const char* pchName,
 	vr::VRInputComponentHandle_t* pHandle
 ) {
-	// We dont actually store haptic inputs in the model since they can be managed from applications
-	// the hook is just here if its needed in the future, and for consistency
+	// We dont actually store haptic inputs in the model since they can be managed from applications, they are only
+	// described in the device registry and tracked by the HapticsManager
 
 	// Call the original CreateHapticComponent()
-	if (originalCreateHapticComponent) return (originalCreateHapticComponent)(_this, ulContainer, pchName, pHandle);
+	if (!originalCreateHapticComponent) return vr::VRInputError_NoData;
+	vr::EVRInputError result = (originalCreateHapticComponent)(_this, ulContainer, pchName, pHandle);
 
-	return vr::VRInputError_NoData;
+	uint32_t deviceIndex = DeviceStateModel::getInstance().getDeviceIndexFromPropertyContainer(ulContainer);
+	if (deviceIndex != UINT32_MAX) {
+		SharedDeviceMemoryDriver::getInstance().registerComponent(
+			MakeComponentInfo(deviceIndex, DeviceComponent_Haptic, pchName, pHandle)
+		);
+
+		if (result == vr::VRInputError_None && pchName && pHandle) {
+			HapticsManager::getInstance().addHapticComponent(deviceIndex, pchName, ulContainer, *pHandle);
+		}
+	}
+
+	return result;
 }
 
 vr::EVRInputError overrideCreateSkeletonComponent(
@@ -263,7 +453,23 @@ vr::EVRInputError overrideCreateSkeletonComponent(
 
 	// Register component to model
 	uint32_t deviceIndex = DeviceStateModel::getInstance().getDeviceIndexFromPropertyContainer(ulContainer);
-	if (deviceIndex != UINT32_MAX) DeviceStateModel::getInstance().addSkeletonInput(deviceIndex, pchName, pHandle);
+	if (deviceIndex != UINT32_MAX) {
+		DeviceStateModel::getInstance().addSkeletonInput(deviceIndex, pchName, pHandle);
+
+		ComponentInfo info = MakeComponentInfo(deviceIndex, DeviceComponent_Skeleton, pchName, pHandle);
+		info.skeletonPath = pchSkeletonPath ? pchSkeletonPath : "";
+		info.basePosePath = pchBasePosePath ? pchBasePosePath : "";
+		info.skeletalTrackingLevel = static_cast<SkeletalTrackingLevel>(eSkeletalTrackingLevel);
+		if (pGripLimitTransforms && unGripLimitTransformCount > 0) {
+			SkeletonInput gripLimits = {};
+			FromVRBoneTransforms(pGripLimitTransforms, unGripLimitTransformCount, gripLimits);
+			info.gripLimitTransforms.assign(
+				gripLimits.boneTransforms,
+				gripLimits.boneTransforms + gripLimits.boneTransformCount
+			);
+		}
+		SharedDeviceMemoryDriver::getInstance().registerComponent(info);
+	}
 
 	return result;
 }
@@ -275,23 +481,66 @@ vr::EVRInputError overrideUpdateSkeletonComponent(
 	const vr::VRBoneTransform_t* pTransforms,
 	uint32_t unTransformCount
 ) {
-	ModelDeviceInputSkeletonSerialized* input = DeviceStateModel::getInstance().getSkeletonInput(ulComponent);
+	CommandScheduler::getInstance().applyDueCommands();
+	PluginManager::getInstance().applyPendingOverrides();
+	SharedDeviceMemoryDriver::getInstance().drainClientDriverLane(MAX_HOOK_COMMAND_DRAIN, true);
 
-	if (input != nullptr) {
-		input->data.value.motionRange = static_cast<SkeletalMotionRange>(eMotionRange);
-		FromVRBoneTransforms(pTransforms, unTransformCount, input->data.value);
-		input->data.value.boneTransformCount = unTransformCount;
-		DeviceStateModel::getInstance().setInputSkeletonChanged(ulComponent);
+	const vr::VRBoneTransform_t* transforms = pTransforms;
+	vr::VRBoneTransform_t animatedTransforms[31];
+	vr::VRBoneTransform_t mergedTransforms[31];
+
+	// Resolved under the batch lock, which is released before any plugin or OpenVR call, like the pose hook
+	{
+		std::shared_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+
+		ModelDeviceInputSkeletonSerialized* input = DeviceStateModel::getInstance().getSkeletonInput(ulComponent);
+
+		// Skeletons stream every frame, so without a client they are skipped like device poses
+		if (input != nullptr && SharedDeviceMemoryDriver::getInstance().isClientAttached()) {
+			HookUpdateQueue::getInstance().pushSkeleton(ulComponent, eMotionRange, pTransforms, unTransformCount);
+		}
+
+		if (input && input->useOverriddenState) {
+			DeviceStateModel& model = DeviceStateModel::getInstance();
+			const vr::VRBoneTransform_t* overwrittenTransforms = model.resolveOverriddenBoneTransforms(
+				ulComponent,
+				*input,
+				pTransforms,
+				unTransformCount,
+				eMotionRange,
+				mergedTransforms
+			);
+
+			// Full overrides point into the model, so they are copied out before the lock is released
+			if (overwrittenTransforms) {
+				unTransformCount = (std::min)(unTransformCount, 31U);
+				if (overwrittenTransforms != mergedTransforms) {
+					std::copy(overwrittenTransforms, overwrittenTransforms + unTransformCount, mergedTransforms);
+				}
+				transforms = mergedTransforms;
+			}
+		} else if (AnimationPlayer::getInstance().sampleSkeleton(
+			ulComponent,
+			pTransforms,
+			unTransformCount,
+			eMotionRange,
+			animatedTransforms,
+			unTransformCount
+		)) {
+			transforms = animatedTransforms;
+		}
 	}
 
-	const vr::VRBoneTransform_t* transforms = pTransforms;
-	
-	if (input && input->useOverriddenState) {
-		eMotionRange = static_cast<vr::EVRSkeletalMotionRange>(input->data.overwrittenValue.motionRange);
-		vr::VRBoneTransform_t overwrittenTransforms[31];
-		ToVRBoneTransforms(input->data.overwrittenValue, overwrittenTransforms);
-		transforms = overwrittenTransforms;
-		unTransformCount = input->data.overwrittenValue.boneTransformCount;
+	vr::VRBoneTransform_t pluginTransforms[31];
+	if (PluginManager::getInstance().processSkeleton(
+		ulComponent,
+		eMotionRange,
+		transforms,
+		unTransformCount,
+		pluginTransforms
+	)) {
+		transforms = pluginTransforms;
+		unTransformCount = (std::min)(unTransformCount, 31U);
 	}
 
 	// Call the original UpdateSkeletonComponent()
@@ -318,7 +567,12 @@ vr::EVRInputError overrideCreatePoseComponent(
 
 	// Register component to model
 	uint32_t deviceIndex = DeviceStateModel::getInstance().getDeviceIndexFromPropertyContainer(ulContainer);
-	if (deviceIndex != UINT32_MAX) DeviceStateModel::getInstance().addPoseInput(deviceIndex, pchName, pHandle);
+	if (deviceIndex != UINT32_MAX) {
+		DeviceStateModel::getInstance().addPoseInput(deviceIndex, pchName, pHandle);
+		SharedDeviceMemoryDriver::getInstance().registerComponent(
+			MakeComponentInfo(deviceIndex, DeviceComponent_Pose, pchName, pHandle)
+		);
+	}
 
 	return result;
 }
@@ -329,20 +583,34 @@ vr::EVRInputError overrideUpdatePoseComponent(
 	const vr::HmdMatrix34_t* pMatPoseOffset,
 	double fTimeOffset
 ) {
-	ModelDeviceInputPoseSerialized* input = DeviceStateModel::getInstance().getPoseInput(ulComponent);
-
-	if (input != nullptr) {
-		if (pMatPoseOffset != nullptr) input->data.value.poseOffset = FromHmdMatrix34(*pMatPoseOffset);
-		input->data.value.timeOffset = fTimeOffset;
-		DeviceStateModel::getInstance().setInputPoseChanged(ulComponent);
-	}
+	CommandScheduler::getInstance().applyDueCommands();
+	PluginManager::getInstance().applyPendingOverrides();
+	SharedDeviceMemoryDriver::getInstance().drainClientDriverLane(MAX_HOOK_COMMAND_DRAIN, true);
 
 	const vr::HmdMatrix34_t* matrixToSend = pMatPoseOffset;
-
-	if (input && input->useOverriddenState) {
-		vr::HmdMatrix34_t overwrittenMatrix = ToHmdMatrix34(input->data.overwrittenValue.poseOffset);
-		matrixToSend = &overwrittenMatrix;
-		fTimeOffset = input->data.overwrittenValue.timeOffset;
+	vr::HmdMatrix34_t overwrittenMatrix;
+
+	// Resolved under the batch lock, which is released before the OpenVR call, like the pose hook
+	{
+		std::shared_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+
+		ModelDeviceInputPoseSerialized* input = DeviceStateModel::getInstance().getPoseInput(ulComponent);
+
+		if (input != nullptr) {
+			if (SharedDeviceMemoryDriver::getInstance().isClientAttached()) {
+				HookUpdateQueue::getInstance().pushPose(ulComponent, pMatPoseOffset, fTimeOffset);
+			} else {
+				// Without a client only the natural value is kept, for the snapshot published when one attaches
+				if (pMatPoseOffset != nullptr) input->data.value.poseOffset = FromHmdMatrix34(*pMatPoseOffset);
+				input->data.value.timeOffset = fTimeOffset;
+			}
+		}
+
+		if (input && input->useOverriddenState) {
+			overwrittenMatrix = ToHmdMatrix34(input->data.overwrittenValue.poseOffset);
+			matrixToSend = &overwrittenMatrix;
+			fTimeOffset = input->data.overwrittenValue.timeOffset;
+		}
 	}
 
 	// Call the original UpdatePoseComponent()
@@ -373,26 +641,41 @@ vr::EVRInputError overrideCreateEyeTrackingComponent(
 
 	// Register component to model
 	uint32_t deviceIndex = DeviceStateModel::getInstance().getDeviceIndexFromPropertyContainer(ulContainer);
-	if (deviceIndex != UINT32_MAX) DeviceStateModel::getInstance().addEyeTrackingInput(deviceIndex, pchName, pHandle);
+	if (deviceIndex != UINT32_MAX) {
+		DeviceStateModel::getInstance().addEyeTrackingInput(deviceIndex, pchName, pHandle);
+		SharedDeviceMemoryDriver::getInstance().registerComponent(
+			MakeComponentInfo(deviceIndex, DeviceComponent_EyeTracking, pchName, pHandle)
+		);
+	}
 
 	return result;
 }
 
 vr::EVRInputError overrideUpdateEyeTrackingComponent(void* _this, vr::VRInputComponentHandle_t ulComponent, const vr::VREyeTrackingData_t* pEyeTrackingData_t, double fTimeOffset) {
-	ModelDeviceInputEyeTrackingSerialized* input = DeviceStateModel::getInstance().getEyeTrackingInput(ulComponent);
-
-	if (input != nullptr) {
-		input->data.value.eyeTrackingData = FromVREyeTrackingData(*pEyeTrackingData_t);
-		input->data.value.timeOffset = fTimeOffset;
-		DeviceStateModel::getInstance().setInputEyeTrackingChanged(ulComponent);
-	}
+	CommandScheduler::getInstance().applyDueCommands();
+	PluginManager::getInstance().applyPendingOverrides();
+	SharedDeviceMemoryDriver::getInstance().drainClientDriverLane(MAX_HOOK_COMMAND_DRAIN, true);
 
 	const vr::VREyeTrackingData_t* eyeTrackingDataToSend = pEyeTrackingData_t;
+	vr::VREyeTrackingData_t overwrittenEyeTrackingData;
+
+	// Resolved under the batch lock, which is released before the OpenVR call, like the pose hook
+	{
+		std::shared_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+
+		ModelDeviceInputEyeTrackingSerialized* input =
+			DeviceStateModel::getInstance().getEyeTrackingInput(ulComponent);
+
+		// Eye tracking streams every frame, so without a client it is skipped like device poses
+		if (input != nullptr && SharedDeviceMemoryDriver::getInstance().isClientAttached()) {
+			HookUpdateQueue::getInstance().pushEyeTracking(ulComponent, *pEyeTrackingData_t, fTimeOffset);
+		}
 
-	if (input && input->useOverriddenState) {
-		vr::VREyeTrackingData_t overwrittenEyeTrackingData = ToVREyeTrackingData(input->data.overwrittenValue.eyeTrackingData);
-		eyeTrackingDataToSend = &overwrittenEyeTrackingData;
-		fTimeOffset = input->data.overwrittenValue.timeOffset;
+		if (input && input->useOverriddenState) {
+			overwrittenEyeTrackingData = ToVREyeTrackingData(input->data.overwrittenValue.eyeTrackingData);
+			eyeTrackingDataToSend = &overwrittenEyeTrackingData;
+			fTimeOffset = input->data.overwrittenValue.timeOffset;
+		}
 	}
 
 	// Call the original UpdateEyeTrackingComponent()
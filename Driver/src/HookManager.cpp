@@ -30,6 +30,13 @@ void HookManager::setupHooks_IVRServerDriverHost(void* host) {
 		reinterpret_cast<void**>(&originalTrackedDevicePoseUpdated),
 		"TrackedDevicePoseUpdated"
 	);
+
+	createHook(
+		vtable[Offset_PollNextEvent],
+		&overridePollNextEvent,
+		reinterpret_cast<void**>(&originalPollNextEvent),
+		"PollNextEvent"
+	);
 	
 	IVRServerDriverHost = host;
 
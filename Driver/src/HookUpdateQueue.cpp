@@ -0,0 +1,262 @@
+#include "HookUpdateQueue.h"
+#include "DeviceStateModelDriver.h"
+#include "SharedDeviceMemoryDriver.h"
+#include "LogManager.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <shared_mutex>
+#include <chrono>
+
+HookUpdateQueue& HookUpdateQueue::getInstance() {
+	static HookUpdateQueue instance;
+	return instance;
+}
+
+void HookUpdateQueue::pushDevicePose(uint32_t deviceIndex, const vr::DriverPose_t& pose) {
+	HookUpdate* slot = this->beginPush();
+	HookUpdate fallback;
+	HookUpdate& update = slot ? *slot : fallback;
+
+	update.type = HookUpdate_DevicePose;
+	update.deviceIndex = deviceIndex;
+	update.devicePose = pose;
+	update.timestampNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+
+	this->endPush(update, slot != nullptr);
+}
+
+void HookUpdateQueue::pushBoolean(vr::VRInputComponentHandle_t componentHandle, bool value, double timeOffset) {
+	HookUpdate* slot = this->beginPush();
+	HookUpdate fallback;
+	HookUpdate& update = slot ? *slot : fallback;
+
+	update.type = HookUpdate_InputBoolean;
+	update.componentHandle = componentHandle;
+	update.timeOffset = timeOffset;
+	update.booleanValue = value;
+
+	this->endPush(update, slot != nullptr);
+}
+
+void HookUpdateQueue::pushScalar(vr::VRInputComponentHandle_t componentHandle, float value, double timeOffset) {
+	HookUpdate* slot = this->beginPush();
+	HookUpdate fallback;
+	HookUpdate& update = slot ? *slot : fallback;
+
+	update.type = HookUpdate_InputScalar;
+	update.componentHandle = componentHandle;
+	update.timeOffset = timeOffset;
+	update.scalarValue = value;
+
+	this->endPush(update, slot != nullptr);
+}
+
+void HookUpdateQueue::pushSkeleton(
+	vr::VRInputComponentHandle_t componentHandle,
+	vr::EVRSkeletalMotionRange motionRange,
+	const vr::VRBoneTransform_t* transforms,
+	uint32_t transformCount
+) {
+	HookUpdate* slot = this->beginPush();
+	HookUpdate fallback;
+	HookUpdate& update = slot ? *slot : fallback;
+
+	transformCount = transforms ? (std::min)(transformCount, 31U) : 0;
+
+	update.type = HookUpdate_InputSkeleton;
+	update.componentHandle = componentHandle;
+	update.skeleton.motionRange = motionRange;
+	update.skeleton.transformCount = transformCount;
+	if (transformCount > 0) {
+		memcpy(update.skeleton.transforms, transforms, transformCount * sizeof(vr::VRBoneTransform_t));
+	}
+
+	this->endPush(update, slot != nullptr);
+}
+
+void HookUpdateQueue::pushPose(
+	vr::VRInputComponentHandle_t componentHandle,
+	const vr::HmdMatrix34_t* poseOffset,
+	double timeOffset
+) {
+	HookUpdate* slot = this->beginPush();
+	HookUpdate fallback;
+	HookUpdate& update = slot ? *slot : fallback;
+
+	update.type = HookUpdate_InputPose;
+	update.componentHandle = componentHandle;
+	update.timeOffset = timeOffset;
+	update.pose.hasPoseOffset = poseOffset != nullptr;
+	if (poseOffset) update.pose.poseOffset = *poseOffset;
+
+	this->endPush(update, slot != nullptr);
+}
+
+void HookUpdateQueue::pushEyeTracking(
+	vr::VRInputComponentHandle_t componentHandle,
+	const vr::VREyeTrackingData_t& eyeTrackingData,
+	double timeOffset
+) {
+	HookUpdate* slot = this->beginPush();
+	HookUpdate fallback;
+	HookUpdate& update = slot ? *slot : fallback;
+
+	update.type = HookUpdate_InputEyeTracking;
+	update.componentHandle = componentHandle;
+	update.timeOffset = timeOffset;
+	update.eyeTrackingData = eyeTrackingData;
+
+	this->endPush(update, slot != nullptr);
+}
+
+void HookUpdateQueue::run() {
+	while (true) {
+		if (this->drainQueues() > 0) continue;
+
+		// Announce the sleep before the last check, so a hook queueing in between either is drained here or sees
+		// the flag and wakes the worker
+		this->workerSleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (this->drainQueues() == 0) this->workerSleeping.wait(true, std::memory_order_acquire);
+		this->workerSleeping.store(false, std::memory_order_relaxed);
+	}
+}
+
+HookUpdateQueue::ProducerQueue* HookUpdateQueue::getThreadQueue() {
+	// Registration is attempted once per thread, so threads past the limit don't retry on every hook call
+	thread_local bool registered = false;
+	thread_local ProducerQueue* threadQueue = nullptr;
+	if (registered) return threadQueue;
+	registered = true;
+
+	std::lock_guard<std::mutex> lock(this->registrationMutex);
+
+	uint32_t count = this->queueCount.load(std::memory_order_relaxed);
+	if (count >= MAX_HOOK_UPDATE_QUEUES) {
+		LogManager::log(LOG_ERROR, "Over {} hook threads, publishing from the hook instead", MAX_HOOK_UPDATE_QUEUES);
+		return nullptr;
+	}
+
+	threadQueue = new ProducerQueue();
+	this->queues[count].store(threadQueue, std::memory_order_release);
+	this->queueCount.store(count + 1, std::memory_order_release);
+
+	return threadQueue;
+}
+
+HookUpdate* HookUpdateQueue::beginPush() {
+	ProducerQueue* queue = this->getThreadQueue();
+	if (!queue) return nullptr;
+
+	uint32_t writeCount = queue->writeCount.load(std::memory_order_relaxed);
+	if (writeCount - queue->readCount.load(std::memory_order_acquire) >= HOOK_UPDATE_QUEUE_SIZE) return nullptr;
+
+	return &queue->slots[writeCount % HOOK_UPDATE_QUEUE_SIZE];
+}
+
+void HookUpdateQueue::endPush(HookUpdate& update, bool queued) {
+	if (!queued) {
+		// The hook already holds the batch mutex, so a full queue falls back to publishing from the hook
+		applyUpdate(update);
+		return;
+	}
+
+	ProducerQueue* queue = this->getThreadQueue();
+	queue->writeCount.store(queue->writeCount.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (this->workerSleeping.load(std::memory_order_relaxed)) {
+		this->workerSleeping.store(false, std::memory_order_release);
+		this->workerSleeping.notify_one();
+	}
+}
+
+uint32_t HookUpdateQueue::drainQueues() {
+	uint32_t applied = 0;
+	uint32_t count = this->queueCount.load(std::memory_order_acquire);
+
+	std::shared_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+
+	for (uint32_t i = 0; i < count; i++) {
+		ProducerQueue* queue = this->queues[i].load(std::memory_order_acquire);
+
+		uint32_t readCount = queue->readCount.load(std::memory_order_relaxed);
+		uint32_t writeCount = queue->writeCount.load(std::memory_order_acquire);
+
+		for (; readCount != writeCount; readCount++, applied++) {
+			applyUpdate(queue->slots[readCount % HOOK_UPDATE_QUEUE_SIZE]);
+		}
+
+		queue->readCount.store(readCount, std::memory_order_release);
+	}
+
+	return applied;
+}
+
+void HookUpdateQueue::applyUpdate(const HookUpdate& update) {
+	DeviceStateModel& model = DeviceStateModel::getInstance();
+
+	switch (update.type) {
+		case HookUpdate_DevicePose: {
+			ModelDevicePoseSerialized* posePointer = model.getDevicePose(update.deviceIndex);
+			if (posePointer == nullptr) break;
+
+			posePointer->data.pose = FromDriverPose(update.devicePose);
+			posePointer->data.updateTimeNanoseconds = update.timestampNanoseconds;
+			SharedDeviceMemoryDriver::getInstance().syncDevicePoseUpdateToSharedMemory(
+				&posePointer->data,
+				update.deviceIndex
+			);
+			break;
+		}
+		case HookUpdate_InputBoolean: {
+			ModelDeviceInputBooleanSerialized* input = model.getBooleanInput(update.componentHandle);
+			if (input == nullptr) break;
+
+			input->data.value.value = update.booleanValue;
+			input->data.value.timeOffset = update.timeOffset;
+			model.setInputBooleanChanged(update.componentHandle);
+			break;
+		}
+		case HookUpdate_InputScalar: {
+			ModelDeviceInputScalarSerialized* input = model.getScalarInput(update.componentHandle);
+			if (input == nullptr) break;
+
+			input->data.value.value = update.scalarValue;
+			input->data.value.timeOffset = update.timeOffset;
+			model.setInputScalarChanged(update.componentHandle);
+			break;
+		}
+		case HookUpdate_InputSkeleton: {
+			ModelDeviceInputSkeletonSerialized* input = model.getSkeletonInput(update.componentHandle);
+			if (input == nullptr) break;
+
+			input->data.value.motionRange = static_cast<SkeletalMotionRange>(update.skeleton.motionRange);
+			FromVRBoneTransforms(update.skeleton.transforms, update.skeleton.transformCount, input->data.value);
+			model.setInputSkeletonChanged(update.componentHandle);
+			break;
+		}
+		case HookUpdate_InputPose: {
+			ModelDeviceInputPoseSerialized* input = model.getPoseInput(update.componentHandle);
+			if (input == nullptr) break;
+
+			if (update.pose.hasPoseOffset) input->data.value.poseOffset = FromHmdMatrix34(update.pose.poseOffset);
+			input->data.value.timeOffset = update.timeOffset;
+			model.setInputPoseChanged(update.componentHandle);
+			break;
+		}
+		case HookUpdate_InputEyeTracking: {
+			ModelDeviceInputEyeTrackingSerialized* input = model.getEyeTrackingInput(update.componentHandle);
+			if (input == nullptr) break;
+
+			input->data.value.eyeTrackingData = FromVREyeTrackingData(update.eyeTrackingData);
+			input->data.value.timeOffset = update.timeOffset;
+			model.setInputEyeTrackingChanged(update.componentHandle);
+			break;
+		}
+	}
+}
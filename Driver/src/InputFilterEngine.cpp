@@ -0,0 +1,326 @@
+#include "InputFilterEngine.h"
+#include "HookFunctions.h"
+#include "PluginManager.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Returns the number of values an opcode pops from and pushes to the stack
+ * @return True if the opcode is valid, false otherwise
+ */
+static bool getStackEffect(FilterOpcode opcode, uint32_t* popped, uint32_t* pushed) {
+	switch (opcode) {
+		case Filter_Push:
+		case Filter_LoadInput:
+		case Filter_LoadBinding:
+		case Filter_LoadRegister:
+		case Filter_LoadDeltaTime:
+			*popped = 0; *pushed = 1; return true;
+		case Filter_StoreRegister:
+		case Filter_JumpIfZero:
+			*popped = 1; *pushed = 0; return true;
+		case Filter_Dup:
+			*popped = 1; *pushed = 2; return true;
+		case Filter_Add:
+		case Filter_Sub:
+		case Filter_Mul:
+		case Filter_Div:
+		case Filter_Min:
+		case Filter_Max:
+		case Filter_Greater:
+		case Filter_Less:
+		case Filter_Equal:
+		case Filter_And:
+		case Filter_Or:
+			*popped = 2; *pushed = 1; return true;
+		case Filter_Abs:
+		case Filter_Neg:
+		case Filter_Not:
+		case Filter_HoldTime:
+		case Filter_Return:
+			*popped = 1; *pushed = 1; return true;
+		case Filter_Select:
+			*popped = 3; *pushed = 1; return true;
+		case Filter_Jump:
+			*popped = 0; *pushed = 0; return true;
+	}
+
+	return false;
+}
+
+InputFilterEngine& InputFilterEngine::getInstance() {
+	static InputFilterEngine instance;
+	return instance;
+}
+
+bool InputFilterEngine::verifyProgram(
+	const FilterInstruction* instructions,
+	uint32_t instructionCount,
+	uint32_t bindingCount
+) {
+	if (instructionCount > MAX_FILTER_INSTRUCTIONS || bindingCount > MAX_FILTER_BINDINGS) return false;
+
+	// The stack depth on entry to each instruction, where index <instructionCount> is the implicit end of the program
+	int32_t depths[MAX_FILTER_INSTRUCTIONS + 1];
+	std::fill(depths, depths + instructionCount + 1, -1);
+	depths[0] = 0;
+
+	auto mergeDepth = [&](uint32_t target, int32_t depth) {
+		if (depths[target] == -1) depths[target] = depth;
+		return depths[target] == depth;
+	};
+
+	for (uint32_t pc = 0; pc < instructionCount; pc++) {
+		const FilterInstruction& instruction = instructions[pc];
+		int32_t depth = depths[pc];
+		if (depth == -1) continue; // Unreachable
+
+		uint32_t popped, pushed;
+		if (!getStackEffect(instruction.opcode, &popped, &pushed)) {
+			LogManager::log(LOG_ERROR, "Filter program has invalid opcode {} at {}", (int)instruction.opcode, pc);
+			return false;
+		}
+
+		if (depth < (int32_t)popped) {
+			LogManager::log(LOG_ERROR, "Filter program stack underflow at {}", pc);
+			return false;
+		}
+
+		int32_t newDepth = depth - (int32_t)popped + (int32_t)pushed;
+		if (newDepth > (int32_t)MAX_FILTER_STACK_DEPTH) {
+			LogManager::log(LOG_ERROR, "Filter program stack overflow at {}", pc);
+			return false;
+		}
+
+		switch (instruction.opcode) {
+			case Filter_LoadBinding:
+				if (instruction.operand >= bindingCount) return false;
+				break;
+			case Filter_LoadRegister:
+			case Filter_StoreRegister:
+			case Filter_HoldTime:
+				if (instruction.operand >= MAX_FILTER_REGISTERS) return false;
+				break;
+			case Filter_Jump:
+			case Filter_JumpIfZero:
+				if (instruction.operand <= pc || instruction.operand > instructionCount) {
+					LogManager::log(LOG_ERROR, "Filter program has non-forward jump at {}", pc);
+					return false;
+				}
+				if (!mergeDepth(instruction.operand, newDepth)) return false;
+				break;
+			default:
+				break;
+		}
+
+		if (instruction.opcode == Filter_Jump || instruction.opcode == Filter_Return) continue;
+		if (!mergeDepth(pc + 1, newDepth)) {
+			LogManager::log(LOG_ERROR, "Filter program has inconsistent stack depth at {}", pc + 1);
+			return false;
+		}
+	}
+
+	// Falling off the end must leave an output value, Filter_Return already guarantees one through its stack effect
+	if (depths[instructionCount] == 0) {
+		LogManager::log(LOG_ERROR, "Filter program ends without an output value");
+		return false;
+	}
+
+	return true;
+}
+
+bool InputFilterEngine::loadProgram(
+	vr::VRInputComponentHandle_t componentHandle,
+	bool isBoolean,
+	const FilterInstruction* instructions,
+	uint32_t instructionCount,
+	const vr::VRInputComponentHandle_t* bindingHandles,
+	uint32_t bindingCount
+) {
+	if (instructionCount > 0 && !this->verifyProgram(instructions, instructionCount, bindingCount)) return false;
+
+	std::lock_guard<std::mutex> lock(this->programMutex);
+
+	auto existing = this->programs.find(componentHandle);
+	if (existing != this->programs.end()) {
+		this->removeBindings(componentHandle, existing->second);
+		this->programs.erase(existing);
+	}
+
+	if (instructionCount > 0) {
+		FilterProgram& program = this->programs[componentHandle];
+		program.isBoolean = isBoolean;
+		program.instructionCount = instructionCount;
+		std::copy(instructions, instructions + instructionCount, program.instructions);
+		program.bindingCount = bindingCount;
+		std::copy(bindingHandles, bindingHandles + bindingCount, program.bindingHandles);
+
+		for (uint32_t i = 0; i < bindingCount; i++) {
+			std::vector<vr::VRInputComponentHandle_t>& targets = this->bindingTargets[bindingHandles[i]];
+			if (std::find(targets.begin(), targets.end(), componentHandle) == targets.end()) {
+				targets.push_back(componentHandle);
+			}
+		}
+	}
+
+	this->programCount.store(static_cast<uint32_t>(this->programs.size()), std::memory_order_release);
+	return true;
+}
+
+void InputFilterEngine::removeBindings(vr::VRInputComponentHandle_t componentHandle, const FilterProgram& program) {
+	for (uint32_t i = 0; i < program.bindingCount; i++) {
+		auto it = this->bindingTargets.find(program.bindingHandles[i]);
+		if (it == this->bindingTargets.end()) continue;
+
+		std::vector<vr::VRInputComponentHandle_t>& targets = it->second;
+		targets.erase(std::remove(targets.begin(), targets.end(), componentHandle), targets.end());
+		if (targets.empty()) this->bindingTargets.erase(it);
+	}
+}
+
+bool InputFilterEngine::filterBoolean(vr::VRInputComponentHandle_t componentHandle, bool& value, double timeOffset) {
+	if (this->programCount.load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->programMutex);
+
+	auto it = this->programs.find(componentHandle);
+	if (it == this->programs.end()) return false;
+
+	it->second.lastTimeOffset = timeOffset;
+	value = this->execute(it->second, value ? 1.0 : 0.0) != 0.0;
+	return true;
+}
+
+bool InputFilterEngine::filterScalar(vr::VRInputComponentHandle_t componentHandle, float& value, double timeOffset) {
+	if (this->programCount.load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->programMutex);
+
+	auto it = this->programs.find(componentHandle);
+	if (it == this->programs.end()) return false;
+
+	it->second.lastTimeOffset = timeOffset;
+	value = static_cast<float>(this->execute(it->second, value));
+	return true;
+}
+
+void InputFilterEngine::notifyInputUpdated(vr::VRInputComponentHandle_t componentHandle, double value) {
+	if (this->programCount.load(std::memory_order_acquire) == 0) return;
+
+	std::vector<FilterRerun> reruns;
+	DeviceStateModel& model = DeviceStateModel::getInstance();
+
+	{
+		// Shared for the override checks only, the reruns below call plugins and OpenVR without it
+		std::shared_lock<std::shared_mutex> batchLock(model.getBatchMutex());
+		std::lock_guard<std::mutex> lock(this->programMutex);
+
+		auto it = this->bindingTargets.find(componentHandle);
+		if (it == this->bindingTargets.end()) return;
+
+		for (vr::VRInputComponentHandle_t target : it->second) {
+			auto programIt = this->programs.find(target);
+			if (programIt == this->programs.end()) continue;
+
+			FilterProgram& program = programIt->second;
+			for (uint32_t i = 0; i < program.bindingCount; i++) {
+				if (program.bindingHandles[i] == componentHandle) program.bindingValues[i] = value;
+			}
+
+			// A program bound to its own input already runs in that input's hook, and one that never ran has no
+			// input value or time offset to rerun with
+			if (target == componentHandle || !program.hasRun) continue;
+
+			// An overridden input sends its override instead, and its own hook skips the program too
+			bool overridden;
+			if (program.isBoolean) {
+				ModelDeviceInputBooleanSerialized* input = model.getBooleanInput(target);
+				overridden = input && input->useOverriddenState;
+			} else {
+				ModelDeviceInputScalarSerialized* input = model.getScalarInput(target);
+				overridden = input && input->useOverriddenState;
+			}
+			if (overridden) continue;
+
+			// The last input value was recorded after rules and smoothing, so the rerun starts from the same value
+			double output = this->execute(program, program.lastInputValue);
+			reruns.push_back({ target, program.isBoolean, output, program.lastTimeOffset });
+		}
+	}
+
+	// The original functions are called directly, so this never re-enters the hooks
+	for (const FilterRerun& rerun : reruns) {
+		double timeOffset = rerun.timeOffset;
+		if (rerun.isBoolean) {
+			bool output = rerun.output != 0.0;
+			PluginManager::getInstance().processBoolean(rerun.componentHandle, output, timeOffset);
+			callUpdateBooleanComponent(rerun.componentHandle, output, timeOffset);
+		} else {
+			float output = static_cast<float>(rerun.output);
+			PluginManager::getInstance().processScalar(rerun.componentHandle, output, timeOffset);
+			callUpdateScalarComponent(rerun.componentHandle, output, timeOffset);
+		}
+	}
+}
+
+double InputFilterEngine::execute(FilterProgram& program, double inputValue) {
+	auto now = std::chrono::steady_clock::now();
+	double deltaTime = program.hasRun ? std::chrono::duration<double>(now - program.lastRunTime).count() : 0.0;
+	program.lastRunTime = now;
+	program.hasRun = true;
+	program.lastInputValue = inputValue;
+
+	// Verification guarantees the stack stays within bounds and that pc strictly increases
+	double stack[MAX_FILTER_STACK_DEPTH];
+	uint32_t top = 0;
+	double* registers = program.registers;
+
+	uint32_t pc = 0;
+	while (pc < program.instructionCount) {
+		const FilterInstruction& instruction = program.instructions[pc];
+		uint32_t next = pc + 1;
+
+		switch (instruction.opcode) {
+			case Filter_Push: stack[top++] = instruction.immediate; break;
+			case Filter_LoadInput: stack[top++] = inputValue; break;
+			case Filter_LoadBinding: stack[top++] = program.bindingValues[instruction.operand]; break;
+			case Filter_LoadRegister: stack[top++] = registers[instruction.operand]; break;
+			case Filter_StoreRegister: registers[instruction.operand] = stack[--top]; break;
+			case Filter_LoadDeltaTime: stack[top++] = deltaTime; break;
+			case Filter_Dup: stack[top] = stack[top - 1]; top++; break;
+			case Filter_Add: top--; stack[top - 1] += stack[top]; break;
+			case Filter_Sub: top--; stack[top - 1] -= stack[top]; break;
+			case Filter_Mul: top--; stack[top - 1] *= stack[top]; break;
+			case Filter_Div: top--; stack[top - 1] = stack[top] == 0.0 ? 0.0 : stack[top - 1] / stack[top]; break;
+			case Filter_Min: top--; stack[top - 1] = (std::min)(stack[top - 1], stack[top]); break;
+			case Filter_Max: top--; stack[top - 1] = (std::max)(stack[top - 1], stack[top]); break;
+			case Filter_Abs: stack[top - 1] = std::fabs(stack[top - 1]); break;
+			case Filter_Neg: stack[top - 1] = -stack[top - 1]; break;
+			case Filter_Not: stack[top - 1] = stack[top - 1] == 0.0 ? 1.0 : 0.0; break;
+			case Filter_Greater: top--; stack[top - 1] = stack[top - 1] > stack[top] ? 1.0 : 0.0; break;
+			case Filter_Less: top--; stack[top - 1] = stack[top - 1] < stack[top] ? 1.0 : 0.0; break;
+			case Filter_Equal: top--; stack[top - 1] = stack[top - 1] == stack[top] ? 1.0 : 0.0; break;
+			case Filter_And: top--; stack[top - 1] = (stack[top - 1] != 0.0 && stack[top] != 0.0) ? 1.0 : 0.0; break;
+			case Filter_Or: top--; stack[top - 1] = (stack[top - 1] != 0.0 || stack[top] != 0.0) ? 1.0 : 0.0; break;
+			case Filter_Select: {
+				top -= 2;
+				stack[top - 1] = stack[top + 1] != 0.0 ? stack[top - 1] : stack[top];
+				break;
+			}
+			case Filter_HoldTime: {
+				double& held = registers[instruction.operand];
+				held = stack[top - 1] != 0.0 ? held + deltaTime : 0.0;
+				stack[top - 1] = held;
+				break;
+			}
+			case Filter_Jump: next = instruction.operand; break;
+			case Filter_JumpIfZero: if (stack[--top] == 0.0) next = instruction.operand; break;
+			case Filter_Return: next = program.instructionCount; break;
+		}
+
+		pc = next;
+	}
+
+	return stack[top - 1];
+}
@@ -0,0 +1,479 @@
+#include "PluginManager.h"
+#include "DeviceStateModelDriver.h"
+#include "LogManager.h"
+#include "SharedDeviceMemoryDriver.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+
+/** @brief The directory plugins are loaded from, next to the driver log */
+static const char* const PLUGIN_DIRECTORY = "C:\\OpenVRConduit\\plugins";
+
+/** @brief The budget of a single plugin callback in microseconds, for plugins that don't set their own */
+static const uint32_t DEFAULT_PLUGIN_BUDGET_US = 200;
+
+/** @brief The number of calls in a row a plugin may overrun its budget before it is disabled */
+static const uint32_t MAX_PLUGIN_BUDGET_OVERRUNS = 8;
+
+static_assert(sizeof(ConduitBoneTransform) == sizeof(vr::VRBoneTransform_t), "Bone transforms must share a layout");
+
+/**
+ * @brief Copies the pose fields of an OpenVR driver pose into a plugin pose
+ */
+static void ToConduitDevicePose(const vr::DriverPose_t& pose, ConduitDevicePose& outPose) {
+	outPose.poseIsValid = pose.poseIsValid;
+	outPose.deviceIsConnected = pose.deviceIsConnected;
+	outPose.poseTimeOffset = pose.poseTimeOffset;
+
+	for (int i = 0; i < 3; i++) {
+		outPose.position[i] = pose.vecPosition[i];
+		outPose.velocity[i] = pose.vecVelocity[i];
+		outPose.acceleration[i] = pose.vecAcceleration[i];
+		outPose.angularVelocity[i] = pose.vecAngularVelocity[i];
+		outPose.angularAcceleration[i] = pose.vecAngularAcceleration[i];
+	}
+
+	outPose.rotation[0] = pose.qRotation.w;
+	outPose.rotation[1] = pose.qRotation.x;
+	outPose.rotation[2] = pose.qRotation.y;
+	outPose.rotation[3] = pose.qRotation.z;
+}
+
+/**
+ * @brief Copies a plugin pose into the pose fields of an OpenVR driver pose, leaving its other fields as they are
+ */
+static void FromConduitDevicePose(const ConduitDevicePose& pose, vr::DriverPose_t& outPose) {
+	outPose.poseIsValid = pose.poseIsValid != 0;
+	outPose.deviceIsConnected = pose.deviceIsConnected != 0;
+	outPose.poseTimeOffset = pose.poseTimeOffset;
+
+	for (int i = 0; i < 3; i++) {
+		outPose.vecPosition[i] = pose.position[i];
+		outPose.vecVelocity[i] = pose.velocity[i];
+		outPose.vecAcceleration[i] = pose.acceleration[i];
+		outPose.vecAngularVelocity[i] = pose.angularVelocity[i];
+		outPose.vecAngularAcceleration[i] = pose.angularAcceleration[i];
+	}
+
+	outPose.qRotation = { pose.rotation[0], pose.rotation[1], pose.rotation[2], pose.rotation[3] };
+}
+
+const ConduitHostApi PluginManager::hostApi = {
+	CONDUIT_PLUGIN_API_VERSION,
+	&PluginManager::hostGetComponentHandle,
+	&PluginManager::hostGetNaturalDevicePose,
+	&PluginManager::hostGetNaturalBoolean,
+	&PluginManager::hostGetNaturalScalar,
+	&PluginManager::hostSetOverriddenDevicePose,
+	&PluginManager::hostSetOverriddenBoolean,
+	&PluginManager::hostSetOverriddenScalar,
+	&PluginManager::hostLog
+};
+
+PluginManager& PluginManager::getInstance() {
+	static PluginManager instance;
+	return instance;
+}
+
+void PluginManager::loadPlugins(const std::string& pluginList) {
+	std::stringstream stream(pluginList);
+	std::string fileName;
+
+	while (std::getline(stream, fileName, ';')) {
+		fileName.erase(0, fileName.find_first_not_of(" \t"));
+		fileName.erase(fileName.find_last_not_of(" \t") + 1);
+		if (!fileName.empty()) this->loadPlugin(fileName);
+	}
+}
+
+void PluginManager::loadPlugin(const std::string& fileName) {
+	std::filesystem::path name(fileName);
+	if (name.filename() != name || name.extension() != ".dll") {
+		LogManager::log(LOG_ERROR, "Refusing to load plugin {}, only DLL file names are accepted", fileName);
+		return;
+	}
+
+	std::string path = (std::filesystem::path(PLUGIN_DIRECTORY) / name).string();
+	HMODULE module = LoadLibraryA(path.c_str());
+	if (!module) {
+		LogManager::log(LOG_ERROR, "Failed to load plugin {}: {}", path, GetLastError());
+		return;
+	}
+
+	auto init = reinterpret_cast<ConduitPluginInitFunction>(GetProcAddress(module, CONDUIT_PLUGIN_INIT_SYMBOL));
+	if (!init) {
+		LogManager::log(LOG_ERROR, "Plugin {} does not export {}", fileName, CONDUIT_PLUGIN_INIT_SYMBOL);
+		FreeLibrary(module);
+		return;
+	}
+
+	if (!this->initializePlugin(module, init, fileName)) FreeLibrary(module);
+}
+
+bool PluginManager::registerPlugin(const std::string& name, ConduitPluginInitFunction init) {
+	if (!init) return false;
+
+	return this->initializePlugin(nullptr, init, name);
+}
+
+bool PluginManager::initializePlugin(HMODULE module, ConduitPluginInitFunction init, const std::string& fileName) {
+	auto plugin = std::make_unique<LoadedPlugin>();
+	plugin->module = module;
+
+	if (!init(CONDUIT_PLUGIN_API_VERSION, &hostApi, &plugin->callbacks)) {
+		LogManager::log(LOG_ERROR, "Plugin {} failed to initialize", fileName);
+		return false;
+	}
+
+	plugin->name = plugin->callbacks.name ? plugin->callbacks.name : fileName;
+
+	uint32_t budget = plugin->callbacks.budgetMicroseconds;
+	plugin->budgetNanoseconds = static_cast<int64_t>(budget ? budget : DEFAULT_PLUGIN_BUDGET_US) * 1000;
+
+	LogManager::log(LOG_INFO, "Loaded plugin {} with a budget of {}ns", plugin->name, plugin->budgetNanoseconds);
+	this->plugins.push_back(std::move(plugin));
+	return true;
+}
+
+void PluginManager::unloadPlugins() {
+	// Disabling the hooks doesn't wait for threads already inside them, so the plugins are disabled first and each is
+	// only unloaded once no hook thread is inside its callbacks anymore
+	for (auto& plugin : this->plugins) plugin->enabled.store(false, std::memory_order_seq_cst);
+
+	for (auto& plugin : this->plugins) {
+		while (plugin->activeCalls.load(std::memory_order_seq_cst) != 0) std::this_thread::yield();
+
+		// The last hook thread to leave a disabled plugin shuts it down itself, and may still be doing so
+		shutdownPlugin(*plugin);
+		while (!plugin->shutdownFinished.load(std::memory_order_acquire)) std::this_thread::yield();
+
+		if (plugin->module) FreeLibrary(plugin->module);
+	}
+
+	this->plugins.clear();
+}
+
+template <typename Call>
+int32_t PluginManager::runCallback(LoadedPlugin& plugin, Call call) {
+	// The call is counted before enabled is checked, and the plugin is disabled before the count is checked, so either
+	// this call sees the plugin disabled, or whoever disabled it sees this call and leaves the shutdown to it
+	plugin.activeCalls.fetch_add(1, std::memory_order_seq_cst);
+
+	int32_t result = 0;
+	if (plugin.enabled.load(std::memory_order_seq_cst)) {
+		auto start = std::chrono::steady_clock::now();
+		result = call();
+		int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start
+		).count();
+
+		if (elapsed > plugin.longestCallNanoseconds.load(std::memory_order_relaxed)) {
+			plugin.longestCallNanoseconds.store(elapsed, std::memory_order_relaxed);
+		}
+
+		if (elapsed <= plugin.budgetNanoseconds) {
+			plugin.consecutiveOverruns.store(0, std::memory_order_relaxed);
+		} else {
+			// A single overrun is usually the thread being preempted, so only a plugin that keeps overrunning is
+			// disabled
+			uint32_t overruns = plugin.consecutiveOverruns.fetch_add(1, std::memory_order_relaxed) + 1;
+			if (overruns >= MAX_PLUGIN_BUDGET_OVERRUNS && plugin.enabled.exchange(false, std::memory_order_seq_cst)) {
+				LogManager::log(
+					LOG_ERROR,
+					"Disabled plugin {} after {} calls in a row over its {}ns budget, the longest took {}ns",
+					plugin.name,
+					overruns,
+					plugin.budgetNanoseconds,
+					plugin.longestCallNanoseconds.load(std::memory_order_relaxed)
+				);
+			}
+		}
+	}
+
+	// Other hook threads may still be inside the plugin, so the last one to leave it shuts it down
+	if (plugin.activeCalls.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+		!plugin.enabled.load(std::memory_order_seq_cst)
+	) {
+		shutdownPlugin(plugin);
+	}
+
+	return result;
+}
+
+void PluginManager::shutdownPlugin(LoadedPlugin& plugin) {
+	if (plugin.shutDown.exchange(true)) return;
+
+	if (plugin.callbacks.shutdown) plugin.callbacks.shutdown(plugin.callbacks.userData);
+	plugin.shutdownFinished.store(true, std::memory_order_release);
+}
+
+void PluginManager::applyPendingOverrides() {
+	if (!this->hasPendingOverrides.load(std::memory_order_acquire)) return;
+
+	DeviceStateModel& model = DeviceStateModel::getInstance();
+	std::unique_lock<std::shared_mutex> batchLock(model.getBatchMutex());
+
+	std::vector<PendingOverride> overrides;
+	{
+		std::lock_guard<std::mutex> lock(this->pendingOverrideMutex);
+		overrides.swap(this->pendingOverrides);
+		this->hasPendingOverrides.store(false, std::memory_order_relaxed);
+	}
+
+	// Applied like the matching client commands, so clients see plugin overrides in their models too
+	for (const PendingOverride& pendingOverride : overrides) {
+		switch (pendingOverride.type) {
+			case Object_DevicePose: {
+				ModelDevicePoseSerialized* modelPose = model.getDevicePose(pendingOverride.deviceIndex);
+				if (!modelPose) break;
+
+				model.setOverriddenDevicePose(
+					pendingOverride.deviceIndex,
+					FromDriverPose(pendingOverride.pose),
+					PoseField_All
+				);
+				modelPose->useOverriddenState = pendingOverride.useOverride;
+				model.setDevicePoseChanged(pendingOverride.deviceIndex);
+				break;
+			}
+			case Object_InputBoolean: {
+				ModelDeviceInputBooleanSerialized* input = model.getBooleanInput(pendingOverride.componentHandle);
+				if (!input) break;
+
+				input->data.overwrittenValue.value = pendingOverride.value != 0.0f;
+				input->useOverriddenState = pendingOverride.useOverride;
+				model.setInputBooleanChanged(pendingOverride.componentHandle);
+				break;
+			}
+			case Object_InputScalar: {
+				ModelDeviceInputScalarSerialized* input = model.getScalarInput(pendingOverride.componentHandle);
+				if (!input) break;
+
+				input->data.overwrittenValue.value = pendingOverride.value;
+				input->useOverriddenState = pendingOverride.useOverride;
+				model.setInputScalarChanged(pendingOverride.componentHandle);
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	SharedDeviceMemoryDriver::getInstance().countPluginOverrides();
+}
+
+void PluginManager::queueOverride(const PendingOverride& pendingOverride) {
+	std::lock_guard<std::mutex> lock(this->pendingOverrideMutex);
+	this->pendingOverrides.push_back(pendingOverride);
+	this->hasPendingOverrides.store(true, std::memory_order_release);
+}
+
+void PluginManager::recordNaturalPose(uint32_t deviceIndex, const vr::DriverPose_t& pose) {
+	if (this->plugins.empty() || deviceIndex >= vr::k_unMaxTrackedDeviceCount) return;
+
+	NaturalPose& naturalPose = this->naturalPoses[deviceIndex];
+	std::lock_guard<std::mutex> lock(naturalPose.poseMutex);
+	naturalPose.pose = pose;
+	naturalPose.recorded = true;
+}
+
+bool PluginManager::processDevicePose(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose) {
+	if (this->plugins.empty()) return false;
+
+	ConduitDevicePose pluginPose;
+	bool converted = false;
+	bool changed = false;
+
+	for (auto& plugin : this->plugins) {
+		if (!plugin->callbacks.onDevicePose || !plugin->enabled.load(std::memory_order_relaxed)) continue;
+
+		if (!converted) {
+			ToConduitDevicePose(pose, pluginPose);
+			converted = true;
+		}
+
+		changed |= this->runCallback(*plugin, [&] {
+			return plugin->callbacks.onDevicePose(plugin->callbacks.userData, deviceIndex, &pluginPose);
+		}) != 0;
+	}
+
+	if (!changed) return false;
+
+	outPose = pose;
+	FromConduitDevicePose(pluginPose, outPose);
+	return true;
+}
+
+bool PluginManager::processBoolean(vr::VRInputComponentHandle_t componentHandle, bool& value, double& timeOffset) {
+	if (this->plugins.empty()) return false;
+
+	int32_t pluginValue = value ? 1 : 0;
+	bool changed = false;
+
+	for (auto& plugin : this->plugins) {
+		if (!plugin->callbacks.onBooleanInput || !plugin->enabled.load(std::memory_order_relaxed)) continue;
+
+		changed |= this->runCallback(*plugin, [&] {
+			return plugin->callbacks.onBooleanInput(
+				plugin->callbacks.userData,
+				componentHandle,
+				&pluginValue,
+				&timeOffset
+			);
+		}) != 0;
+	}
+
+	value = pluginValue != 0;
+	return changed;
+}
+
+bool PluginManager::processScalar(vr::VRInputComponentHandle_t componentHandle, float& value, double& timeOffset) {
+	if (this->plugins.empty()) return false;
+
+	bool changed = false;
+
+	for (auto& plugin : this->plugins) {
+		if (!plugin->callbacks.onScalarInput || !plugin->enabled.load(std::memory_order_relaxed)) continue;
+
+		changed |= this->runCallback(*plugin, [&] {
+			return plugin->callbacks.onScalarInput(plugin->callbacks.userData, componentHandle, &value, &timeOffset);
+		}) != 0;
+	}
+
+	return changed;
+}
+
+bool PluginManager::processSkeleton(
+	vr::VRInputComponentHandle_t componentHandle,
+	vr::EVRSkeletalMotionRange motionRange,
+	const vr::VRBoneTransform_t* transforms,
+	uint32_t transformCount,
+	vr::VRBoneTransform_t* outTransforms
+) {
+	if (this->plugins.empty() || !transforms) return false;
+
+	transformCount = (std::min)(transformCount, 31U);
+	bool copied = false;
+	bool changed = false;
+
+	for (auto& plugin : this->plugins) {
+		if (!plugin->callbacks.onSkeletonInput || !plugin->enabled.load(std::memory_order_relaxed)) continue;
+
+		if (!copied) {
+			memcpy(outTransforms, transforms, transformCount * sizeof(vr::VRBoneTransform_t));
+			copied = true;
+		}
+
+		changed |= this->runCallback(*plugin, [&] {
+			return plugin->callbacks.onSkeletonInput(
+				plugin->callbacks.userData,
+				componentHandle,
+				static_cast<int32_t>(motionRange),
+				reinterpret_cast<ConduitBoneTransform*>(outTransforms),
+				transformCount
+			);
+		}) != 0;
+	}
+
+	return changed;
+}
+
+int32_t PluginManager::hostGetComponentHandle(uint32_t deviceIndex, const char* path, uint64_t* outComponentHandle) {
+	if (!path || !outComponentHandle) return 0;
+
+	vr::VRInputComponentHandle_t componentHandle;
+	if (!DeviceStateModel::getInstance().getComponentHandle(deviceIndex, path, &componentHandle)) return 0;
+
+	*outComponentHandle = componentHandle;
+	return 1;
+}
+
+int32_t PluginManager::hostGetNaturalDevicePose(uint32_t deviceIndex, ConduitDevicePose* outPose) {
+	// The model pose is only kept up to date while a client is attached, so the pose hook records one for plugins
+	if (!outPose || deviceIndex >= vr::k_unMaxTrackedDeviceCount) return 0;
+	if (!DeviceStateModel::getInstance().getDevicePose(deviceIndex)) return 0;
+
+	NaturalPose& naturalPose = getInstance().naturalPoses[deviceIndex];
+	std::lock_guard<std::mutex> lock(naturalPose.poseMutex);
+	if (!naturalPose.recorded) return 0;
+
+	ToConduitDevicePose(naturalPose.pose, *outPose);
+	return 1;
+}
+
+int32_t PluginManager::hostGetNaturalBoolean(uint64_t componentHandle, int32_t* outValue) {
+	ModelDeviceInputBooleanSerialized* input = DeviceStateModel::getInstance().getBooleanInput(componentHandle);
+	if (!input || !outValue) return 0;
+
+	*outValue = input->data.value.value ? 1 : 0;
+	return 1;
+}
+
+int32_t PluginManager::hostGetNaturalScalar(uint64_t componentHandle, float* outValue) {
+	ModelDeviceInputScalarSerialized* input = DeviceStateModel::getInstance().getScalarInput(componentHandle);
+	if (!input || !outValue) return 0;
+
+	*outValue = input->data.value.value;
+	return 1;
+}
+
+int32_t PluginManager::hostSetOverriddenDevicePose(
+	uint32_t deviceIndex,
+	const ConduitDevicePose* pose,
+	int32_t useOverride
+) {
+	if (!pose || deviceIndex >= vr::k_unMaxTrackedDeviceCount) return 0;
+	if (!DeviceStateModel::getInstance().getDevicePose(deviceIndex)) return 0;
+
+	PluginManager& pluginManager = getInstance();
+	PendingOverride pendingOverride;
+	pendingOverride.type = Object_DevicePose;
+	pendingOverride.deviceIndex = deviceIndex;
+	pendingOverride.useOverride = useOverride != 0;
+
+	// Fields the plugin pose doesn't carry are taken from the natural pose
+	{
+		NaturalPose& naturalPose = pluginManager.naturalPoses[deviceIndex];
+		std::lock_guard<std::mutex> lock(naturalPose.poseMutex);
+		pendingOverride.pose = naturalPose.pose;
+	}
+	FromConduitDevicePose(*pose, pendingOverride.pose);
+
+	pluginManager.queueOverride(pendingOverride);
+	return 1;
+}
+
+int32_t PluginManager::hostSetOverriddenBoolean(uint64_t componentHandle, int32_t value, int32_t useOverride) {
+	if (!DeviceStateModel::getInstance().getBooleanInput(componentHandle)) return 0;
+
+	PendingOverride pendingOverride;
+	pendingOverride.type = Object_InputBoolean;
+	pendingOverride.componentHandle = componentHandle;
+	pendingOverride.value = value != 0 ? 1.0f : 0.0f;
+	pendingOverride.useOverride = useOverride != 0;
+
+	getInstance().queueOverride(pendingOverride);
+	return 1;
+}
+
+int32_t PluginManager::hostSetOverriddenScalar(uint64_t componentHandle, float value, int32_t useOverride) {
+	if (!DeviceStateModel::getInstance().getScalarInput(componentHandle)) return 0;
+
+	PendingOverride pendingOverride;
+	pendingOverride.type = Object_InputScalar;
+	pendingOverride.componentHandle = componentHandle;
+	pendingOverride.value = value;
+	pendingOverride.useOverride = useOverride != 0;
+
+	getInstance().queueOverride(pendingOverride);
+	return 1;
+}
+
+void PluginManager::hostLog(const char* message) {
+	if (message) LogManager::log(LOG_INFO, "[plugin] {}", message);
+}
@@ -0,0 +1,120 @@
+#include "PoseExtrapolator.h"
+
+#include <algorithm>
+#include <cmath>
+
+/** @brief Overrides arriving longer than this in seconds after the last sent pose snap instead of blending */
+static const double MAX_CORRECTION_GAP_SECONDS = 0.25;
+
+/**
+ * @brief Returns the rotation of <angularVelocity> in radians per second applied for <dt> seconds
+ */
+static vr::HmdQuaternion_t integrateAngularVelocity(const double angularVelocity[3], double dt) {
+	double speed = std::sqrt(
+		angularVelocity[0] * angularVelocity[0] +
+		angularVelocity[1] * angularVelocity[1] +
+		angularVelocity[2] * angularVelocity[2]
+	);
+
+	double halfAngle = 0.5 * speed * dt;
+	if (halfAngle < 1e-9) return { 1.0, 0.0, 0.0, 0.0 };
+
+	double scale = std::sin(halfAngle) / speed;
+	return {
+		std::cos(halfAngle),
+		angularVelocity[0] * scale,
+		angularVelocity[1] * scale,
+		angularVelocity[2] * scale
+	};
+}
+
+PoseExtrapolator& PoseExtrapolator::getInstance() {
+	static PoseExtrapolator instance;
+	return instance;
+}
+
+void PoseExtrapolator::setConfig(uint32_t deviceIndex, const PoseExtrapolationConfig& config) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return;
+
+	std::lock_guard<std::mutex> lock(this->extrapolatorMutex);
+
+	ExtrapolationState& state = this->states[deviceIndex];
+	state = ExtrapolationState{};
+	state.config = config;
+	state.config.maxHorizonSeconds = (std::max)(config.maxHorizonSeconds, 0.0);
+	state.config.correctionSeconds = (std::max)(config.correctionSeconds, 0.0);
+	state.overrideTime = std::chrono::steady_clock::now();
+
+	this->extrapolationEnabled[deviceIndex].store(config.enabled, std::memory_order_release);
+}
+
+void PoseExtrapolator::recordOverride(uint32_t deviceIndex, const vr::DriverPose_t& pose) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return;
+	if (!this->extrapolationEnabled[deviceIndex].load(std::memory_order_acquire)) return;
+
+	std::lock_guard<std::mutex> lock(this->extrapolatorMutex);
+
+	ExtrapolationState& state = this->states[deviceIndex];
+	auto now = std::chrono::steady_clock::now();
+	state.overrideTime = now;
+
+	for (int i = 0; i < 3; i++) state.positionError[i] = 0.0;
+	state.rotationError = { 1.0, 0.0, 0.0, 0.0 };
+
+	// Without a recent pose to blend from, e.g. after tracking loss or a pause in overrides, snap to the override
+	double gap = std::chrono::duration<double>(now - state.outputTime).count();
+	if (!state.hasOutput || !pose.poseIsValid || gap > MAX_CORRECTION_GAP_SECONDS) return;
+	if (state.config.correctionSeconds <= 0.0) return;
+
+	for (int i = 0; i < 3; i++) state.positionError[i] = state.lastPosition[i] - pose.vecPosition[i];
+
+	const vr::HmdQuaternion_t& q = pose.qRotation;
+	state.rotationError = MultiplyQuaternions(state.lastRotation, { q.w, -q.x, -q.y, -q.z });
+}
+
+bool PoseExtrapolator::extrapolate(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return false;
+	if (!this->extrapolationEnabled[deviceIndex].load(std::memory_order_acquire)) return false;
+
+	std::lock_guard<std::mutex> lock(this->extrapolatorMutex);
+
+	ExtrapolationState& state = this->states[deviceIndex];
+	const PoseExtrapolationConfig& config = state.config;
+	if (!config.enabled) return false;
+
+	if (!pose.poseIsValid) {
+		state.hasOutput = false;
+		return false;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	double elapsed = (std::max)(std::chrono::duration<double>(now - state.overrideTime).count(), 0.0);
+	double dt = (std::min)(elapsed, config.maxHorizonSeconds);
+
+	outPose = pose;
+
+	for (int i = 0; i < 3; i++) {
+		double acceleration = config.useAcceleration ? pose.vecAcceleration[i] : 0.0;
+		outPose.vecPosition[i] += pose.vecVelocity[i] * dt + 0.5 * acceleration * dt * dt;
+		outPose.vecVelocity[i] += acceleration * dt;
+	}
+
+	// Angular velocity is taken in the same driver space as the velocity, so the rotation applies on the left
+	outPose.qRotation = MultiplyQuaternions(integrateAngularVelocity(pose.vecAngularVelocity, dt), pose.qRotation);
+
+	if (config.correctionSeconds > 0.0 && elapsed < config.correctionSeconds) {
+		double weight = 1.0 - elapsed / config.correctionSeconds;
+
+		for (int i = 0; i < 3; i++) outPose.vecPosition[i] += state.positionError[i] * weight;
+
+		vr::HmdQuaternion_t correction = SlerpQuaternions({ 1.0, 0.0, 0.0, 0.0 }, state.rotationError, weight);
+		outPose.qRotation = MultiplyQuaternions(correction, outPose.qRotation);
+	}
+
+	for (int i = 0; i < 3; i++) state.lastPosition[i] = outPose.vecPosition[i];
+	state.lastRotation = outPose.qRotation;
+	state.outputTime = now;
+	state.hasOutput = true;
+
+	return true;
+}
@@ -1,7 +1,25 @@
 #include "SharedDeviceMemoryDriver.h"
-
-const uint32_t PROTOCOL_VERSION = 5;
-const uint32_t SHARED_MEMORY_SIZE = sizeof(SharedMemoryHeader) + PATH_TABLE_SIZE + 2 * LANE_SIZE;
+#include "TransformRuleManager.h"
+#include "InputFilterEngine.h"
+#include "SmoothingFilterManager.h"
+#include "CommandScheduler.h"
+#include "AnimationPlayer.h"
+#include "PoseExtrapolator.h"
+#include "MirroredRing.h"
+#include "HapticsManager.h"
+#include "PluginManager.h"
+
+#include <psapi.h>
+#include <algorithm>
+#include <thread>
+
+const uint32_t PROTOCOL_VERSION = 24;
+const uint32_t COMMAND_STATUS_RING_BYTES = COMMAND_STATUS_RING_SIZE * sizeof(CommandStatusEntry);
+const uint32_t ANIMATION_BLOB_BYTES = MAX_ANIMATION_TRACKS * ANIMATION_TRACK_SLOT_SIZE;
+const uint32_t HAPTIC_LANE_BYTES = HAPTIC_LANE_SIZE * sizeof(HapticEventRecord);
+const uint32_t SHARED_MEMORY_SIZE =
+	sizeof(SharedMemoryHeader) + PATH_TABLE_SIZE + 2 * LANE_SIZE + COMMAND_STATUS_RING_BYTES + ANIMATION_BLOB_BYTES +
+	sizeof(DeviceRegistry) + HAPTIC_LANE_BYTES;
 
 SharedDeviceMemoryDriver& SharedDeviceMemoryDriver::getInstance() {
 	static SharedDeviceMemoryDriver instance;
@@ -9,33 +27,179 @@ SharedDeviceMemoryDriver& SharedDeviceMemoryDriver::getInstance() {
 }
 
 SharedDeviceMemoryDriver::~SharedDeviceMemoryDriver() {
+	if (this->mirroredLanes) {
+		unmapMirroredView(this->driverClientLane, LANE_SIZE);
+		unmapMirroredView(this->clientDriverLane, LANE_SIZE);
+		CloseHandle(this->driverClientLaneHandle);
+		CloseHandle(this->clientDriverLaneHandle);
+	}
+
 	UnmapViewOfFile(this->sharedMemory);
 	CloseHandle(this->sharedMemoryHandle);
 }
 
-bool SharedDeviceMemoryDriver::initialize() {
-	// Create shared memory
+/**
+ * @brief Enables SeLockMemoryPrivilege on the process token, which large page mappings require. This only succeeds if
+ * the user running SteamVR was granted the "Lock pages in memory" right
+ */
+static bool enableLockMemoryPrivilege() {
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+
+	TOKEN_PRIVILEGES privileges = {};
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+	bool enabled = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+		AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+		GetLastError() == ERROR_SUCCESS;	// AdjustTokenPrivileges succeeds without assigning unheld privileges
+
+	CloseHandle(token);
+	return enabled;
+}
+
+bool SharedDeviceMemoryDriver::initialize(bool lockedMapping, bool mirroredLanes) {
+	this->mappingSize = SHARED_MEMORY_SIZE;
+
+	// Create shared memory, falling back to regular pages if large pages are unavailable
+	if (!lockedMapping || !this->createLargePageSharedMemory()) {
+		this->sharedMemoryHandle = CreateFileMappingA(
+			INVALID_HANDLE_VALUE,
+			nullptr,
+			PAGE_READWRITE,
+			0,
+			SHARED_MEMORY_SIZE,
+			SHM_NAME
+		);
+	}
+
+	if (!this->sharedMemoryHandle) {
+		LogManager::log(LOG_ERROR, "Failed to create shared memory handle: {}", GetLastError());
+		return false;
+	}
+
+	this->sharedMemory = MapViewOfFile(this->sharedMemoryHandle, FILE_MAP_ALL_ACCESS, 0, 0, this->mappingSize);
+
+	if (!this->sharedMemory) {
+		LogManager::log(LOG_ERROR, "Failed to map shared memory: {}", GetLastError());
+		return false;
+	}
+
+	if (lockedMapping) this->prefaultSharedMemory();
+	if (mirroredLanes) this->createMirroredLanes();
+
+	if (!this->initializeSharedMemoryData()) {
+		LogManager::log(LOG_ERROR, "Failed to initialize shared memory data: {}", GetLastError());
+		return false;
+	}
+
+	return true;
+}
+
+bool SharedDeviceMemoryDriver::createLargePageSharedMemory() {
+	SIZE_T largePageSize = GetLargePageMinimum();
+	if (largePageSize == 0) {
+		LogManager::log(LOG_INFO, "Large pages are not supported, using regular pages for shared memory");
+		return false;
+	}
+
+	if (!enableLockMemoryPrivilege()) {
+		LogManager::log(LOG_INFO, "SeLockMemoryPrivilege is not held, using regular pages for shared memory");
+		return false;
+	}
+
+	// Large page mappings must span whole large pages
+	uint32_t roundedSize = static_cast<uint32_t>(
+		(SHARED_MEMORY_SIZE + largePageSize - 1) / largePageSize * largePageSize
+	);
+
 	this->sharedMemoryHandle = CreateFileMappingA(
 		INVALID_HANDLE_VALUE,
 		nullptr,
-		PAGE_READWRITE,
+		PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES,
 		0,
-		SHARED_MEMORY_SIZE,
+		roundedSize,
 		SHM_NAME
 	);
 
 	if (!this->sharedMemoryHandle) {
-		LogManager::log(LOG_ERROR, "Failed to create shared memory handle: {}", GetLastError());
+		LogManager::log(LOG_INFO, "Failed to create large page shared memory, using regular pages: {}", GetLastError());
 		return false;
 	}
 
-	this->sharedMemory = MapViewOfFile(this->sharedMemoryHandle, FILE_MAP_ALL_ACCESS, 0, 0, SHARED_MEMORY_SIZE);
+	this->mappingSize = roundedSize;
+	this->mappingFlags |= SharedMemoryMapping_LargePages;
+	return true;
+}
+
+void SharedDeviceMemoryDriver::prefaultSharedMemory() {
+	HANDLE process = GetCurrentProcess();
 
-	if (!this->initializeSharedMemoryData()) {
-		LogManager::log(LOG_ERROR, "Failed to initialize shared memory data: {}", GetLastError());
+	PROCESS_MEMORY_COUNTERS countersBefore = {};
+	GetProcessMemoryInfo(process, &countersBefore, sizeof(countersBefore));
+
+	// The mapping is still all zeroes, so writing every page commits it without changing its contents
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	volatile uint8_t* bytes = static_cast<volatile uint8_t*>(this->sharedMemory);
+	for (uint32_t offset = 0; offset < this->mappingSize; offset += systemInfo.dwPageSize) bytes[offset] = 0;
+
+	PROCESS_MEMORY_COUNTERS countersAfter = {};
+	GetProcessMemoryInfo(process, &countersAfter, sizeof(countersAfter));
+
+	// Large pages are never paged out, while regular pages need room in the working set to be locked
+	bool locked = (this->mappingFlags & SharedMemoryMapping_LargePages) != 0;
+	if (!locked) {
+		SIZE_T minimumSize, maximumSize;
+		if (GetProcessWorkingSetSize(process, &minimumSize, &maximumSize)) {
+			SetProcessWorkingSetSize(process, minimumSize + this->mappingSize, maximumSize + this->mappingSize);
+		}
+
+		locked = VirtualLock(this->sharedMemory, this->mappingSize) != 0;
+		if (!locked) LogManager::log(LOG_ERROR, "Failed to lock shared memory: {}", GetLastError());
+	}
+
+	if (locked) this->mappingFlags |= SharedMemoryMapping_Locked;
+
+	LogManager::log(
+		LOG_INFO,
+		"Prefaulted {} bytes of shared memory with {} page faults (large pages: {}, locked: {})",
+		this->mappingSize,
+		countersAfter.PageFaultCount - countersBefore.PageFaultCount,
+		(this->mappingFlags & SharedMemoryMapping_LargePages) != 0,
+		locked
+	);
+}
+
+bool SharedDeviceMemoryDriver::createMirroredLanes() {
+	this->driverClientLaneHandle = CreateFileMappingA(
+		INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, LANE_SIZE, DRIVER_CLIENT_LANE_NAME
+	);
+	this->clientDriverLaneHandle = CreateFileMappingA(
+		INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, LANE_SIZE, CLIENT_DRIVER_LANE_NAME
+	);
+
+	if (this->driverClientLaneHandle && this->clientDriverLaneHandle) {
+		this->driverClientLane = mapMirroredView(this->driverClientLaneHandle, LANE_SIZE);
+		this->clientDriverLane = mapMirroredView(this->clientDriverLaneHandle, LANE_SIZE);
+	}
+
+	if (!this->driverClientLane || !this->clientDriverLane) {
+		LogManager::log(LOG_INFO, "Failed to mirror lanes, using the lanes in shared memory: {}", GetLastError());
+
+		unmapMirroredView(this->driverClientLane, LANE_SIZE);
+		unmapMirroredView(this->clientDriverLane, LANE_SIZE);
+		if (this->driverClientLaneHandle) CloseHandle(this->driverClientLaneHandle);
+		if (this->clientDriverLaneHandle) CloseHandle(this->clientDriverLaneHandle);
+
+		this->driverClientLane = this->clientDriverLane = nullptr;
+		this->driverClientLaneHandle = this->clientDriverLaneHandle = nullptr;
 		return false;
 	}
 
+	this->mirroredLanes = true;
+	this->mappingFlags |= SharedMemoryMapping_MirroredLanes;
+	LogManager::log(LOG_INFO, "Mirrored both lanes");
 	return true;
 }
 
@@ -54,6 +218,7 @@ bool SharedDeviceMemoryDriver::initializeSharedMemoryData() {
 	currentOffset += PATH_TABLE_SIZE;
 
 	header.driverClientLaneStart = this->driverClientLaneStart = currentOffset;
+	if (!this->mirroredLanes) this->driverClientLane = static_cast<uint8_t*>(this->sharedMemory) + currentOffset;
 	header.driverClientLaneSize = LANE_SIZE;
 	header.driverClientWriteCount = 0;
 	header.driverClientWriteOffset = 0;
@@ -62,13 +227,48 @@ bool SharedDeviceMemoryDriver::initializeSharedMemoryData() {
 	currentOffset += LANE_SIZE;
 
 	header.clientDriverLaneStart = this->clientDriverLaneStart = currentOffset;
+	if (!this->mirroredLanes) this->clientDriverLane = static_cast<uint8_t*>(this->sharedMemory) + currentOffset;
 	header.clientDriverLaneSize = LANE_SIZE;
 	header.clientDriverWriteCount = 0;
 	header.clientDriverWriteOffset = 0;
 	header.clientDriverReadOffset = 0;
 
+	currentOffset += LANE_SIZE;
+
+	header.commandStatusRingStart = this->commandStatusRingStart = currentOffset;
+	header.commandAckCount = 0;
+	header.pluginOverrideCount = 0;
+
+	currentOffset += COMMAND_STATUS_RING_BYTES;
+
+	header.animationBlobStart = this->animationBlobStart = currentOffset;
+
+	currentOffset += ANIMATION_BLOB_BYTES;
+
+	header.deviceRegistryStart = currentOffset;
+	header.deviceRegistryVersion = 0;
+	this->deviceRegistry = reinterpret_cast<DeviceRegistry*>(static_cast<uint8_t*>(this->sharedMemory) + currentOffset);
+
+	currentOffset += sizeof(DeviceRegistry);
+
+	header.hapticLaneStart = currentOffset;
+	header.hapticWriteCount = 0;
+	this->hapticLane = reinterpret_cast<HapticEventRecord*>(static_cast<uint8_t*>(this->sharedMemory) + currentOffset);
+
+	header.mappingFlags = this->mappingFlags;
+	header.mappingSize = this->mappingSize;
+
+	header.clientHeartbeatNanoseconds = 0;
+	header.clientGeneration = 0;
+
 	memcpy(this->sharedMemory, &header, sizeof(SharedMemoryHeader));
 
+	// Fresh mappings are zeroed, which would read as an applied status for version 0
+	CommandStatusEntry* ring = reinterpret_cast<CommandStatusEntry*>(
+		static_cast<uint8_t*>(this->sharedMemory) + this->commandStatusRingStart
+	);
+	for (uint32_t i = 0; i < COMMAND_STATUS_RING_SIZE; i++) ring[i].version.store(UINT64_MAX, std::memory_order_relaxed);
+
 	return true;
 }
 
@@ -97,12 +297,17 @@ std::string SharedDeviceMemoryDriver::getPathFromPathOffset(uint32_t offset) {
 uint32_t SharedDeviceMemoryDriver::getOffsetOfPath(const std::string& path) {
 	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
 
-	auto foundOffet = this->pathTableOffsets.find(path);
-	if (foundOffet != this->pathTableOffsets.end()) {
-		headerPtr->pathTableWritingOffset.store(UINT32_MAX, std::memory_order_release);
-		return foundOffet->second;
+	{
+		std::shared_lock<std::shared_mutex> lookupLock(this->pathTableMutex);
+		auto foundOffet = this->pathTableOffsets.find(path);
+		if (foundOffet != this->pathTableOffsets.end()) return foundOffet->second;
 	}
 
+	// Another producer may have added the path between the lookup and taking the exclusive lock
+	std::unique_lock<std::shared_mutex> appendLock(this->pathTableMutex);
+	auto foundOffet = this->pathTableOffsets.find(path);
+	if (foundOffet != this->pathTableOffsets.end()) return foundOffet->second;
+
 	uint32_t offset = this->currentPathTableWriteOffset;
 	uint32_t writeSize = (uint32_t) path.length() + 1;
 
@@ -125,242 +330,671 @@ uint32_t SharedDeviceMemoryDriver::getOffsetOfPath(const std::string& path) {
 }
 
 void SharedDeviceMemoryDriver::pollForClientUpdates() {
+	// Covers scheduled commands whose devices have stopped updating, so they still apply close to on time
+	CommandScheduler::getInstance().applyDueCommands();
+	PluginManager::getInstance().applyPendingOverrides();
+
+	this->updateClientPresence();
+	this->drainClientDriverLane(UINT32_MAX, false);
+}
+
+void SharedDeviceMemoryDriver::drainClientDriverLane(uint32_t maxPackets, bool lightCommandsOnly) {
 	SharedMemoryHeader* headerPtr = static_cast<SharedMemoryHeader*>(this->sharedMemory);
 	DeviceStateModel& model = DeviceStateModel::getInstance();
 
+	// A single load while nothing is pending, which is the common case for the hooks
 	uint64_t currentWriteCount = headerPtr->clientDriverWriteCount.load(std::memory_order_acquire);
+	if (currentWriteCount <= this->drainedClientDriverCount.load(std::memory_order_relaxed)) return;
+
+	// Whoever holds the lock is already draining the lane, so other callers carry on instead of waiting
+	std::unique_lock<std::mutex> readLock(this->clientDriverReadMutex, std::try_to_lock);
+	if (!readLock.owns_lock()) return;
+
 	if (this->clientDriverLaneReadCount < currentWriteCount) {
 		std::atomic_thread_fence(std::memory_order_acquire);
 
 		ClientCommandHeaderData commandHeader;
+		uint32_t packetsRead = 0;
+		bool reachedLimit = false;
 		do {
-			auto packet = this->readPacketFromClientDriverLane();
+			// A deferred heavy command comes next in lane order, so a hook stops at it again
+			std::pair<ClientCommandHeaderData, std::pair<ClientCommandType, std::unique_ptr<uint8_t[]>>> packet;
+			if (this->deferredPacket.first.successful) {
+				if (lightCommandsOnly) {
+					reachedLimit = true;
+					break;
+				}
+
+				packet = std::move(this->deferredPacket);
+				this->deferredPacket = {};
+			} else {
+				packet = this->readPacketFromClientDriverLane();
+			}
 			commandHeader = packet.first;
 
+			// Realigning skips packets, so an open batch may have lost some of its commands or its commit
+			if (this->readerRealigned) {
+				this->readerRealigned = false;
+				if (this->batchOpen) this->discardStagedBatch("the reader realigned");
+			}
+
 			if (!commandHeader.successful) break;
 
-			std::unique_ptr<uint8_t[]>& paramsBuf = packet.second.second;
+			// Read packets can't be put back, so a heavy one is held until the poll thread drains the lane
+			bool heavyCommand = isHeavyCommand(commandHeader.type) ||
+				(commandHeader.type == Command_CommitBatch && this->stagedBatchHasHeavyCommand);
+			if (lightCommandsOnly && heavyCommand) {
+				this->deferredPacket = std::move(packet);
+				reachedLimit = true;
+				break;
+			}
 
-			uint32_t deviceIndex = commandHeader.deviceIndex;
-			std::string path;
+			std::unique_ptr<uint8_t[]>& paramsBuf = packet.second.second;
 
 			switch (commandHeader.type) {
-				case Command_SetUseOverriddenStateDevicePose: {
-						CommandParams_SetUseOverriddenStateDevicePose * params =
-							reinterpret_cast<CommandParams_SetUseOverriddenStateDevicePose*>(paramsBuf.get());
-						ModelDevicePoseSerialized* pose = model.getDevicePose(deviceIndex);
-						if (pose) pose->useOverriddenState = params->useOverriddenState;
-
-						break;
-				}
-				case Command_SetOverriddenStateDevicePose: {
-					CommandParams_SetOverriddenStateDevicePose* params =
-						reinterpret_cast<CommandParams_SetOverriddenStateDevicePose*>(paramsBuf.get());
-					ModelDevicePoseSerialized* pose = model.getDevicePose(deviceIndex);
-					if (pose) {
-						pose->data.overwrittenPose = params->overriddenPose;
-						model.setDevicePoseChanged(deviceIndex);
-					}
+				case Command_BeginBatch: {
+					CommandParams_BeginBatch* params = reinterpret_cast<CommandParams_BeginBatch*>(paramsBuf.get());
+					if (this->batchOpen) this->discardStagedBatch("it was never committed");
 
+					this->stagedBatchCommands.reserve(params->commandCount);
+					this->stagedBatchCommandCount = params->commandCount;
+					this->batchOpen = true;
 					break;
 				}
-				case Command_SetUseOverriddenStateDeviceInput: {
-					CommandParams_SetUseOverriddenStateDeviceInput* params = 
-						reinterpret_cast<CommandParams_SetUseOverriddenStateDeviceInput*>(paramsBuf.get());
-					std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
-
-					ModelDeviceInputBooleanSerialized* inputBoolean = model.getBooleanInput(deviceIndex, inputPath);
-					if (inputBoolean) {
-						inputBoolean->useOverriddenState = params->useOverriddenState;
-						model.setInputBooleanChanged(deviceIndex, inputPath);
-						break;
-					}
+				case Command_CommitBatch: {
+					CommandParams_CommitBatch* params = reinterpret_cast<CommandParams_CommitBatch*>(paramsBuf.get());
 
-					ModelDeviceInputScalarSerialized* inputScalar = model.getScalarInput(deviceIndex, inputPath);
-					if (inputScalar) {
-						inputScalar->useOverriddenState = params->useOverriddenState;
-						model.setInputScalarChanged(deviceIndex, inputPath);
+					// A count mismatch means packets were dropped by realignment, so applying would tear the batch
+					if (!this->batchOpen || this->stagedBatchCommands.size() != params->commandCount) {
+						this->discardStagedBatch("it is incomplete");
 						break;
 					}
 
-					ModelDeviceInputSkeletonSerialized* inputSkeleton = model.getSkeletonInput(deviceIndex, inputPath);
-					if (inputSkeleton) {
-						inputSkeleton->useOverriddenState = params->useOverriddenState;
-						model.setInputSkeletonChanged(deviceIndex, inputPath);
-						break;
-					}
-
-					ModelDeviceInputPoseSerialized* inputPose = model.getPoseInput(deviceIndex, inputPath);
-					if (inputPose) {
-						inputPose->useOverriddenState = params->useOverriddenState;
-						model.setInputPoseChanged(deviceIndex, inputPath);
-						break;
-					}
+					{
+						std::unique_lock<std::shared_mutex> batchLock(model.getBatchMutex());
+						for (auto& stagedCommand : this->stagedBatchCommands) {
+							if (this->scheduleCommand(stagedCommand.first, stagedCommand.second)) continue;
 
-					ModelDeviceInputEyeTrackingSerialized* inputEyeTracking = model.getEyeTrackingInput(
-						deviceIndex, 
-						inputPath
-					);
-					if (inputEyeTracking) {
-						inputEyeTracking->useOverriddenState = params->useOverriddenState;
-						model.setInputEyeTrackingChanged(deviceIndex, inputPath);
-						break;
+							CommandStatus status = this->applyCommand(stagedCommand.first, stagedCommand.second.get());
+							this->writeCommandStatus(stagedCommand.first, status);
+						}
 					}
 
+					this->stagedBatchCommands.clear();
+					this->stagedBatchHasHeavyCommand = false;
+					this->batchOpen = false;
 					break;
 				}
-				case Command_SetOverriddenStateDeviceInputBoolean: {
-					CommandParams_SetOverriddenStateDeviceInputBoolean* params =
-						reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputBoolean*>(paramsBuf.get());
-					std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
-
-					ModelDeviceInputBooleanSerialized* input = model.getBooleanInput(deviceIndex, inputPath);
-					if (input) {
-						input->data.overwrittenValue = params->overriddenValue;
-						model.setInputBooleanChanged(deviceIndex, inputPath);
+				default: {
+					// Clients write a batch in one go, so a full batch followed by anything but its commit lost it
+					if (this->batchOpen && this->stagedBatchCommands.size() >= this->stagedBatchCommandCount) {
+						this->discardStagedBatch("its commit was lost");
 					}
 
-					break;
-				}
-				case Command_SetOverriddenStateDeviceInputScalar: {
-					CommandParams_SetOverriddenStateDeviceInputScalar* params =
-						reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputScalar*>(paramsBuf.get());
-					std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
-
-					ModelDeviceInputScalarSerialized* input = model.getScalarInput(deviceIndex, inputPath);
-					if (input) { 
-						input->data.overwrittenValue = params->overriddenValue;
-						model.setInputScalarChanged(deviceIndex, inputPath);
+					if (this->batchOpen) {
+						this->stagedBatchHasHeavyCommand |= heavyCommand;
+						this->stagedBatchCommands.emplace_back(commandHeader, std::move(paramsBuf));
+					} else if (!this->scheduleCommand(commandHeader, paramsBuf)) {
+						// Scheduled commands apply from the hooks, so this keeps the two from interleaving
+						std::unique_lock<std::shared_mutex> batchLock(model.getBatchMutex());
+						this->writeCommandStatus(commandHeader, this->applyCommand(commandHeader, paramsBuf.get()));
 					}
-
 					break;
 				}
-				case Command_SetOverriddenStateDeviceInputSkeleton: {
-					CommandParams_SetOverriddenStateDeviceInputSkeleton* params = reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputSkeleton*>(paramsBuf.get());
-					std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
-
-					ModelDeviceInputSkeletonSerialized* input = model.getSkeletonInput(deviceIndex, inputPath);
-					if (input) { 
-						input->data.overwrittenValue = params->overriddenValue;
-						model.setInputSkeletonChanged(deviceIndex, inputPath);
-					}
+			}
 
-					break;
-				}
-				case Command_SetOverriddenStateDeviceInputPose: {
-					CommandParams_SetOverriddenStateDeviceInputPose* params = reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputPose*>(paramsBuf.get());
-					std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
-
-					ModelDeviceInputPoseSerialized* input = model.getPoseInput(deviceIndex, inputPath);
-					if (input) { 
-						input->data.overwrittenValue = params->overriddenValue;
-						model.setInputPoseChanged(deviceIndex, inputPath);
-					}
+			// Clients write the count before their own increment as the version, so packet v leaves v + 1 read
+			this->clientDriverLaneReadCount = commandHeader.version + 1;
 
-					break;
-				}
-				case Command_SetOverriddenStateDeviceInputEyeTracking: {
-					CommandParams_SetOverriddenStateDeviceInputEyeTracking* params = reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputEyeTracking*>(paramsBuf.get());
-					std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
-
-					ModelDeviceInputEyeTrackingSerialized* input = model.getEyeTrackingInput(deviceIndex, inputPath);
-					if (input) {
-						input->data.overwrittenValue = params->overriddenValue;
-						model.setInputEyeTrackingChanged(deviceIndex, inputPath);
-					}
+			// The rest is left for the next caller, so a hook never stalls its device on a long backlog
+			if (++packetsRead >= maxPackets && this->clientDriverLaneReadCount < currentWriteCount) {
+				reachedLimit = true;
+				break;
+			}
+		} while (this->clientDriverLaneReadCount < currentWriteCount);
 
-					break;
-				}
+		if (!reachedLimit) this->clientDriverLaneReadCount = currentWriteCount;
+		headerPtr->commandAckCount.store(this->clientDriverLaneReadCount, std::memory_order_release);
+	}
+
+	this->drainedClientDriverCount.store(this->clientDriverLaneReadCount, std::memory_order_relaxed);
+}
+
+void SharedDeviceMemoryDriver::discardStagedBatch(const char* reason) {
+	size_t commandCount = this->stagedBatchCommands.size();
+	LogManager::log(LOG_ERROR, "Discarding a command batch of {} commands, {}", commandCount, reason);
+	for (auto& stagedCommand : this->stagedBatchCommands) {
+		this->writeCommandStatus(stagedCommand.first, CommandStatus_Dropped);
+	}
+
+	this->stagedBatchCommands.clear();
+	this->stagedBatchHasHeavyCommand = false;
+	this->batchOpen = false;
+}
+
+void SharedDeviceMemoryDriver::countPluginOverrides() {
+	if (!this->sharedMemory) return;
+
+	SharedMemoryHeader* headerPtr = static_cast<SharedMemoryHeader*>(this->sharedMemory);
+	headerPtr->pluginOverrideCount.fetch_add(1, std::memory_order_release);
+}
+
+bool SharedDeviceMemoryDriver::isClientAttached() {
+	return this->clientAttached.load(std::memory_order_relaxed);
+}
+
+void SharedDeviceMemoryDriver::updateClientPresence() {
+	SharedMemoryHeader* headerPtr = static_cast<SharedMemoryHeader*>(this->sharedMemory);
+
+	int64_t heartbeat = headerPtr->clientHeartbeatNanoseconds.load(std::memory_order_acquire);
+	uint32_t generation = headerPtr->clientGeneration.load(std::memory_order_acquire);
+
+	int64_t timeout = static_cast<int64_t>(CLIENT_HEARTBEAT_TIMEOUT_MS) * 1000000;
+	bool attached = heartbeat != 0 && CommandScheduler::now() - heartbeat < timeout;
+	bool wasAttached = this->clientAttached.load(std::memory_order_relaxed);
+
+	if (attached && (!wasAttached || generation != this->attachedClientGeneration)) {
+		// Hooks start publishing before the snapshot, so no update made during the snapshot is missed
+		this->clientAttached.store(true, std::memory_order_relaxed);
+		this->attachedClientGeneration = generation;
+
+		std::shared_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+		DeviceStateModel::getInstance().syncSnapshotToSharedMemory();
+
+		LogManager::log(LOG_INFO, "Client attached (generation {}), published a model snapshot", generation);
+	} else if (!attached && wasAttached) {
+		this->clientAttached.store(false, std::memory_order_relaxed);
+		LogManager::log(LOG_INFO, "Client detached, pausing publishing to the driver-client lane");
+	}
+}
+
+bool SharedDeviceMemoryDriver::scheduleCommand(
+	const ClientCommandHeaderData& header,
+	std::unique_ptr<uint8_t[]>& paramsBuf
+) {
+	if (header.applyTimeNanoseconds <= CommandScheduler::now()) return false;
+
+	bool scheduled = CommandScheduler::getInstance().schedule(header, std::move(paramsBuf));
+	if (!scheduled) {
+		LogManager::log(LOG_ERROR, "Rejecting command, {} commands are already scheduled", MAX_SCHEDULED_COMMANDS);
+	}
+
+	this->writeCommandStatus(header, scheduled ? CommandStatus_Scheduled : CommandStatus_Rejected);
+	return true;
+}
+
+void SharedDeviceMemoryDriver::applyScheduledCommand(const ClientCommandHeaderData& header, uint8_t* paramsBuf) {
+	CommandStatus status = this->applyCommand(header, paramsBuf);
+
+	uint8_t* ringStart = static_cast<uint8_t*>(this->sharedMemory) + this->commandStatusRingStart;
+	CommandStatusEntry* entry =
+		reinterpret_cast<CommandStatusEntry*>(ringStart) + (header.version % COMMAND_STATUS_RING_SIZE);
+
+	// Commands scheduled far ahead can have their entry reused by newer commands, whose status must be kept
+	if (entry->version.load(std::memory_order_acquire) != header.version) return;
+
+	this->writeCommandStatus(header, status);
+}
+
+CommandStatus SharedDeviceMemoryDriver::applyCommand(const ClientCommandHeaderData& header, uint8_t* paramsBuf) {
+	DeviceStateModel& model = DeviceStateModel::getInstance();
+
+	uint32_t deviceIndex = header.deviceIndex;
+
+	switch (header.type) {
+		case Command_SetUseOverriddenStateDevicePose: {
+				CommandParams_SetUseOverriddenStateDevicePose * params =
+					reinterpret_cast<CommandParams_SetUseOverriddenStateDevicePose*>(paramsBuf);
+				ModelDevicePoseSerialized* pose = model.getDevicePose(deviceIndex);
+				if (!pose) return CommandStatus_UnknownDevice;
+
+				pose->useOverriddenState = params->useOverriddenState;
+
+				break;
+		}
+		case Command_SetOverriddenStateDevicePose: {
+			CommandParams_SetOverriddenStateDevicePose* params =
+				reinterpret_cast<CommandParams_SetOverriddenStateDevicePose*>(paramsBuf);
+			ModelDevicePoseSerialized* pose = model.getDevicePose(deviceIndex);
+			if (!pose) return CommandStatus_UnknownDevice;
+
+			model.setOverriddenDevicePose(deviceIndex, params->overriddenPose, params->fieldMask);
+			model.setDevicePoseChanged(deviceIndex);
+
+			break;
+		}
+		case Command_SetUseOverriddenStateDeviceInput: {
+			CommandParams_SetUseOverriddenStateDeviceInput* params = 
+				reinterpret_cast<CommandParams_SetUseOverriddenStateDeviceInput*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			ModelDeviceInputBooleanSerialized* inputBoolean = model.getBooleanInput(deviceIndex, inputPath);
+			if (inputBoolean) {
+				inputBoolean->useOverriddenState = params->useOverriddenState;
+				model.setInputBooleanChanged(deviceIndex, inputPath);
+				break;
 			}
 
-			this->clientDriverLaneReadCount = commandHeader.version;
-		} while (this->clientDriverLaneReadCount < currentWriteCount);
+			ModelDeviceInputScalarSerialized* inputScalar = model.getScalarInput(deviceIndex, inputPath);
+			if (inputScalar) {
+				inputScalar->useOverriddenState = params->useOverriddenState;
+				model.setInputScalarChanged(deviceIndex, inputPath);
+				break;
+			}
+
+			ModelDeviceInputSkeletonSerialized* inputSkeleton = model.getSkeletonInput(deviceIndex, inputPath);
+			if (inputSkeleton) {
+				inputSkeleton->useOverriddenState = params->useOverriddenState;
+				model.setInputSkeletonChanged(deviceIndex, inputPath);
+				break;
+			}
+
+			ModelDeviceInputPoseSerialized* inputPose = model.getPoseInput(deviceIndex, inputPath);
+			if (inputPose) {
+				inputPose->useOverriddenState = params->useOverriddenState;
+				model.setInputPoseChanged(deviceIndex, inputPath);
+				break;
+			}
+
+			ModelDeviceInputEyeTrackingSerialized* inputEyeTracking = model.getEyeTrackingInput(
+				deviceIndex, 
+				inputPath
+			);
+			if (inputEyeTracking) {
+				inputEyeTracking->useOverriddenState = params->useOverriddenState;
+				model.setInputEyeTrackingChanged(deviceIndex, inputPath);
+				break;
+			}
 
-		this->clientDriverLaneReadCount = currentWriteCount;
+			return this->getMissingInputStatus(deviceIndex, inputPath);
+		}
+		case Command_SetOverriddenStateDeviceInputBoolean: {
+			CommandParams_SetOverriddenStateDeviceInputBoolean* params =
+				reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputBoolean*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			ModelDeviceInputBooleanSerialized* input = model.getBooleanInput(deviceIndex, inputPath);
+			if (!input) return this->getMissingInputStatus(deviceIndex, inputPath);
+
+			input->data.overwrittenValue = params->overriddenValue;
+			model.setInputBooleanChanged(deviceIndex, inputPath);
+
+			break;
+		}
+		case Command_SetOverriddenStateDeviceInputScalar: {
+			CommandParams_SetOverriddenStateDeviceInputScalar* params =
+				reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputScalar*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			ModelDeviceInputScalarSerialized* input = model.getScalarInput(deviceIndex, inputPath);
+			if (!input) return this->getMissingInputStatus(deviceIndex, inputPath);
+
+			input->data.overwrittenValue = params->overriddenValue;
+			model.setInputScalarChanged(deviceIndex, inputPath);
+
+			break;
+		}
+		case Command_SetOverriddenStateDeviceInputSkeleton: {
+			CommandParams_SetOverriddenStateDeviceInputSkeleton* params = reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputSkeleton*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			ModelDeviceInputSkeletonSerialized* input = model.getSkeletonInput(deviceIndex, inputPath);
+			if (!input) return this->getMissingInputStatus(deviceIndex, inputPath);
+
+			model.setOverriddenSkeletonInput(deviceIndex, inputPath, params->overriddenValue, params->boneMask);
+			model.setInputSkeletonChanged(deviceIndex, inputPath);
+
+			break;
+		}
+		case Command_SetOverriddenStateDeviceInputPose: {
+			CommandParams_SetOverriddenStateDeviceInputPose* params = reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputPose*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			ModelDeviceInputPoseSerialized* input = model.getPoseInput(deviceIndex, inputPath);
+			if (!input) return this->getMissingInputStatus(deviceIndex, inputPath);
+
+			input->data.overwrittenValue = params->overriddenValue;
+			model.setInputPoseChanged(deviceIndex, inputPath);
+
+			break;
+		}
+		case Command_SetOverriddenStateDeviceInputEyeTracking: {
+			CommandParams_SetOverriddenStateDeviceInputEyeTracking* params = reinterpret_cast<CommandParams_SetOverriddenStateDeviceInputEyeTracking*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			ModelDeviceInputEyeTrackingSerialized* input = model.getEyeTrackingInput(deviceIndex, inputPath);
+			if (!input) return this->getMissingInputStatus(deviceIndex, inputPath);
+
+			input->data.overwrittenValue = params->overriddenValue;
+			model.setInputEyeTrackingChanged(deviceIndex, inputPath);
+
+			break;
+		}
+		case Command_SetPoseTransformRules: {
+			CommandParams_SetPoseTransformRules* params =
+				reinterpret_cast<CommandParams_SetPoseTransformRules*>(paramsBuf);
+			TransformRuleManager::getInstance().setPoseRules(deviceIndex, params->rules, params->ruleCount);
+
+			break;
+		}
+		case Command_SetInputTransformRules: {
+			CommandParams_SetInputTransformRules* params =
+				reinterpret_cast<CommandParams_SetInputTransformRules*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			vr::VRInputComponentHandle_t componentHandle;
+			if (!model.getComponentHandle(deviceIndex, inputPath, &componentHandle)) {
+				return this->getMissingInputStatus(deviceIndex, inputPath);
+			}
+
+			TransformRuleManager::getInstance().setInputRules(componentHandle, params->rules, params->ruleCount);
+
+			break;
+		}
+		case Command_LoadInputFilterProgram: {
+			CommandParams_LoadInputFilterProgram* params =
+				reinterpret_cast<CommandParams_LoadInputFilterProgram*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			// Programs only filter boolean and scalar inputs
+			bool isBoolean = model.getBooleanInput(deviceIndex, inputPath) != nullptr;
+			if (!isBoolean && model.getScalarInput(deviceIndex, inputPath) == nullptr) {
+				return this->getMissingInputStatus(deviceIndex, inputPath);
+			}
+
+			vr::VRInputComponentHandle_t componentHandle;
+			if (!model.getComponentHandle(deviceIndex, inputPath, &componentHandle)) {
+				return this->getMissingInputStatus(deviceIndex, inputPath);
+			}
+
+			uint32_t bindingCount = (std::min)(params->bindingCount, MAX_FILTER_BINDINGS);
+			vr::VRInputComponentHandle_t bindingHandles[MAX_FILTER_BINDINGS];
+			bool bindingsResolved = true;
+			for (uint32_t i = 0; i < bindingCount; i++) {
+				std::string bindingPath = this->getPathFromPathOffset(params->bindingPathOffsets[i]);
+				bindingsResolved &= model.getComponentHandle(
+					params->bindingDeviceIndexes[i],
+					bindingPath,
+					&bindingHandles[i]
+				);
+			}
+
+			if (!bindingsResolved) {
+				LogManager::log(LOG_ERROR, "Failed to resolve filter program bindings for {}", inputPath);
+				return CommandStatus_UnknownPath;
+			}
+
+			if (!InputFilterEngine::getInstance().loadProgram(
+				componentHandle,
+				isBoolean,
+				params->instructions,
+				(std::min)(params->instructionCount, MAX_FILTER_INSTRUCTIONS),
+				bindingHandles,
+				bindingCount
+			)) {
+				LogManager::log(LOG_ERROR, "Rejected invalid filter program for {}", inputPath);
+				return CommandStatus_Rejected;
+			}
+
+			break;
+		}
+		case Command_SetPoseSmoothingFilter: {
+			CommandParams_SetPoseSmoothingFilter* params =
+				reinterpret_cast<CommandParams_SetPoseSmoothingFilter*>(paramsBuf);
+			SmoothingFilterManager::getInstance().setPoseFilter(deviceIndex, params->config);
+
+			break;
+		}
+		case Command_SetScalarSmoothingFilter: {
+			CommandParams_SetScalarSmoothingFilter* params =
+				reinterpret_cast<CommandParams_SetScalarSmoothingFilter*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			vr::VRInputComponentHandle_t componentHandle;
+			if (model.getScalarInput(deviceIndex, inputPath) == nullptr ||
+				!model.getComponentHandle(deviceIndex, inputPath, &componentHandle)
+			) {
+				return this->getMissingInputStatus(deviceIndex, inputPath);
+			}
+
+			SmoothingFilterManager::getInstance().setScalarFilter(componentHandle, params->config);
+
+			break;
+		}
+		case Command_LoadAnimationTrack: {
+			CommandParams_LoadAnimationTrack* params =
+				reinterpret_cast<CommandParams_LoadAnimationTrack*>(paramsBuf);
+			if (params->trackId >= MAX_ANIMATION_TRACKS) return CommandStatus_Rejected;
+
+			uint8_t* slot = static_cast<uint8_t*>(this->sharedMemory) + this->animationBlobStart +
+				static_cast<size_t>(params->trackId) * ANIMATION_TRACK_SLOT_SIZE;
+
+			if (!AnimationPlayer::getInstance().loadTrack(params->trackId, params->type, slot, params->keyframeCount)) {
+				LogManager::log(LOG_ERROR, "Rejected invalid animation track {}", params->trackId);
+				return CommandStatus_Rejected;
+			}
+
+			break;
+		}
+		case Command_PlayPoseAnimation: {
+			CommandParams_PlayPoseAnimation* params =
+				reinterpret_cast<CommandParams_PlayPoseAnimation*>(paramsBuf);
+			if (!AnimationPlayer::getInstance().playPoseTrack(deviceIndex, params->trackId, params->config)) {
+				return CommandStatus_Rejected;
+			}
+
+			break;
+		}
+		case Command_PlayInputAnimation: {
+			CommandParams_PlayInputAnimation* params =
+				reinterpret_cast<CommandParams_PlayInputAnimation*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			// Tracks only play on scalar and skeleton inputs
+			bool isSkeleton = model.getSkeletonInput(deviceIndex, inputPath) != nullptr;
+			if (!isSkeleton && model.getScalarInput(deviceIndex, inputPath) == nullptr) {
+				return this->getMissingInputStatus(deviceIndex, inputPath);
+			}
+
+			vr::VRInputComponentHandle_t componentHandle;
+			if (!model.getComponentHandle(deviceIndex, inputPath, &componentHandle)) {
+				return this->getMissingInputStatus(deviceIndex, inputPath);
+			}
+
+			if (!AnimationPlayer::getInstance().playInputTrack(
+				componentHandle,
+				isSkeleton ? AnimationTrack_Skeleton : AnimationTrack_Scalar,
+				params->trackId,
+				params->config
+			)) {
+				return CommandStatus_Rejected;
+			}
+
+			break;
+		}
+		case Command_SetPoseExtrapolation: {
+			CommandParams_SetPoseExtrapolation* params =
+				reinterpret_cast<CommandParams_SetPoseExtrapolation*>(paramsBuf);
+			PoseExtrapolator::getInstance().setConfig(deviceIndex, params->config);
+
+			break;
+		}
+		case Command_InjectHapticPulse: {
+			CommandParams_InjectHapticPulse* params =
+				reinterpret_cast<CommandParams_InjectHapticPulse*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			if (!HapticsManager::getInstance().injectPulse(
+				deviceIndex,
+				inputPath,
+				params->durationSeconds,
+				params->frequency,
+				params->amplitude
+			)) {
+				return this->getMissingInputStatus(deviceIndex, inputPath);
+			}
+
+			break;
+		}
+		case Command_SetHapticSuppression: {
+			CommandParams_SetHapticSuppression* params =
+				reinterpret_cast<CommandParams_SetHapticSuppression*>(paramsBuf);
+			std::string inputPath = this->getPathFromPathOffset(params->inputPathOffset);
+
+			if (!HapticsManager::getInstance().setSuppressed(deviceIndex, inputPath, params->suppressed)) {
+				return this->getMissingInputStatus(deviceIndex, inputPath);
+			}
+
+			break;
+		}
+		default:
+			break;
 	}
+
+	return CommandStatus_Applied;
+}
+
+CommandStatus SharedDeviceMemoryDriver::getMissingInputStatus(uint32_t deviceIndex, const std::string& inputPath) {
+	if (inputPath.empty()) return CommandStatus_PathTableMiss;
+	if (DeviceStateModel::getInstance().getPropertyContainerFromDeviceIndex(deviceIndex) == nullptr) {
+		return CommandStatus_UnknownDevice;
+	}
+
+	return CommandStatus_UnknownPath;
+}
+
+void SharedDeviceMemoryDriver::writeCommandStatus(const ClientCommandHeaderData& header, CommandStatus status) {
+	uint8_t* ringStart = static_cast<uint8_t*>(this->sharedMemory) + this->commandStatusRingStart;
+	CommandStatusEntry* entry =
+		reinterpret_cast<CommandStatusEntry*>(ringStart) + (header.version % COMMAND_STATUS_RING_SIZE);
+
+	// Mark the entry while it is rewritten, so a concurrent reader retries instead of reading a mix. Scheduled commands
+	// rewrite their entry after the ack count has passed them, so this can race with the lib
+	entry->version.store(COMMAND_STATUS_WRITING_VERSION, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	entry->sequence = header.sequence;
+	entry->status = static_cast<uint32_t>(status);
+	entry->appliedTimeNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+
+	entry->version.store(header.version, std::memory_order_release);
 }
 
 void SharedDeviceMemoryDriver::writePacketToDriverClientLane(void* packet, uint32_t packetSize) {
 	if (!packet || packetSize <= 0) return;
 
 	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+	uint32_t frameStride = getFrameStride(packetSize);
+
+	// Reserve the frame and its version together, so frames end up in the lane in version order. The max packet size
+	// is the skeleton serialized data (4kb), which is unable to go out of bounds since the padding is 5kb, therefore,
+	// no bound checks are performed. Mirrored lanes run on into their second view instead, so they never wrap early
+	uint64_t reservation = this->driverClientLaneReservation.load(std::memory_order_relaxed);
+	uint32_t writeOffset, frameOffset, version;
+	uint64_t newReservation;
+	do {
+		writeOffset = static_cast<uint32_t>(reservation);
+		version = static_cast<uint32_t>(reservation >> 32);
+
+		// The cached read offset only ever lags the real one, so the lane is only refreshed when it looks full
+		uint32_t readOffset = this->cachedDriverClientReadOffset.load(std::memory_order_relaxed);
+		if (!hasLaneSpace(writeOffset, readOffset, frameStride, this->mirroredLanes)) {
+			readOffset = headerPtr->driverClientReadOffset.load(std::memory_order_acquire);
+			this->cachedDriverClientReadOffset.store(readOffset, std::memory_order_relaxed);
+			if (!hasLaneSpace(writeOffset, readOffset, frameStride, this->mirroredLanes)) return;
+		}
 
-	uint32_t readOffset = headerPtr->driverClientReadOffset.load(std::memory_order_acquire);
-	uint32_t writeOffset = this->driverClientLaneWriteOffset;
-		
-	uint32_t freeSpace = writeOffset >= readOffset 
-		? (LANE_SIZE - writeOffset) + readOffset
-		: readOffset - writeOffset;
-		
-	if (packetSize > freeSpace) return;
-
-	uint8_t* laneStart = static_cast<uint8_t*>(this->sharedMemory) + this->driverClientLaneStart;
-
-	// The max packet size is the skeleton serialized data (4kb), which is unable to go out of bounds
-	// since the padding is 5kb, therefore, no bound checks are performed
-	uint8_t* currentWriteStart;
-	uint32_t newWriteOffset;
-	if (this->driverClientLaneWriteOffset >= LANE_SIZE - LANE_PADDING_SIZE) {
-		currentWriteStart = laneStart;
-		newWriteOffset = packetSize;
-	} else {
-		currentWriteStart = laneStart + this->driverClientLaneWriteOffset;
-		newWriteOffset = this->driverClientLaneWriteOffset + packetSize;
-	}
+		bool wraps = !this->mirroredLanes && writeOffset >= LANE_SIZE - LANE_PADDING_SIZE;
+		frameOffset = wraps ? 0 : writeOffset;
+
+		uint32_t newWriteOffset = (frameOffset + frameStride) % LANE_SIZE;
+		newReservation = (static_cast<uint64_t>(version + 1) << 32) | newWriteOffset;
+	} while (!this->driverClientLaneReservation.compare_exchange_weak(
+		reservation, newReservation, std::memory_order_relaxed, std::memory_order_relaxed
+	));
 
-	memcpy(currentWriteStart, packet, packetSize);
+	ObjectEntry* frame = reinterpret_cast<ObjectEntry*>(packet);
+	frame->frameSize = packetSize;
+	frame->version = version;
+	frame->checksum = computeFrameChecksum(frame);
 
-	ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(currentWriteStart);
-	entry->committed.store(true, std::memory_order_release);
+	uint8_t* laneStart = this->driverClientLane;
+	if (frameOffset != writeOffset) memcpy(laneStart + writeOffset, &WRAP_MARKER_CONSTANT, sizeof(uint32_t));
 
-	this->driverClientLaneWriteOffset = newWriteOffset;
-	headerPtr->driverClientWriteOffset.store(this->driverClientLaneWriteOffset, std::memory_order_release);
+	writeFrame(laneStart + frameOffset, packet, packetSize);
 
-	this->driverClientLaneWriteCount++;
-	headerPtr->driverClientWriteCount.store(this->driverClientLaneWriteCount, std::memory_order_release);
+	// Publish in reservation order. Producers reserved earlier are only ever a frame copy away from publishing, so
+	// this wait is short, and the client never sees a published range with a hole in it
+	uint64_t publishedCount = headerPtr->driverClientWriteCount.load(std::memory_order_acquire);
+	while (static_cast<uint32_t>(publishedCount) != version) {
+		std::this_thread::yield();
+		publishedCount = headerPtr->driverClientWriteCount.load(std::memory_order_acquire);
+	}
+
+	headerPtr->driverClientWriteOffset.store(static_cast<uint32_t>(newReservation), std::memory_order_release);
+	headerPtr->driverClientWriteCount.store(publishedCount + 1, std::memory_order_release);
 }
  
 std::pair<ClientCommandHeaderData, std::pair<ClientCommandType, std::unique_ptr<uint8_t[]>>> 
 SharedDeviceMemoryDriver::readPacketFromClientDriverLane() {
 	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
 
-	if (this->clientDriverLaneReadOffset >= LANE_SIZE - LANE_PADDING_SIZE) this->clientDriverLaneReadOffset = 0;
+	// The cached write offset only ever lags the real one, so the lane is only refreshed when it looks empty
+	if (this->clientDriverLaneReadOffset == this->cachedClientDriverWriteOffset) {
+		this->cachedClientDriverWriteOffset = headerPtr->clientDriverWriteOffset.load(std::memory_order_acquire);
+	}
 
-	uint32_t writeOffset = headerPtr->clientDriverWriteOffset.load(std::memory_order_acquire);
+	uint32_t writeOffset = this->cachedClientDriverWriteOffset;
 	if (this->clientDriverLaneReadOffset == writeOffset) 
 		return { ClientCommandHeaderData{}, { Command_SetOverriddenStateDevicePose, nullptr } };
 
+	// The writer left a wrap marker here and continued from the start of the lane
+	if (!this->mirroredLanes && this->clientDriverLaneReadOffset >= LANE_SIZE - LANE_PADDING_SIZE) {
+		this->clientDriverLaneReadOffset = 0;
+		if (this->clientDriverLaneReadOffset == writeOffset)
+			return { ClientCommandHeaderData{}, { Command_SetOverriddenStateDevicePose, nullptr } };
+	}
+
 	// Read ClientCommandHeader
-	uint8_t* laneStart = static_cast<uint8_t*>(this->sharedMemory) + this->clientDriverLaneStart;
+	uint8_t* laneStart = this->clientDriverLane;
 	uint8_t* readStart = laneStart + this->clientDriverLaneReadOffset;
 	ClientCommandHeader* rawHeader = reinterpret_cast<ClientCommandHeader*>(readStart);
 
-	// Misalignment correction
+	// Misalignment correction. The magic is written last, so a header that validates is also fully written
 	if (!this->isValidCommandHeader(rawHeader, headerPtr) &&
 		!this->realignReadHeader(headerPtr, laneStart, &readStart, writeOffset, &rawHeader))
 		return { ClientCommandHeaderData{}, { Command_SetUseOverriddenStateDevicePose , nullptr } };
-		
-
-	// Wait for packet to be valid
-	auto start = std::chrono::high_resolution_clock::now();
-	while (!rawHeader->committed.load(std::memory_order_acquire)) {
-		auto now = std::chrono::high_resolution_clock::now();
-		if (std::chrono::duration_cast<std::chrono::microseconds>(now - start).count() > COMMIT_FLAG_TIMEOUT_US) {
-			LogManager::log(LOG_ERROR, "Timeout waiting for client packet commit");
-			if (!this->realignReadHeader(headerPtr, laneStart, &readStart, writeOffset, &rawHeader))
-				return { ClientCommandHeaderData{}, { Command_SetUseOverriddenStateDevicePose , nullptr } };
-		}
-	}
 
 	ClientCommandHeaderData header;
 	header.successful = true;
-	header.type = rawHeader->type;
+	header.type = static_cast<ClientCommandType>(rawHeader->type);
 	header.deviceIndex = rawHeader->deviceIndex;
-	header.version = rawHeader->version;
+	header.version = widenFrameVersion(rawHeader->version, this->clientDriverLaneReadCount);
+	header.sequence = rawHeader->sequence;
+	header.applyTimeNanoseconds = rawHeader->applyTimeNanoseconds;
 
-	// Read object data
-	uint32_t dataSize = 0;
+	// Read object data, whose size was checked against the frame size when the header was validated
 	ClientCommandType type = header.type;
+	uint32_t dataSize = getCommandParamsSize(type);
+
+	auto dataBuffer = std::make_unique<uint8_t[]>(dataSize);
+	memcpy(dataBuffer.get(), readStart + sizeof(ClientCommandHeader), dataSize);
+
+	uint32_t frameStride = getFrameStride(rawHeader->frameSize);
+	this->clientDriverLaneReadOffset = (this->clientDriverLaneReadOffset + frameStride) % LANE_SIZE;
+	headerPtr->clientDriverReadOffset.store(this->clientDriverLaneReadOffset, std::memory_order_release);
+
+	return std::make_pair(header, std::make_pair(type, std::move(dataBuffer)));
+}
+
+bool SharedDeviceMemoryDriver::isHeavyCommand(ClientCommandType type) {
+	return type == Command_LoadAnimationTrack || type == Command_LoadInputFilterProgram;
+}
+
+uint32_t SharedDeviceMemoryDriver::getCommandParamsSize(ClientCommandType type) {
+	uint32_t dataSize = 0;
 	switch (type) {
 	case Command_SetUseOverriddenStateDevicePose:
 		dataSize = sizeof(CommandParams_SetUseOverriddenStateDevicePose); break;
@@ -378,15 +1012,53 @@ SharedDeviceMemoryDriver::readPacketFromClientDriverLane() {
 		dataSize = sizeof(CommandParams_SetOverriddenStateDeviceInputPose); break;
 	case Command_SetOverriddenStateDeviceInputEyeTracking:
 		dataSize = sizeof(CommandParams_SetOverriddenStateDeviceInputEyeTracking); break;
+	case Command_SetPoseTransformRules:
+		dataSize = sizeof(CommandParams_SetPoseTransformRules); break;
+	case Command_SetInputTransformRules:
+		dataSize = sizeof(CommandParams_SetInputTransformRules); break;
+	case Command_LoadInputFilterProgram:
+		dataSize = sizeof(CommandParams_LoadInputFilterProgram); break;
+	case Command_SetPoseSmoothingFilter:
+		dataSize = sizeof(CommandParams_SetPoseSmoothingFilter); break;
+	case Command_SetScalarSmoothingFilter:
+		dataSize = sizeof(CommandParams_SetScalarSmoothingFilter); break;
+	case Command_BeginBatch:
+		dataSize = sizeof(CommandParams_BeginBatch); break;
+	case Command_CommitBatch:
+		dataSize = sizeof(CommandParams_CommitBatch); break;
+	case Command_LoadAnimationTrack:
+		dataSize = sizeof(CommandParams_LoadAnimationTrack); break;
+	case Command_PlayPoseAnimation:
+		dataSize = sizeof(CommandParams_PlayPoseAnimation); break;
+	case Command_PlayInputAnimation:
+		dataSize = sizeof(CommandParams_PlayInputAnimation); break;
+	case Command_SetPoseExtrapolation:
+		dataSize = sizeof(CommandParams_SetPoseExtrapolation); break;
+	case Command_InjectHapticPulse:
+		dataSize = sizeof(CommandParams_InjectHapticPulse); break;
+	case Command_SetHapticSuppression:
+		dataSize = sizeof(CommandParams_SetHapticSuppression); break;
 	}
+	return dataSize;
+}
 
-	auto dataBuffer = std::make_unique<uint8_t[]>(dataSize);
-	memcpy(dataBuffer.get(), readStart + sizeof(ClientCommandHeader), dataSize);
-
-	this->clientDriverLaneReadOffset += sizeof(ClientCommandHeader) + dataSize;
-	headerPtr->clientDriverReadOffset.store(this->clientDriverLaneReadOffset, std::memory_order_release);
-
-	return std::make_pair(header, std::make_pair(type, std::move(dataBuffer)));
+uint32_t SharedDeviceMemoryDriver::getObjectDataSize(ObjectType type) {
+	uint32_t dataSize = 0;
+	switch (type) {
+	case Object_DevicePose:
+		dataSize = sizeof(DevicePoseSerialized); break;
+	case Object_InputBoolean:
+		dataSize = sizeof(DeviceInputBooleanSerialized); break;
+	case Object_InputScalar:
+		dataSize = sizeof(DeviceInputScalarSerialized); break;
+	case Object_InputSkeleton:
+		dataSize = sizeof(DeviceInputSkeletonSerialized); break;
+	case Object_InputPose:
+		dataSize = sizeof(DeviceInputPoseSerialized); break;
+	case Object_InputEyeTracking:
+		dataSize = sizeof(DeviceInputEyeTrackingSerialized); break;
+	}
+	return dataSize;
 }
 
 bool SharedDeviceMemoryDriver::realignReadHeader(
@@ -396,30 +1068,43 @@ bool SharedDeviceMemoryDriver::realignReadHeader(
 	uint32_t writeOffset,
 	ClientCommandHeader** output
 ) {
-	uint32_t searchOffset = this->clientDriverLaneReadOffset;
-
-	const uint32_t FORWARD_SEARCH_BYTES = 4096;
+	uint32_t searchOffset = getFrameStride(this->clientDriverLaneReadOffset + 1);
+
+	// Strategy 1: Forward Check, stepping frame boundaries and only validating candidates that start with the magic.
+	// Bounded to a single pass over the lane in case stale wrap markers keep sending the search back to the start
+	for (uint32_t i = 0; i < LANE_SIZE / FRAME_ALIGNMENT && searchOffset != writeOffset; i++) {
+		if (searchOffset >= LANE_SIZE) {
+			searchOffset = 0;
+			continue;
+		}
 
-	// Strategy 1: Forward Check
-	for (uint32_t i = 0; i < FORWARD_SEARCH_BYTES; i++) {
-		searchOffset = (searchOffset + 1) % LANE_SIZE;
+		uint32_t magic;
+		memcpy(&magic, laneStart + searchOffset, sizeof(uint32_t));
 
-		if (searchOffset == writeOffset) break;
+		if (!this->mirroredLanes && searchOffset >= LANE_SIZE - LANE_PADDING_SIZE && magic == WRAP_MARKER_CONSTANT) {
+			searchOffset = 0;
+			continue;
+		}
 
 		ClientCommandHeader* testHeader = reinterpret_cast<ClientCommandHeader*>(laneStart + searchOffset);
 
-		if (this->isValidCommandHeader(testHeader, headerPtr)) {
+		if (magic == ALIGNMENT_CONSTANT && this->isValidCommandHeader(testHeader, headerPtr)) {
+			this->readerRealigned = true;
 			this->clientDriverLaneReadOffset = searchOffset;
 			*readStart = laneStart + searchOffset;
 			*output = testHeader;
-			LogManager::log(LOG_DEBUG, "Packet misaligned, forward search {} bytes", i);
+			LogManager::log(LOG_DEBUG, "Packet misaligned, forward search {} frames", i);
 			return true;
 		}
+
+		searchOffset += FRAME_ALIGNMENT;
 	}
 
 	// Strategy 2: Jump To Write Offset
+	this->readerRealigned = true;
 	this->clientDriverLaneReadOffset = headerPtr->clientDriverWriteOffset.load(std::memory_order_acquire);
 	this->clientDriverLaneReadCount = headerPtr->clientDriverWriteCount.load(std::memory_order_acquire);
+	this->cachedClientDriverWriteOffset = this->clientDriverLaneReadOffset;
 	LogManager::log(LOG_DEBUG, "Packet misaligned, jumped to write header");
 	return false;
 }
@@ -431,11 +1116,9 @@ void SharedDeviceMemoryDriver::syncDevicePoseUpdateToSharedMemory(DevicePoseSeri
 	ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(buffer);
 	entry->alignmentCheck = ALIGNMENT_CONSTANT;
 	entry->type = Object_DevicePose;
-	entry->deviceIndex = deviceIndex;
+	entry->deviceIndex = static_cast<uint8_t>(deviceIndex);
 	entry->inputPathOffset = 0;
-	entry->version = this->driverClientLaneWriteCount;
 	entry->valid = true;
-	entry->committed.store(false, std::memory_order_relaxed);
 
 	memcpy(buffer + sizeof(ObjectEntry), packet, sizeof(DevicePoseSerialized));
 
@@ -456,11 +1139,9 @@ void SharedDeviceMemoryDriver::syncDeviceInputBooleanUpdateToSharedMemory(
 	ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(buffer);
 	entry->alignmentCheck = ALIGNMENT_CONSTANT;
 	entry->type = Object_InputBoolean;
-	entry->deviceIndex = deviceIndex;
-	entry->inputPathOffset = offset;
-	entry->version = this->driverClientLaneWriteCount;
+	entry->deviceIndex = static_cast<uint8_t>(deviceIndex);
+	entry->inputPathOffset = static_cast<uint16_t>(offset);
 	entry->valid = true;
-	entry->committed.store(false, std::memory_order_relaxed);
 
 	memcpy(buffer + sizeof(ObjectEntry), packet, sizeof(DeviceInputBooleanSerialized));
 	
@@ -481,11 +1162,9 @@ void SharedDeviceMemoryDriver::syncDeviceInputScalarUpdateToSharedMemory(
 	ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(buffer);
 	entry->alignmentCheck = ALIGNMENT_CONSTANT;
 	entry->type = Object_InputScalar;
-	entry->deviceIndex = deviceIndex;
-	entry->inputPathOffset = offset;
-	entry->version = this->driverClientLaneWriteCount;
+	entry->deviceIndex = static_cast<uint8_t>(deviceIndex);
+	entry->inputPathOffset = static_cast<uint16_t>(offset);
 	entry->valid = true;
-	entry->committed.store(false, std::memory_order_relaxed);
 
 	memcpy(buffer + sizeof(ObjectEntry), packet, sizeof(DeviceInputScalarSerialized));
 
@@ -506,11 +1185,9 @@ void SharedDeviceMemoryDriver::syncDeviceInputSkeletonUpdateToSharedMemory(
 	ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(buffer);
 	entry->alignmentCheck = ALIGNMENT_CONSTANT;
 	entry->type = Object_InputSkeleton;
-	entry->deviceIndex = deviceIndex;
-	entry->inputPathOffset = offset;
-	entry->version = this->driverClientLaneWriteCount;
+	entry->deviceIndex = static_cast<uint8_t>(deviceIndex);
+	entry->inputPathOffset = static_cast<uint16_t>(offset);
 	entry->valid = true;
-	entry->committed.store(false, std::memory_order_relaxed);
 
 	memcpy(buffer + sizeof(ObjectEntry), packet, sizeof(DeviceInputSkeletonSerialized));
 
@@ -531,11 +1208,9 @@ void SharedDeviceMemoryDriver::syncDeviceInputPoseUpdateToSharedMemory(
 	ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(buffer);
 	entry->alignmentCheck = ALIGNMENT_CONSTANT;
 	entry->type = Object_InputPose;
-	entry->deviceIndex = deviceIndex;
-	entry->inputPathOffset = offset;
-	entry->version = this->driverClientLaneWriteCount;
+	entry->deviceIndex = static_cast<uint8_t>(deviceIndex);
+	entry->inputPathOffset = static_cast<uint16_t>(offset);
 	entry->valid = true;
-	entry->committed.store(false, std::memory_order_relaxed);
 
 	memcpy(buffer + sizeof(ObjectEntry), packet, sizeof(DeviceInputPoseSerialized));
 
@@ -556,17 +1231,198 @@ void SharedDeviceMemoryDriver::syncDeviceInputEyeTrackingUpdateToSharedMemory(
 	ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(buffer);
 	entry->alignmentCheck = ALIGNMENT_CONSTANT;
 	entry->type = Object_InputEyeTracking;
-	entry->deviceIndex = deviceIndex;
-	entry->inputPathOffset = offset;
-	entry->version = this->driverClientLaneWriteCount;
+	entry->deviceIndex = static_cast<uint8_t>(deviceIndex);
+	entry->inputPathOffset = static_cast<uint16_t>(offset);
 	entry->valid = true;
-	entry->committed.store(false, std::memory_order_relaxed);
 
 	memcpy(buffer + sizeof(ObjectEntry), packet, sizeof(DeviceInputEyeTrackingSerialized));
 
 	this->writePacketToDriverClientLane(buffer, totalSize);
 }
 
+void SharedDeviceMemoryDriver::syncObjectRemovalToSharedMemory(
+	ObjectType type,
+	uint32_t deviceIndex,
+	const std::string& path
+) {
+	// A client attaching later only sees the devices that are still in the snapshot
+	if (!this->isClientAttached()) return;
+
+	uint32_t offset = 0;
+	if (type != Object_DevicePose) {
+		offset = this->getOffsetOfPath(path);
+		if (offset == UINT32_MAX) return;
+	}
+
+	// Removals keep the frame size of their type so the client validates them like updates, with the data zeroed
+	uint32_t totalSize = sizeof(ObjectEntry) + getObjectDataSize(type);
+	std::vector<uint8_t> buffer(totalSize);
+
+	ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(buffer.data());
+	entry->alignmentCheck = ALIGNMENT_CONSTANT;
+	entry->type = static_cast<uint8_t>(type);
+	entry->deviceIndex = static_cast<uint8_t>(deviceIndex);
+	entry->inputPathOffset = static_cast<uint16_t>(offset);
+	entry->valid = false;
+
+	this->writePacketToDriverClientLane(buffer.data(), totalSize);
+}
+
+void SharedDeviceMemoryDriver::registerDevice(const DeviceInfo& info) {
+	if (!this->deviceRegistry || info.deviceIndex >= MAX_REGISTRY_DEVICES) return;
+
+	DeviceRegistryDevice device = {};
+	device.registered = true;
+	device.deviceClass = static_cast<uint8_t>(info.deviceClass);
+	device.role = static_cast<uint8_t>(info.role);
+	// The slot is zeroed, so truncated strings stay null terminated
+	info.serialNumber.copy(device.serialNumber, REGISTRY_STRING_SIZE - 1);
+	info.modelNumber.copy(device.modelNumber, REGISTRY_STRING_SIZE - 1);
+
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+	std::lock_guard<std::mutex> registryLock(this->deviceRegistryMutex);
+
+	// An odd version tells clients a copy taken from here on may be torn
+	headerPtr->deviceRegistryVersion.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	this->deviceRegistry->devices[info.deviceIndex] = device;
+
+	headerPtr->deviceRegistryVersion.fetch_add(1, std::memory_order_release);
+}
+
+void SharedDeviceMemoryDriver::registerComponent(const ComponentInfo& info) {
+	if (!this->deviceRegistry || info.deviceIndex >= MAX_REGISTRY_DEVICES) return;
+
+	// Paths are resolved before taking the registry lock, an unset or unresolvable path is left out of range
+	auto getPathOffset = [this](const std::string& path) -> uint16_t {
+		uint32_t offset = path.empty() ? UINT32_MAX : this->getOffsetOfPath(path);
+		return static_cast<uint16_t>((std::min)(offset, static_cast<uint32_t>(UINT16_MAX)));
+	};
+
+	DeviceRegistryComponent component = {};
+	component.componentHandle = info.componentHandle;
+	component.deviceIndex = static_cast<uint8_t>(info.deviceIndex);
+	component.type = static_cast<uint8_t>(info.type);
+	component.scalarType = static_cast<uint8_t>(info.scalarType);
+	component.scalarUnits = static_cast<uint8_t>(info.scalarUnits);
+	component.pathOffset = getPathOffset(info.path);
+	component.skeletonPathOffset = getPathOffset(info.skeletonPath);
+	component.basePosePathOffset = getPathOffset(info.basePosePath);
+	component.skeletalTrackingLevel = static_cast<uint8_t>(info.skeletalTrackingLevel);
+	component.gripLimitSlot = NO_GRIP_LIMIT_SLOT;
+
+	uint32_t gripLimitCount = (std::min)(static_cast<uint32_t>(info.gripLimitTransforms.size()), 31U);
+
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+	std::lock_guard<std::mutex> registryLock(this->deviceRegistryMutex);
+
+	DeviceRegistry* registry = this->deviceRegistry;
+	if (registry->componentCount >= MAX_REGISTRY_COMPONENTS) {
+		LogManager::log(LOG_ERROR, "Device registry full, not registering component {}", info.path);
+		return;
+	}
+
+	headerPtr->deviceRegistryVersion.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	if (gripLimitCount > 0 && !this->freeGripLimitSlots.empty()) {
+		component.gripLimitSlot = this->freeGripLimitSlots.back();
+		this->freeGripLimitSlots.pop_back();
+	} else if (gripLimitCount > 0 && registry->gripLimitSlotCount < MAX_REGISTRY_GRIP_LIMITS) {
+		component.gripLimitSlot = static_cast<uint16_t>(registry->gripLimitSlotCount++);
+	}
+
+	if (component.gripLimitSlot != NO_GRIP_LIMIT_SLOT) {
+		component.gripLimitTransformCount = static_cast<uint8_t>(gripLimitCount);
+		std::copy_n(
+			info.gripLimitTransforms.begin(),
+			gripLimitCount,
+			registry->gripLimitTransforms[component.gripLimitSlot]
+		);
+	}
+
+	registry->components[registry->componentCount++] = component;
+
+	headerPtr->deviceRegistryVersion.fetch_add(1, std::memory_order_release);
+}
+
+DeviceClass SharedDeviceMemoryDriver::getRegisteredDeviceClass(uint32_t deviceIndex) {
+	if (!this->deviceRegistry || deviceIndex >= MAX_REGISTRY_DEVICES) return DeviceClass_Invalid;
+
+	// The driver is the only writer, so holding the writer lock is enough to read a consistent slot
+	std::lock_guard<std::mutex> registryLock(this->deviceRegistryMutex);
+	const DeviceRegistryDevice& device = this->deviceRegistry->devices[deviceIndex];
+	return device.registered ? static_cast<DeviceClass>(device.deviceClass) : DeviceClass_Invalid;
+}
+
+void SharedDeviceMemoryDriver::writeHapticEvent(
+	uint32_t deviceIndex,
+	const std::string& path,
+	vr::VRInputComponentHandle_t componentHandle,
+	const vr::VREvent_HapticVibration_t& vibration,
+	uint8_t flags
+) {
+	if (!this->hapticLane) return;
+
+	int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+	uint32_t pathOffset = this->getOffsetOfPath(path);
+
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+	uint64_t recordNumber = headerPtr->hapticWriteCount.fetch_add(1, std::memory_order_relaxed);
+	HapticEventRecord* record = this->hapticLane + (recordNumber % HAPTIC_LANE_SIZE);
+
+	// Mark the record while it is rewritten, so a concurrent reader retries instead of reading a mix
+	record->sequence.store(HAPTIC_RECORD_WRITING_SEQUENCE, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	record->timestampNanoseconds = timestamp;
+	record->componentHandle = componentHandle;
+	record->deviceIndex = static_cast<uint8_t>(deviceIndex);
+	record->flags = flags;
+	record->pathOffset = static_cast<uint16_t>((std::min)(pathOffset, static_cast<uint32_t>(UINT16_MAX)));
+	record->durationSeconds = vibration.fDurationSeconds;
+	record->frequency = vibration.fFrequency;
+	record->amplitude = vibration.fAmplitude;
+
+	record->sequence.store(recordNumber + 1, std::memory_order_release);
+}
+
+void SharedDeviceMemoryDriver::unregisterDevice(uint32_t deviceIndex) {
+	if (!this->deviceRegistry || deviceIndex >= MAX_REGISTRY_DEVICES) return;
+
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+	std::lock_guard<std::mutex> registryLock(this->deviceRegistryMutex);
+
+	headerPtr->deviceRegistryVersion.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	DeviceRegistry* registry = this->deviceRegistry;
+	registry->devices[deviceIndex] = DeviceRegistryDevice{};
+
+	// The remaining components are moved down in place, so they keep the order they were created in
+	uint32_t keptCount = 0;
+	for (uint32_t i = 0; i < registry->componentCount; i++) {
+		DeviceRegistryComponent component = registry->components[i];
+		if (component.deviceIndex != deviceIndex) {
+			registry->components[keptCount++] = component;
+		} else if (component.gripLimitSlot != NO_GRIP_LIMIT_SLOT) {
+			this->freeGripLimitSlots.push_back(component.gripLimitSlot);
+		}
+	}
+
+	std::fill(
+		registry->components + keptCount,
+		registry->components + registry->componentCount,
+		DeviceRegistryComponent{}
+	);
+	registry->componentCount = keptCount;
+
+	headerPtr->deviceRegistryVersion.fetch_add(1, std::memory_order_release);
+}
+
 bool SharedDeviceMemoryDriver::isValidCommandHeader(
 	const ClientCommandHeader* header,
 	const SharedMemoryHeader* sharedMemoryHeader
@@ -574,10 +1430,16 @@ bool SharedDeviceMemoryDriver::isValidCommandHeader(
 	if (header->alignmentCheck != ALIGNMENT_CONSTANT) return false;
 
 	if (!(Command_SetUseOverriddenStateDevicePose <= header->type && 
-		header->type <= Command_SetOverriddenStateDeviceInputEyeTracking
+		header->type <= Command_SetHapticSuppression
 	)) return false;
 
 	if (!(0 <= header->deviceIndex && header->deviceIndex < vr::k_unMaxTrackedDeviceCount)) return false;
 
+	uint32_t paramsSize = getCommandParamsSize(static_cast<ClientCommandType>(header->type));
+	if (header->frameSize != sizeof(ClientCommandHeader) + paramsSize) return false;
+
+	// Checked last, and only once everything else fits, so a resync scan rarely pays for it
+	if (header->checksum != computeFrameChecksum(header)) return false;
+
 	return true;
 }
\ No newline at end of file
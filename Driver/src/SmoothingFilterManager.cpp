@@ -0,0 +1,221 @@
+#include "SmoothingFilterManager.h"
+
+#include <cmath>
+
+/** @brief Gaps between samples longer than this in seconds reset the filter instead of smoothing across them */
+static const double MAX_FILTER_GAP_SECONDS = 0.25;
+
+/** @brief The smallest time step in seconds used by the filters, guarding against duplicate timestamps */
+static const double MIN_FILTER_STEP_SECONDS = 1e-4;
+
+static const double PI = 3.14159265358979323846;
+static const double LN2 = 0.69314718055994530942;
+
+/**
+ * @brief Returns the smoothing factor of a first order low pass filter with the given cutoff frequency
+ */
+static double lowPassAlpha(double cutoff, double dt) {
+	double tau = 1.0 / (2.0 * PI * (std::max)(cutoff, 1e-6));
+	return 1.0 / (1.0 + tau / dt);
+}
+
+/**
+ * @brief Returns the frame rate independent smoothing factor that halves the remaining distance every <halfLife>
+ */
+static double halfLifeAlpha(double halfLife, double dt) {
+	if (halfLife <= 0.0) return 1.0;
+	return 1.0 - std::exp(-LN2 * dt / halfLife);
+}
+
+/**
+ * @brief Returns the time in seconds since <lastTime>, updating it, or a negative value if the filter should reset
+ */
+static double advanceClock(std::chrono::steady_clock::time_point& lastTime, bool initialized) {
+	auto now = std::chrono::steady_clock::now();
+	double dt = std::chrono::duration<double>(now - lastTime).count();
+	lastTime = now;
+
+	if (!initialized || dt > MAX_FILTER_GAP_SECONDS) return -1.0;
+	return (std::max)(dt, MIN_FILTER_STEP_SECONDS);
+}
+
+SmoothingFilterManager& SmoothingFilterManager::getInstance() {
+	static SmoothingFilterManager instance;
+	return instance;
+}
+
+void SmoothingFilterManager::setPoseFilter(uint32_t deviceIndex, const SmoothingFilterConfig& config) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return;
+
+	PoseFilterState& state = this->poseStates[deviceIndex];
+	std::lock_guard<std::mutex> lock(state.stateMutex);
+
+	// The next pose reinitializes the rest of the state
+	state.config = config;
+	state.initialized = false;
+	this->poseFilterEnabled[deviceIndex].store(config.type != SmoothingFilter_None, std::memory_order_release);
+}
+
+bool SmoothingFilterManager::filterPose(
+	uint32_t deviceIndex,
+	const vr::DriverPose_t& pose,
+	vr::DriverPose_t& outPose
+) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return false;
+	if (!this->poseFilterEnabled[deviceIndex].load(std::memory_order_acquire)) return false;
+
+	PoseFilterState& state = this->poseStates[deviceIndex];
+	std::lock_guard<std::mutex> lock(state.stateMutex);
+
+	const SmoothingFilterConfig& config = state.config;
+	if (config.type == SmoothingFilter_None) return false;
+
+	// Tracking loss breaks continuity, so start over from the next valid pose
+	if (!pose.poseIsValid) {
+		state.initialized = false;
+		return false;
+	}
+
+	outPose = pose;
+
+	alignas(32) double target[4] = { pose.vecPosition[0], pose.vecPosition[1], pose.vecPosition[2], 0.0 };
+	double* position = state.position;
+	double* velocity = state.velocity;
+
+	double dt = advanceClock(state.lastTime, state.initialized);
+	if (dt < 0.0) {
+		for (int i = 0; i < 4; i++) {
+			position[i] = target[i];
+			velocity[i] = 0.0;
+		}
+		state.rotation = outPose.qRotation;
+		state.angularSpeed = 0.0;
+		state.initialized = true;
+		return true;
+	}
+
+	// The per-axis loops below run over padded 4 lane arrays so they compile down to packed vector instructions
+	switch (config.type) {
+		case SmoothingFilter_OneEuro: {
+			double derivativeAlpha = lowPassAlpha(config.derivativeCutoff, dt);
+
+			for (int i = 0; i < 4; i++) {
+				double speed = (target[i] - position[i]) / dt;
+				velocity[i] += derivativeAlpha * (speed - velocity[i]);
+			}
+
+			for (int i = 0; i < 4; i++) {
+				double alpha = lowPassAlpha(config.minCutoff + config.beta * std::fabs(velocity[i]), dt);
+				position[i] += alpha * (target[i] - position[i]);
+			}
+
+			const vr::HmdQuaternion_t& q = outPose.qRotation;
+			const vr::HmdQuaternion_t& r = state.rotation;
+			double dot = std::fabs(q.w * r.w + q.x * r.x + q.y * r.y + q.z * r.z);
+			double angle = 2.0 * std::acos((std::min)(dot, 1.0));
+			state.angularSpeed += derivativeAlpha * (angle / dt - state.angularSpeed);
+
+			double rotationAlpha = lowPassAlpha(config.minCutoff + config.beta * state.angularSpeed, dt);
+			state.rotation = SlerpQuaternions(state.rotation, outPose.qRotation, rotationAlpha);
+			break;
+		}
+		case SmoothingFilter_CriticallyDampedSpring: {
+			double y = 2.0 * LN2 / (std::max)(config.halfLife, 1e-6);
+			double eydt = std::exp(-y * dt);
+
+			for (int i = 0; i < 4; i++) {
+				double j0 = position[i] - target[i];
+				double j1 = velocity[i] + j0 * y;
+				position[i] = eydt * (j0 + j1 * dt) + target[i];
+				velocity[i] = eydt * (velocity[i] - j1 * y * dt);
+			}
+
+			state.rotation = SlerpQuaternions(state.rotation, outPose.qRotation, halfLifeAlpha(config.halfLife, dt));
+			break;
+		}
+		case SmoothingFilter_Slerp: {
+			double alpha = halfLifeAlpha(config.halfLife, dt);
+
+			for (int i = 0; i < 4; i++) position[i] += alpha * (target[i] - position[i]);
+
+			state.rotation = SlerpQuaternions(state.rotation, outPose.qRotation, alpha);
+			break;
+		}
+		default:
+			return false;
+	}
+
+	for (int i = 0; i < 3; i++) outPose.vecPosition[i] = position[i];
+	outPose.qRotation = state.rotation;
+
+	// Raw velocities would let the runtime's prediction reintroduce the jitter, so report the filter's estimate
+	if (config.type != SmoothingFilter_Slerp) {
+		for (int i = 0; i < 3; i++) outPose.vecVelocity[i] = velocity[i];
+	}
+
+	return true;
+}
+
+void SmoothingFilterManager::setScalarFilter(
+	vr::VRInputComponentHandle_t componentHandle,
+	const SmoothingFilterConfig& config
+) {
+	std::lock_guard<std::mutex> lock(this->filterMutex);
+
+	if (config.type == SmoothingFilter_None) {
+		this->scalarStates.erase(componentHandle);
+	} else {
+		this->scalarStates[componentHandle] = ScalarFilterState{};
+		this->scalarStates[componentHandle].config = config;
+	}
+
+	this->scalarFilterCount.store(static_cast<uint32_t>(this->scalarStates.size()), std::memory_order_release);
+}
+
+bool SmoothingFilterManager::filterScalar(vr::VRInputComponentHandle_t componentHandle, float& value) {
+	if (this->scalarFilterCount.load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->filterMutex);
+
+	auto it = this->scalarStates.find(componentHandle);
+	if (it == this->scalarStates.end()) return false;
+
+	ScalarFilterState& state = it->second;
+	const SmoothingFilterConfig& config = state.config;
+	double target = value;
+
+	double dt = advanceClock(state.lastTime, state.initialized);
+	if (dt < 0.0) {
+		state.value = target;
+		state.velocity = 0.0;
+		state.initialized = true;
+		return true;
+	}
+
+	switch (config.type) {
+		case SmoothingFilter_OneEuro: {
+			state.velocity += lowPassAlpha(config.derivativeCutoff, dt) * ((target - state.value) / dt - state.velocity);
+			double alpha = lowPassAlpha(config.minCutoff + config.beta * std::fabs(state.velocity), dt);
+			state.value += alpha * (target - state.value);
+			break;
+		}
+		case SmoothingFilter_CriticallyDampedSpring: {
+			double y = 2.0 * LN2 / (std::max)(config.halfLife, 1e-6);
+			double eydt = std::exp(-y * dt);
+			double j0 = state.value - target;
+			double j1 = state.velocity + j0 * y;
+			state.value = eydt * (j0 + j1 * dt) + target;
+			state.velocity = eydt * (state.velocity - j1 * y * dt);
+			break;
+		}
+		case SmoothingFilter_Slerp: {
+			state.value += halfLifeAlpha(config.halfLife, dt) * (target - state.value);
+			break;
+		}
+		default:
+			return false;
+	}
+
+	value = static_cast<float>(state.value);
+	return true;
+}
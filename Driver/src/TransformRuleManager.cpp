@@ -0,0 +1,194 @@
+#include "TransformRuleManager.h"
+
+#include <algorithm>
+
+TransformRuleManager& TransformRuleManager::getInstance() {
+	static TransformRuleManager instance;
+	return instance;
+}
+
+void TransformRuleManager::setPoseRules(uint32_t deviceIndex, const PoseTransformRule* rules, uint32_t ruleCount) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return;
+	if (ruleCount > MAX_POSE_TRANSFORM_RULES) ruleCount = MAX_POSE_TRANSFORM_RULES;
+
+	std::lock_guard<std::mutex> lock(this->ruleMutex);
+
+	PoseRuleSet& ruleSet = this->poseRules[deviceIndex];
+	this->remapRuleCount.fetch_sub(ruleSet.remapRuleCount, std::memory_order_relaxed);
+
+	ruleSet.ruleCount = ruleCount;
+	ruleSet.remapRuleCount = 0;
+	for (uint32_t i = 0; i < ruleCount; i++) {
+		ruleSet.rules[i] = rules[i];
+		if (rules[i].type == PoseTransformRule_RemapFromDevice) ruleSet.remapRuleCount++;
+	}
+
+	this->remapRuleCount.fetch_add(ruleSet.remapRuleCount, std::memory_order_relaxed);
+	this->poseRuleCounts[deviceIndex].store(ruleCount, std::memory_order_release);
+}
+
+bool TransformRuleManager::applyPoseRules(uint32_t deviceIndex, const vr::DriverPose_t& pose, vr::DriverPose_t& outPose) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return false;
+	if (this->poseRuleCounts[deviceIndex].load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->ruleMutex);
+
+	const PoseRuleSet& ruleSet = this->poseRules[deviceIndex];
+	if (ruleSet.ruleCount == 0) return false;
+
+	outPose = pose;
+
+	for (uint32_t i = 0; i < ruleSet.ruleCount; i++) {
+		const PoseTransformRule& rule = ruleSet.rules[i];
+
+		switch (rule.type) {
+			case PoseTransformRule_Offset: {
+				double offset[3] = { rule.vector[0], rule.vector[1], rule.vector[2] };
+				if (rule.localSpace) RotateVector(outPose.qRotation, offset, offset);
+
+				for (int axis = 0; axis < 3; axis++) outPose.vecPosition[axis] += offset[axis];
+				break;
+			}
+			case PoseTransformRule_Rotate: {
+				vr::HmdQuaternion_t rotation = { rule.rotation.w, rule.rotation.x, rule.rotation.y, rule.rotation.z };
+
+				if (rule.localSpace) {
+					outPose.qRotation = MultiplyQuaternions(outPose.qRotation, rotation);
+				} else {
+					// Driver space rotations pivot around the driver space origin, so the linear state rotates too
+					outPose.qRotation = MultiplyQuaternions(rotation, outPose.qRotation);
+					RotateVector(rotation, outPose.vecPosition, outPose.vecPosition);
+					RotateVector(rotation, outPose.vecVelocity, outPose.vecVelocity);
+					RotateVector(rotation, outPose.vecAcceleration, outPose.vecAcceleration);
+					RotateVector(rotation, outPose.vecAngularVelocity, outPose.vecAngularVelocity);
+					RotateVector(rotation, outPose.vecAngularAcceleration, outPose.vecAngularAcceleration);
+				}
+				break;
+			}
+			case PoseTransformRule_AxisLock: {
+				for (int axis = 0; axis < 3; axis++) {
+					if (!(rule.axisMask & (1U << axis))) continue;
+
+					outPose.vecPosition[axis] = rule.vector[axis];
+					outPose.vecVelocity[axis] = 0.0;
+					outPose.vecAcceleration[axis] = 0.0;
+				}
+				break;
+			}
+			case PoseTransformRule_Scale: {
+				for (int axis = 0; axis < 3; axis++) {
+					outPose.vecPosition[axis] *= rule.vector[axis];
+					outPose.vecVelocity[axis] *= rule.vector[axis];
+					outPose.vecAcceleration[axis] *= rule.vector[axis];
+				}
+				break;
+			}
+			case PoseTransformRule_Mirror: {
+				double* quaternionAxes[3] = { &outPose.qRotation.x, &outPose.qRotation.y, &outPose.qRotation.z };
+
+				for (int axis = 0; axis < 3; axis++) {
+					if (!(rule.axisMask & (1U << axis))) continue;
+
+					// Positions flip along the mirrored axis, while rotations (being pseudovectors) flip along the
+					// other two
+					outPose.vecPosition[axis] = -outPose.vecPosition[axis];
+					outPose.vecVelocity[axis] = -outPose.vecVelocity[axis];
+					outPose.vecAcceleration[axis] = -outPose.vecAcceleration[axis];
+
+					for (int other = 0; other < 3; other++) {
+						if (other == axis) continue;
+
+						*quaternionAxes[other] = -*quaternionAxes[other];
+						outPose.vecAngularVelocity[other] = -outPose.vecAngularVelocity[other];
+						outPose.vecAngularAcceleration[other] = -outPose.vecAngularAcceleration[other];
+					}
+				}
+				break;
+			}
+			case PoseTransformRule_RemapFromDevice: {
+				if (rule.sourceDeviceIndex >= vr::k_unMaxTrackedDeviceCount) break;
+
+				bool deviceIsConnected = outPose.deviceIsConnected;
+				outPose = this->naturalPoses[rule.sourceDeviceIndex];
+				outPose.deviceIsConnected = deviceIsConnected;
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+void TransformRuleManager::recordNaturalPose(uint32_t deviceIndex, const vr::DriverPose_t& pose) {
+	if (deviceIndex >= vr::k_unMaxTrackedDeviceCount) return;
+	if (this->remapRuleCount.load(std::memory_order_relaxed) == 0) return;
+
+	std::lock_guard<std::mutex> lock(this->ruleMutex);
+	this->naturalPoses[deviceIndex] = pose;
+}
+
+void TransformRuleManager::setInputRules(
+	vr::VRInputComponentHandle_t componentHandle,
+	const InputTransformRule* rules,
+	uint32_t ruleCount
+) {
+	if (ruleCount > MAX_INPUT_TRANSFORM_RULES) ruleCount = MAX_INPUT_TRANSFORM_RULES;
+
+	std::lock_guard<std::mutex> lock(this->ruleMutex);
+
+	if (ruleCount == 0) {
+		this->inputRules.erase(componentHandle);
+	} else {
+		InputRuleSet& ruleSet = this->inputRules[componentHandle];
+		ruleSet.ruleCount = ruleCount;
+		for (uint32_t i = 0; i < ruleCount; i++) ruleSet.rules[i] = rules[i];
+	}
+
+	this->inputRuleSetCount.store(static_cast<uint32_t>(this->inputRules.size()), std::memory_order_release);
+}
+
+bool TransformRuleManager::applyBooleanRules(vr::VRInputComponentHandle_t componentHandle, bool& value) {
+	if (this->inputRuleSetCount.load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->ruleMutex);
+
+	const InputRuleSet* ruleSet = this->findInputRules(componentHandle);
+	if (ruleSet == nullptr) return false;
+
+	for (uint32_t i = 0; i < ruleSet->ruleCount; i++) {
+		if (ruleSet->rules[i].type == InputTransformRule_Invert) value = !value;
+	}
+
+	return true;
+}
+
+bool TransformRuleManager::applyScalarRules(vr::VRInputComponentHandle_t componentHandle, float& value) {
+	if (this->inputRuleSetCount.load(std::memory_order_acquire) == 0) return false;
+
+	std::lock_guard<std::mutex> lock(this->ruleMutex);
+
+	const InputRuleSet* ruleSet = this->findInputRules(componentHandle);
+	if (ruleSet == nullptr) return false;
+
+	double result = value;
+	for (uint32_t i = 0; i < ruleSet->ruleCount; i++) {
+		const InputTransformRule& rule = ruleSet->rules[i];
+
+		switch (rule.type) {
+			case InputTransformRule_Scale: result *= rule.a; break;
+			case InputTransformRule_Offset: result += rule.a; break;
+			case InputTransformRule_Clamp: result = std::clamp(result, rule.a, (std::max)(rule.a, rule.b)); break;
+			case InputTransformRule_Invert: result = rule.a - result; break;
+		}
+	}
+
+	value = static_cast<float>(result);
+	return true;
+}
+
+const TransformRuleManager::InputRuleSet* TransformRuleManager::findInputRules(
+	vr::VRInputComponentHandle_t componentHandle
+) {
+	auto it = this->inputRules.find(componentHandle);
+	return it == this->inputRules.end() ? nullptr : &(it->second);
+}
@@ -1,109 +1,175 @@
 #include "Utils.h"
+#include "SharedDeviceMemoryDriver.h"
+
+#include <cstddef>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CONDUIT_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONDUIT_SIMD_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CONDUIT_SIMD_NEON
+#endif
 
 vr::ETrackedDeviceClass getDeviceClass(uint32_t deviceIndex) {
+	DeviceClass deviceClass = SharedDeviceMemoryDriver::getInstance().getRegisteredDeviceClass(deviceIndex);
+	return static_cast<vr::ETrackedDeviceClass>(deviceClass);
+}
+
+DeviceInfo ReadDeviceInfo(uint32_t deviceIndex) {
+	DeviceInfo info;
+	info.deviceIndex = deviceIndex;
+
 	vr::PropertyContainerHandle_t container = vr::VRProperties()->TrackedDeviceToPropertyContainer(deviceIndex);
 	vr::ETrackedPropertyError error;
-	int32_t result = vr::VRProperties()->GetInt32Property(container, vr::Prop_DeviceClass_Int32, &error);
-	if (error == vr::TrackedProp_Success) return static_cast<vr::ETrackedDeviceClass>(result);
-	else return vr::TrackedDeviceClass_Invalid;
-}
 
-DevicePose FromDriverPose(const vr::DriverPose_t& pose) {
-    DevicePose cp{};
-    cp.poseTimeOffset = pose.poseTimeOffset;
-
-    cp.qWorldFromDriverRotation = {
-        pose.qWorldFromDriverRotation.w,
-        pose.qWorldFromDriverRotation.x,
-        pose.qWorldFromDriverRotation.y,
-        pose.qWorldFromDriverRotation.z
-    };
-    std::copy(
-        std::begin(pose.vecWorldFromDriverTranslation),
-        std::end(pose.vecWorldFromDriverTranslation),
-        cp.vecWorldFromDriverTranslation
-    );
+	int32_t deviceClass = vr::VRProperties()->GetInt32Property(container, vr::Prop_DeviceClass_Int32, &error);
+	if (error == vr::TrackedProp_Success) info.deviceClass = static_cast<DeviceClass>(deviceClass);
 
-    cp.qDriverFromHeadRotation = {
-        pose.qDriverFromHeadRotation.w,
-        pose.qDriverFromHeadRotation.x,
-        pose.qDriverFromHeadRotation.y,
-        pose.qDriverFromHeadRotation.z
-    };
-    std::copy(
-        std::begin(pose.vecDriverFromHeadTranslation),
-        std::end(pose.vecDriverFromHeadTranslation),
-        cp.vecDriverFromHeadTranslation
-    );
+	int32_t role = vr::VRProperties()->GetInt32Property(container, vr::Prop_ControllerRoleHint_Int32, &error);
+	if (error == vr::TrackedProp_Success) info.role = static_cast<DeviceRole>(role);
 
-    std::copy(std::begin(pose.vecPosition), std::end(pose.vecPosition), cp.vecPosition);
-    std::copy(std::begin(pose.vecVelocity), std::end(pose.vecVelocity), cp.vecVelocity);
-    std::copy(std::begin(pose.vecAcceleration), std::end(pose.vecAcceleration), cp.vecAcceleration);
+	std::string serialNumber = vr::VRProperties()->GetStringProperty(container, vr::Prop_SerialNumber_String, &error);
+	if (error == vr::TrackedProp_Success) info.serialNumber = serialNumber;
 
-    cp.qRotation = { pose.qRotation.w, pose.qRotation.x, pose.qRotation.y, pose.qRotation.z };
+	std::string modelNumber = vr::VRProperties()->GetStringProperty(container, vr::Prop_ModelNumber_String, &error);
+	if (error == vr::TrackedProp_Success) info.modelNumber = modelNumber;
 
-    std::copy(std::begin(pose.vecAngularVelocity), std::end(pose.vecAngularVelocity), cp.vecAngularVelocity);
-    std::copy(
-        std::begin(pose.vecAngularAcceleration),
-        std::end(pose.vecAngularAcceleration),
-        cp.vecAngularAcceleration
-    );
+	return info;
+}
+
+// DevicePose mirrors the layout of DriverPose_t, so everything up to <result> is a contiguous block of doubles that
+// can be copied as-is without going field by field
+constexpr size_t POSE_DOUBLE_COUNT = offsetof(vr::DriverPose_t, result) / sizeof(double);
 
-    cp.result = static_cast<DeviceTrackingResult>(pose.result);
+static_assert(offsetof(DevicePose, qWorldFromDriverRotation) == offsetof(vr::DriverPose_t, qWorldFromDriverRotation));
+static_assert(offsetof(DevicePose, vecWorldFromDriverTranslation) ==
+    offsetof(vr::DriverPose_t, vecWorldFromDriverTranslation));
+static_assert(offsetof(DevicePose, qDriverFromHeadRotation) == offsetof(vr::DriverPose_t, qDriverFromHeadRotation));
+static_assert(offsetof(DevicePose, vecDriverFromHeadTranslation) ==
+    offsetof(vr::DriverPose_t, vecDriverFromHeadTranslation));
+static_assert(offsetof(DevicePose, vecPosition) == offsetof(vr::DriverPose_t, vecPosition));
+static_assert(offsetof(DevicePose, vecVelocity) == offsetof(vr::DriverPose_t, vecVelocity));
+static_assert(offsetof(DevicePose, vecAcceleration) == offsetof(vr::DriverPose_t, vecAcceleration));
+static_assert(offsetof(DevicePose, qRotation) == offsetof(vr::DriverPose_t, qRotation));
+static_assert(offsetof(DevicePose, vecAngularVelocity) == offsetof(vr::DriverPose_t, vecAngularVelocity));
+static_assert(offsetof(DevicePose, vecAngularAcceleration) == offsetof(vr::DriverPose_t, vecAngularAcceleration));
+static_assert(offsetof(DevicePose, result) == offsetof(vr::DriverPose_t, result));
 
-    cp.poseIsValid = pose.poseIsValid;
-    cp.willDriftInYaw = pose.willDriftInYaw;
-    cp.shouldApplyHeadModel = pose.shouldApplyHeadModel;
-    cp.deviceIsConnected = pose.deviceIsConnected;
+// A bone is 8 floats in OpenVR (position xyzw, orientation wxyz) and the same 8 values as doubles in Conduit
+static_assert(sizeof(vr::VRBoneTransform_t) == 8 * sizeof(float));
+static_assert(sizeof(BoneTransform) == 8 * sizeof(double));
+static_assert(offsetof(vr::VRBoneTransform_t, orientation) == 4 * sizeof(float));
+static_assert(offsetof(BoneTransform, orientation) == 4 * sizeof(double));
+
+/**
+ * @brief Copies <count> doubles from <src> to <dst>
+ */
+static inline void copyDoubles(const double* src, double* dst, size_t count) {
+    size_t i = 0;
+#if defined(CONDUIT_SIMD_AVX)
+    for (; i + 4 <= count; i += 4) _mm256_storeu_pd(dst + i, _mm256_loadu_pd(src + i));
+#endif
+#if defined(CONDUIT_SIMD_AVX) || defined(CONDUIT_SIMD_SSE2)
+    for (; i + 2 <= count; i += 2) _mm_storeu_pd(dst + i, _mm_loadu_pd(src + i));
+#elif defined(CONDUIT_SIMD_NEON)
+    for (; i + 2 <= count; i += 2) vst1q_f64(dst + i, vld1q_f64(src + i));
+#endif
+    for (; i < count; i++) dst[i] = src[i];
+}
+
+/**
+ * @brief Widens <count> floats from <src> into doubles at <dst>
+ */
+static inline void widenFloats(const float* src, double* dst, size_t count) {
+    size_t i = 0;
+#if defined(CONDUIT_SIMD_AVX)
+    for (; i + 4 <= count; i += 4) _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+#elif defined(CONDUIT_SIMD_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 f = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(dst + i, _mm_cvtps_pd(f));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+    }
+#elif defined(CONDUIT_SIMD_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t f = vld1q_f32(src + i);
+        vst1q_f64(dst + i, vcvt_f64_f32(vget_low_f32(f)));
+        vst1q_f64(dst + i + 2, vcvt_f64_f32(vget_high_f32(f)));
+    }
+#endif
+    for (; i < count; i++) dst[i] = static_cast<double>(src[i]);
+}
 
+/**
+ * @brief Narrows <count> doubles from <src> into floats at <dst>
+ */
+static inline void narrowDoubles(const double* src, float* dst, size_t count) {
+    size_t i = 0;
+#if defined(CONDUIT_SIMD_AVX)
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+#elif defined(CONDUIT_SIMD_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+#elif defined(CONDUIT_SIMD_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x2_t lo = vcvt_f32_f64(vld1q_f64(src + i));
+        float32x2_t hi = vcvt_f32_f64(vld1q_f64(src + i + 2));
+        vst1q_f32(dst + i, vcombine_f32(lo, hi));
+    }
+#endif
+    for (; i < count; i++) dst[i] = static_cast<float>(src[i]);
+}
+
+DevicePose FromDriverPose(const vr::DriverPose_t& pose) {
+    DevicePose cp;
+    FromDriverPoses(&pose, 1, &cp);
     return cp;
 }
 
 vr::DriverPose_t ToDriverPose(const DevicePose& cp) {
-    vr::DriverPose_t pose = {};
-    pose.poseTimeOffset = cp.poseTimeOffset;
-
-    pose.qWorldFromDriverRotation = { 
-        cp.qWorldFromDriverRotation.w,
-        cp.qWorldFromDriverRotation.x,
-        cp.qWorldFromDriverRotation.y,
-        cp.qWorldFromDriverRotation.z
-    };
-    std::copy(
-        std::begin(cp.vecWorldFromDriverTranslation),
-        std::end(cp.vecWorldFromDriverTranslation),
-        pose.vecWorldFromDriverTranslation
-    );
+    vr::DriverPose_t pose;
+    ToDriverPoses(&cp, 1, &pose);
+    return pose;
+}
 
-    pose.qDriverFromHeadRotation = {
-        cp.qDriverFromHeadRotation.w,
-        cp.qDriverFromHeadRotation.x,
-        cp.qDriverFromHeadRotation.y,
-        cp.qDriverFromHeadRotation.z
-    };
-    std::copy(
-        std::begin(cp.vecDriverFromHeadTranslation),
-        std::end(cp.vecDriverFromHeadTranslation),
-        pose.vecDriverFromHeadTranslation
-    );
+void FromDriverPoses(const vr::DriverPose_t* poses, uint32_t count, DevicePose* outPoses) {
+    for (uint32_t i = 0; i < count; i++) {
+        const vr::DriverPose_t& pose = poses[i];
+        DevicePose& cp = outPoses[i];
+
+        copyDoubles(reinterpret_cast<const double*>(&pose), reinterpret_cast<double*>(&cp), POSE_DOUBLE_COUNT);
 
-    std::copy(std::begin(cp.vecPosition), std::end(cp.vecPosition), pose.vecPosition);
-    std::copy(std::begin(cp.vecVelocity), std::end(cp.vecVelocity), pose.vecVelocity);
-    std::copy(std::begin(cp.vecAcceleration), std::end(cp.vecAcceleration), pose.vecAcceleration);
+        cp.result = static_cast<DeviceTrackingResult>(pose.result);
 
-    pose.qRotation = { cp.qRotation.w, cp.qRotation.x, cp.qRotation.y, cp.qRotation.z };
+        cp.poseIsValid = pose.poseIsValid;
+        cp.willDriftInYaw = pose.willDriftInYaw;
+        cp.shouldApplyHeadModel = pose.shouldApplyHeadModel;
+        cp.deviceIsConnected = pose.deviceIsConnected;
+    }
+}
 
-    std::copy(std::begin(cp.vecAngularVelocity), std::end(cp.vecAngularVelocity), pose.vecAngularVelocity);
-    std::copy(std::begin(cp.vecAngularAcceleration), std::end(cp.vecAngularAcceleration), pose.vecAngularAcceleration);
+void ToDriverPoses(const DevicePose* poses, uint32_t count, vr::DriverPose_t* outPoses) {
+    for (uint32_t i = 0; i < count; i++) {
+        const DevicePose& cp = poses[i];
+        vr::DriverPose_t& pose = outPoses[i];
 
-    pose.result = static_cast<vr::ETrackingResult>(cp.result);
+        copyDoubles(reinterpret_cast<const double*>(&cp), reinterpret_cast<double*>(&pose), POSE_DOUBLE_COUNT);
 
-    pose.poseIsValid = cp.poseIsValid;
-    pose.willDriftInYaw = cp.willDriftInYaw;
-    pose.shouldApplyHeadModel = cp.shouldApplyHeadModel;
-    pose.deviceIsConnected = cp.deviceIsConnected;
+        pose.result = static_cast<vr::ETrackingResult>(cp.result);
 
-    return pose;
+        pose.poseIsValid = cp.poseIsValid;
+        pose.willDriftInYaw = cp.willDriftInYaw;
+        pose.shouldApplyHeadModel = cp.shouldApplyHeadModel;
+        pose.deviceIsConnected = cp.deviceIsConnected;
+    }
 }
 
 vr::HmdMatrix34_t ToHmdMatrix34(const DeviceMatrix34& mat) {
@@ -127,40 +193,22 @@ DeviceMatrix34 FromHmdMatrix34(const vr::HmdMatrix34_t& mat) {
 }
 
 void ToVRBoneTransforms(const SkeletonInput& input, vr::VRBoneTransform_t* outTransforms) {
-    for (uint32_t i = 0; i < input.boneTransformCount; i++) {
-        const auto& bt = input.boneTransforms[i];
-        outTransforms[i].position = {
-            (float)bt.position.v[0],
-            (float)bt.position.v[1],
-            (float)bt.position.v[2],
-            (float)bt.position.v[3]
-        };
-        outTransforms[i].orientation = {
-            (float)bt.orientation.w,
-            (float)bt.orientation.x,
-            (float)bt.orientation.y,
-            (float)bt.orientation.z
-        };
-    }
+    uint32_t count = input.boneTransformCount < 31 ? input.boneTransformCount : 31;
+    narrowDoubles(
+        reinterpret_cast<const double*>(input.boneTransforms),
+        reinterpret_cast<float*>(outTransforms),
+        static_cast<size_t>(count) * 8
+    );
 }
 
 void FromVRBoneTransforms(const vr::VRBoneTransform_t* transforms, uint32_t count, SkeletonInput& outInput) {
+    if (count > 31) count = 31;
     outInput.boneTransformCount = count;
-    for (uint32_t i = 0; i < count; i++) {
-        const auto& bt = transforms[i];
-        outInput.boneTransforms[i].position = {
-            bt.position.v[0],
-            bt.position.v[1],
-            bt.position.v[2],
-            bt.position.v[3]
-        };
-        outInput.boneTransforms[i].orientation = {
-            bt.orientation.w,
-            bt.orientation.x,
-            bt.orientation.y,
-            bt.orientation.z
-        };
-    }
+    widenFloats(
+        reinterpret_cast<const float*>(transforms),
+        reinterpret_cast<double*>(outInput.boneTransforms),
+        static_cast<size_t>(count) * 8
+    );
 }
 
 vr::VREyeTrackingData_t ToVREyeTrackingData(const EyeTrackingData& data) {
@@ -181,4 +229,115 @@ EyeTrackingData FromVREyeTrackingData(const vr::VREyeTrackingData_t& data) {
     result.gazeOrigin = { data.vGazeOrigin.v[0], data.vGazeOrigin.v[1], data.vGazeOrigin.v[2] };
     result.gazeTarget = { data.vGazeTarget.v[0], data.vGazeTarget.v[1], data.vGazeTarget.v[2] };
     return result;
+}
+
+vr::HmdQuaternion_t MultiplyQuaternions(const vr::HmdQuaternion_t& a, const vr::HmdQuaternion_t& b) {
+    vr::HmdQuaternion_t result;
+    result.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+    result.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+    result.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+    result.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+    return result;
+}
+
+void RotateVector(const vr::HmdQuaternion_t& q, const double vector[3], double outVector[3]) {
+    // v' = v + 2w(u x v) + 2u x (u x v), where u is the vector part of q
+    double tx = 2.0 * (q.y * vector[2] - q.z * vector[1]);
+    double ty = 2.0 * (q.z * vector[0] - q.x * vector[2]);
+    double tz = 2.0 * (q.x * vector[1] - q.y * vector[0]);
+
+    double x = vector[0] + q.w * tx + (q.y * tz - q.z * ty);
+    double y = vector[1] + q.w * ty + (q.z * tx - q.x * tz);
+    double z = vector[2] + q.w * tz + (q.x * ty - q.y * tx);
+
+    outVector[0] = x;
+    outVector[1] = y;
+    outVector[2] = z;
+}
+
+vr::HmdQuaternion_t SlerpQuaternions(const vr::HmdQuaternion_t& a, const vr::HmdQuaternion_t& b, double t) {
+    double dot = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+
+    // q and -q are the same rotation, so flip b onto a's hemisphere to take the shortest arc
+    double sign = 1.0;
+    if (dot < 0.0) {
+        dot = -dot;
+        sign = -1.0;
+    }
+
+    double weightA, weightB;
+    if (dot > 0.9995) {
+        // Nearly parallel, where normalized lerp is accurate and avoids dividing by sin(~0)
+        weightA = 1.0 - t;
+        weightB = t;
+    } else {
+        double theta = std::acos(dot);
+        double sinTheta = std::sin(theta);
+        weightA = std::sin((1.0 - t) * theta) / sinTheta;
+        weightB = std::sin(t * theta) / sinTheta;
+    }
+    weightB *= sign;
+
+    vr::HmdQuaternion_t result;
+    result.w = weightA * a.w + weightB * b.w;
+    result.x = weightA * a.x + weightB * b.x;
+    result.y = weightA * a.y + weightB * b.y;
+    result.z = weightA * a.z + weightB * b.z;
+
+    double length = std::sqrt(result.w * result.w + result.x * result.x + result.y * result.y + result.z * result.z);
+    if (length > 0.0) {
+        result.w /= length;
+        result.x /= length;
+        result.y /= length;
+        result.z /= length;
+    }
+
+    return result;
+}
+
+void MergeDriverPose(const vr::DriverPose_t& overriddenPose, uint32_t fieldMask, vr::DriverPose_t& pose) {
+    if (fieldMask & PoseField_Position) {
+        for (int i = 0; i < 3; i++) pose.vecPosition[i] = overriddenPose.vecPosition[i];
+    }
+    if (fieldMask & PoseField_Rotation) pose.qRotation = overriddenPose.qRotation;
+    if (fieldMask & PoseField_Velocity) {
+        for (int i = 0; i < 3; i++) {
+            pose.vecVelocity[i] = overriddenPose.vecVelocity[i];
+            pose.vecAcceleration[i] = overriddenPose.vecAcceleration[i];
+        }
+    }
+    if (fieldMask & PoseField_AngularVelocity) {
+        for (int i = 0; i < 3; i++) {
+            pose.vecAngularVelocity[i] = overriddenPose.vecAngularVelocity[i];
+            pose.vecAngularAcceleration[i] = overriddenPose.vecAngularAcceleration[i];
+        }
+    }
+    if (fieldMask & PoseField_Flags) {
+        pose.result = overriddenPose.result;
+        pose.poseIsValid = overriddenPose.poseIsValid;
+        pose.willDriftInYaw = overriddenPose.willDriftInYaw;
+        pose.shouldApplyHeadModel = overriddenPose.shouldApplyHeadModel;
+        pose.deviceIsConnected = overriddenPose.deviceIsConnected;
+    }
+    if (fieldMask & PoseField_Transforms) {
+        pose.poseTimeOffset = overriddenPose.poseTimeOffset;
+        pose.qWorldFromDriverRotation = overriddenPose.qWorldFromDriverRotation;
+        pose.qDriverFromHeadRotation = overriddenPose.qDriverFromHeadRotation;
+        for (int i = 0; i < 3; i++) {
+            pose.vecWorldFromDriverTranslation[i] = overriddenPose.vecWorldFromDriverTranslation[i];
+            pose.vecDriverFromHeadTranslation[i] = overriddenPose.vecDriverFromHeadTranslation[i];
+        }
+    }
+}
+
+void MergeBoneTransforms(
+    const vr::VRBoneTransform_t* overriddenTransforms,
+    uint32_t boneMask,
+    uint32_t count,
+    vr::VRBoneTransform_t* transforms
+) {
+    uint32_t boneCount = count < 31 ? count : 31;
+    for (uint32_t i = 0; i < boneCount; i++) {
+        if (boneMask & (1U << i)) transforms[i] = overriddenTransforms[i];
+    }
 }
\ No newline at end of file
@@ -16,15 +16,22 @@ void Main::main() {
 	}
 }
 
-// Currently unused, may be implemented in a future update
 void Main::pollEvents() {
 	vr::VREvent_t event;
-	if (vr::VRServerDriverHost()->PollNextEvent(&event, sizeof(vr::VREvent_t))) {
+	while (callPollNextEvent(&event, sizeof(vr::VREvent_t))) {
 		switch (event.eventType) {
 		case vr::VREvent_TrackedDeviceActivated:
+			// The vendor driver has set the device properties once it is activated, so clients see them before its
+			// first pose
+			SharedDeviceMemoryDriver::getInstance().registerDevice(ReadDeviceInfo(event.trackedDeviceIndex));
 			break;
-		case vr::VREvent_TrackedDeviceDeactivated:
+		case vr::VREvent_TrackedDeviceDeactivated: {
+			std::unique_lock<std::shared_mutex> batchLock(DeviceStateModel::getInstance().getBatchMutex());
+			DeviceStateModel::getInstance().removeDevice(event.trackedDeviceIndex);
+
+			LogManager::log(LOG_INFO, "Removed deactivated device {}", event.trackedDeviceIndex);
 			break;
 		}
+		}
 	}
 }
\ No newline at end of file
@@ -6,6 +6,11 @@
 #include <stdint.h>
 #include <optional>
 #include <string>
+#include <vector>
+#include <utility>
+#include <future>
+#include <functional>
+#include <chrono>
 
 /**
  * @brief Handles sending client commands to the Conduit driver, and notifies event listeners of incoming events from
@@ -36,14 +41,130 @@ public:
 	 * 1 - Failed to get shared memory handle
 	 * 2 - Failed to map shared memory
 	 * 3 - Shared memory protocol version mismatch
+	 * 4 - Failed to map the lanes the driver mirrored
 	 */
 	int initialize();
 
+	/**
+	 * @brief Returns how the shared memory was mapped into this process. When the driver runs with "lockSharedMemory"
+	 * enabled in the driver_conduit section of steamvr.vrsettings, initialize() prefaults and locks the mapping
+	 * @return The mapping stats, which are all unset before initialize() succeeds
+	 */
+	SharedMemoryMappingStats getSharedMemoryMappingStats();
+
 	/**
 	 * @brief Used to notify the conduit driver that a client is disconnecting (Unused)
 	 */
 	void notifyClientDisconnect();
 
+	/**
+	 * @brief Sends all buffered commands to the Conduit driver immediately. Commands are otherwise buffered and sent
+	 * once per poll period, where repeated commands to the same target only send the latest value, except for haptic
+	 * pulses, and commands that would not change the driver state are dropped. Call this at the end of each app frame
+	 * for the lowest latency
+	 */
+	void flushCommands();
+
+	/**
+	 * @brief Starts a batch of commands that the Conduit driver applies together, so that for example several devices
+	 * move in the same driver frame. Commands issued until commitBatch() are held back instead of being sent. Batches
+	 * don't nest
+	 */
+	void beginBatch();
+
+	/**
+	 * @brief Ends the current batch and sends it. The driver stages every command of the batch and applies them all
+	 * at once, so no hook observes part of a batch
+	 */
+	void commitBatch();
+
+	/**************************************************
+	* @brief Command scheduling
+	**************************************************/
+
+	/**
+	 * @brief Schedules the commands issued by the calling thread from now on to take effect at a precise time. The
+	 * driver holds them back and applies them on the first pose or input update at or after that time, so sending
+	 * commands a few frames ahead hides IPC jitter entirely. Scheduled commands complete with
+	 * getCommandCompletion() once applied, and commands scheduled for the same time are applied together
+	 * @param applyTime The time to apply the commands at, times in the past apply as soon as the driver reads them
+	 */
+	void setCommandApplyTime(std::chrono::steady_clock::time_point applyTime);
+
+	/**
+	 * @brief Makes the commands issued by the calling thread from now on apply as soon as the driver reads them again
+	 */
+	void clearCommandApplyTime();
+
+	/**************************************************
+	* @brief Command completion
+	**************************************************/
+
+	/**
+	 * @brief Returns the sequence id of the last command issued by the calling thread. Every command sent through
+	 * this class gets a sequence id, which can be passed to getCommandCompletion() right after issuing it
+	 * @return The sequence id, or 0 if the thread has not issued a command
+	 */
+	uint64_t getLastCommandSequence();
+
+	/**
+	 * @brief Returns a future that completes once the Conduit driver has processed a command, with its status and the
+	 * measured latency from issuing it to the driver applying it. Commands replaced by a later command to the same
+	 * target before being sent complete together with the command that replaced them
+	 * @param sequence The sequence id of the command
+	 * @return The future, already completed with CommandStatus_Dropped if the sequence id is unknown or too old
+	 */
+	std::future<CommandResult> getCommandCompletion(uint64_t sequence);
+
+	/**
+	 * @brief Sets a callback invoked with the result of every completed command, useful for monitoring command
+	 * latency and failures. The callback runs on the lib's poll thread and should return quickly
+	 * @param callback The callback, or an empty function to remove it
+	 */
+	void setCommandCompletionCallback(std::function<void(const CommandResult&)> callback);
+
+	/**************************************************
+	* @brief Device registry queries
+	**************************************************/
+
+	/**
+	 * @brief Returns the properties of a device, as read once by the driver when it first saw the device. Registry
+	 * queries are answered from a local copy that is only refreshed when the driver changed the registry, so they
+	 * never call into OpenVR and are cheap enough for event callbacks
+	 * @param deviceIndex The device index of the device
+	 * @return The properties, or std::nullopt if the driver hasn't seen the device
+	 */
+	std::optional<DeviceInfo> getDeviceInfo(uint32_t deviceIndex);
+
+	/**
+	 * @brief Returns the class of a device, see getDeviceInfo()
+	 * @param deviceIndex The device index of the device
+	 * @return The class, or DeviceClass_Invalid if the driver hasn't seen the device
+	 */
+	DeviceClass getDeviceClass(uint32_t deviceIndex);
+
+	/**
+	 * @brief Returns the device indexes of every device of a class, such as all controllers
+	 * @param deviceClass The class
+	 * @return The device indexes in ascending order
+	 */
+	std::vector<uint32_t> getDevicesOfClass(DeviceClass deviceClass);
+
+	/**
+	 * @brief Returns the metadata of every component a device created
+	 * @param deviceIndex The device index of the device
+	 * @return The components in the order they were created
+	 */
+	std::vector<ComponentInfo> getDeviceComponents(uint32_t deviceIndex);
+
+	/**
+	 * @brief Returns the metadata a device created a component with
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the component
+	 * @return The metadata, or std::nullopt if the device has no such component
+	 */
+	std::optional<ComponentInfo> getComponentInfo(uint32_t deviceIndex, const std::string& path);
+
 	/**************************************************
 	* @brief Device pose commands
 	**************************************************/
@@ -55,6 +176,16 @@ public:
 	 */
 	void setOverriddenDevicePose(uint32_t deviceIndex, const DevicePose newPose);
 
+	/**
+	 * @brief Sets the overridden state of only some fields of a device pose for a device. The Conduit driver merges the
+	 * fields in <fieldMask> over every natural pose of the device, so for example pinning the position only has to be
+	 * sent once while the rotation keeps tracking
+	 * @param deviceIndex The device index of the device
+	 * @param newPose The new overridden pose, where only the fields in <fieldMask> are used
+	 * @param fieldMask The PoseOverrideField's to override
+	 */
+	void setPartialOverriddenDevicePose(uint32_t deviceIndex, const DevicePose newPose, uint32_t fieldMask);
+
 	/**
 	 * @brief Returns the natural (non-overridden) state of a device pose for a device
 	 * @param deviceIndex The device index of the device
@@ -183,6 +314,21 @@ public:
 	 */
 	void setOverriddenSkeletonInputState(uint32_t deviceIndex, const std::string& path, const SkeletonInput newInput);
 
+	/**
+	 * @brief Sets the overridden state of only some bones of a skeleton input for a device. The Conduit driver merges
+	 * the bones in <boneMask> over every natural skeleton of the input, keeping its natural motion range and bone count
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 * @param newInput The new overridden skeleton input state, where only the bones in <boneMask> are used
+	 * @param boneMask The bones to override, where bit i selects bone i of the OpenVR hand skeleton
+	 */
+	void setPartialOverriddenSkeletonInputState(
+		uint32_t deviceIndex,
+		const std::string& path,
+		const SkeletonInput newInput,
+		uint32_t boneMask
+	);
+
 	/**
 	 * @brief Returns the natural (non-overridden) state of a skeleton input for a device
 	 * @param deviceIndex The device index of the device
@@ -302,4 +448,265 @@ public:
 	 * @return True if the input is using its overridden state, false otherwise
 	 */
 	bool getUseOverriddenEyeTrackingInputState(uint32_t deviceIndex, const std::string& path);
+
+	/**************************************************
+	* @brief Transform rule commands
+	**************************************************/
+
+	/**
+	 * @brief Replaces the pose transform rules of a device. The rules are evaluated by the Conduit driver on every
+	 * natural pose update of the device while its pose is not overridden, with no round trip through the client
+	 * @param deviceIndex The device index of the device
+	 * @param rules The rules, applied in order. Rules beyond the first 8 are ignored
+	 */
+	void setPoseTransformRules(uint32_t deviceIndex, const std::vector<PoseTransformRule>& rules);
+
+	/**
+	 * @brief Removes all pose transform rules of a device
+	 * @param deviceIndex The device index of the device
+	 */
+	void clearPoseTransformRules(uint32_t deviceIndex);
+
+	/**
+	 * @brief Replaces the input transform rules of a boolean or scalar input. The rules are evaluated by the Conduit
+	 * driver on every natural update of the input while it is not overridden, with no round trip through the client
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 * @param rules The rules, applied in order. Rules beyond the first 4 are ignored
+	 */
+	void setInputTransformRules(
+		uint32_t deviceIndex,
+		const std::string& path,
+		const std::vector<InputTransformRule>& rules
+	);
+
+	/**
+	 * @brief Removes all input transform rules of a boolean or scalar input
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 */
+	void clearInputTransformRules(uint32_t deviceIndex, const std::string& path);
+
+	/**************************************************
+	* @brief Input filter program commands
+	**************************************************/
+
+	/**
+	 * @brief Loads a filter program for a boolean or scalar input, replacing any program it already has. The program
+	 * is verified and then run by the Conduit driver on every natural update of the input while it is not overridden,
+	 * with no round trip through the client. The driver rejects programs that fail verification
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 * @param program The program bytecode, at most 64 instructions
+	 * @param bindings Up to 4 (device index, input path) pairs whose natural values the program can read through
+	 * Filter_LoadBinding, in slot order. The program also reruns whenever one of these inputs updates
+	 * @return True if the program was sent, false if it exceeds the instruction or binding limits
+	 */
+	bool loadInputFilterProgram(
+		uint32_t deviceIndex,
+		const std::string& path,
+		const std::vector<FilterInstruction>& program,
+		const std::vector<std::pair<uint32_t, std::string>>& bindings = {}
+	);
+
+	/**
+	 * @brief Unloads the filter program of a boolean or scalar input
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 */
+	void unloadInputFilterProgram(uint32_t deviceIndex, const std::string& path);
+
+	/**************************************************
+	* @brief Smoothing filter commands
+	**************************************************/
+
+	/**
+	 * @brief Sets the smoothing filter applied by the Conduit driver to the natural pose of a device while it is not
+	 * overridden. Smoothing runs before any pose transform rules
+	 * @param deviceIndex The device index of the device
+	 * @param config The filter configuration
+	 */
+	void setPoseSmoothingFilter(uint32_t deviceIndex, const SmoothingFilterConfig& config);
+
+	/**
+	 * @brief Removes the smoothing filter of a device pose
+	 * @param deviceIndex The device index of the device
+	 */
+	void clearPoseSmoothingFilter(uint32_t deviceIndex);
+
+	/**
+	 * @brief Sets the smoothing filter applied by the Conduit driver to the natural value of a scalar input while it is
+	 * not overridden. Smoothing runs before any input transform rules and filter program
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 * @param config The filter configuration
+	 */
+	void setScalarSmoothingFilter(uint32_t deviceIndex, const std::string& path, const SmoothingFilterConfig& config);
+
+	/**
+	 * @brief Removes the smoothing filter of a scalar input
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 */
+	void clearScalarSmoothingFilter(uint32_t deviceIndex, const std::string& path);
+
+	/**
+	 * @brief Sets the dead reckoning applied by the Conduit driver to the overridden pose of a device. While enabled,
+	 * the driver extrapolates each override along its velocity and angular velocity on every pose update and blends
+	 * out the gap to the next override, so overrides can be sent far less often than the device updates
+	 * @param deviceIndex The device index of the device
+	 * @param config The extrapolation configuration
+	 */
+	void setPoseExtrapolation(uint32_t deviceIndex, const PoseExtrapolationConfig& config);
+
+	/**
+	 * @brief Stops dead reckoning the overridden pose of a device, holding each override until the next one
+	 * @param deviceIndex The device index of the device
+	 */
+	void clearPoseExtrapolation(uint32_t deviceIndex);
+
+	/**************************************************
+	* @brief Keyframe animation commands
+	**************************************************/
+
+	/**
+	 * @brief Uploads a pose keyframe track to the Conduit driver, replacing the track with the same id. Tracks are
+	 * uploaded once and then played back by the driver on every update, so the client can go idle during playback
+	 * @param trackId The id of the track, below MAX_ANIMATION_TRACKS
+	 * @param keyframes The keyframes, sorted by time
+	 * @return True if the track was uploaded, false if it is too large or its previous upload is still being loaded
+	 */
+	bool uploadPoseAnimation(uint32_t trackId, const std::vector<PoseKeyframe>& keyframes);
+
+	/**
+	 * @brief Uploads a scalar keyframe track to the Conduit driver, replacing the track with the same id
+	 * @param trackId The id of the track, below MAX_ANIMATION_TRACKS
+	 * @param keyframes The keyframes, sorted by time
+	 * @return True if the track was uploaded, false if it is too large or its previous upload is still being loaded
+	 */
+	bool uploadScalarAnimation(uint32_t trackId, const std::vector<ScalarKeyframe>& keyframes);
+
+	/**
+	 * @brief Uploads a skeleton keyframe track to the Conduit driver, replacing the track with the same id
+	 * @param trackId The id of the track, below MAX_ANIMATION_TRACKS
+	 * @param keyframes The keyframes, sorted by time
+	 * @return True if the track was uploaded, false if it is too large or its previous upload is still being loaded
+	 */
+	bool uploadSkeletonAnimation(uint32_t trackId, const std::vector<SkeletonKeyframe>& keyframes);
+
+	/**
+	 * @brief Plays a pose track on a device while its pose is not overridden, replacing any playback it already has.
+	 * Playback runs after smoothing and pose transform rules, blending over their output
+	 * @param deviceIndex The device index of the device
+	 * @param trackId The id of an uploaded pose track
+	 * @param config The playback configuration
+	 */
+	void playPoseAnimation(uint32_t deviceIndex, uint32_t trackId, const AnimationPlaybackConfig& config);
+
+	/**
+	 * @brief Stops the pose track playing on a device
+	 * @param deviceIndex The device index of the device
+	 * @param blendOutSeconds The time in seconds to fade back to the natural pose, or 0 to stop immediately
+	 */
+	void stopPoseAnimation(uint32_t deviceIndex, double blendOutSeconds);
+
+	/**
+	 * @brief Plays a scalar or skeleton track on an input while it is not overridden, replacing any playback it
+	 * already has. The track type must match the input type
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 * @param trackId The id of an uploaded scalar or skeleton track
+	 * @param config The playback configuration
+	 */
+	void playInputAnimation(
+		uint32_t deviceIndex,
+		const std::string& path,
+		uint32_t trackId,
+		const AnimationPlaybackConfig& config
+	);
+
+	/**
+	 * @brief Stops the track playing on an input
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the input
+	 * @param blendOutSeconds The time in seconds to fade back to the natural value, or 0 to stop immediately
+	 */
+	void stopInputAnimation(uint32_t deviceIndex, const std::string& path, double blendOutSeconds);
+
+	/**************************************************
+	* @brief Haptic commands
+	**************************************************/
+
+	/**
+	 * @brief Sends a vibration to a haptic component, as if an application had triggered it. The Conduit driver hands
+	 * it to the vendor driver the next time it polls for events, and it is reported to DeviceHapticEvent() as injected.
+	 * Every pulse is sent, even several to the same component within one poll of the lib
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the haptic component
+	 * @param durationSeconds The duration of the vibration
+	 * @param frequency The frequency of the vibration
+	 * @param amplitude The amplitude of the vibration
+	 */
+	void injectHapticPulse(
+		uint32_t deviceIndex,
+		const std::string& path,
+		float durationSeconds,
+		float frequency,
+		float amplitude
+	);
+
+	/**
+	 * @brief Sets whether vibrations sent by applications to a haptic component are kept from the device. Suppressed
+	 * vibrations are still reported to DeviceHapticEvent(), and injected pulses are never suppressed
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the haptic component
+	 * @param suppressed Whether to suppress vibrations
+	 */
+	void setHapticSuppression(uint32_t deviceIndex, const std::string& path, bool suppressed);
+
+	/**************************************************
+	* @brief Pose history
+	**************************************************/
+
+	/**
+	 * @brief Starts recording the natural poses of a device in a history owned by the lib, so past poses can be
+	 * queried with getPoseAt() and resamplePoseHistory(). Poses are kept at the time the vendor driver reported them
+	 * for, and the history is bounded to durationSeconds * maxUpdateRate poses, at most 16384. Enabling it again
+	 * resizes it and drops the poses recorded so far
+	 * @param deviceIndex The device index of the device
+	 * @param config The configuration of the history
+	 * @return True if the history was enabled, false if the device index or config is invalid
+	 */
+	bool enablePoseHistory(uint32_t deviceIndex, const PoseHistoryConfig& config);
+
+	/**
+	 * @brief Stops recording the pose history of a device and frees it
+	 * @param deviceIndex The device index of the device
+	 */
+	void disablePoseHistory(uint32_t deviceIndex);
+
+	/**
+	 * @brief Returns where a device was at a time, interpolating linearly between the recorded positions and
+	 * spherically between the recorded rotations around it. A lookup only binary searches the history, so it is cheap
+	 * enough to call for every device every frame. Times after the newest pose hold the newest pose
+	 * @param deviceIndex The device index of the device
+	 * @param time The time
+	 * @return The pose, or std::nullopt if the history is disabled or the time is before the oldest recorded pose
+	 */
+	std::optional<PoseHistorySample> getPoseAt(uint32_t deviceIndex, std::chrono::steady_clock::time_point time);
+
+	/**
+	 * @brief Resamples the pose history of a device at a fixed rate, appending a sample for every period from the next
+	 * sample time of <state> up to the newest recorded pose. Calling this repeatedly with the same state streams
+	 * evenly spaced samples, where periods that already fell out of the history are skipped
+	 * @param deviceIndex The device index of the device
+	 * @param state The resampler state, advanced past the appended samples
+	 * @param outSamples Where to append the samples
+	 * @return The number of samples appended
+	 */
+	uint32_t resamplePoseHistory(
+		uint32_t deviceIndex,
+		PoseResamplerState& state,
+		std::vector<PoseHistorySample>& outSamples
+	);
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
  #pragma once
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 /**
  * @brief Many of these struct declarations are taken directly from the OpenVR SDK. For proper documentation on each
@@ -84,6 +86,33 @@ struct DevicePose {
 	bool deviceIsConnected = false;
 };
 
+/**
+ * @brief The groups of DevicePose fields that a partial pose override replaces, combined into a field mask. Fields
+ * outside the mask keep following the natural pose of the device
+ */
+enum PoseOverrideField {
+	/** @brief vecPosition */
+	PoseField_Position = 1 << 0,
+
+	/** @brief qRotation */
+	PoseField_Rotation = 1 << 1,
+
+	/** @brief vecVelocity and vecAcceleration */
+	PoseField_Velocity = 1 << 2,
+
+	/** @brief vecAngularVelocity and vecAngularAcceleration */
+	PoseField_AngularVelocity = 1 << 3,
+
+	/** @brief result, poseIsValid, willDriftInYaw, shouldApplyHeadModel and deviceIsConnected */
+	PoseField_Flags = 1 << 4,
+
+	/** @brief poseTimeOffset and the world from driver and driver from head transforms */
+	PoseField_Transforms = 1 << 5,
+
+	/** @brief Every field, which overrides the whole pose */
+	PoseField_All = (1 << 6) - 1
+};
+
 /**
  * Based on enum EVRSkeletalMotionRange from the OpenVR SDK, documentation available there
  */ 
@@ -152,4 +181,552 @@ struct PoseInput {
 struct EyeTrackingInput {
 	EyeTrackingData eyeTrackingData;
 	double timeOffset;
+};
+
+/**
+ * @brief Bit flags selecting axes for transform rules that operate on individual axes
+ */
+enum TransformAxis {
+	TransformAxis_X = 1 << 0,
+	TransformAxis_Y = 1 << 1,
+	TransformAxis_Z = 1 << 2,
+};
+
+/**
+ * @brief The operation performed by a PoseTransformRule
+ */
+enum PoseTransformRuleType {
+	/** @brief Translates the pose by <vector>, in driver space or the device's local space */
+	PoseTransformRule_Offset,
+
+	/** @brief Rotates the pose by <rotation>, in driver space or the device's local space */
+	PoseTransformRule_Rotate,
+
+	/** @brief Fixes the position of each axis in <axisMask> to the matching component of <vector> */
+	PoseTransformRule_AxisLock,
+
+	/** @brief Multiplies the position and velocity of each axis by the matching component of <vector> */
+	PoseTransformRule_Scale,
+
+	/** @brief Mirrors the pose across the plane perpendicular to each axis in <axisMask> */
+	PoseTransformRule_Mirror,
+
+	/** @brief Replaces the pose with the latest natural pose of <sourceDeviceIndex> */
+	PoseTransformRule_RemapFromDevice
+};
+
+/**
+ * @brief A declarative transform evaluated by the Conduit driver on every natural pose update of a device, avoiding a
+ * round trip through the client. Rules of a device are applied in order, and members not used by <type> are ignored
+ */
+struct PoseTransformRule {
+	PoseTransformRuleType type = PoseTransformRule_Offset;
+
+	/** @brief The translation (Offset), locked position (AxisLock), or per-axis factor (Scale) */
+	double vector[3] = { 0.0, 0.0, 0.0 };
+
+	/** @brief The rotation to apply (Rotate) */
+	DeviceQuaternion rotation;
+
+	/** @brief A combination of TransformAxis flags (AxisLock, Mirror) */
+	uint32_t axisMask = 0;
+
+	/** @brief True to apply in the device's local space, false to apply in driver space (Offset, Rotate) */
+	bool localSpace = false;
+
+	/** @brief The device index whose natural pose is used (RemapFromDevice) */
+	uint32_t sourceDeviceIndex = 0;
+};
+
+/**
+ * @brief The operation performed by an InputTransformRule
+ */
+enum InputTransformRuleType {
+	/** @brief Multiplies a scalar input by <a> */
+	InputTransformRule_Scale,
+
+	/** @brief Adds <a> to a scalar input */
+	InputTransformRule_Offset,
+
+	/** @brief Clamps a scalar input to the range [<a>, <b>] */
+	InputTransformRule_Clamp,
+
+	/** @brief Replaces a scalar input with <a> minus its value, or negates a boolean input */
+	InputTransformRule_Invert
+};
+
+/**
+ * @brief A declarative transform evaluated by the Conduit driver on every natural update of a boolean or scalar
+ * input. Rules of an input are applied in order, and boolean inputs only honor InputTransformRule_Invert
+ */
+struct InputTransformRule {
+	InputTransformRuleType type = InputTransformRule_Scale;
+
+	/** @brief The first operand of the rule, as described by InputTransformRuleType */
+	double a = 0.0;
+
+	/** @brief The second operand of the rule, as described by InputTransformRuleType */
+	double b = 0.0;
+};
+
+/**
+ * @brief The operations of the input filter bytecode. Programs run on a stack of doubles, where booleans are read as
+ * 0 or 1 and any non-zero value is treated as true. Stack effects are listed as (popped -> pushed)
+ */
+enum FilterOpcode {
+	/** @brief Pushes <immediate> (0 -> 1) */
+	Filter_Push,
+
+	/**
+	 * @brief Pushes the current value of the input the program is bound to, after its smoothing, transform rules and
+	 * animation (0 -> 1)
+	 */
+	Filter_LoadInput,
+
+	/**
+	 * @brief Pushes the latest value of the binding in slot <operand> as its own input sends it on, after its override,
+	 * smoothing, transform rules, animation and filter program, but before plugins (0 -> 1)
+	 */
+	Filter_LoadBinding,
+
+	/** @brief Pushes the value of register <operand>, which persists between runs (0 -> 1) */
+	Filter_LoadRegister,
+
+	/** @brief Pops a value into register <operand> (1 -> 0) */
+	Filter_StoreRegister,
+
+	/** @brief Pushes the number of seconds since the program last ran, or 0 on the first run (0 -> 1) */
+	Filter_LoadDeltaTime,
+
+	/** @brief Duplicates the top of the stack (1 -> 2) */
+	Filter_Dup,
+
+	/** @brief Binary arithmetic on the two top values a and b, where b is on top (2 -> 1). Division by 0 yields 0 */
+	Filter_Add,
+	Filter_Sub,
+	Filter_Mul,
+	Filter_Div,
+	Filter_Min,
+	Filter_Max,
+
+	/** @brief Unary operations on the top value (1 -> 1) */
+	Filter_Abs,
+	Filter_Neg,
+	Filter_Not,
+
+	/** @brief Comparisons and logic on the two top values a and b, where b is on top, pushing 0 or 1 (2 -> 1) */
+	Filter_Greater,
+	Filter_Less,
+	Filter_Equal,
+	Filter_And,
+	Filter_Or,
+
+	/** @brief Pops a, b and condition c (c on top), pushing c ? a : b (3 -> 1) */
+	Filter_Select,
+
+	/**
+	 * @brief Pops a condition, accumulating the time it has been continuously true in register <operand> and pushing
+	 * that time in seconds (1 -> 1)
+	 */
+	Filter_HoldTime,
+
+	/** @brief Continues execution at instruction <operand>, which must be after this instruction (0 -> 0) */
+	Filter_Jump,
+
+	/** @brief Pops a value, continuing at instruction <operand> if it is 0, which must be after this instruction (1 -> 0) */
+	Filter_JumpIfZero,
+
+	/** @brief Ends the program, using the top of the stack as the output value (1 -> 1) */
+	Filter_Return
+};
+
+/**
+ * @brief A single input filter bytecode instruction. Programs without a trailing Filter_Return end after their last
+ * instruction, and their output value is the top of the stack
+ */
+struct FilterInstruction {
+	FilterOpcode opcode = Filter_Push;
+
+	/** @brief The register, binding slot, or jump target of the instruction, as described by FilterOpcode */
+	uint32_t operand = 0;
+
+	/** @brief The constant pushed by Filter_Push */
+	double immediate = 0.0;
+};
+
+/**
+ * @brief The smoothing filters the Conduit driver can apply to natural device poses and scalar inputs
+ */
+enum SmoothingFilterType {
+	/** @brief No smoothing, used to disable a filter */
+	SmoothingFilter_None,
+
+	/** @brief One Euro filter, which adapts its cutoff to the speed of the signal to trade jitter for lag */
+	SmoothingFilter_OneEuro,
+
+	/** @brief Critically damped spring that follows the signal without overshoot, rotations are slerped */
+	SmoothingFilter_CriticallyDampedSpring,
+
+	/** @brief Frame rate independent exponential smoothing, slerping rotations */
+	SmoothingFilter_Slerp
+};
+
+/**
+ * @brief The configuration of a smoothing filter. Members not used by <type> are ignored
+ */
+struct SmoothingFilterConfig {
+	SmoothingFilterType type = SmoothingFilter_None;
+
+	/** @brief The cutoff frequency in Hz at rest (OneEuro) */
+	double minCutoff = 1.0;
+
+	/** @brief How strongly the cutoff frequency rises with speed (OneEuro) */
+	double beta = 0.0;
+
+	/** @brief The cutoff frequency in Hz used to estimate speed (OneEuro) */
+	double derivativeCutoff = 1.0;
+
+	/** @brief The time in seconds for the remaining distance to the signal to halve (CriticallyDampedSpring, Slerp) */
+	double halfLife = 0.05;
+};
+
+/**
+ * @brief The configuration of dead reckoning on an overridden device pose. While enabled, the Conduit driver treats
+ * the velocities of the overridden pose as authoritative and extrapolates it to the time of every pose update, so
+ * clients can send overrides far less often than the device updates
+ */
+struct PoseExtrapolationConfig {
+	/** @brief Whether the overridden pose is extrapolated, where false holds it until the next override */
+	bool enabled = false;
+
+	/** @brief Whether vecAcceleration is integrated along with vecVelocity */
+	bool useAcceleration = false;
+
+	/** @brief The longest time in seconds an override is extrapolated for, after which it is held in place */
+	double maxHorizonSeconds = 0.1;
+
+	/**
+	 * @brief The time in seconds over which the gap between the extrapolated pose and a new override is blended out,
+	 * or 0 to snap to each new override
+	 */
+	double correctionSeconds = 0.05;
+};
+
+/**
+ * @brief How the shared memory was mapped into the client process at startup
+ */
+struct SharedMemoryMappingStats {
+	/** @brief Whether the driver backed the shared memory with large pages */
+	bool largePages = false;
+
+	/** @brief Whether every page was prefaulted at startup, so no lane or table access takes a page fault later */
+	bool prefaulted = false;
+
+	/** @brief Whether the pages are locked in memory, so they can't be trimmed and faulted back in mid-session */
+	bool locked = false;
+
+	/** @brief Whether the lanes are mapped twice back to back, so packets never wrap or skip padding */
+	bool mirroredLanes = false;
+
+	/** @brief The size in bytes of the mapping */
+	uint64_t mappingSize = 0;
+
+	/** @brief The number of page faults taken while prefaulting, which would otherwise have hit later accesses */
+	uint64_t prefaultPageFaults = 0;
+};
+
+/**
+ * @brief The kinds of keyframe tracks the Conduit driver can play back
+ */
+enum AnimationTrackType {
+	/** @brief A track of PoseKeyframe, played on device poses */
+	AnimationTrack_Pose,
+
+	/** @brief A track of ScalarKeyframe, played on scalar inputs */
+	AnimationTrack_Scalar,
+
+	/** @brief A track of SkeletonKeyframe, played on skeleton inputs */
+	AnimationTrack_Skeleton
+};
+
+/**
+ * @brief How the Conduit driver interpolates between the keyframes of a track
+ */
+enum AnimationInterpolation {
+	/** @brief Holds each keyframe until the next one */
+	AnimationInterpolation_Step,
+
+	/** @brief Linearly interpolates positions and values, slerping rotations */
+	AnimationInterpolation_Linear,
+
+	/** @brief Catmull-Rom interpolates positions and values through the neighbouring keyframes, slerping rotations */
+	AnimationInterpolation_Cubic
+};
+
+/**
+ * @brief What happens when playback reaches the end of a track
+ */
+enum AnimationPlaybackMode {
+	/** @brief Plays the track once, then hands control back to the natural state */
+	AnimationPlayback_OneShot,
+
+	/** @brief Restarts the track from its first keyframe until stopped */
+	AnimationPlayback_Loop
+};
+
+/**
+ * @brief The configuration of a track playback
+ */
+struct AnimationPlaybackConfig {
+	AnimationPlaybackMode mode = AnimationPlayback_OneShot;
+
+	AnimationInterpolation interpolation = AnimationInterpolation_Linear;
+
+	/** @brief The playback rate, where 1 plays the keyframes at their own timestamps */
+	double speed = 1.0;
+
+	/** @brief The time in seconds to fade from the natural state into the track when playback starts */
+	double blendInSeconds = 0.0;
+
+	/** @brief The time in seconds to fade back to the natural state when a one shot ends or playback is stopped */
+	double blendOutSeconds = 0.0;
+};
+
+/**
+ * @brief A single keyframe of a pose track. Blends only mix the position, rotation and velocities with the natural
+ * pose, the remaining fields are taken from the keyframe
+ */
+struct PoseKeyframe {
+	/** @brief The time of the keyframe in seconds from the start of the track */
+	double time = 0.0;
+
+	DevicePose pose;
+};
+
+/**
+ * @brief A single keyframe of a scalar track
+ */
+struct ScalarKeyframe {
+	/** @brief The time of the keyframe in seconds from the start of the track */
+	double time = 0.0;
+
+	float value = 0.0f;
+};
+
+/**
+ * @brief A single keyframe of a skeleton track
+ */
+struct SkeletonKeyframe {
+	/** @brief The time of the keyframe in seconds from the start of the track */
+	double time = 0.0;
+
+	SkeletonInput skeleton;
+};
+
+/**
+ * @brief The outcome of a client command, as reported by the Conduit driver
+ */
+enum CommandStatus {
+	/** @brief The command was applied */
+	CommandStatus_Applied,
+
+	/** @brief The target device has not been seen by the driver */
+	CommandStatus_UnknownDevice,
+
+	/** @brief The device exists but has no input with the given path, or the input has the wrong type */
+	CommandStatus_UnknownPath,
+
+	/** @brief The path was not in the path table, usually because no device has reported it yet */
+	CommandStatus_PathTableMiss,
+
+	/** @brief The driver rejected the command parameters, such as a filter program that failed verification */
+	CommandStatus_Rejected,
+
+	/** @brief The command never reached the driver intact, or its status was overwritten before it was read */
+	CommandStatus_Dropped,
+
+	/** @brief The command matched the state the driver last applied for its target, so the lib never sent it */
+	CommandStatus_Redundant,
+
+	/**
+	 * @brief The driver is holding the command until its apply time. This is only an interim status, completions
+	 * always report the status the command had once applied
+	 */
+	CommandStatus_Scheduled
+};
+
+/**
+ * @brief The completion of a client command
+ */
+struct CommandResult {
+	/** @brief The sequence id of the command */
+	uint64_t sequence = 0;
+
+	/** @brief The outcome of the command */
+	CommandStatus status = CommandStatus_Dropped;
+
+	/** @brief The time in microseconds from issuing the command to the driver applying it, or 0 if it wasn't applied */
+	double latencyMicroseconds = 0.0;
+};
+
+/**
+ * Based on enum ETrackedDeviceClass from the OpenVR SDK, documentation available there
+ */
+enum DeviceClass {
+	DeviceClass_Invalid = 0,
+	DeviceClass_HMD = 1,
+	DeviceClass_Controller = 2,
+	DeviceClass_GenericTracker = 3,
+	DeviceClass_TrackingReference = 4,
+	DeviceClass_DisplayRedirect = 5
+};
+
+/**
+ * Based on enum ETrackedControllerRole from the OpenVR SDK, documentation available there
+ */
+enum DeviceRole {
+	DeviceRole_Invalid = 0,
+	DeviceRole_LeftHand = 1,
+	DeviceRole_RightHand = 2,
+	DeviceRole_OptOut = 3,
+	DeviceRole_Treadmill = 4,
+	DeviceRole_Stylus = 5
+};
+
+/**
+ * @brief The kinds of components a device can create
+ */
+enum DeviceComponentType {
+	DeviceComponent_Boolean,
+	DeviceComponent_Scalar,
+	DeviceComponent_Skeleton,
+	DeviceComponent_Pose,
+	DeviceComponent_EyeTracking,
+	DeviceComponent_Haptic
+};
+
+/**
+ * Based on enum EVRScalarType from the OpenVR SDK, documentation available there
+ */
+enum ScalarType {
+	ScalarType_Absolute = 0,
+	ScalarType_Relative = 1
+};
+
+/**
+ * Based on enum EVRScalarUnits from the OpenVR SDK, documentation available there
+ */
+enum ScalarUnits {
+	ScalarUnits_NormalizedOneSided = 0,
+	ScalarUnits_NormalizedTwoSided = 1
+};
+
+/**
+ * Based on enum EVRSkeletalTrackingLevel from the OpenVR SDK, documentation available there
+ */
+enum SkeletalTrackingLevel {
+	SkeletalTrackingLevel_Estimated = 0,
+	SkeletalTrackingLevel_Partial = 1,
+	SkeletalTrackingLevel_Full = 2
+};
+
+/**
+ * @brief The properties of a device, read once by the driver when it first sees the device
+ */
+struct DeviceInfo {
+	uint32_t deviceIndex = 0;
+
+	DeviceClass deviceClass = DeviceClass_Invalid;
+
+	/** @brief The controller role hint of the device, DeviceRole_Invalid for devices without one */
+	DeviceRole role = DeviceRole_Invalid;
+
+	std::string serialNumber;
+	std::string modelNumber;
+};
+
+/**
+ * @brief The metadata a device created a component with
+ */
+struct ComponentInfo {
+	uint32_t deviceIndex = 0;
+	DeviceComponentType type = DeviceComponent_Boolean;
+
+	/** @brief The input path of the component (ex. '/input/trigger/value') */
+	std::string path;
+
+	/** @brief The OpenVR component handle, which is only meaningful inside the driver process */
+	uint64_t componentHandle = 0;
+
+	/** @brief The scalar type, only used by DeviceComponent_Scalar */
+	ScalarType scalarType = ScalarType_Absolute;
+
+	/** @brief The scalar units, only used by DeviceComponent_Scalar */
+	ScalarUnits scalarUnits = ScalarUnits_NormalizedOneSided;
+
+	/** @brief The skeleton path, only used by DeviceComponent_Skeleton */
+	std::string skeletonPath;
+
+	/** @brief The base pose path, only used by DeviceComponent_Skeleton */
+	std::string basePosePath;
+
+	/** @brief The tracking level, only used by DeviceComponent_Skeleton */
+	SkeletalTrackingLevel skeletalTrackingLevel = SkeletalTrackingLevel_Estimated;
+
+	/** @brief The grip limit transforms, only used by DeviceComponent_Skeleton and empty if the device sent none */
+	std::vector<BoneTransform> gripLimitTransforms;
+};
+
+/**
+ * Based on struct VREvent_HapticVibration_t from the OpenVR SDK, documentation available there
+ */
+struct HapticEvent {
+	/** @brief The steady clock time in nanoseconds when the driver intercepted the vibration */
+	int64_t timestampNanoseconds = 0;
+
+	float durationSeconds = 0.0f;
+	float frequency = 0.0f;
+	float amplitude = 0.0f;
+
+	/** @brief Whether the vibration was suppressed, so the device never received it */
+	bool suppressed = false;
+
+	/** @brief Whether the vibration was injected by a client instead of sent by an application */
+	bool injected = false;
+};
+
+/**
+ * @brief The configuration of the pose history of a device, which the lib records from the natural poses published by
+ * the driver so past poses can be queried without every client keeping its own history
+ */
+struct PoseHistoryConfig {
+	/** @brief How far back in seconds poses are kept */
+	double durationSeconds = 2.0;
+
+	/** @brief The highest rate in Hz the device is expected to update at, which sizes the history with the duration */
+	double maxUpdateRate = 1000.0;
+};
+
+/**
+ * @brief A pose recorded in the pose history of a device, or interpolated between two recorded poses
+ */
+struct PoseHistorySample {
+	/** @brief The steady clock time in nanoseconds the pose is at, shared by all processes */
+	int64_t timestampNanoseconds = 0;
+
+	double vecPosition[3] = { 0.0, 0.0, 0.0 };
+
+	DeviceQuaternion qRotation;
+};
+
+/**
+ * @brief The state of a fixed rate resampling of a pose history, kept by the caller between calls to
+ * resamplePoseHistory()
+ */
+struct PoseResamplerState {
+	/** @brief The rate in Hz samples are emitted at */
+	double sampleRate = 90.0;
+
+	/** @brief The steady clock time in nanoseconds of the next sample, or 0 to start at the newest recorded pose */
+	int64_t nextTimestampNanoseconds = 0;
 };
\ No newline at end of file
@@ -132,4 +132,20 @@ public:
 	 * @param newInput The updated state of the eye tracking input
 	 */
 	virtual void DeviceInputEyeTrackingChanged(uint32_t deviceIndex, std::string path, EyeTrackingInput oldInput, EyeTrackingInput newInput) = 0;
+
+	/**
+	 * @brief Notification that a haptic component received a vibration, either from an application or injected by a
+	 * client. Called from the lib's poll thread ahead of state updates, and does nothing unless overridden
+	 * @param deviceIndex The index of the device with the haptic component
+	 * @param path The path of the haptic component
+	 * @param event The vibration
+	 */
+	virtual void DeviceHapticEvent(uint32_t deviceIndex, std::string path, HapticEvent event) {}
+
+	/**
+	 * @brief Notification that a device was deactivated, sent after the removal of each of its inputs. Called from the
+	 * lib's poll thread, and does nothing unless overridden
+	 * @param deviceIndex The index of the removed device, which OpenVR may later reuse for another device
+	 */
+	virtual void DeviceRemoved(uint32_t deviceIndex) {}
 };
\ No newline at end of file
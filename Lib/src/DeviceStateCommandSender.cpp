@@ -2,6 +2,9 @@
 
 #include "SharedDeviceMemoryClient.h"
 #include "DeviceStateModelClient.h"
+#include "PoseHistoryManager.h"
+
+#include <algorithm>
 
 void DeviceStateCommandSender::addEventListener(IDeviceStateEventReceiver& listener) {
 	DeviceStateModelClient::getInstance().addEventListener(listener);
@@ -15,15 +18,92 @@ int DeviceStateCommandSender::initialize() {
 	return SharedDeviceMemoryClient::getInstance().initialize();
 }
 
+SharedMemoryMappingStats DeviceStateCommandSender::getSharedMemoryMappingStats() {
+	return SharedDeviceMemoryClient::getInstance().getMappingStats();
+}
+
 void DeviceStateCommandSender::notifyClientDisconnect() {
 	// Unused, may be implemented in future update
 }
 
+void DeviceStateCommandSender::flushCommands() {
+	SharedDeviceMemoryClient::getInstance().flushCommands();
+}
+
+void DeviceStateCommandSender::beginBatch() {
+	SharedDeviceMemoryClient::getInstance().beginBatch();
+}
+
+void DeviceStateCommandSender::commitBatch() {
+	SharedDeviceMemoryClient::getInstance().commitBatch();
+}
+
+void DeviceStateCommandSender::setCommandApplyTime(std::chrono::steady_clock::time_point applyTime) {
+	int64_t applyTimeNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		applyTime.time_since_epoch()
+	).count();
+
+	// 0 means immediate on the wire, which no real steady clock reading is
+	SharedDeviceMemoryClient::getInstance().setCommandApplyTime((std::max)(applyTimeNanoseconds, (int64_t)1));
+}
+
+void DeviceStateCommandSender::clearCommandApplyTime() {
+	SharedDeviceMemoryClient::getInstance().setCommandApplyTime(0);
+}
+
+uint64_t DeviceStateCommandSender::getLastCommandSequence() {
+	return SharedDeviceMemoryClient::getInstance().getLastIssuedCommandSequence();
+}
+
+std::future<CommandResult> DeviceStateCommandSender::getCommandCompletion(uint64_t sequence) {
+	return SharedDeviceMemoryClient::getInstance().getCommandCompletion(sequence);
+}
+
+void DeviceStateCommandSender::setCommandCompletionCallback(std::function<void(const CommandResult&)> callback) {
+	SharedDeviceMemoryClient::getInstance().setCommandCompletionCallback(std::move(callback));
+}
+
+std::optional<DeviceInfo> DeviceStateCommandSender::getDeviceInfo(uint32_t deviceIndex) {
+	return SharedDeviceMemoryClient::getInstance().getDeviceInfo(deviceIndex);
+}
+
+DeviceClass DeviceStateCommandSender::getDeviceClass(uint32_t deviceIndex) {
+	return SharedDeviceMemoryClient::getInstance().getDeviceClass(deviceIndex);
+}
+
+std::vector<uint32_t> DeviceStateCommandSender::getDevicesOfClass(DeviceClass deviceClass) {
+	uint64_t mask = SharedDeviceMemoryClient::getInstance().getDeviceClassMask(deviceClass);
+
+	std::vector<uint32_t> deviceIndexes;
+	for (uint32_t deviceIndex = 0; mask != 0; deviceIndex++, mask >>= 1) {
+		if (mask & 1) deviceIndexes.push_back(deviceIndex);
+	}
+
+	return deviceIndexes;
+}
+
+std::vector<ComponentInfo> DeviceStateCommandSender::getDeviceComponents(uint32_t deviceIndex) {
+	return SharedDeviceMemoryClient::getInstance().getDeviceComponents(deviceIndex);
+}
+
+std::optional<ComponentInfo> DeviceStateCommandSender::getComponentInfo(uint32_t deviceIndex, const std::string& path) {
+	return SharedDeviceMemoryClient::getInstance().getComponentInfo(deviceIndex, path);
+}
+
 void DeviceStateCommandSender::setOverriddenDevicePose(uint32_t deviceIndex, const DevicePose newPose) {
+	this->setPartialOverriddenDevicePose(deviceIndex, newPose, PoseField_All);
+}
+
+void DeviceStateCommandSender::setPartialOverriddenDevicePose(
+	uint32_t deviceIndex,
+	const DevicePose newPose,
+	uint32_t fieldMask
+) {
 	ModelDevicePoseSerialized* pose = DeviceStateModelClient::getInstance().getDevicePose(deviceIndex);
 	if (pose != nullptr) pose->data.overwrittenPose = newPose;
 	CommandParams_SetOverriddenStateDevicePose params{};
 	params.overriddenPose = newPose;
+	params.fieldMask = fieldMask & PoseField_All;
 	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
 		Command_SetOverriddenStateDevicePose, deviceIndex, &params, sizeof(CommandParams_SetOverriddenStateDevicePose)
 	);
@@ -198,6 +278,15 @@ void DeviceStateCommandSender::setOverriddenSkeletonInputState(
 	uint32_t deviceIndex,
 	const std::string& path,
 	const SkeletonInput newInput
+) {
+	this->setPartialOverriddenSkeletonInputState(deviceIndex, path, newInput, ALL_SKELETON_BONES);
+}
+
+void DeviceStateCommandSender::setPartialOverriddenSkeletonInputState(
+	uint32_t deviceIndex,
+	const std::string& path,
+	const SkeletonInput newInput,
+	uint32_t boneMask
 ) {
 	ModelDeviceInputSkeletonSerialized* input = DeviceStateModelClient::getInstance().getSkeletonInput(
 		deviceIndex,
@@ -208,6 +297,7 @@ void DeviceStateCommandSender::setOverriddenSkeletonInputState(
 	CommandParams_SetOverriddenStateDeviceInputSkeleton params = {};
 	params.inputPathOffset = SharedDeviceMemoryClient::getInstance().getOffsetOfPath(path);
 	params.overriddenValue = newInput;
+	params.boneMask = boneMask & ALL_SKELETON_BONES;
 	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
 		Command_SetOverriddenStateDeviceInputSkeleton,
 		deviceIndex,
@@ -402,4 +492,294 @@ bool DeviceStateCommandSender::getUseOverriddenEyeTrackingInputState(uint32_t de
 	);
 	if (input != nullptr) return input->useOverriddenState;
 	return false;
+}
+
+void DeviceStateCommandSender::setPoseTransformRules(uint32_t deviceIndex, const std::vector<PoseTransformRule>& rules) {
+	CommandParams_SetPoseTransformRules params = {};
+	params.ruleCount = static_cast<uint32_t>((std::min)(rules.size(), static_cast<size_t>(MAX_POSE_TRANSFORM_RULES)));
+	for (uint32_t i = 0; i < params.ruleCount; i++) params.rules[i] = rules[i];
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_SetPoseTransformRules,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_SetPoseTransformRules)
+	);
+}
+
+void DeviceStateCommandSender::clearPoseTransformRules(uint32_t deviceIndex) {
+	this->setPoseTransformRules(deviceIndex, {});
+}
+
+void DeviceStateCommandSender::setInputTransformRules(
+	uint32_t deviceIndex,
+	const std::string& path,
+	const std::vector<InputTransformRule>& rules
+) {
+	CommandParams_SetInputTransformRules params = {};
+	params.inputPathOffset = SharedDeviceMemoryClient::getInstance().getOffsetOfPath(path);
+	params.ruleCount = static_cast<uint32_t>((std::min)(rules.size(), static_cast<size_t>(MAX_INPUT_TRANSFORM_RULES)));
+	for (uint32_t i = 0; i < params.ruleCount; i++) params.rules[i] = rules[i];
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_SetInputTransformRules,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_SetInputTransformRules)
+	);
+}
+
+void DeviceStateCommandSender::clearInputTransformRules(uint32_t deviceIndex, const std::string& path) {
+	this->setInputTransformRules(deviceIndex, path, {});
+}
+
+bool DeviceStateCommandSender::loadInputFilterProgram(
+	uint32_t deviceIndex,
+	const std::string& path,
+	const std::vector<FilterInstruction>& program,
+	const std::vector<std::pair<uint32_t, std::string>>& bindings
+) {
+	if (program.size() > MAX_FILTER_INSTRUCTIONS || bindings.size() > MAX_FILTER_BINDINGS) return false;
+
+	SharedDeviceMemoryClient& sharedMemory = SharedDeviceMemoryClient::getInstance();
+
+	CommandParams_LoadInputFilterProgram params = {};
+	params.inputPathOffset = sharedMemory.getOffsetOfPath(path);
+	params.instructionCount = static_cast<uint32_t>(program.size());
+	std::copy(program.begin(), program.end(), params.instructions);
+
+	params.bindingCount = static_cast<uint32_t>(bindings.size());
+	for (uint32_t i = 0; i < params.bindingCount; i++) {
+		params.bindingDeviceIndexes[i] = bindings[i].first;
+		params.bindingPathOffsets[i] = sharedMemory.getOffsetOfPath(bindings[i].second);
+	}
+
+	sharedMemory.issueCommandToSharedMemory(
+		Command_LoadInputFilterProgram,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_LoadInputFilterProgram)
+	);
+
+	return true;
+}
+
+void DeviceStateCommandSender::unloadInputFilterProgram(uint32_t deviceIndex, const std::string& path) {
+	CommandParams_LoadInputFilterProgram params = {};
+	params.inputPathOffset = SharedDeviceMemoryClient::getInstance().getOffsetOfPath(path);
+	params.instructionCount = 0;
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_LoadInputFilterProgram,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_LoadInputFilterProgram)
+	);
+}
+
+void DeviceStateCommandSender::setPoseSmoothingFilter(uint32_t deviceIndex, const SmoothingFilterConfig& config) {
+	CommandParams_SetPoseSmoothingFilter params = {};
+	params.config = config;
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_SetPoseSmoothingFilter,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_SetPoseSmoothingFilter)
+	);
+}
+
+void DeviceStateCommandSender::clearPoseSmoothingFilter(uint32_t deviceIndex) {
+	SmoothingFilterConfig config = {};
+	config.type = SmoothingFilter_None;
+	this->setPoseSmoothingFilter(deviceIndex, config);
+}
+
+void DeviceStateCommandSender::setScalarSmoothingFilter(
+	uint32_t deviceIndex,
+	const std::string& path,
+	const SmoothingFilterConfig& config
+) {
+	CommandParams_SetScalarSmoothingFilter params = {};
+	params.inputPathOffset = SharedDeviceMemoryClient::getInstance().getOffsetOfPath(path);
+	params.config = config;
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_SetScalarSmoothingFilter,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_SetScalarSmoothingFilter)
+	);
+}
+
+void DeviceStateCommandSender::clearScalarSmoothingFilter(uint32_t deviceIndex, const std::string& path) {
+	SmoothingFilterConfig config = {};
+	config.type = SmoothingFilter_None;
+	this->setScalarSmoothingFilter(deviceIndex, path, config);
+}
+
+void DeviceStateCommandSender::setPoseExtrapolation(uint32_t deviceIndex, const PoseExtrapolationConfig& config) {
+	CommandParams_SetPoseExtrapolation params = {};
+	params.config = config;
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_SetPoseExtrapolation,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_SetPoseExtrapolation)
+	);
+}
+
+void DeviceStateCommandSender::clearPoseExtrapolation(uint32_t deviceIndex) {
+	PoseExtrapolationConfig config = {};
+	config.enabled = false;
+	this->setPoseExtrapolation(deviceIndex, config);
+}
+
+bool DeviceStateCommandSender::uploadPoseAnimation(uint32_t trackId, const std::vector<PoseKeyframe>& keyframes) {
+	return SharedDeviceMemoryClient::getInstance().uploadAnimationTrack(
+		trackId,
+		AnimationTrack_Pose,
+		keyframes.data(),
+		sizeof(PoseKeyframe),
+		static_cast<uint32_t>(keyframes.size())
+	);
+}
+
+bool DeviceStateCommandSender::uploadScalarAnimation(uint32_t trackId, const std::vector<ScalarKeyframe>& keyframes) {
+	return SharedDeviceMemoryClient::getInstance().uploadAnimationTrack(
+		trackId,
+		AnimationTrack_Scalar,
+		keyframes.data(),
+		sizeof(ScalarKeyframe),
+		static_cast<uint32_t>(keyframes.size())
+	);
+}
+
+bool DeviceStateCommandSender::uploadSkeletonAnimation(
+	uint32_t trackId,
+	const std::vector<SkeletonKeyframe>& keyframes
+) {
+	return SharedDeviceMemoryClient::getInstance().uploadAnimationTrack(
+		trackId,
+		AnimationTrack_Skeleton,
+		keyframes.data(),
+		sizeof(SkeletonKeyframe),
+		static_cast<uint32_t>(keyframes.size())
+	);
+}
+
+void DeviceStateCommandSender::playPoseAnimation(
+	uint32_t deviceIndex,
+	uint32_t trackId,
+	const AnimationPlaybackConfig& config
+) {
+	CommandParams_PlayPoseAnimation params = {};
+	params.trackId = trackId;
+	params.config = config;
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_PlayPoseAnimation,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_PlayPoseAnimation)
+	);
+}
+
+void DeviceStateCommandSender::stopPoseAnimation(uint32_t deviceIndex, double blendOutSeconds) {
+	AnimationPlaybackConfig config = {};
+	config.blendOutSeconds = blendOutSeconds;
+	this->playPoseAnimation(deviceIndex, NO_ANIMATION_TRACK, config);
+}
+
+void DeviceStateCommandSender::playInputAnimation(
+	uint32_t deviceIndex,
+	const std::string& path,
+	uint32_t trackId,
+	const AnimationPlaybackConfig& config
+) {
+	CommandParams_PlayInputAnimation params = {};
+	params.inputPathOffset = SharedDeviceMemoryClient::getInstance().getOffsetOfPath(path);
+	params.trackId = trackId;
+	params.config = config;
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_PlayInputAnimation,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_PlayInputAnimation)
+	);
+}
+
+void DeviceStateCommandSender::stopInputAnimation(
+	uint32_t deviceIndex,
+	const std::string& path,
+	double blendOutSeconds
+) {
+	AnimationPlaybackConfig config = {};
+	config.blendOutSeconds = blendOutSeconds;
+	this->playInputAnimation(deviceIndex, path, NO_ANIMATION_TRACK, config);
+}
+
+void DeviceStateCommandSender::injectHapticPulse(
+	uint32_t deviceIndex,
+	const std::string& path,
+	float durationSeconds,
+	float frequency,
+	float amplitude
+) {
+	CommandParams_InjectHapticPulse params = {};
+	params.inputPathOffset = SharedDeviceMemoryClient::getInstance().getOffsetOfPath(path);
+	params.durationSeconds = durationSeconds;
+	params.frequency = frequency;
+	params.amplitude = amplitude;
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_InjectHapticPulse,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_InjectHapticPulse)
+	);
+}
+
+void DeviceStateCommandSender::setHapticSuppression(uint32_t deviceIndex, const std::string& path, bool suppressed) {
+	CommandParams_SetHapticSuppression params = {};
+	params.inputPathOffset = SharedDeviceMemoryClient::getInstance().getOffsetOfPath(path);
+	params.suppressed = suppressed;
+
+	SharedDeviceMemoryClient::getInstance().issueCommandToSharedMemory(
+		Command_SetHapticSuppression,
+		deviceIndex,
+		&params,
+		sizeof(CommandParams_SetHapticSuppression)
+	);
+}
+
+bool DeviceStateCommandSender::enablePoseHistory(uint32_t deviceIndex, const PoseHistoryConfig& config) {
+	return PoseHistoryManager::getInstance().enable(deviceIndex, config);
+}
+
+void DeviceStateCommandSender::disablePoseHistory(uint32_t deviceIndex) {
+	PoseHistoryManager::getInstance().disable(deviceIndex);
+}
+
+std::optional<PoseHistorySample> DeviceStateCommandSender::getPoseAt(
+	uint32_t deviceIndex,
+	std::chrono::steady_clock::time_point time
+) {
+	int64_t timestampNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		time.time_since_epoch()
+	).count();
+
+	PoseHistorySample sample;
+	if (PoseHistoryManager::getInstance().getPoseAt(deviceIndex, timestampNanoseconds, sample)) return sample;
+	return std::nullopt;
+}
+
+uint32_t DeviceStateCommandSender::resamplePoseHistory(
+	uint32_t deviceIndex,
+	PoseResamplerState& state,
+	std::vector<PoseHistorySample>& outSamples
+) {
+	return PoseHistoryManager::getInstance().resample(deviceIndex, state, outSamples);
 }
\ No newline at end of file
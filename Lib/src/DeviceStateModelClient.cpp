@@ -290,4 +290,20 @@ void DeviceStateModelClient::notifyListenersEyeTrackingInputUpdated(
 	for (IDeviceStateEventReceiver* listener : this->eventListeners) {
 		listener->DeviceInputEyeTrackingChanged(deviceIndex, path, oldInput.value, newInput.value);
 	}
+}
+
+void DeviceStateModelClient::notifyListenersHapticEvent(
+	uint32_t deviceIndex,
+	const std::string& path,
+	const HapticEvent& event
+) {
+	for (IDeviceStateEventReceiver* listener : this->eventListeners) {
+		listener->DeviceHapticEvent(deviceIndex, path, event);
+	}
+}
+
+void DeviceStateModelClient::notifyListenersDeviceRemoved(uint32_t deviceIndex) {
+	for (IDeviceStateEventReceiver* listener : this->eventListeners) {
+		listener->DeviceRemoved(deviceIndex);
+	}
 }
\ No newline at end of file
@@ -253,6 +253,20 @@ public:
 		const DeviceInputEyeTrackingSerialized oldInput,
 		const DeviceInputEyeTrackingSerialized newInput
 	);
+
+	/**
+	 * @brief Notifies all listeners that a haptic component received a vibration
+	 * @param deviceIndex The device index of the device
+	 * @param path The path of the haptic component
+	 * @param event The vibration
+	 */
+	void notifyListenersHapticEvent(uint32_t deviceIndex, const std::string& path, const HapticEvent& event);
+
+	/**
+	 * @brief Notifies all listeners that a device was removed
+	 * @param deviceIndex The device index of the device
+	 */
+	void notifyListenersDeviceRemoved(uint32_t deviceIndex);
 private:
 	/** @brief Collection of registered event listeners */
 	std::vector<IDeviceStateEventReceiver*> eventListeners;
@@ -0,0 +1,245 @@
+#include "PoseHistoryManager.h"
+
+#include <algorithm>
+#include <cmath>
+
+/** @brief The most poses a single history holds, 16 seconds at 1 kHz, which bounds it to about a megabyte */
+static const uint32_t MAX_POSE_HISTORY_SAMPLES = 16384;
+
+/**
+ * @brief Spherically interpolates between two rotations along the shortest arc, falling back to a normalized lerp
+ * when they are nearly parallel
+ */
+static DeviceQuaternion slerpRotations(const DeviceQuaternion& a, const DeviceQuaternion& b, double t) {
+	double dot = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+
+	// q and -q are the same rotation, so b is flipped onto a's hemisphere
+	double sign = 1.0;
+	if (dot < 0.0) {
+		dot = -dot;
+		sign = -1.0;
+	}
+
+	double weightA, weightB;
+	if (dot > 0.9995) {
+		weightA = 1.0 - t;
+		weightB = t;
+	} else {
+		double theta = std::acos(dot);
+		double sinTheta = std::sin(theta);
+		weightA = std::sin((1.0 - t) * theta) / sinTheta;
+		weightB = std::sin(t * theta) / sinTheta;
+	}
+	weightB *= sign;
+
+	DeviceQuaternion result;
+	result.w = weightA * a.w + weightB * b.w;
+	result.x = weightA * a.x + weightB * b.x;
+	result.y = weightA * a.y + weightB * b.y;
+	result.z = weightA * a.z + weightB * b.z;
+
+	double length = std::sqrt(result.w * result.w + result.x * result.x + result.y * result.y + result.z * result.z);
+	if (length > 0.0) {
+		result.w /= length;
+		result.x /= length;
+		result.y /= length;
+		result.z /= length;
+	}
+
+	return result;
+}
+
+PoseHistoryManager& PoseHistoryManager::getInstance() {
+	static PoseHistoryManager instance;
+	return instance;
+}
+
+bool PoseHistoryManager::enable(uint32_t deviceIndex, const PoseHistoryConfig& config) {
+	if (deviceIndex >= MAX_REGISTRY_DEVICES) return false;
+	if (!(config.durationSeconds > 0.0) || !(config.maxUpdateRate > 0.0)) return false;
+
+	double wantedSamples = std::ceil(config.durationSeconds * config.maxUpdateRate) + 1.0;
+	uint32_t capacity = 1;
+	while (capacity < MAX_POSE_HISTORY_SAMPLES && capacity < wantedSamples) capacity <<= 1;
+
+	DeviceHistory& history = this->histories[deviceIndex];
+	{
+		std::lock_guard<std::mutex> lock(history.historyMutex);
+
+		history.capacityMask = capacity - 1;
+		history.writeCount = 0;
+		history.timestamps.assign(capacity, 0);
+		history.positions.assign(capacity, {});
+		history.rotations.assign(capacity, {});
+	}
+
+	this->enabledMask.fetch_or(1ULL << deviceIndex, std::memory_order_release);
+	return true;
+}
+
+void PoseHistoryManager::disable(uint32_t deviceIndex) {
+	if (deviceIndex >= MAX_REGISTRY_DEVICES) return;
+
+	this->enabledMask.fetch_and(~(1ULL << deviceIndex), std::memory_order_release);
+
+	DeviceHistory& history = this->histories[deviceIndex];
+	std::lock_guard<std::mutex> lock(history.historyMutex);
+
+	history.capacityMask = 0;
+	history.writeCount = 0;
+	std::vector<int64_t>().swap(history.timestamps);
+	std::vector<std::array<double, 3>>().swap(history.positions);
+	std::vector<DeviceQuaternion>().swap(history.rotations);
+}
+
+void PoseHistoryManager::clear(uint32_t deviceIndex) {
+	if (deviceIndex >= MAX_REGISTRY_DEVICES) return;
+
+	DeviceHistory& history = this->histories[deviceIndex];
+	std::lock_guard<std::mutex> lock(history.historyMutex);
+	history.writeCount = 0;
+}
+
+void PoseHistoryManager::recordPose(uint32_t deviceIndex, int64_t timestampNanoseconds, const DevicePose& pose) {
+	if (deviceIndex >= MAX_REGISTRY_DEVICES || !pose.poseIsValid) return;
+	if (!(this->enabledMask.load(std::memory_order_acquire) & (1ULL << deviceIndex))) return;
+
+	DeviceHistory& history = this->histories[deviceIndex];
+	std::lock_guard<std::mutex> lock(history.historyMutex);
+	if (history.timestamps.empty()) return;
+
+	// Pose time offsets can jitter between updates, and the binary search relies on the times never decreasing
+	if (history.writeCount > 0) {
+		int64_t newestTimestamp = history.timestamps[(history.writeCount - 1) & history.capacityMask];
+		timestampNanoseconds = std::max(timestampNanoseconds, newestTimestamp);
+	}
+
+	uint32_t index = static_cast<uint32_t>(history.writeCount & history.capacityMask);
+	history.timestamps[index] = timestampNanoseconds;
+	history.positions[index] = { pose.vecPosition[0], pose.vecPosition[1], pose.vecPosition[2] };
+	history.rotations[index] = pose.qRotation;
+	history.writeCount++;
+}
+
+bool PoseHistoryManager::getPoseAt(uint32_t deviceIndex, int64_t timestampNanoseconds, PoseHistorySample& outSample) {
+	if (deviceIndex >= MAX_REGISTRY_DEVICES) return false;
+
+	DeviceHistory& history = this->histories[deviceIndex];
+	std::lock_guard<std::mutex> lock(history.historyMutex);
+
+	uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(history.writeCount, history.timestamps.size()));
+	if (count == 0) return false;
+
+	uint64_t oldest = history.writeCount - count;
+	if (timestampNanoseconds < history.timestamps[oldest & history.capacityMask]) return false;
+
+	uint32_t after = findFirstPoseAfter(history, count, timestampNanoseconds);
+	samplePose(history, count, after, timestampNanoseconds, outSample);
+	return true;
+}
+
+uint32_t PoseHistoryManager::resample(
+	uint32_t deviceIndex,
+	PoseResamplerState& state,
+	std::vector<PoseHistorySample>& outSamples
+) {
+	if (deviceIndex >= MAX_REGISTRY_DEVICES || !(state.sampleRate > 0.0)) return 0;
+
+	int64_t periodNanoseconds = std::max<int64_t>(1, std::llround(1000000000.0 / state.sampleRate));
+
+	DeviceHistory& history = this->histories[deviceIndex];
+	std::lock_guard<std::mutex> lock(history.historyMutex);
+
+	uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(history.writeCount, history.timestamps.size()));
+	if (count == 0) return 0;
+
+	uint64_t oldest = history.writeCount - count;
+	int64_t oldestTimestamp = history.timestamps[oldest & history.capacityMask];
+	int64_t newestTimestamp = history.timestamps[(history.writeCount - 1) & history.capacityMask];
+
+	if (state.nextTimestampNanoseconds == 0) state.nextTimestampNanoseconds = newestTimestamp;
+
+	// A caller that fell behind skips whole periods, so the samples stay on the same grid
+	if (state.nextTimestampNanoseconds < oldestTimestamp) {
+		int64_t behind = oldestTimestamp - state.nextTimestampNanoseconds;
+		state.nextTimestampNanoseconds += (behind + periodNanoseconds - 1) / periodNanoseconds * periodNanoseconds;
+	}
+
+	if (state.nextTimestampNanoseconds > newestTimestamp) return 0;
+
+	// Only the first sample is searched for, the following ones walk forward through the history
+	uint32_t after = findFirstPoseAfter(history, count, state.nextTimestampNanoseconds);
+	uint32_t emitted = 0;
+
+	while (state.nextTimestampNanoseconds <= newestTimestamp) {
+		while (after < count) {
+			int64_t afterTimestamp = history.timestamps[(oldest + after) & history.capacityMask];
+			if (afterTimestamp > state.nextTimestampNanoseconds) break;
+			after++;
+		}
+
+		PoseHistorySample sample;
+		samplePose(history, count, after, state.nextTimestampNanoseconds, sample);
+		outSamples.push_back(sample);
+
+		state.nextTimestampNanoseconds += periodNanoseconds;
+		emitted++;
+	}
+
+	return emitted;
+}
+
+uint32_t PoseHistoryManager::findFirstPoseAfter(
+	const DeviceHistory& history,
+	uint32_t count,
+	int64_t timestampNanoseconds
+) {
+	uint64_t oldest = history.writeCount - count;
+
+	uint32_t low = 0;
+	uint32_t high = count;
+	while (low < high) {
+		uint32_t middle = low + (high - low) / 2;
+		if (history.timestamps[(oldest + middle) & history.capacityMask] <= timestampNanoseconds) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+void PoseHistoryManager::samplePose(
+	const DeviceHistory& history,
+	uint32_t count,
+	uint32_t after,
+	int64_t timestampNanoseconds,
+	PoseHistorySample& outSample
+) {
+	uint64_t oldest = history.writeCount - count;
+	outSample.timestampNanoseconds = timestampNanoseconds;
+
+	// The newest pose is held past the end of the history, and a time matching a pose exactly needs no blending
+	uint32_t fromIndex = static_cast<uint32_t>((oldest + after - 1) & history.capacityMask);
+	int64_t fromTimestamp = history.timestamps[fromIndex];
+	if (after >= count || fromTimestamp == timestampNanoseconds) {
+		const std::array<double, 3>& position = history.positions[fromIndex];
+		std::copy(position.begin(), position.end(), outSample.vecPosition);
+		outSample.qRotation = history.rotations[fromIndex];
+		return;
+	}
+
+	uint32_t toIndex = static_cast<uint32_t>((oldest + after) & history.capacityMask);
+	int64_t toTimestamp = history.timestamps[toIndex];
+	double t = static_cast<double>(timestampNanoseconds - fromTimestamp) /
+		static_cast<double>(toTimestamp - fromTimestamp);
+
+	const std::array<double, 3>& from = history.positions[fromIndex];
+	const std::array<double, 3>& to = history.positions[toIndex];
+	for (int i = 0; i < 3; i++) {
+		outSample.vecPosition[i] = from[i] + (to[i] - from[i]) * t;
+	}
+
+	outSample.qRotation = slerpRotations(history.rotations[fromIndex], history.rotations[toIndex], t);
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "ObjectSchemas.h"
+
+/**
+ * @brief Records the natural poses of the devices that opted in into a history ring each, so clients can ask where a
+ * device was at a past time or resample its motion at a fixed rate. Each history is laid out as separate timestamp,
+ * position and rotation arrays, so a query only binary searches the timestamps and touches two poses
+ */
+class PoseHistoryManager {
+public:
+	/**
+	 * @brief Returns the singleton PoseHistoryManager instance
+	 * @return The singleton instance
+	 */
+	static PoseHistoryManager& getInstance();
+
+	/**
+	 * @brief Starts recording the pose history of a device, dropping any poses already recorded for it. The history
+	 * holds durationSeconds * maxUpdateRate poses, capped so a single history never exceeds a fixed size
+	 * @param deviceIndex The device index of the device
+	 * @param config The configuration of the history
+	 * @return True if the history was enabled, false if the device index or config is invalid
+	 */
+	bool enable(uint32_t deviceIndex, const PoseHistoryConfig& config);
+
+	/**
+	 * @brief Stops recording the pose history of a device and frees it
+	 * @param deviceIndex The device index of the device
+	 */
+	void disable(uint32_t deviceIndex);
+
+	/**
+	 * @brief Drops the poses recorded for a device while keeping its history enabled, called when the device is removed
+	 * since a device activated later at the same index is unrelated to it
+	 * @param deviceIndex The device index of the device
+	 */
+	void clear(uint32_t deviceIndex);
+
+	/**
+	 * @brief Records a natural pose of a device if its history is enabled, called from the poll thread. Invalid poses
+	 * are skipped, so queries interpolate across tracking loss instead of towards garbage
+	 * @param deviceIndex The device index of the device
+	 * @param timestampNanoseconds The steady clock time in nanoseconds the pose is at
+	 * @param pose The pose
+	 */
+	void recordPose(uint32_t deviceIndex, int64_t timestampNanoseconds, const DevicePose& pose);
+
+	/**
+	 * @brief Returns the pose of a device at a time, interpolating linearly between the recorded positions and
+	 * spherically between the recorded rotations around it. Times after the newest pose hold the newest pose
+	 * @param deviceIndex The device index of the device
+	 * @param timestampNanoseconds The steady clock time in nanoseconds
+	 * @param outSample The output sample, only valid if the method returns true
+	 * @return True if <outSample> was written, false if the history is disabled or the time is before the oldest pose
+	 */
+	bool getPoseAt(uint32_t deviceIndex, int64_t timestampNanoseconds, PoseHistorySample& outSample);
+
+	/**
+	 * @brief Appends samples at a fixed rate from the next sample time of <state> up to the newest recorded pose, and
+	 * advances the state past them. Sample times that fell out of the history are skipped
+	 * @param deviceIndex The device index of the device
+	 * @param state The resampler state
+	 * @param outSamples Where to append the samples
+	 * @return The number of samples appended
+	 */
+	uint32_t resample(uint32_t deviceIndex, PoseResamplerState& state, std::vector<PoseHistorySample>& outSamples);
+
+private:
+	/** @brief The pose history of a single device */
+	struct DeviceHistory {
+		/** @brief Guards the history, held by the poll thread only for as long as it takes to record one pose */
+		std::mutex historyMutex;
+
+		/** @brief The capacity minus one, where the capacity is a power of two so ring indexes are masked */
+		uint32_t capacityMask = 0;
+
+		/** @brief The number of poses recorded since the history was enabled or cleared */
+		uint64_t writeCount = 0;
+
+		/** @brief The time of each pose, never decreasing from the oldest pose to the newest */
+		std::vector<int64_t> timestamps;
+
+		std::vector<std::array<double, 3>> positions;
+
+		std::vector<DeviceQuaternion> rotations;
+	};
+
+	/** @brief The history of every device index, only allocating storage while enabled */
+	std::array<DeviceHistory, MAX_REGISTRY_DEVICES> histories;
+
+	/** @brief Bit i is set while the history of device index i is enabled, so disabled devices skip the lock */
+	std::atomic<uint64_t> enabledMask = 0;
+
+	/** @brief Private empty constructor for the singleton pattern */
+	PoseHistoryManager() = default;
+
+	/**
+	 * @brief Binary searches a history for the first pose whose time is after <timestampNanoseconds>, assuming the
+	 * caller holds the history mutex
+	 * @param history The history
+	 * @param count The number of poses in the history
+	 * @param timestampNanoseconds The time
+	 * @return The offset, which is <count> if no pose is after the time
+	 */
+	static uint32_t findFirstPoseAfter(const DeviceHistory& history, uint32_t count, int64_t timestampNanoseconds);
+
+	/**
+	 * @brief Interpolates a history at a time, assuming the caller holds the history mutex and the time is at or
+	 * after the oldest pose
+	 * @param history The history
+	 * @param count The number of poses in the history
+	 * @param after The offset of the first pose after the time, see findFirstPoseAfter
+	 * @param timestampNanoseconds The time
+	 * @param outSample The output sample
+	 */
+	static void samplePose(
+		const DeviceHistory& history,
+		uint32_t count,
+		uint32_t after,
+		int64_t timestampNanoseconds,
+		PoseHistorySample& outSample
+	);
+};
@@ -1,7 +1,41 @@
 #include "SharedDeviceMemoryClient.h"
 #include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <psapi.h>
 
-const uint32_t PROTOCOL_VERSION = 5;
+#include "MirroredRing.h"
+#include "PoseHistoryManager.h"
+
+const uint32_t PROTOCOL_VERSION = 24;
+
+/** @brief The sequence id of the last command issued by each thread, so callers can wait on what they just sent */
+static thread_local uint64_t lastIssuedCommandSequence = 0;
+
+/** @brief The time in milliseconds an animation upload waits for the previous load of its slot to complete */
+const uint32_t ANIMATION_UPLOAD_TIMEOUT_MS = 100;
+
+/** @brief The apply time given to commands issued by each thread, or 0 to apply them immediately */
+static thread_local int64_t commandApplyTime = 0;
+
+/** @brief The number of times a device registry refresh retries a copy torn by the driver changing the registry */
+const uint32_t MAX_DEVICE_REGISTRY_COPY_ATTEMPTS = 16;
+
+/**
+ * @brief Rebuilds params of type T field by field on top of zeroed storage, so that the padding bytes left by the
+ * caller don't make identical params compare as different
+ * @param copyFields Copies every field of the params given first into the params given second
+ */
+template <typename T, typename CopyFields>
+static void rebuildParams(std::vector<uint8_t>& params, CopyFields copyFields) {
+	if (params.size() != sizeof(T)) return;
+
+	T rebuilt;
+	std::memset(static_cast<void*>(&rebuilt), 0, sizeof(T));
+	copyFields(*reinterpret_cast<const T*>(params.data()), rebuilt);
+	std::memcpy(params.data(), &rebuilt, sizeof(T));
+}
 
 SharedDeviceMemoryClient& SharedDeviceMemoryClient::getInstance() {
 	static SharedDeviceMemoryClient instance;
@@ -13,20 +47,50 @@ int SharedDeviceMemoryClient::initialize() {
 
 	if (!this->sharedMemoryHandle) return 1;
 	this->sharedMemory = MapViewOfFile(this->sharedMemoryHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+
+	// Large page sections may have to be mapped as large pages explicitly
+	if (!this->sharedMemory) {
+		DWORD access = FILE_MAP_ALL_ACCESS | FILE_MAP_LARGE_PAGES;
+		this->sharedMemory = MapViewOfFile(this->sharedMemoryHandle, access, 0, 0, 0);
+	}
+
 	if (!this->sharedMemory) return 2;
 	SharedMemoryHeader* header = static_cast<SharedMemoryHeader*>(this->sharedMemory);
 	if (header->protocolVersion != PROTOCOL_VERSION) return 3;
 
+	this->mappingStats.largePages = (header->mappingFlags & SharedMemoryMapping_LargePages) != 0;
+	this->mappingStats.mappingSize = header->mappingSize;
+	if (header->mappingFlags & SharedMemoryMapping_Locked) this->prefaultSharedMemory();
+	if ((header->mappingFlags & SharedMemoryMapping_MirroredLanes) && !this->mapMirroredLanes()) return 4;
+
 	this->pathTableStart = header->pathTableStart;
 
 	this->driverClientLaneStart = header->driverClientLaneStart;
+	if (!this->mirroredLanes) {
+		this->driverClientLane = static_cast<uint8_t*>(this->sharedMemory) + this->driverClientLaneStart;
+	}
 	this->driverClientLaneReadOffset = header->driverClientWriteOffset.load(std::memory_order_acquire);
 	header->driverClientReadOffset.store(this->driverClientLaneReadOffset, std::memory_order_release);
 	this->driverClientLaneReadCount = header->driverClientWriteCount.load(std::memory_order_acquire);
+	this->cachedDriverClientWriteOffset = this->driverClientLaneReadOffset;
 
 	this->clientDriverLaneStart = header->clientDriverLaneStart;
+	if (!this->mirroredLanes) {
+		this->clientDriverLane = static_cast<uint8_t*>(this->sharedMemory) + this->clientDriverLaneStart;
+	}
 	this->clientDriverLaneWriteOffset = header->clientDriverWriteOffset.load(std::memory_order_acquire);
 	this->clientDriverLaneWriteCount = header->clientDriverWriteCount.load(std::memory_order_acquire);
+	this->cachedClientDriverReadOffset = header->clientDriverReadOffset.load(std::memory_order_acquire);
+
+	this->commandStatusRingStart = header->commandStatusRingStart;
+	this->animationBlobStart = header->animationBlobStart;
+	this->deviceRegistryStart = header->deviceRegistryStart;
+	this->hapticLaneStart = header->hapticLaneStart;
+	this->hapticLaneReadCount = header->hapticWriteCount.load(std::memory_order_acquire);
+
+	// Announce the client, so the driver starts publishing state and sends a snapshot of the model
+	header->clientGeneration.fetch_add(1, std::memory_order_relaxed);
+	this->publishHeartbeat();
 
 	std::thread(&SharedDeviceMemoryClient::pollLoop, this).detach();
 
@@ -35,6 +99,72 @@ int SharedDeviceMemoryClient::initialize() {
 	return 0;
 }
 
+void SharedDeviceMemoryClient::prefaultSharedMemory() {
+	HANDLE process = GetCurrentProcess();
+
+	PROCESS_MEMORY_COUNTERS countersBefore = {};
+	GetProcessMemoryInfo(process, &countersBefore, sizeof(countersBefore));
+
+	// The driver is already using the mapping, so pages are faulted in by reading them rather than writing
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	const volatile uint8_t* bytes = static_cast<const volatile uint8_t*>(this->sharedMemory);
+	uint8_t sink = 0;
+	for (uint64_t offset = 0; offset < this->mappingStats.mappingSize; offset += systemInfo.dwPageSize) {
+		sink ^= bytes[offset];
+	}
+	(void)sink;
+
+	PROCESS_MEMORY_COUNTERS countersAfter = {};
+	GetProcessMemoryInfo(process, &countersAfter, sizeof(countersAfter));
+
+	this->mappingStats.prefaulted = true;
+	this->mappingStats.prefaultPageFaults = countersAfter.PageFaultCount - countersBefore.PageFaultCount;
+
+	// Large pages are never paged out, while regular pages need room in the working set to be locked
+	if (this->mappingStats.largePages) {
+		this->mappingStats.locked = true;
+		return;
+	}
+
+	SIZE_T mappingSize = static_cast<SIZE_T>(this->mappingStats.mappingSize);
+	SIZE_T minimumSize, maximumSize;
+	if (GetProcessWorkingSetSize(process, &minimumSize, &maximumSize)) {
+		SetProcessWorkingSetSize(process, minimumSize + mappingSize, maximumSize + mappingSize);
+	}
+
+	this->mappingStats.locked = VirtualLock(this->sharedMemory, mappingSize) != 0;
+}
+
+bool SharedDeviceMemoryClient::mapMirroredLanes() {
+	HANDLE driverClientLaneHandle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, DRIVER_CLIENT_LANE_NAME);
+	HANDLE clientDriverLaneHandle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, CLIENT_DRIVER_LANE_NAME);
+
+	if (driverClientLaneHandle && clientDriverLaneHandle) {
+		this->driverClientLane = mapMirroredView(driverClientLaneHandle, LANE_SIZE);
+		this->clientDriverLane = mapMirroredView(clientDriverLaneHandle, LANE_SIZE);
+	}
+
+	// The views keep the sections alive on their own
+	if (driverClientLaneHandle) CloseHandle(driverClientLaneHandle);
+	if (clientDriverLaneHandle) CloseHandle(clientDriverLaneHandle);
+
+	if (!this->driverClientLane || !this->clientDriverLane) {
+		unmapMirroredView(this->driverClientLane, LANE_SIZE);
+		unmapMirroredView(this->clientDriverLane, LANE_SIZE);
+		this->driverClientLane = this->clientDriverLane = nullptr;
+		return false;
+	}
+
+	this->mirroredLanes = true;
+	this->mappingStats.mirroredLanes = true;
+	return true;
+}
+
+SharedMemoryMappingStats SharedDeviceMemoryClient::getMappingStats() {
+	return this->mappingStats;
+}
+
 std::string SharedDeviceMemoryClient::getPathFromPathOffset(uint32_t offset) {
 	if (!(0 <= offset && offset <= PATH_TABLE_SIZE)) return std::string();
 
@@ -85,6 +215,154 @@ uint32_t SharedDeviceMemoryClient::getOffsetOfPath(const std::string& path) {
 	return UINT32_MAX;
 }
 
+std::optional<DeviceInfo> SharedDeviceMemoryClient::getDeviceInfo(uint32_t deviceIndex) {
+	if (deviceIndex >= MAX_REGISTRY_DEVICES) return std::nullopt;
+
+	std::lock_guard<std::mutex> lock(this->deviceRegistryMutex);
+	this->refreshDeviceRegistry();
+	return this->cachedDevices[deviceIndex];
+}
+
+DeviceClass SharedDeviceMemoryClient::getDeviceClass(uint32_t deviceIndex) {
+	if (deviceIndex >= MAX_REGISTRY_DEVICES) return DeviceClass_Invalid;
+
+	std::lock_guard<std::mutex> lock(this->deviceRegistryMutex);
+	this->refreshDeviceRegistry();
+	const std::optional<DeviceInfo>& device = this->cachedDevices[deviceIndex];
+	return device ? device->deviceClass : DeviceClass_Invalid;
+}
+
+uint64_t SharedDeviceMemoryClient::getDeviceClassMask(DeviceClass deviceClass) {
+	if (static_cast<uint32_t>(deviceClass) >= NUM_DEVICE_CLASSES) return 0;
+
+	std::lock_guard<std::mutex> lock(this->deviceRegistryMutex);
+	this->refreshDeviceRegistry();
+	return this->cachedDeviceClassMasks[deviceClass];
+}
+
+std::vector<ComponentInfo> SharedDeviceMemoryClient::getDeviceComponents(uint32_t deviceIndex) {
+	std::vector<ComponentInfo> components;
+
+	std::lock_guard<std::mutex> lock(this->deviceRegistryMutex);
+	this->refreshDeviceRegistry();
+	for (const ComponentInfo& component : this->cachedComponents) {
+		if (component.deviceIndex == deviceIndex) components.push_back(component);
+	}
+
+	return components;
+}
+
+std::optional<ComponentInfo> SharedDeviceMemoryClient::getComponentInfo(uint32_t deviceIndex, const std::string& path) {
+	std::lock_guard<std::mutex> lock(this->deviceRegistryMutex);
+	this->refreshDeviceRegistry();
+
+	auto device = this->cachedComponentIndexes.find(deviceIndex);
+	if (device == this->cachedComponentIndexes.end()) return std::nullopt;
+
+	auto component = device->second.find(path);
+	if (component == device->second.end()) return std::nullopt;
+
+	return this->cachedComponents[component->second];
+}
+
+bool SharedDeviceMemoryClient::refreshDeviceRegistry() {
+	if (!this->initialized) return false;
+
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+	const DeviceRegistry* registry = reinterpret_cast<const DeviceRegistry*>(
+		static_cast<uint8_t*>(this->sharedMemory) + this->deviceRegistryStart
+	);
+
+	// The common case, where nothing changed since the last query, costs a single load
+	uint32_t version = headerPtr->deviceRegistryVersion.load(std::memory_order_acquire);
+	if (version == this->cachedDeviceRegistryVersion) return true;
+
+	if (!this->deviceRegistrySnapshot) this->deviceRegistrySnapshot = std::make_unique<DeviceRegistry>();
+	DeviceRegistry& snapshot = *this->deviceRegistrySnapshot;
+
+	bool copied = false;
+	for (uint32_t attempt = 0; attempt < MAX_DEVICE_REGISTRY_COPY_ATTEMPTS && !copied; attempt++) {
+		if (version % 2 == 0) {
+			// Only the used part of the component and grip limit tables is copied
+			memcpy(&snapshot, registry, offsetof(DeviceRegistry, components));
+			snapshot.componentCount = (std::min)(snapshot.componentCount, MAX_REGISTRY_COMPONENTS);
+			snapshot.gripLimitSlotCount = (std::min)(snapshot.gripLimitSlotCount, MAX_REGISTRY_GRIP_LIMITS);
+			memcpy(
+				snapshot.components,
+				registry->components,
+				snapshot.componentCount * sizeof(DeviceRegistryComponent)
+			);
+			memcpy(
+				snapshot.gripLimitTransforms,
+				registry->gripLimitTransforms,
+				snapshot.gripLimitSlotCount * sizeof(registry->gripLimitTransforms[0])
+			);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			copied = headerPtr->deviceRegistryVersion.load(std::memory_order_relaxed) == version;
+		} else {
+			std::this_thread::yield();
+		}
+
+		if (!copied) version = headerPtr->deviceRegistryVersion.load(std::memory_order_acquire);
+	}
+
+	if (!copied) return false;
+
+	for (uint64_t& mask : this->cachedDeviceClassMasks) mask = 0;
+	for (uint32_t deviceIndex = 0; deviceIndex < MAX_REGISTRY_DEVICES; deviceIndex++) {
+		const DeviceRegistryDevice& device = snapshot.devices[deviceIndex];
+		if (!device.registered) {
+			this->cachedDevices[deviceIndex] = std::nullopt;
+			continue;
+		}
+
+		DeviceInfo info;
+		info.deviceIndex = deviceIndex;
+		info.deviceClass = static_cast<DeviceClass>(device.deviceClass);
+		info.role = static_cast<DeviceRole>(device.role);
+		info.serialNumber.assign(device.serialNumber, strnlen(device.serialNumber, REGISTRY_STRING_SIZE));
+		info.modelNumber.assign(device.modelNumber, strnlen(device.modelNumber, REGISTRY_STRING_SIZE));
+		this->cachedDevices[deviceIndex] = info;
+
+		if (device.deviceClass < NUM_DEVICE_CLASSES) {
+			this->cachedDeviceClassMasks[device.deviceClass] |= 1ULL << deviceIndex;
+		}
+	}
+
+	// Removing a device compacts the component table, so a cached position can now hold another component and the
+	// table is resolved again in full. This only happens when the registry changed, which is rare
+	this->cachedComponents.clear();
+	this->cachedComponentIndexes.clear();
+	this->cachedComponents.reserve(snapshot.componentCount);
+	for (uint32_t i = 0; i < snapshot.componentCount; i++) {
+		const DeviceRegistryComponent& component = snapshot.components[i];
+
+		ComponentInfo info;
+		info.deviceIndex = component.deviceIndex;
+		info.type = static_cast<DeviceComponentType>(component.type);
+		info.path = this->getPathFromPathOffset(component.pathOffset);
+		info.componentHandle = component.componentHandle;
+		info.scalarType = static_cast<ScalarType>(component.scalarType);
+		info.scalarUnits = static_cast<ScalarUnits>(component.scalarUnits);
+		info.skeletonPath = this->getPathFromPathOffset(component.skeletonPathOffset);
+		info.basePosePath = this->getPathFromPathOffset(component.basePosePathOffset);
+		info.skeletalTrackingLevel = static_cast<SkeletalTrackingLevel>(component.skeletalTrackingLevel);
+
+		if (component.gripLimitSlot < snapshot.gripLimitSlotCount) {
+			const BoneTransform* transforms = snapshot.gripLimitTransforms[component.gripLimitSlot];
+			uint32_t count = (std::min)(static_cast<uint32_t>(component.gripLimitTransformCount), 31U);
+			info.gripLimitTransforms.assign(transforms, transforms + count);
+		}
+
+		this->cachedComponentIndexes[info.deviceIndex][info.path] = this->cachedComponents.size();
+		this->cachedComponents.push_back(std::move(info));
+	}
+
+	this->cachedDeviceRegistryVersion = version;
+	return true;
+}
+
 void SharedDeviceMemoryClient::pollForDriverUpdates() {
 	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
 	DeviceStateModelClient& model = DeviceStateModelClient::getInstance();
@@ -121,8 +399,17 @@ void SharedDeviceMemoryClient::pollForDriverUpdates() {
 						ModelDevicePoseSerialized oldPose = *pose;
 						pose->data = *data;
 						model.notifyListenersDevicePoseUpdated(deviceIndex, oldPose.data, *data);
+
+						// The pose is from poseTimeOffset seconds after the time the vendor driver reported it at
+						int64_t poseTimeNanoseconds = data->updateTimeNanoseconds +
+							static_cast<int64_t>(data->pose.poseTimeOffset * 1000000000.0);
+						PoseHistoryManager::getInstance().recordPose(deviceIndex, poseTimeNanoseconds, data->pose);
 					} else {
+						// Sent after the removal of every input of the device, once the driver dropped all of its state
 						model.removeDevicePose(deviceIndex);
+						PoseHistoryManager::getInstance().clear(deviceIndex);
+						this->forgetWrittenParams(deviceIndex);
+						model.notifyListenersDeviceRemoved(deviceIndex);
 					}
 
 					break;
@@ -258,16 +545,635 @@ void SharedDeviceMemoryClient::pollLoop() {
 	double POLL_PERIOD_MICROSECONDS = 1000000.0 / POLL_RATE;
 
 	while (true) {
+		this->publishHeartbeat();
+		this->flushCommands();
+		this->pollForCommandAcks();
+		this->pollHapticLane();
 		this->pollForDriverUpdates();
 		std::this_thread::sleep_for(std::chrono::microseconds((int)POLL_PERIOD_MICROSECONDS));
 	}
 }
 
-void SharedDeviceMemoryClient::issueCommandToSharedMemory(
+void SharedDeviceMemoryClient::pollHapticLane() {
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+	uint64_t writeCount = headerPtr->hapticWriteCount.load(std::memory_order_acquire);
+	if (this->hapticLaneReadCount >= writeCount) return;
+
+	// Only the last lap of records is still in the lane
+	if (writeCount - this->hapticLaneReadCount > HAPTIC_LANE_SIZE) {
+		this->hapticLaneReadCount = writeCount - HAPTIC_LANE_SIZE;
+	}
+
+	const HapticEventRecord* lane = reinterpret_cast<const HapticEventRecord*>(
+		static_cast<uint8_t*>(this->sharedMemory) + this->hapticLaneStart
+	);
+	DeviceStateModelClient& model = DeviceStateModelClient::getInstance();
+
+	while (this->hapticLaneReadCount < writeCount) {
+		const HapticEventRecord& record = lane[this->hapticLaneReadCount % HAPTIC_LANE_SIZE];
+		uint64_t expectedSequence = this->hapticLaneReadCount + 1;
+
+		// A claimed record that isn't written yet holds up the rest of the lane until the next poll
+		uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+		if (sequence == HAPTIC_RECORD_WRITING_SEQUENCE || sequence < expectedSequence) break;
+
+		HapticEvent event;
+		event.timestampNanoseconds = record.timestampNanoseconds;
+		event.durationSeconds = record.durationSeconds;
+		event.frequency = record.frequency;
+		event.amplitude = record.amplitude;
+		event.suppressed = (record.flags & HapticEvent_Suppressed) != 0;
+		event.injected = (record.flags & HapticEvent_Injected) != 0;
+		uint32_t deviceIndex = record.deviceIndex;
+		uint32_t pathOffset = record.pathOffset;
+
+		// A record the driver lapped before or while it was copied is dropped
+		std::atomic_thread_fence(std::memory_order_acquire);
+		bool lapped = sequence != expectedSequence ||
+			record.sequence.load(std::memory_order_relaxed) != expectedSequence;
+
+		this->hapticLaneReadCount++;
+		if (lapped) continue;
+
+		model.notifyListenersHapticEvent(deviceIndex, this->getPathFromPathOffset(pathOffset), event);
+	}
+}
+
+void SharedDeviceMemoryClient::publishHeartbeat() {
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+
+	int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+	headerPtr->clientHeartbeatNanoseconds.store(now, std::memory_order_release);
+}
+
+uint64_t SharedDeviceMemoryClient::issueCommandToSharedMemory(
 	ClientCommandType type,
 	uint32_t deviceIndex,
 	void* paramsStart,
 	uint32_t paramsSize
+) {
+	CommandKey key = { type, deviceIndex, getCommandPathOffset(type, paramsStart), commandApplyTime };
+	const uint8_t* params = static_cast<const uint8_t*>(paramsStart);
+	IssuedCommand issued = { this->nextCommandSequence.fetch_add(1), std::chrono::steady_clock::now() };
+	lastIssuedCommandSequence = issued.sequence;
+
+	std::lock_guard<std::mutex> lock(this->commandBufferMutex);
+
+	// A replaced command completes together with the command that replaced it, while events always queue their own
+	if (!isEventCommand(type)) {
+		auto existing = this->pendingCommandIndexes.find(key);
+		if (existing != this->pendingCommandIndexes.end()) {
+			PendingCommand& command = this->pendingCommands[existing->second];
+			command.params.assign(params, params + paramsSize);
+			clearParamsPadding(type, command.params);
+			command.issuedCommands.push_back(issued);
+			return issued.sequence;
+		}
+
+		this->pendingCommandIndexes[key] = this->pendingCommands.size();
+	}
+
+	this->pendingCommands.push_back({ key, std::vector<uint8_t>(params, params + paramsSize), { issued } });
+	clearParamsPadding(type, this->pendingCommands.back().params);
+	return issued.sequence;
+}
+
+void SharedDeviceMemoryClient::flushCommands() {
+	std::vector<CommandResult> completedResults;
+
+	{
+		std::lock_guard<std::mutex> lock(this->commandBufferMutex);
+		if (!this->initialized || this->batchOpen) return;
+
+		// Plugins replaced state the driver applied for us, so none of it can be trusted for redundancy checks
+		SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+		uint64_t pluginOverrideCount = headerPtr->pluginOverrideCount.load(std::memory_order_acquire);
+		if (pluginOverrideCount != this->seenPluginOverrideCount) {
+			this->seenPluginOverrideCount = pluginOverrideCount;
+			this->lastWrittenParams.clear();
+		}
+
+		if (this->batchCommitted) {
+			if (this->writePendingBatch(completedResults)) this->batchCommitted = false;
+		} else {
+			size_t flushedCount = 0;
+			for (; flushedCount < this->pendingCommands.size(); flushedCount++) {
+				PendingCommand& command = this->pendingCommands[flushedCount];
+				if (this->isRedundantCommand(command)) {
+					appendResults(command.issuedCommands, CommandStatus_Redundant, 0, completedResults);
+					continue;
+				}
+
+				uint64_t version = this->clientDriverLaneWriteCount;
+				bool written = this->writeCommandToClientDriverLane(
+					command.key.type,
+					command.key.deviceIndex,
+					command.params.data(),
+					static_cast<uint32_t>(command.params.size()),
+					command.issuedCommands.back().sequence,
+					command.key.applyTimeNanoseconds
+				);
+
+				// The lane is full, so keep the rest in order for the next flush
+				if (!written) break;
+
+				this->writtenCommands.push_back({ version, command.key, std::move(command.issuedCommands) });
+				this->recordWrittenParams(command, version);
+			}
+
+			this->pendingCommands.erase(this->pendingCommands.begin(), this->pendingCommands.begin() + flushedCount);
+
+			this->pendingCommandIndexes.clear();
+			for (size_t i = 0; i < this->pendingCommands.size(); i++) {
+				const CommandKey& key = this->pendingCommands[i].key;
+				if (!isEventCommand(key.type)) this->pendingCommandIndexes[key] = i;
+			}
+		}
+	}
+
+	if (!completedResults.empty()) this->completeCommands(completedResults);
+}
+
+void SharedDeviceMemoryClient::beginBatch() {
+	this->flushCommands();
+
+	std::lock_guard<std::mutex> lock(this->commandBufferMutex);
+	this->batchOpen = true;
+}
+
+void SharedDeviceMemoryClient::commitBatch() {
+	{
+		std::lock_guard<std::mutex> lock(this->commandBufferMutex);
+		if (!this->batchOpen) return;
+
+		this->batchOpen = false;
+		this->batchCommitted = true;
+	}
+
+	this->flushCommands();
+}
+
+bool SharedDeviceMemoryClient::writePendingBatch(std::vector<CommandResult>& completedResults) {
+	// Redundant commands are dropped up front so the frame carries its exact command count
+	std::vector<PendingCommand*> commands;
+	commands.reserve(this->pendingCommands.size());
+	for (PendingCommand& command : this->pendingCommands) {
+		if (!this->isRedundantCommand(command)) commands.push_back(&command);
+	}
+
+	if (!commands.empty()) {
+		uint32_t savedWriteOffset = this->clientDriverLaneWriteOffset;
+		uint64_t savedWriteCount = this->clientDriverLaneWriteCount;
+
+		CommandParams_BeginBatch beginParams = {};
+		beginParams.commandCount = static_cast<uint32_t>(commands.size());
+		bool written = this->writeCommandToClientDriverLane(
+			Command_BeginBatch,
+			0,
+			&beginParams,
+			sizeof(CommandParams_BeginBatch),
+			0,
+			0,
+			false
+		);
+
+		std::vector<uint64_t> versions(commands.size());
+		for (size_t i = 0; written && i < commands.size(); i++) {
+			versions[i] = this->clientDriverLaneWriteCount;
+			written = this->writeCommandToClientDriverLane(
+				commands[i]->key.type,
+				commands[i]->key.deviceIndex,
+				commands[i]->params.data(),
+				static_cast<uint32_t>(commands[i]->params.size()),
+				commands[i]->issuedCommands.back().sequence,
+				commands[i]->key.applyTimeNanoseconds,
+				false
+			);
+		}
+
+		CommandParams_CommitBatch commitParams = {};
+		commitParams.commandCount = beginParams.commandCount;
+		written = written && this->writeCommandToClientDriverLane(
+			Command_CommitBatch,
+			0,
+			&commitParams,
+			sizeof(CommandParams_CommitBatch),
+			0,
+			0,
+			false
+		);
+
+		// Nothing was published yet, so rewinding the local cursors discards the partial frame
+		if (!written) {
+			this->clientDriverLaneWriteOffset = savedWriteOffset;
+			this->clientDriverLaneWriteCount = savedWriteCount;
+			return false;
+		}
+
+		this->publishClientDriverLaneWrites();
+
+		for (size_t i = 0; i < commands.size(); i++) {
+			PendingCommand* command = commands[i];
+			this->writtenCommands.push_back({ versions[i], command->key, std::move(command->issuedCommands) });
+			this->recordWrittenParams(*command, versions[i]);
+		}
+	}
+
+	// Anything not moved out above was redundant
+	for (PendingCommand& command : this->pendingCommands) {
+		appendResults(command.issuedCommands, CommandStatus_Redundant, 0, completedResults);
+	}
+
+	this->pendingCommands.clear();
+	this->pendingCommandIndexes.clear();
+	return true;
+}
+
+bool SharedDeviceMemoryClient::isRedundantCommand(const PendingCommand& command) {
+	if (!isStateCommand(command.key.type) || command.key.applyTimeNanoseconds != 0) return false;
+
+	auto lastWritten = this->lastWrittenParams.find(command.key);
+	return lastWritten != this->lastWrittenParams.end() && lastWritten->second.applied &&
+		lastWritten->second.params == command.params;
+}
+
+void SharedDeviceMemoryClient::recordWrittenParams(PendingCommand& command, uint64_t version) {
+	if (!isStateCommand(command.key.type)) return;
+
+	// Not trusted until the driver acknowledges it as applied, so resending the same params meanwhile still goes out
+	if (command.key.applyTimeNanoseconds == 0) {
+		this->lastWrittenParams[command.key] = { version, std::move(command.params), false };
+		return;
+	}
+
+	// A scheduled command changes the state later on, so the next immediate command can't be assumed redundant
+	CommandKey immediateKey = command.key;
+	immediateKey.applyTimeNanoseconds = 0;
+	this->lastWrittenParams.erase(immediateKey);
+}
+
+void SharedDeviceMemoryClient::recordCommandStatus(const WrittenCommand& command, CommandStatus status) {
+	if (!isStateCommand(command.key.type) || command.key.applyTimeNanoseconds != 0) return;
+
+	// A later command of the same key is still in flight, and its own ack decides
+	auto lastWritten = this->lastWrittenParams.find(command.key);
+	if (lastWritten == this->lastWrittenParams.end() || lastWritten->second.version != command.version) return;
+
+	// A command that didn't apply leaves the driver state unknown, so the next identical command has to go out
+	if (status == CommandStatus_Applied) {
+		lastWritten->second.applied = true;
+	} else {
+		this->lastWrittenParams.erase(lastWritten);
+	}
+}
+
+void SharedDeviceMemoryClient::forgetWrittenParams(uint32_t deviceIndex) {
+	std::lock_guard<std::mutex> lock(this->commandBufferMutex);
+
+	for (auto it = this->lastWrittenParams.begin(); it != this->lastWrittenParams.end();) {
+		if (it->first.deviceIndex == deviceIndex) {
+			it = this->lastWrittenParams.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+void SharedDeviceMemoryClient::pollForCommandAcks() {
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+	uint64_t ackCount = headerPtr->commandAckCount.load(std::memory_order_acquire);
+
+	const CommandStatusEntry* ring = reinterpret_cast<const CommandStatusEntry*>(
+		static_cast<uint8_t*>(this->sharedMemory) + this->commandStatusRingStart
+	);
+
+	std::vector<CommandResult> completedResults;
+
+	{
+		std::lock_guard<std::mutex> lock(this->commandBufferMutex);
+
+		// Reads the status entry of a command, returning false if the driver is writing it right now
+		auto readStatus = [&](const WrittenCommand& command, CommandStatus* status, int64_t* appliedTime) {
+			const CommandStatusEntry& entry = ring[command.version % COMMAND_STATUS_RING_SIZE];
+
+			uint64_t versionBefore = entry.version.load(std::memory_order_acquire);
+			*status = static_cast<CommandStatus>(entry.status);
+			*appliedTime = entry.appliedTimeNanoseconds;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t versionAfter = entry.version.load(std::memory_order_relaxed);
+
+			if (versionBefore == COMMAND_STATUS_WRITING_VERSION || versionBefore != versionAfter) return false;
+
+			// A mismatched version means the command was lost in the lane or its entry was already reused
+			if (versionBefore != command.version) *status = CommandStatus_Dropped;
+			return true;
+		};
+
+		CommandStatus status;
+		int64_t appliedTime;
+
+		while (!this->writtenCommands.empty() && this->writtenCommands.front().version < ackCount) {
+			WrittenCommand& command = this->writtenCommands.front();
+			if (!readStatus(command, &status, &appliedTime)) break;
+
+			if (status == CommandStatus_Scheduled) {
+				this->scheduledCommands.push_back(std::move(command));
+			} else {
+				this->recordCommandStatus(command, status);
+				appendResults(command.issuedCommands, status, appliedTime, completedResults);
+			}
+
+			this->writtenCommands.pop_front();
+		}
+
+		// Scheduled commands complete whenever the driver reaches their apply time, regardless of lane order
+		size_t stillScheduled = 0;
+		for (size_t i = 0; i < this->scheduledCommands.size(); i++) {
+			WrittenCommand& command = this->scheduledCommands[i];
+
+			if (!readStatus(command, &status, &appliedTime) || status == CommandStatus_Scheduled) {
+				if (stillScheduled != i) this->scheduledCommands[stillScheduled] = std::move(command);
+				stillScheduled++;
+				continue;
+			}
+
+			appendResults(command.issuedCommands, status, appliedTime, completedResults);
+		}
+		this->scheduledCommands.erase(this->scheduledCommands.begin() + stillScheduled, this->scheduledCommands.end());
+	}
+
+	if (!completedResults.empty()) this->completeCommands(completedResults);
+}
+
+void SharedDeviceMemoryClient::appendResults(
+	const std::vector<IssuedCommand>& issuedCommands,
+	CommandStatus status,
+	int64_t appliedTimeNanoseconds,
+	std::vector<CommandResult>& results
+) {
+	for (const IssuedCommand& issued : issuedCommands) {
+		CommandResult result;
+		result.sequence = issued.sequence;
+		result.status = status;
+
+		// steady_clock reads the same system wide counter in every process, so driver timestamps are comparable
+		if (status == CommandStatus_Applied) {
+			int64_t issuedTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				issued.issueTime.time_since_epoch()
+			).count();
+			result.latencyMicroseconds = (std::max)(0.0, (appliedTimeNanoseconds - issuedTime) / 1000.0);
+		}
+
+		results.push_back(result);
+	}
+}
+
+void SharedDeviceMemoryClient::completeCommands(const std::vector<CommandResult>& results) {
+	std::vector<std::pair<std::promise<CommandResult>, CommandResult>> readyPromises;
+	std::function<void(const CommandResult&)> callback;
+
+	{
+		std::lock_guard<std::mutex> lock(this->completionMutex);
+
+		for (const CommandResult& result : results) {
+			this->recentResults[result.sequence % COMMAND_STATUS_RING_SIZE] = result;
+			this->highestCompletedSequence = (std::max)(this->highestCompletedSequence, result.sequence);
+
+			auto promises = this->completionPromises.find(result.sequence);
+			if (promises == this->completionPromises.end()) continue;
+
+			for (std::promise<CommandResult>& promise : promises->second) {
+				readyPromises.emplace_back(std::move(promise), result);
+			}
+			this->completionPromises.erase(promises);
+		}
+
+		callback = this->completionCallback;
+	}
+
+	for (auto& readyPromise : readyPromises) readyPromise.first.set_value(readyPromise.second);
+
+	if (callback) {
+		for (const CommandResult& result : results) callback(result);
+	}
+}
+
+std::future<CommandResult> SharedDeviceMemoryClient::getCommandCompletion(uint64_t sequence) {
+	std::promise<CommandResult> promise;
+	std::future<CommandResult> future = promise.get_future();
+
+	std::lock_guard<std::mutex> lock(this->completionMutex);
+
+	const CommandResult& recent = this->recentResults[sequence % COMMAND_STATUS_RING_SIZE];
+	if (sequence != 0 && recent.sequence == sequence) {
+		promise.set_value(recent);
+		return future;
+	}
+
+	// Unknown sequences, and completions too old to still be remembered, can't be waited on
+	if (sequence == 0 ||
+		sequence >= this->nextCommandSequence.load() ||
+		sequence + COMMAND_STATUS_RING_SIZE <= this->highestCompletedSequence
+	) {
+		CommandResult result;
+		result.sequence = sequence;
+		result.status = CommandStatus_Dropped;
+		promise.set_value(result);
+		return future;
+	}
+
+	this->completionPromises[sequence].push_back(std::move(promise));
+	return future;
+}
+
+void SharedDeviceMemoryClient::setCommandCompletionCallback(std::function<void(const CommandResult&)> callback) {
+	std::lock_guard<std::mutex> lock(this->completionMutex);
+	this->completionCallback = std::move(callback);
+}
+
+bool SharedDeviceMemoryClient::uploadAnimationTrack(
+	uint32_t trackId,
+	AnimationTrackType type,
+	const void* keyframes,
+	uint32_t keyframeSize,
+	uint32_t keyframeCount
+) {
+	if (!this->initialized || trackId >= MAX_ANIMATION_TRACKS || keyframeCount == 0) return false;
+	if (static_cast<uint64_t>(keyframeSize) * keyframeCount > ANIMATION_TRACK_SLOT_SIZE) return false;
+
+	std::lock_guard<std::mutex> lock(this->animationUploadMutex);
+
+	// The driver copies a track out of its slot when loading it, so the slot is free once the last load completes
+	uint64_t lastLoadSequence = this->animationLoadSequences[trackId];
+	if (lastLoadSequence != 0) {
+		this->flushCommands();
+
+		std::future<CommandResult> lastLoad = this->getCommandCompletion(lastLoadSequence);
+		if (lastLoad.wait_for(std::chrono::milliseconds(ANIMATION_UPLOAD_TIMEOUT_MS)) != std::future_status::ready) {
+			return false;
+		}
+	}
+
+	uint8_t* slot = static_cast<uint8_t*>(this->sharedMemory) + this->animationBlobStart +
+		static_cast<size_t>(trackId) * ANIMATION_TRACK_SLOT_SIZE;
+	memcpy(slot, keyframes, static_cast<size_t>(keyframeSize) * keyframeCount);
+
+	// Publishing the command releases the slot contents along with it
+	CommandParams_LoadAnimationTrack params = {};
+	params.trackId = trackId;
+	params.type = type;
+	params.keyframeCount = keyframeCount;
+
+	this->animationLoadSequences[trackId] = this->issueCommandToSharedMemory(
+		Command_LoadAnimationTrack,
+		0,
+		&params,
+		sizeof(CommandParams_LoadAnimationTrack)
+	);
+	return true;
+}
+
+void SharedDeviceMemoryClient::setCommandApplyTime(int64_t applyTimeNanoseconds) {
+	commandApplyTime = applyTimeNanoseconds;
+}
+
+uint64_t SharedDeviceMemoryClient::getLastIssuedCommandSequence() {
+	return lastIssuedCommandSequence;
+}
+
+uint32_t SharedDeviceMemoryClient::getCommandPathOffset(ClientCommandType type, const void* paramsStart) {
+	switch (type) {
+	case Command_SetUseOverriddenStateDevicePose:
+	case Command_SetOverriddenStateDevicePose:
+	case Command_SetPoseTransformRules:
+	case Command_SetPoseSmoothingFilter:
+	case Command_PlayPoseAnimation:
+	case Command_SetPoseExtrapolation:
+		return UINT32_MAX;
+	case Command_LoadAnimationTrack:
+		// Loads are keyed by track id instead, so loads of different tracks never replace eachother
+		return static_cast<const CommandParams_LoadAnimationTrack*>(paramsStart)->trackId;
+	// Override params put the input path offset after the value, so the offset has to be read from its own field
+	case Command_SetUseOverriddenStateDeviceInput:
+		return static_cast<const CommandParams_SetUseOverriddenStateDeviceInput*>(paramsStart)->inputPathOffset;
+	case Command_SetOverriddenStateDeviceInputBoolean:
+		return static_cast<const CommandParams_SetOverriddenStateDeviceInputBoolean*>(paramsStart)->inputPathOffset;
+	case Command_SetOverriddenStateDeviceInputScalar:
+		return static_cast<const CommandParams_SetOverriddenStateDeviceInputScalar*>(paramsStart)->inputPathOffset;
+	case Command_SetOverriddenStateDeviceInputSkeleton:
+		return static_cast<const CommandParams_SetOverriddenStateDeviceInputSkeleton*>(paramsStart)->inputPathOffset;
+	case Command_SetOverriddenStateDeviceInputPose:
+		return static_cast<const CommandParams_SetOverriddenStateDeviceInputPose*>(paramsStart)->inputPathOffset;
+	case Command_SetOverriddenStateDeviceInputEyeTracking:
+		return static_cast<const CommandParams_SetOverriddenStateDeviceInputEyeTracking*>(paramsStart)->inputPathOffset;
+	default:
+		// The remaining commands that target an input start their params with the input path offset
+		return *static_cast<const uint32_t*>(paramsStart);
+	}
+}
+
+bool SharedDeviceMemoryClient::isStateCommand(ClientCommandType type) {
+	switch (type) {
+	case Command_SetUseOverriddenStateDevicePose:
+	case Command_SetOverriddenStateDevicePose:
+	case Command_SetUseOverriddenStateDeviceInput:
+	case Command_SetOverriddenStateDeviceInputBoolean:
+	case Command_SetOverriddenStateDeviceInputScalar:
+	case Command_SetOverriddenStateDeviceInputSkeleton:
+	case Command_SetOverriddenStateDeviceInputPose:
+	case Command_SetOverriddenStateDeviceInputEyeTracking:
+	case Command_SetHapticSuppression:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool SharedDeviceMemoryClient::isEventCommand(ClientCommandType type) {
+	return type == Command_InjectHapticPulse;
+}
+
+void SharedDeviceMemoryClient::clearParamsPadding(ClientCommandType type, std::vector<uint8_t>& params) {
+	switch (type) {
+	case Command_SetOverriddenStateDevicePose:
+		rebuildParams<CommandParams_SetOverriddenStateDevicePose>(params, [](const auto& from, auto& to) {
+			to.overriddenPose = from.overriddenPose;
+			to.fieldMask = from.fieldMask;
+		});
+		break;
+	case Command_SetUseOverriddenStateDeviceInput:
+		rebuildParams<CommandParams_SetUseOverriddenStateDeviceInput>(params, [](const auto& from, auto& to) {
+			to.useOverriddenState = from.useOverriddenState;
+			to.inputPathOffset = from.inputPathOffset;
+		});
+		break;
+	case Command_SetOverriddenStateDeviceInputBoolean:
+		rebuildParams<CommandParams_SetOverriddenStateDeviceInputBoolean>(params, [](const auto& from, auto& to) {
+			to.overriddenValue.value = from.overriddenValue.value;
+			to.overriddenValue.timeOffset = from.overriddenValue.timeOffset;
+			to.inputPathOffset = from.inputPathOffset;
+		});
+		break;
+	case Command_SetOverriddenStateDeviceInputScalar:
+		rebuildParams<CommandParams_SetOverriddenStateDeviceInputScalar>(params, [](const auto& from, auto& to) {
+			to.overriddenValue.value = from.overriddenValue.value;
+			to.overriddenValue.timeOffset = from.overriddenValue.timeOffset;
+			to.inputPathOffset = from.inputPathOffset;
+		});
+		break;
+	case Command_SetOverriddenStateDeviceInputSkeleton:
+		rebuildParams<CommandParams_SetOverriddenStateDeviceInputSkeleton>(params, [](const auto& from, auto& to) {
+			const SkeletonInput& skeleton = from.overriddenValue;
+			to.overriddenValue.motionRange = skeleton.motionRange;
+			std::copy(
+				std::begin(skeleton.boneTransforms),
+				std::end(skeleton.boneTransforms),
+				to.overriddenValue.boneTransforms
+			);
+			to.overriddenValue.boneTransformCount = skeleton.boneTransformCount;
+			to.inputPathOffset = from.inputPathOffset;
+			to.boneMask = from.boneMask;
+		});
+		break;
+	case Command_SetOverriddenStateDeviceInputPose:
+		rebuildParams<CommandParams_SetOverriddenStateDeviceInputPose>(params, [](const auto& from, auto& to) {
+			to.overriddenValue = from.overriddenValue;
+			to.inputPathOffset = from.inputPathOffset;
+		});
+		break;
+	case Command_SetOverriddenStateDeviceInputEyeTracking:
+		rebuildParams<CommandParams_SetOverriddenStateDeviceInputEyeTracking>(params, [](const auto& from, auto& to) {
+			const EyeTrackingData& eyeTracking = from.overriddenValue.eyeTrackingData;
+			to.overriddenValue.eyeTrackingData.active = eyeTracking.active;
+			to.overriddenValue.eyeTrackingData.valid = eyeTracking.valid;
+			to.overriddenValue.eyeTrackingData.tracked = eyeTracking.tracked;
+			to.overriddenValue.eyeTrackingData.gazeOrigin = eyeTracking.gazeOrigin;
+			to.overriddenValue.eyeTrackingData.gazeTarget = eyeTracking.gazeTarget;
+			to.overriddenValue.timeOffset = from.overriddenValue.timeOffset;
+			to.inputPathOffset = from.inputPathOffset;
+		});
+		break;
+	case Command_SetHapticSuppression:
+		rebuildParams<CommandParams_SetHapticSuppression>(params, [](const auto& from, auto& to) {
+			to.inputPathOffset = from.inputPathOffset;
+			to.suppressed = from.suppressed;
+		});
+		break;
+	default:
+		break;
+	}
+}
+
+bool SharedDeviceMemoryClient::writeCommandToClientDriverLane(
+	ClientCommandType type,
+	uint32_t deviceIndex,
+	const void* paramsStart,
+	uint32_t paramsSize,
+	uint64_t sequence,
+	int64_t applyTimeNanoseconds,
+	bool publish
 ) {
 	uint32_t totalSize = 0;
 	switch (type) {
@@ -287,57 +1193,96 @@ void SharedDeviceMemoryClient::issueCommandToSharedMemory(
 		totalSize = sizeof(CommandParams_SetOverriddenStateDeviceInputPose); break;
 	case Command_SetOverriddenStateDeviceInputEyeTracking:
 		totalSize = sizeof(CommandParams_SetOverriddenStateDeviceInputEyeTracking); break;
+	case Command_SetPoseTransformRules:
+		totalSize = sizeof(CommandParams_SetPoseTransformRules); break;
+	case Command_SetInputTransformRules:
+		totalSize = sizeof(CommandParams_SetInputTransformRules); break;
+	case Command_LoadInputFilterProgram:
+		totalSize = sizeof(CommandParams_LoadInputFilterProgram); break;
+	case Command_SetPoseSmoothingFilter:
+		totalSize = sizeof(CommandParams_SetPoseSmoothingFilter); break;
+	case Command_SetScalarSmoothingFilter:
+		totalSize = sizeof(CommandParams_SetScalarSmoothingFilter); break;
+	case Command_BeginBatch:
+		totalSize = sizeof(CommandParams_BeginBatch); break;
+	case Command_CommitBatch:
+		totalSize = sizeof(CommandParams_CommitBatch); break;
+	case Command_LoadAnimationTrack:
+		totalSize = sizeof(CommandParams_LoadAnimationTrack); break;
+	case Command_PlayPoseAnimation:
+		totalSize = sizeof(CommandParams_PlayPoseAnimation); break;
+	case Command_PlayInputAnimation:
+		totalSize = sizeof(CommandParams_PlayInputAnimation); break;
+	case Command_SetPoseExtrapolation:
+		totalSize = sizeof(CommandParams_SetPoseExtrapolation); break;
+	case Command_InjectHapticPulse:
+		totalSize = sizeof(CommandParams_InjectHapticPulse); break;
+	case Command_SetHapticSuppression:
+		totalSize = sizeof(CommandParams_SetHapticSuppression); break;
 	}
 	totalSize += sizeof(ClientCommandHeader);
 	std::vector<uint8_t> buffer(totalSize);
 
 	ClientCommandHeader* header = reinterpret_cast<ClientCommandHeader*>(buffer.data());
 	header->alignmentCheck = ALIGNMENT_CONSTANT;
-    header->type = type;
-    header->deviceIndex = deviceIndex;
-    header->version = this->clientDriverLaneWriteCount;
-	header->committed.store(false, std::memory_order_relaxed);
+    header->type = static_cast<uint8_t>(type);
+    header->deviceIndex = static_cast<uint8_t>(deviceIndex);
+    header->version = static_cast<uint32_t>(this->clientDriverLaneWriteCount);
+	header->sequence = sequence;
+	header->applyTimeNanoseconds = applyTimeNanoseconds;
 
 	memcpy(buffer.data() + sizeof(ClientCommandHeader), paramsStart, paramsSize);
 
-	this->writePacketToClientDriverLane(buffer.data(), totalSize);
+	return this->writePacketToClientDriverLane(buffer.data(), totalSize, publish);
 }
 
-void SharedDeviceMemoryClient::writePacketToClientDriverLane(void* packet, uint32_t packetSize) {
-	if (!packet || packetSize <= 0) return;
+bool SharedDeviceMemoryClient::writePacketToClientDriverLane(void* packet, uint32_t packetSize, bool publish) {
+	if (!packet || packetSize <= 0) return false;
 
 	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
 
-	uint32_t readOffset = headerPtr->clientDriverReadOffset.load(std::memory_order_acquire);
 	uint32_t writeOffset = this->clientDriverLaneWriteOffset;
+	uint32_t frameStride = getFrameStride(packetSize);
 
-	uint32_t freeSpace = writeOffset >= readOffset
-		? (LANE_SIZE - writeOffset) + readOffset
-		: readOffset - writeOffset;
+	// The cached read offset only ever lags the real one, so the lane is only refreshed when it looks full
+	if (!hasLaneSpace(writeOffset, this->cachedClientDriverReadOffset, frameStride, this->mirroredLanes)) {
+		this->cachedClientDriverReadOffset = headerPtr->clientDriverReadOffset.load(std::memory_order_acquire);
+		if (!hasLaneSpace(writeOffset, this->cachedClientDriverReadOffset, frameStride, this->mirroredLanes)) {
+			return false;
+		}
+	}
 
-	if (packetSize > freeSpace) return;
+	ClientCommandHeader* frame = reinterpret_cast<ClientCommandHeader*>(packet);
+	frame->frameSize = packetSize;
+	frame->checksum = computeFrameChecksum(frame);
 
-	uint8_t* laneStart = static_cast<uint8_t*>(this->sharedMemory) + this->clientDriverLaneStart;
+	uint8_t* laneStart = this->clientDriverLane;
 
+	// Mirrored lanes run on into their second view instead of wrapping early
 	uint8_t* currentWriteStart;
 	uint32_t newWriteOffset;
-	if (this->clientDriverLaneWriteOffset >= LANE_SIZE - LANE_PADDING_SIZE) {
+	if (!this->mirroredLanes && this->clientDriverLaneWriteOffset >= LANE_SIZE - LANE_PADDING_SIZE) {
+		memcpy(laneStart + this->clientDriverLaneWriteOffset, &WRAP_MARKER_CONSTANT, sizeof(uint32_t));
 		currentWriteStart = laneStart;
-		newWriteOffset = packetSize;
+		newWriteOffset = frameStride;
 	} else {
 		currentWriteStart = laneStart + this->clientDriverLaneWriteOffset;
-		newWriteOffset = this->clientDriverLaneWriteOffset + packetSize;
+		newWriteOffset = (this->clientDriverLaneWriteOffset + frameStride) % LANE_SIZE;
 	}
 
-	memcpy(currentWriteStart, packet, packetSize);
-
-	ClientCommandHeader* header = reinterpret_cast<ClientCommandHeader*>(currentWriteStart);
-	header->committed.store(true, std::memory_order_release);
+	writeFrame(currentWriteStart, packet, packetSize);
 
 	this->clientDriverLaneWriteOffset = newWriteOffset;
-	headerPtr->clientDriverWriteOffset.store(this->clientDriverLaneWriteOffset, std::memory_order_release);
-
 	this->clientDriverLaneWriteCount++;
+
+	if (publish) this->publishClientDriverLaneWrites();
+	return true;
+}
+
+void SharedDeviceMemoryClient::publishClientDriverLaneWrites() {
+	SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);
+
+	headerPtr->clientDriverWriteOffset.store(this->clientDriverLaneWriteOffset, std::memory_order_release);
 	headerPtr->clientDriverWriteCount.store(this->clientDriverLaneWriteCount, std::memory_order_release);
 }
 
@@ -345,42 +1290,55 @@ std::pair<ObjectEntryData, std::pair<ObjectType, std::unique_ptr<uint8_t[]>>>
 SharedDeviceMemoryClient::readPacketFromDriverClientLane() {
     SharedMemoryHeader* headerPtr = reinterpret_cast<SharedMemoryHeader*>(this->sharedMemory);    
 	
-	if (this->driverClientLaneReadOffset >= LANE_SIZE - LANE_PADDING_SIZE) this->driverClientLaneReadOffset = 0;
+	// The cached write offset only ever lags the real one, so the lane is only refreshed when it looks empty
+	if (this->driverClientLaneReadOffset == this->cachedDriverClientWriteOffset) {
+		this->cachedDriverClientWriteOffset = headerPtr->driverClientWriteOffset.load(std::memory_order_acquire);
+	}
 
-	uint32_t writeOffset = headerPtr->driverClientWriteOffset.load(std::memory_order_acquire);
+	uint32_t writeOffset = this->cachedDriverClientWriteOffset;
 	if (this->driverClientLaneReadOffset == writeOffset) return { ObjectEntryData{}, { Object_DevicePose, nullptr } };
 
+	// The writer left a wrap marker here and continued from the start of the lane
+	if (!this->mirroredLanes && this->driverClientLaneReadOffset >= LANE_SIZE - LANE_PADDING_SIZE) {
+		this->driverClientLaneReadOffset = 0;
+		if (this->driverClientLaneReadOffset == writeOffset)
+			return { ObjectEntryData{}, { Object_DevicePose, nullptr } };
+	}
+
     // Read ObjectEntry
-	uint8_t* laneStart = static_cast<uint8_t*>(this->sharedMemory) + this->driverClientLaneStart;
+	uint8_t* laneStart = this->driverClientLane;
     uint8_t* readStart = laneStart + this->driverClientLaneReadOffset;
     ObjectEntry* rawEntry = reinterpret_cast<ObjectEntry*>(readStart);
 
-	// Misalignment correction
+	// Misalignment correction. The magic is written last, so an entry that validates is also fully written
 	if (!this->isValidObjectPacket(rawEntry, headerPtr) &&
 		!this->realignReadHeader(headerPtr, laneStart, &readStart, writeOffset, &rawEntry))
 		return { ObjectEntryData{}, { Object_DevicePose, nullptr } };
 
-	// Wait for packet to be valid
-	auto start = std::chrono::high_resolution_clock::now();
-	while (!rawEntry->committed.load(std::memory_order_acquire)) {
-		auto now = std::chrono::high_resolution_clock::now();
-		if (std::chrono::duration_cast<std::chrono::microseconds>(now - start).count() > COMMIT_FLAG_TIMEOUT_US) {
-			if (!this->realignReadHeader(headerPtr, laneStart, &readStart, writeOffset, &rawEntry))
-				return { ObjectEntryData{}, { Object_DevicePose, nullptr } };
-		}
-	}
-
 	ObjectEntryData entry = {};
 	entry.successful = true;
-	entry.type = rawEntry->type;
+	entry.type = static_cast<ObjectType>(rawEntry->type);
 	entry.deviceIndex = rawEntry->deviceIndex;
 	entry.inputPathOffset = rawEntry->inputPathOffset;
-	entry.version = rawEntry->version;
+	entry.version = widenFrameVersion(rawEntry->version, this->driverClientLaneReadCount);
 	entry.valid = rawEntry->valid;
 
-    // Read object data
-    uint32_t dataSize = 0;
+    // Read object data, whose size was checked against the frame size when the entry was validated
 	ObjectType type = entry.type;
+    uint32_t dataSize = getObjectDataSize(type);
+
+    auto dataBuffer = std::make_unique<uint8_t[]>(dataSize);
+    memcpy(dataBuffer.get(), readStart + sizeof(ObjectEntry), dataSize);
+
+    uint32_t frameStride = getFrameStride(rawEntry->frameSize);
+    this->driverClientLaneReadOffset = (this->driverClientLaneReadOffset + frameStride) % LANE_SIZE;
+    headerPtr->driverClientReadOffset.store(this->driverClientLaneReadOffset, std::memory_order_release);
+
+    return std::make_pair(entry, std::make_pair(type, std::move(dataBuffer)));
+}
+
+uint32_t SharedDeviceMemoryClient::getObjectDataSize(ObjectType type) {
+    uint32_t dataSize = 0;
     switch (type) {
     case Object_DevicePose:
         dataSize = sizeof(DevicePoseSerialized); break;
@@ -395,14 +1353,7 @@ SharedDeviceMemoryClient::readPacketFromDriverClientLane() {
     case Object_InputEyeTracking:
         dataSize = sizeof(DeviceInputEyeTrackingSerialized); break;
     }
-
-    auto dataBuffer = std::make_unique<uint8_t[]>(dataSize);
-    memcpy(dataBuffer.get(), readStart + sizeof(ObjectEntry), dataSize);
-
-    this->driverClientLaneReadOffset += sizeof(ObjectEntry) + dataSize;
-    headerPtr->driverClientReadOffset.store(this->driverClientLaneReadOffset, std::memory_order_release);
-
-    return std::make_pair(entry, std::make_pair(type, std::move(dataBuffer)));
+    return dataSize;
 }
 
 bool SharedDeviceMemoryClient::realignReadHeader(
@@ -412,29 +1363,40 @@ bool SharedDeviceMemoryClient::realignReadHeader(
 	uint32_t writeOffset,
 	ObjectEntry** output
 ) {
-	uint32_t searchOffset = this->driverClientLaneReadOffset;
-
-	const uint32_t FORWARD_SEARCH_BYTES = 4096;
+	uint32_t searchOffset = getFrameStride(this->driverClientLaneReadOffset + 1);
+
+	// Strategy 1: Forward Check, stepping frame boundaries and only validating candidates that start with the magic.
+	// Bounded to a single pass over the lane in case stale wrap markers keep sending the search back to the start
+	for (uint32_t i = 0; i < LANE_SIZE / FRAME_ALIGNMENT && searchOffset != writeOffset; i++) {
+		if (searchOffset >= LANE_SIZE) {
+			searchOffset = 0;
+			continue;
+		}
 
-	// Strategy 1: Forward Check
-	for (uint32_t i = 0; i < FORWARD_SEARCH_BYTES; i++) {
-		searchOffset = (searchOffset + 1) % LANE_SIZE;
+		uint32_t magic;
+		memcpy(&magic, laneStart + searchOffset, sizeof(uint32_t));
 
-		if (searchOffset == writeOffset) break;
+		if (!this->mirroredLanes && searchOffset >= LANE_SIZE - LANE_PADDING_SIZE && magic == WRAP_MARKER_CONSTANT) {
+			searchOffset = 0;
+			continue;
+		}
 
 		ObjectEntry* testEntry = reinterpret_cast<ObjectEntry*>(laneStart + searchOffset);
 
-		if (this->isValidObjectPacket(testEntry, headerPtr)) {
+		if (magic == ALIGNMENT_CONSTANT && this->isValidObjectPacket(testEntry, headerPtr)) {
 			this->driverClientLaneReadOffset = searchOffset;
 			*readStart = laneStart + searchOffset;
 			*output = testEntry;
 			return true;
 		}
+
+		searchOffset += FRAME_ALIGNMENT;
 	}
 
 	// Strategy 2: Jump To Write Offset
 	this->driverClientLaneReadOffset = headerPtr->driverClientWriteOffset.load(std::memory_order_acquire);
 	this->driverClientLaneReadCount = headerPtr->driverClientWriteCount.load(std::memory_order_acquire);
+	this->cachedDriverClientWriteOffset = this->driverClientLaneReadOffset;
 	return false;
 }
 
@@ -445,25 +1407,12 @@ bool SharedDeviceMemoryClient::isValidObjectPacket(const ObjectEntry* entry, con
 
 	if (!(0 <= entry->deviceIndex && entry->deviceIndex < 64)) return false;
 
-	// Valid characters are [a-z]+[A-Z]+[/]
-	if (entry->type != Object_DevicePose) {
-		if (!(0 <= entry->inputPathOffset && entry->inputPathOffset <= PATH_TABLE_SIZE)) return false;
+	if (entry->type != Object_DevicePose && entry->inputPathOffset >= PATH_TABLE_SIZE) return false;
 
-		std::string inputPath = this->getPathFromPathOffset(entry->inputPathOffset);
+	if (entry->frameSize != sizeof(ObjectEntry) + getObjectDataSize(static_cast<ObjectType>(entry->type))) return false;
 
-		for (size_t i = 0; i < MAX_PATH_LENGTH; i++) {
-			char c = inputPath[i];
-			
-			if (c == '\0') break;
-
-			if (!((c >= 'a' && c <= 'z') || 
-			      (c >= 'A' && c <= 'Z') || 
-			      (c >= '0' && c <= '9') || 
-			      c == '/')) {
-				return false;
-			}
-		}
-	}
+	// Checked last, and only once everything else fits, so a resync scan rarely pays for it
+	if (entry->checksum != computeFrameChecksum(entry)) return false;
 
 	return true;
 }
\ No newline at end of file
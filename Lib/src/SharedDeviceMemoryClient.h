@@ -4,8 +4,16 @@
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <future>
+#include <functional>
+#include <optional>
 
 #include "ObjectSchemas.h"
+#include "LaneFraming.h"
 #include "DeviceStateModelClient.h"
 
 /**
@@ -31,14 +39,91 @@ public:
 	int initialize();
 
 	/**
-	 * @brief Handles serializing and writing a command header and command params to the shared memory safely and
-	 * with adherence to the protocol
+	 * @brief Returns how the shared memory was mapped into this process. When the driver locked its mapping, the
+	 * client prefaults and locks its own view during initialize() as well
+	 * @return The mapping stats
+	 */
+	SharedMemoryMappingStats getMappingStats();
+
+	/**
+	 * @brief Queues a command in the command buffer, replacing any pending command with the same type, device index
+	 * and input path so only the latest value is written. The buffer is written to the shared memory on the next
+	 * flush, either from the poll loop or from flushCommands()
 	 * @param type The type of command being issued
 	 * @param deviceIndex The index of the device this command is related to
 	 * @param paramsStart A pointer to the params struct corresponding to <type>
 	 * @param paramsSize The size in bytes of the params being supplied
+	 * @return The sequence id of the command
+	 */
+	uint64_t issueCommandToSharedMemory(
+		ClientCommandType type,
+		uint32_t deviceIndex,
+		void* paramsStart,
+		uint32_t paramsSize
+	);
+
+	/**
+	 * @brief Writes all pending commands in the command buffer to the shared memory in the order they were first
+	 * queued, skipping state commands identical to the last value written for the same target. Commands that don't
+	 * fit in the client-driver lane stay pending for the next flush
+	 */
+	void flushCommands();
+
+	/**
+	 * @brief Opens a batch, flushing any commands queued before it. Commands queued until commitBatch() are held back
+	 * and written together as one transaction frame
 	 */
-	void issueCommandToSharedMemory(ClientCommandType type, uint32_t deviceIndex, void* paramsStart, uint32_t paramsSize);
+	void beginBatch();
+
+	/**
+	 * @brief Closes the open batch and writes it to the shared memory as one transaction frame, published with a
+	 * single write count release. If the lane is full the batch stays pending for the next flush
+	 */
+	void commitBatch();
+
+	/**
+	 * @brief Returns a future that completes once the driver has processed a command
+	 * @param sequence The sequence id of the command
+	 * @return The future, already completed with CommandStatus_Dropped if the sequence id is unknown or too old
+	 */
+	std::future<CommandResult> getCommandCompletion(uint64_t sequence);
+
+	/**
+	 * @brief Sets a callback invoked from the poll thread with the result of every completed command
+	 * @param callback The callback, or an empty function to remove it
+	 */
+	void setCommandCompletionCallback(std::function<void(const CommandResult&)> callback);
+
+	/**
+	 * @brief Copies a keyframe track into its upload slot in the animation blob region and issues the command that
+	 * loads it into the driver. If the slot is still being loaded from a previous upload, waits for that load first
+	 * @param trackId The id of the track
+	 * @param type The type of the track
+	 * @param keyframes Pointer to the keyframes, sorted by time
+	 * @param keyframeSize The size in bytes of a single keyframe
+	 * @param keyframeCount The number of keyframes
+	 * @return True if the track was uploaded, false if it doesn't fit in a slot or the previous load didn't complete
+	 */
+	bool uploadAnimationTrack(
+		uint32_t trackId,
+		AnimationTrackType type,
+		const void* keyframes,
+		uint32_t keyframeSize,
+		uint32_t keyframeCount
+	);
+
+	/**
+	 * @brief Sets the apply time of the commands issued by the calling thread from now on. The driver holds such
+	 * commands back and applies them from the first hook call at or after that time
+	 * @param applyTimeNanoseconds The steady clock time in nanoseconds, or 0 to apply commands as soon as they arrive
+	 */
+	void setCommandApplyTime(int64_t applyTimeNanoseconds);
+
+	/**
+	 * @brief Returns the sequence id of the last command issued by the calling thread
+	 * @return The sequence id, or 0 if the thread has not issued a command
+	 */
+	uint64_t getLastIssuedCommandSequence();
 
 	/**
 	 * @brief Returns the path found at a given offset in the path table
@@ -54,6 +139,42 @@ public:
 	 */
 	uint32_t getOffsetOfPath(const std::string& path);
 
+	/**
+	 * @brief Returns the properties of a device from the device registry
+	 * @param deviceIndex The device index of the device
+	 * @return The properties, or std::nullopt if the driver hasn't seen the device
+	 */
+	std::optional<DeviceInfo> getDeviceInfo(uint32_t deviceIndex);
+
+	/**
+	 * @brief Returns the class of a device from the device registry
+	 * @param deviceIndex The device index of the device
+	 * @return The class, or DeviceClass_Invalid if the driver hasn't seen the device
+	 */
+	DeviceClass getDeviceClass(uint32_t deviceIndex);
+
+	/**
+	 * @brief Returns a mask of the devices of a class, where bit N is set if device index N has the class
+	 * @param deviceClass The class
+	 * @return The mask
+	 */
+	uint64_t getDeviceClassMask(DeviceClass deviceClass);
+
+	/**
+	 * @brief Returns the metadata of every component of a device from the device registry
+	 * @param deviceIndex The device index of the device
+	 * @return The components in the order they were created
+	 */
+	std::vector<ComponentInfo> getDeviceComponents(uint32_t deviceIndex);
+
+	/**
+	 * @brief Returns the metadata of a single component from the device registry
+	 * @param deviceIndex The device index of the device
+	 * @param path The input path of the component
+	 * @return The metadata, or std::nullopt if the device has no such component
+	 */
+	std::optional<ComponentInfo> getComponentInfo(uint32_t deviceIndex, const std::string& path);
+
 private:
 	/** @brief True if the shared memory has been successfully initialized, false otherwise */
 	bool initialized;
@@ -64,6 +185,9 @@ private:
 	/** @brief A pointer to the start of the shared memory */
 	void* sharedMemory;
 
+	/** @brief How the shared memory was mapped into this process */
+	SharedMemoryMappingStats mappingStats;
+
 	/** @brief The offset in bytes from the start of the shared memory to the start of the path table */
 	uint32_t pathTableStart;
 
@@ -73,30 +197,336 @@ private:
 	/** @brief The offset in bytes of the driver-client lane from the start of the shared memory */
 	uint32_t driverClientLaneStart;
 
+	/** @brief A pointer to the start of the driver-client lane, in the shared memory or in its mirrored section */
+	uint8_t* driverClientLane = nullptr;
+
 	/** @brief The offset in bytes of where the lib is currently reading in the driver-client lane */
 	uint32_t driverClientLaneReadOffset;
 
 	/** @brief The version of the last successfully read packet in the driver-client lane */
 	uint64_t driverClientLaneReadCount;
 
+	/** @brief The cached write offset of the driver-client lane, reloaded only when the lane looks empty */
+	uint32_t cachedDriverClientWriteOffset = 0;
+
 	/** @brief The offset in bytes of the client-driver lane from the start of the shared memory */
 	uint32_t clientDriverLaneStart;
 
+	/** @brief A pointer to the start of the client-driver lane, in the shared memory or in its mirrored section */
+	uint8_t* clientDriverLane = nullptr;
+
+	/** @brief Whether both lanes are mirrored, see SharedMemoryMapping_MirroredLanes */
+	bool mirroredLanes = false;
+
 	/** @brief The offset in bytes of where the client is currently writing in the client-driver lane */
 	uint32_t clientDriverLaneWriteOffset;
 
 	/** @brief The version of the last written packet in the client-driver lane */
 	uint64_t clientDriverLaneWriteCount;
 
+	/** @brief The cached read offset of the client-driver lane, reloaded only when the lane looks full */
+	uint32_t cachedClientDriverReadOffset = 0;
+
+	/**
+	 * @brief Identifies the target of a command, where commands with the same key overwrite eachother. Commands
+	 * scheduled for different apply times never overwrite eachother, so playback can queue several frames ahead
+	 */
+	struct CommandKey {
+		ClientCommandType type;
+		uint32_t deviceIndex;
+		uint32_t pathOffset;
+		int64_t applyTimeNanoseconds;
+
+		bool operator==(const CommandKey& other) const {
+			return type == other.type && deviceIndex == other.deviceIndex && pathOffset == other.pathOffset &&
+				applyTimeNanoseconds == other.applyTimeNanoseconds;
+		}
+	};
+
+	/** @brief Hashes a CommandKey for use in unordered maps */
+	struct CommandKeyHash {
+		size_t operator()(const CommandKey& key) const {
+			uint64_t packed = (static_cast<uint64_t>(key.deviceIndex) << 32) | key.pathOffset;
+			return std::hash<uint64_t>()(packed) ^ (static_cast<size_t>(key.type) * 0x9E3779B97F4A7C15ULL) ^
+				std::hash<int64_t>()(key.applyTimeNanoseconds);
+		}
+	};
+
+	/** @brief A sequence id handed out for an issued command, along with when it was issued */
+	struct IssuedCommand {
+		uint64_t sequence;
+		std::chrono::steady_clock::time_point issueTime;
+	};
+
+	/** @brief A command waiting in the command buffer */
+	struct PendingCommand {
+		CommandKey key;
+		std::vector<uint8_t> params;
+		/** @brief Every issued command coalesced into this one, completed together */
+		std::vector<IssuedCommand> issuedCommands;
+	};
+
+	/** @brief A command written to the client-driver lane and waiting for its acknowledgement */
+	struct WrittenCommand {
+		uint64_t version;
+		CommandKey key;
+		std::vector<IssuedCommand> issuedCommands;
+	};
+
+	/** @brief Guards the command buffer and the client-driver lane write state */
+	std::mutex commandBufferMutex;
+
+	/** @brief The pending commands, in the order their keys were first queued */
+	std::vector<PendingCommand> pendingCommands;
+
+	/** @brief Maps command keys to their index in <pendingCommands>, leaving out event commands */
+	std::unordered_map<CommandKey, size_t, CommandKeyHash> pendingCommandIndexes;
+
+	/** @brief The params of a state command written to the lane, trusted for redundancy checks once applied */
+	struct WrittenParams {
+		/** @brief The version of the command that wrote the params, so only its own ack promotes them */
+		uint64_t version;
+		std::vector<uint8_t> params;
+		/** @brief Whether the driver acknowledged the command as applied */
+		bool applied;
+	};
+
+	/** @brief The params of the last state command written for each command key, used to drop duplicates */
+	std::unordered_map<CommandKey, WrittenParams, CommandKeyHash> lastWrittenParams;
+
+	/** @brief The plugin override count of the shared memory header as of the last flush */
+	uint64_t seenPluginOverrideCount = 0;
+
+	/** @brief The commands written to the lane that the driver has not acknowledged, in version order */
+	std::deque<WrittenCommand> writtenCommands;
+
+	/** @brief The acknowledged commands the driver is holding until their apply time */
+	std::vector<WrittenCommand> scheduledCommands;
+
+	/** @brief The sequence id given to the next issued command */
+	std::atomic<uint64_t> nextCommandSequence = 1;
+
+	/** @brief Guards the completion state below, separate so completions never wait on the lane */
+	std::mutex completionMutex;
+
+	/** @brief Maps sequence ids to the promises waiting on them */
+	std::unordered_map<uint64_t, std::vector<std::promise<CommandResult>>> completionPromises;
+
+	/** @brief The most recent results, indexed by sequence id modulo COMMAND_STATUS_RING_SIZE */
+	CommandResult recentResults[COMMAND_STATUS_RING_SIZE] = {};
+
+	/** @brief The highest sequence id that has completed */
+	uint64_t highestCompletedSequence = 0;
+
+	/** @brief Invoked with the result of every completed command */
+	std::function<void(const CommandResult&)> completionCallback;
+
+	/** @brief The offset in bytes of the command status ring from the start of the shared memory */
+	uint32_t commandStatusRingStart;
+
+	/** @brief The offset in bytes of the animation blob region from the start of the shared memory */
+	uint32_t animationBlobStart;
+
+	/** @brief The offset in bytes of the device registry from the start of the shared memory */
+	uint32_t deviceRegistryStart;
+
+	/** @brief The offset in bytes of the haptics lane from the start of the shared memory */
+	uint32_t hapticLaneStart;
+
+	/** @brief The number of the next record to read from the haptics lane */
+	uint64_t hapticLaneReadCount = 0;
+
+	/** @brief Guards the device registry cache below, which is refreshed by whichever thread queries it */
+	std::mutex deviceRegistryMutex;
+
+	/** @brief The deviceRegistryVersion the cache was built at, odd (and never published) until the first build */
+	uint32_t cachedDeviceRegistryVersion = UINT32_MAX;
+
+	/** @brief The copy of the device registry the cache is built from, reused between refreshes */
+	std::unique_ptr<DeviceRegistry> deviceRegistrySnapshot;
+
+	/** @brief The cached device properties, indexed by device index */
+	std::optional<DeviceInfo> cachedDevices[MAX_REGISTRY_DEVICES];
+
+	/** @brief The cached masks of device indexes of each DeviceClass */
+	uint64_t cachedDeviceClassMasks[NUM_DEVICE_CLASSES] = {};
+
+	/** @brief The cached components in the order they were created */
+	std::vector<ComponentInfo> cachedComponents;
+
+	/** @brief Maps each device index and input path to its index in <cachedComponents> */
+	std::unordered_map<uint32_t, std::unordered_map<std::string, size_t>> cachedComponentIndexes;
+
+	/** @brief Serializes animation uploads, so only one writer touches a slot at a time */
+	std::mutex animationUploadMutex;
+
+	/** @brief The sequence id of the last load command issued for each upload slot, or 0 if none */
+	uint64_t animationLoadSequences[MAX_ANIMATION_TRACKS] = {};
+
+	/** @brief True between beginBatch() and commitBatch(), while flushes hold the command buffer back */
+	bool batchOpen = false;
+
+	/** @brief True once a batch is committed but not yet written, so the next flush writes it as a transaction frame */
+	bool batchCommitted = false;
+
 	/** @brief Private empty contructor for the singleton pattern */
 	SharedDeviceMemoryClient() = default;
 
+	/**
+	 * @brief Rebuilds the device registry cache if the driver changed the registry since it was last built. The
+	 * caller must hold <deviceRegistryMutex>
+	 * @return True if the cache is current, false if the driver kept changing the registry while it was copied, in
+	 * which case the previous cache is kept
+	 */
+	bool refreshDeviceRegistry();
+
+	/**
+	 * @brief Touches every page of the shared memory so it is faulted in now instead of on the poll and command
+	 * threads, then locks it in memory unless large pages already keep it resident
+	 */
+	void prefaultSharedMemory();
+
+	/**
+	 * @brief Opens the sections the driver created for the lanes and maps each twice back to back
+	 * @return True if both lanes are mirrored, false otherwise
+	 */
+	bool mapMirroredLanes();
+
+	/**
+	 * @brief Returns the input path offset targeted by a command
+	 * @param type The type of command
+	 * @param paramsStart A pointer to the params struct corresponding to <type>
+	 * @return The input path offset, or UINT32_MAX if the command targets a whole device
+	 */
+	static uint32_t getCommandPathOffset(ClientCommandType type, const void* paramsStart);
+
+	/**
+	 * @brief Returns whether a command only sets state, so that resending the same params has no effect on the driver.
+	 * Configuration commands such as rules and filters reset driver side state when received, so they never count
+	 * @param type The type of command
+	 * @return True if duplicates of the command can be dropped, false otherwise
+	 */
+	static bool isStateCommand(ClientCommandType type);
+
+	/**
+	 * @brief Returns whether every issued copy of a command has an effect of its own, such as a haptic pulse, so that
+	 * it is never coalesced with a pending command of the same key
+	 * @param type The type of command
+	 * @return True if the command must be sent as often as it was issued, false otherwise
+	 */
+	static bool isEventCommand(ClientCommandType type);
+
+	/**
+	 * @brief Zeroes the padding bytes of a state command's params, which the caller may have left uninitialized, so
+	 * that redundancy checks compare only the values of its fields
+	 * @param type The type of command
+	 * @param params The params of the command, rewritten in place
+	 */
+	static void clearParamsPadding(ClientCommandType type, std::vector<uint8_t>& params);
+
+	/**
+	 * @brief Returns whether a pending command is a state command identical to the last one written for its key,
+	 * and the driver applied that one, assuming the caller holds <commandBufferMutex>
+	 * @param command The pending command
+	 * @return True if the command can be dropped, false otherwise
+	 */
+	bool isRedundantCommand(const PendingCommand& command);
+
+	/**
+	 * @brief Records the params of a written state command for redundancy checks, assuming the caller holds
+	 * <commandBufferMutex>
+	 * @param command The written command, whose params are moved out
+	 * @param version The version the command was written with
+	 */
+	void recordWrittenParams(PendingCommand& command, uint64_t version);
+
+	/**
+	 * @brief Trusts the params of an acknowledged state command for redundancy checks if the driver applied it, and
+	 * forgets them otherwise, assuming the caller holds <commandBufferMutex>
+	 * @param command The acknowledged command
+	 * @param status The status the driver acknowledged the command with
+	 */
+	void recordCommandStatus(const WrittenCommand& command, CommandStatus status);
+
+	/**
+	 * @brief Forgets the params of the state commands last written for a device, since the driver reset its state
+	 * when the device was removed and the same commands have to reach it again
+	 * @param deviceIndex The device index of the removed device
+	 */
+	void forgetWrittenParams(uint32_t deviceIndex);
+
+	/**
+	 * @brief Writes all pending commands as one transaction frame, assuming the caller holds <commandBufferMutex>
+	 * @param completedResults Where to append the results of redundant commands dropped from the frame
+	 * @return True if the frame was written and published, false if it doesn't fit in the client-driver lane
+	 */
+	bool writePendingBatch(std::vector<CommandResult>& completedResults);
+
+	/**
+	 * @brief Completes every written command the driver has acknowledged since the last call, and every scheduled
+	 * command the driver has since applied
+	 */
+	void pollForCommandAcks();
+
+	/**
+	 * @brief Appends a result for each issued command
+	 * @param issuedCommands The issued commands
+	 * @param status The status shared by all of them
+	 * @param appliedTimeNanoseconds The steady clock time the driver applied them at, used if <status> is applied
+	 * @param results Where to append the results
+	 */
+	static void appendResults(
+		const std::vector<IssuedCommand>& issuedCommands,
+		CommandStatus status,
+		int64_t appliedTimeNanoseconds,
+		std::vector<CommandResult>& results
+	);
+
+	/**
+	 * @brief Records results, fulfills the promises waiting on them and invokes the completion callback, assuming
+	 * the caller holds no lock
+	 * @param results The results
+	 */
+	void completeCommands(const std::vector<CommandResult>& results);
+
+	/**
+	 * @brief Serializes a command header and command params and writes them to the client-driver lane, assuming the
+	 * caller holds <commandBufferMutex>
+	 * @param type The type of command being written
+	 * @param deviceIndex The index of the device this command is related to
+	 * @param paramsStart A pointer to the params struct corresponding to <type>
+	 * @param paramsSize The size in bytes of the params being supplied
+	 * @param sequence The sequence id of the command, or 0 for batch markers
+	 * @param applyTimeNanoseconds The steady clock time to apply the command at, or 0 to apply it immediately
+	 * @param publish True to publish the write offset and count to the driver, false to leave the command hidden until
+	 * a later publish
+	 * @return True if the command was written, false if the lane is full
+	 */
+	bool writeCommandToClientDriverLane(
+		ClientCommandType type,
+		uint32_t deviceIndex,
+		const void* paramsStart,
+		uint32_t paramsSize,
+		uint64_t sequence,
+		int64_t applyTimeNanoseconds,
+		bool publish = true
+	);
+
 	/**
 	 * @brief Writes a packet into the client-driver lane
 	 * @param packet A pointer to the start of the packet
 	 * @param packetSize The size of the packet in bytes
+	 * @param publish True to publish the write offset and count to the driver, false to leave the packet hidden until
+	 * a later publish
+	 * @return True if the packet was written, false if the lane doesn't have enough free space
+	 */
+	bool writePacketToClientDriverLane(void* packet, uint32_t packetSize, bool publish = true);
+
+	/**
+	 * @brief Publishes the current client-driver lane write offset and count, making every packet written so far
+	 * visible to the driver
 	 */
-	void writePacketToClientDriverLane(void* packet, uint32_t packetSize);
+	void publishClientDriverLaneWrites();
 
 	/**
 	 * @brief Reads a packet from the driver-client lane
@@ -108,9 +538,14 @@ private:
 	std::pair<ObjectEntryData, std::pair<ObjectType, std::unique_ptr<uint8_t[]>>> readPacketFromDriverClientLane();
 
 	/**
-	 * @brief Realigns the read header to a valid packet by forward searching for valid packets. If none are found
-	 * after a specified amount of bytes, the read header is advanced to the write header, dropping all packets in
-	 * between
+	 * @brief Returns the size in bytes of the serialized data that follows an object entry of type <type>
+	 */
+	static uint32_t getObjectDataSize(ObjectType type);
+
+	/**
+	 * @brief Realigns the read header to a valid packet by scanning frame boundaries up to the write header for a
+	 * frame with a valid checksum, following wrap markers. If none are found, the read header is advanced to the
+	 * write header, dropping all packets in between
 	 * @param headerPtr The shared memory header
 	 * @param laneStart The start of the shared memory lane
 	 * @param readStart A pointer to where to write the new read offset in the event that forward searching succeeded
@@ -143,8 +578,20 @@ private:
 	void pollForDriverUpdates();
 
 	/**
-	 * @brief Infinitely checks for updates from the driver at the standard poll rate, should be started in a detatched
-	 * thread
+	 * @brief Reads the vibrations the driver published to the haptics lane since the last call and notifies the
+	 * listeners. Records the driver already overwrote are skipped
+	 */
+	void pollHapticLane();
+
+	/**
+	 * @brief Infinitely checks for updates and acknowledgements from the driver and flushes the command buffer at the
+	 * standard poll rate, should be started in a detatched thread
 	 */
 	void pollLoop();
+
+	/**
+	 * @brief Stores the current time as the client heartbeat, which the driver checks to decide whether a client is
+	 * attached and state has to be published at all
+	 */
+	void publishHeartbeat();
 };
\ No newline at end of file
@@ -23,16 +23,18 @@ void StateEventReceiver::DeviceInputEyeTrackingAdded(uint32_t deviceIndex, const
 void StateEventReceiver::DeviceInputEyeTrackingRemoved(uint32_t deviceIndex, const std::string& path) {}
 
 void StateEventReceiver::DevicePoseChanged(uint32_t deviceIndex, DevicePose oldPose, DevicePose newPose) {
-    vr::IVRSystem* vrSystem = vr::VRSystem();
-    if (!vrSystem || vrSystem->GetTrackedDeviceClass(deviceIndex) != vr::TrackedDeviceClass_Controller) return;
-
-    newPose.vecPosition[0] = newPose.vecPosition[1] = newPose.vecPosition[2] = 0;
-    this->commandSender.setOverriddenDevicePose(deviceIndex, newPose);
+    // The device registry answers from shared memory, so filtering every pose event costs no OpenVR call
+    if (this->commandSender.getDeviceClass(deviceIndex) != DeviceClass_Controller) return;
 
     auto& seenDeviceIndexes = this->seenDeviceIndexes;
     if (find(seenDeviceIndexes.begin(), seenDeviceIndexes.end(), deviceIndex) == seenDeviceIndexes.end()) {
         seenDeviceIndexes.push_back(deviceIndex);
-        this->commandSender.setUseOverriddenDevicePose(deviceIndex, true);
+
+        // Lock every axis at the origin once, after which the driver applies the rule to each pose by itself
+        PoseTransformRule lockToOrigin;
+        lockToOrigin.type = PoseTransformRule_AxisLock;
+        lockToOrigin.axisMask = TransformAxis_X | TransformAxis_Y | TransformAxis_Z;
+        this->commandSender.setPoseTransformRules(deviceIndex, { lockToOrigin });
     }
 }
 
@@ -0,0 +1,164 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "ObjectSchemas.h"
+
+#if defined(__SSE4_2__) || defined(_M_X64)
+#include <nmmintrin.h>
+#define CONDUIT_CRC32C_SSE42
+#if defined(_M_X64) && !defined(__SSE4_2__)
+#include <intrin.h>
+#define CONDUIT_CRC32C_RUNTIME_CHECK
+#endif
+#endif
+
+/**
+ * @brief The lookup table for the software CRC32C (Castagnoli, reflected polynomial 0x82F63B78), used when the CPU
+ * has no CRC32 instruction
+ */
+struct Crc32cTable {
+	uint32_t entries[256];
+
+	constexpr Crc32cTable() : entries() {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t crc = i;
+			for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0x82F63B78U & (0U - (crc & 1U)));
+			this->entries[i] = crc;
+		}
+	}
+};
+
+inline constexpr Crc32cTable CRC32C_TABLE{};
+
+/**
+ * @brief Returns true if the SSE4.2 CRC32 instruction can be used, checked once per process where it isn't
+ * guaranteed at compile time
+ */
+inline bool hasHardwareCrc32c() {
+#if defined(CONDUIT_CRC32C_RUNTIME_CHECK)
+	static const bool supported = [] {
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 20)) != 0;
+	}();
+	return supported;
+#elif defined(CONDUIT_CRC32C_SSE42)
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief Continues a CRC32C over <size> bytes at <data>
+ * @param crc The running CRC, starting at 0xFFFFFFFF
+ * @param data Pointer to the bytes
+ * @param size The number of bytes
+ * @return The updated running CRC, which is inverted to get the final checksum
+ */
+inline uint32_t updateCrc32c(uint32_t crc, const void* data, size_t size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+#if defined(CONDUIT_CRC32C_SSE42)
+	if (hasHardwareCrc32c()) {
+		uint64_t crc64 = crc;
+		for (; size >= 8; size -= 8, bytes += 8) {
+			uint64_t word;
+			memcpy(&word, bytes, sizeof(word));
+			crc64 = _mm_crc32_u64(crc64, word);
+		}
+
+		crc = static_cast<uint32_t>(crc64);
+		for (; size > 0; size--, bytes++) crc = _mm_crc32_u8(crc, *bytes);
+		return crc;
+	}
+#endif
+
+	for (; size > 0; size--, bytes++) crc = CRC32C_TABLE.entries[(crc ^ *bytes) & 0xFFU] ^ (crc >> 8);
+	return crc;
+}
+
+// Frame sizes are stored in 16 bits, and every frame must fit in the lane padding
+static_assert(LANE_PADDING_SIZE <= UINT16_MAX, "Frame sizes must fit in the 16 bit frameSize field");
+
+/**
+ * @brief Returns the number of bytes a frame of <frameSize> bytes takes up in a lane, so every frame starts on a
+ * multiple of FRAME_ALIGNMENT
+ */
+inline uint32_t getFrameStride(uint32_t frameSize) {
+	return (frameSize + FRAME_ALIGNMENT - 1) & ~(FRAME_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Returns true if a frame fits in a lane without reaching its reader, including the wrap to the start of the
+ * lane when the writer is inside the padding
+ * @param writeOffset The write offset of the lane
+ * @param readOffset The read offset of the lane, which may lag the real one and only understate the free space
+ * @param frameStride The number of bytes the frame takes up in the lane
+ * @param mirrored Whether the lane is mirrored, in which case frames never skip the padding
+ * @return True if the frame fits, false otherwise
+ */
+inline bool hasLaneSpace(uint32_t writeOffset, uint32_t readOffset, uint32_t frameStride, bool mirrored) {
+	if (mirrored) return frameStride < (readOffset > writeOffset ? 0 : LANE_SIZE) + readOffset - writeOffset;
+
+	// Frames never start inside the padding, so a writer there first wraps to the start of the lane
+	if (writeOffset >= LANE_SIZE - LANE_PADDING_SIZE) return readOffset == writeOffset || frameStride < readOffset;
+
+	// Frames starting before the padding always fit in the rest of the lane
+	if (writeOffset >= readOffset) return true;
+
+	return frameStride < readOffset - writeOffset;
+}
+
+/**
+ * @brief Computes the checksum of a lane frame, covering every byte up to <frameSize> except <checksum> itself
+ * @param frame The header of the frame, either an ObjectEntry or a ClientCommandHeader, whose <frameSize> must
+ * already have been validated
+ * @return The CRC32C of the frame
+ */
+template <typename FrameHeader>
+inline uint32_t computeFrameChecksum(const FrameHeader* frame) {
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(frame);
+
+	uint32_t crc = updateCrc32c(0xFFFFFFFFU, bytes, offsetof(FrameHeader, checksum));
+	size_t resume = offsetof(FrameHeader, checksum) + sizeof(frame->checksum);
+	crc = updateCrc32c(crc, bytes + resume, frame->frameSize - resume);
+	return ~crc;
+}
+
+/**
+ * @brief Copies a frame into a lane, writing its leading ALIGNMENT_CONSTANT last with release ordering so the magic
+ * doubles as the commit flag of the frame. The magic is cleared first, since the last lap may have left a frame at
+ * the same offset
+ * @param destination Where the frame starts in the lane
+ * @param frame The frame, starting with its ALIGNMENT_CONSTANT
+ * @param frameSize The size in bytes of the frame
+ */
+inline void writeFrame(uint8_t* destination, const void* frame, uint32_t frameSize) {
+	std::atomic_ref<uint32_t> magic(*reinterpret_cast<uint32_t*>(destination));
+	magic.store(0, std::memory_order_relaxed);
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(frame);
+	memcpy(destination + sizeof(uint32_t), bytes + sizeof(uint32_t), frameSize - sizeof(uint32_t));
+
+	magic.store(ALIGNMENT_CONSTANT, std::memory_order_release);
+}
+
+/**
+ * @brief Widens the low 32 bits of a frame version back to the full version, picking the value closest to the last
+ * version the reader saw
+ * @param version The low 32 bits of the version, as stored in the frame
+ * @param reference The last full version the reader saw
+ * @return The full version
+ */
+inline uint64_t widenFrameVersion(uint32_t version, uint64_t reference) {
+	uint64_t widened = (reference & ~0xFFFFFFFFULL) | version;
+
+	if (widened + 0x80000000ULL < reference) widened += 0x100000000ULL;
+	else if (widened > reference + 0x80000000ULL && widened >= 0x100000000ULL) widened -= 0x100000000ULL;
+
+	return widened;
+}
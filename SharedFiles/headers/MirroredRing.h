@@ -0,0 +1,70 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+
+#include "ObjectSchemas.h"
+
+// Views can only be placed at multiples of the 64kb allocation granularity
+static_assert(LANE_SIZE % 65536U == 0, "Mirrored lanes must be a multiple of the allocation granularity");
+
+/**
+ * @brief Maps a section twice back to back, so a read or write running off the end of the first view continues into
+ * the start of the section through the second view. Relies on VirtualAlloc2 and MapViewOfFile3, which are looked up
+ * at runtime since they are only available from Windows 10 version 1803
+ * @param section The section to map
+ * @param size The size in bytes of the section, which must be a multiple of the allocation granularity
+ * @return A pointer to the first of the two views, or nullptr if they couldn't be mapped
+ */
+inline uint8_t* mapMirroredView(HANDLE section, SIZE_T size) {
+	using VirtualAlloc2Function = PVOID(WINAPI*)(HANDLE, PVOID, SIZE_T, ULONG, ULONG, void*, ULONG);
+	using MapViewOfFile3Function = PVOID(WINAPI*)(HANDLE, HANDLE, PVOID, uint64_t, SIZE_T, ULONG, ULONG, void*, ULONG);
+
+	HMODULE kernelBase = GetModuleHandleA("kernelbase.dll");
+	if (!kernelBase) return nullptr;
+
+	auto virtualAlloc2 = reinterpret_cast<VirtualAlloc2Function>(GetProcAddress(kernelBase, "VirtualAlloc2"));
+	auto mapViewOfFile3 = reinterpret_cast<MapViewOfFile3Function>(GetProcAddress(kernelBase, "MapViewOfFile3"));
+	if (!virtualAlloc2 || !mapViewOfFile3) return nullptr;
+
+	// Reserve room for both views, then split the reservation so each view can replace one half
+	uint8_t* placeholder = static_cast<uint8_t*>(
+		virtualAlloc2(nullptr, nullptr, 2 * size, MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, nullptr, 0)
+	);
+	if (!placeholder) return nullptr;
+
+	if (!VirtualFree(placeholder, size, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER)) {
+		VirtualFree(placeholder, 0, MEM_RELEASE);
+		return nullptr;
+	}
+
+	void* first = mapViewOfFile3(
+		section, nullptr, placeholder, 0, size, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0
+	);
+	void* second = mapViewOfFile3(
+		section, nullptr, placeholder + size, 0, size, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0
+	);
+
+	if (!first || !second) {
+		if (first) UnmapViewOfFile(first);
+		else VirtualFree(placeholder, 0, MEM_RELEASE);
+
+		if (second) UnmapViewOfFile(second);
+		else VirtualFree(placeholder + size, 0, MEM_RELEASE);
+
+		return nullptr;
+	}
+
+	return placeholder;
+}
+
+/**
+ * @brief Unmaps both views of a section mapped by mapMirroredView
+ * @param view The pointer returned by mapMirroredView
+ * @param size The size in bytes of the section
+ */
+inline void unmapMirroredView(uint8_t* view, SIZE_T size) {
+	if (!view) return;
+
+	UnmapViewOfFile(view);
+	UnmapViewOfFile(view + size);
+}
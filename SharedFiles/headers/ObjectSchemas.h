@@ -7,12 +7,22 @@
 /* The size of the ObjectType enum */
 inline const uint32_t NUM_OBJECT_TYPES = 6U;
 
-/* A constant used interally to ensure packets are aligned in shared memory */
+/* A constant used interally to ensure packets are aligned in shared memory, which starts every lane frame */
 inline const uint32_t ALIGNMENT_CONSTANT = 0x4F424A45U;
 
+/* Written by a lane writer at its write offset when it wraps back to the start of the lane */
+inline const uint32_t WRAP_MARKER_CONSTANT = 0x50415257U;
+
+/* The alignment in bytes of every frame in a lane, which is also the stride readers scan for frames at */
+inline const uint32_t FRAME_ALIGNMENT = 8U;
+
 /* The name of the Conduit shared memory region, as required by Windows */
 inline const char* SHM_NAME = "Local\\ConduitSharedDeviceMemory";
 
+/* The names of the sections holding the driver-client and client-driver lanes when they are mirrored */
+inline const char* DRIVER_CLIENT_LANE_NAME = "Local\\ConduitDriverClientLane";
+inline const char* CLIENT_DRIVER_LANE_NAME = "Local\\ConduitClientDriverLane";
+
 /* The total allocated size of the path table, in bytes */
 inline const uint32_t PATH_TABLE_SIZE = 1024U * 5U;		// 5kb
 
@@ -25,14 +35,87 @@ client-driver lanes */
 inline const uint32_t LANE_SIZE = 1048576U * 5U;		// 5mb
 
 /* The allocated padding at the end of each lane that signals a read header to
-reset to offset 0. Should be greater than the maximum possible packet size */
+reset to offset 0. Should be greater than the maximum possible packet size. Unused
+when the lanes are mirrored */
 inline const uint32_t LANE_PADDING_SIZE = 1024U * 5U;	// 5kb
 
 /* The rate in Hz that the Conduit driver and lib poll for updates from eachother */
 inline const double POLL_RATE = 1024.0;
 
-/* The number of microseconds the client and driver should wait for the commit flag of the other before timing out */
-inline const uint32_t COMMIT_FLAG_TIMEOUT_US = 10000;
+/* The number of entries in the command status ring, which must cover the commands issued between two lib polls */
+inline const uint32_t COMMAND_STATUS_RING_SIZE = 4096U;
+
+/* The version a command status entry holds while it is being written, which readers retry instead of reading */
+inline const uint64_t COMMAND_STATUS_WRITING_VERSION = UINT64_MAX - 1;
+
+/* The maximum number of commands the driver holds back for a future apply time */
+inline const uint32_t MAX_SCHEDULED_COMMANDS = 4096U;
+
+/* The maximum number of client-driver lane packets a single update hook reads before calling the original function */
+inline const uint32_t MAX_HOOK_COMMAND_DRAIN = 32U;
+
+/* The time in milliseconds without a lib poll after which the driver treats the client as detached */
+inline const uint32_t CLIENT_HEARTBEAT_TIMEOUT_MS = 250U;
+
+/* The number of raw hook updates each hook thread can queue for the driver's publishing worker */
+inline const uint32_t HOOK_UPDATE_QUEUE_SIZE = 256U;
+
+/* The maximum number of hook threads with their own update queue, later threads publish from the hook instead */
+inline const uint32_t MAX_HOOK_UPDATE_QUEUES = 16U;
+
+/* The maximum number of pose transform rules that can be attached to a single device */
+inline const uint32_t MAX_POSE_TRANSFORM_RULES = 8U;
+
+/* The maximum number of input transform rules that can be attached to a single input */
+inline const uint32_t MAX_INPUT_TRANSFORM_RULES = 4U;
+
+/* The maximum number of instructions in a single input filter program */
+inline const uint32_t MAX_FILTER_INSTRUCTIONS = 64U;
+
+/* The maximum number of inputs a single input filter program can read through bindings */
+inline const uint32_t MAX_FILTER_BINDINGS = 4U;
+
+/* The number of persistent registers available to each input filter program */
+inline const uint32_t MAX_FILTER_REGISTERS = 8U;
+
+/* The maximum depth of the value stack of an input filter program */
+inline const uint32_t MAX_FILTER_STACK_DEPTH = 16U;
+
+/* The number of keyframe tracks the driver can hold, each with its own upload slot in the animation blob region */
+inline const uint32_t MAX_ANIMATION_TRACKS = 16U;
+
+/* The size of the upload slot of a single keyframe track in the animation blob region */
+inline const uint32_t ANIMATION_TRACK_SLOT_SIZE = 1048576U;	// 1mb
+
+/* The track id used by the animation playback commands to stop playback */
+inline const uint32_t NO_ANIMATION_TRACK = UINT32_MAX;
+
+/* The bone mask of a skeleton override that replaces all 31 bones */
+inline const uint32_t ALL_SKELETON_BONES = 0x7FFFFFFFU;
+
+/* The number of device slots in the device registry, one per OpenVR device index */
+inline const uint32_t MAX_REGISTRY_DEVICES = 64U;
+
+/* The maximum number of components the device registry describes, across all devices */
+inline const uint32_t MAX_REGISTRY_COMPONENTS = 1024U;
+
+/* The maximum number of skeleton components whose grip limit transforms are kept in the device registry */
+inline const uint32_t MAX_REGISTRY_GRIP_LIMITS = 32U;
+
+/* The size of the serial and model number strings in the device registry, including the null terminator */
+inline const uint32_t REGISTRY_STRING_SIZE = 64U;
+
+/* The size of the DeviceClass enum */
+inline const uint32_t NUM_DEVICE_CLASSES = 6U;
+
+/* The grip limit slot of a registry component without grip limit transforms */
+inline const uint16_t NO_GRIP_LIMIT_SLOT = UINT16_MAX;
+
+/* The number of records in the haptics lane, which must cover the haptic events between two lib polls */
+inline const uint32_t HAPTIC_LANE_SIZE = 1024U;
+
+/* The sequence a haptics lane record holds while it is being written, which readers retry instead of reading */
+inline const uint64_t HAPTIC_RECORD_WRITING_SEQUENCE = UINT64_MAX;
 
 /**
  * @brief Represents the type of input (or pose) of a packet
@@ -57,12 +140,54 @@ enum ClientCommandType {
 	Command_SetOverriddenStateDeviceInputScalar,
 	Command_SetOverriddenStateDeviceInputSkeleton,
 	Command_SetOverriddenStateDeviceInputPose,
-	Command_SetOverriddenStateDeviceInputEyeTracking
+	Command_SetOverriddenStateDeviceInputEyeTracking,
+	Command_SetPoseTransformRules,
+	Command_SetInputTransformRules,
+	Command_LoadInputFilterProgram,
+	Command_SetPoseSmoothingFilter,
+	Command_SetScalarSmoothingFilter,
+	Command_BeginBatch,
+	Command_CommitBatch,
+	Command_LoadAnimationTrack,
+	Command_PlayPoseAnimation,
+	Command_PlayInputAnimation,
+	Command_SetPoseExtrapolation,
+	Command_InjectHapticPulse,
+	Command_SetHapticSuppression
+};
+
+/**
+ * @brief Flags describing how the driver mapped the shared memory
+ */
+enum SharedMemoryMappingFlag {
+	/** @brief The shared memory is backed by large pages, which are never paged out */
+	SharedMemoryMapping_LargePages = 1 << 0,
+
+	/** @brief The driver prefaulted and locked the shared memory at startup, and clients should do the same */
+	SharedMemoryMapping_Locked = 1 << 1,
+
+	/**
+	 * @brief Each lane lives in its own section, mapped twice back to back, so frames are contiguous at any offset
+	 * and offsets simply wrap modulo LANE_SIZE. The lane regions of the shared memory are left unused
+	 */
+	SharedMemoryMapping_MirroredLanes = 1 << 2
+};
+
+/**
+ * @brief Flags describing a haptics lane record
+ */
+enum HapticEventFlag {
+	/** @brief The vibration was suppressed, so the device never received it */
+	HapticEvent_Suppressed = 1 << 0,
+
+	/** @brief The vibration was injected by a client instead of sent by an application */
+	HapticEvent_Injected = 1 << 1
 };
 
 /**
  * @brief Represents the central header in shared memory, containing critical metadata needed by both the Conduit
- * lib and Driver, often simultaneously
+ * lib and Driver, often simultaneously. Fields written by different sides never share a cache line, so a producer
+ * advancing its cursor doesn't invalidate the line the consumer publishes its own cursor on, and vice versa
  */
 struct SharedMemoryHeader {
 	/**************************************************
@@ -88,9 +213,9 @@ struct SharedMemoryHeader {
 
 	/**
 	 * @brief An offset in bytes (from <pathTableStart>) for where the driver is currently writing a path, or 0 if the
-	 * driver is not currently writing
+	 * driver is not currently writing. Written only by the driver, so it sits on its own cache line
 	 */
-	std::atomic<uint32_t> pathTableWritingOffset;
+	alignas(64) std::atomic<uint32_t> pathTableWritingOffset;
 
 
 	/**************************************************
@@ -98,22 +223,26 @@ struct SharedMemoryHeader {
 	**************************************************/
 
 	/** @brief The offset in bytes from the start of the shared memory to the start of the driver-client lane */
-	uint32_t driverClientLaneStart;
+	alignas(64) uint32_t driverClientLaneStart;
 
 	/** @brief The total size in bytes allocated for the driver-client lane */
 	uint32_t driverClientLaneSize;
 
 	/** 
 	 * @brief The total number of writes made by the driver to the driver-client lane, which is compared to a local
-	 * read count by the lib to decide when new packets can be read 
+	 * read count by the lib to decide when new packets can be read. Starts the cache line owned by the driver as the
+	 * producer of the lane
 	 */
-	std::atomic<uint64_t> driverClientWriteCount;
+	alignas(64) std::atomic<uint64_t> driverClientWriteCount;
 
 	/** @brief The current offset in bytes that the driver is writing to the driver-client lane at */
 	std::atomic<uint32_t> driverClientWriteOffset;
 
-	/** @brief The current offset in bytes that the lib has read at from the driver-client lane */
-	std::atomic<uint32_t> driverClientReadOffset;
+	/**
+	 * @brief The current offset in bytes that the lib has read at from the driver-client lane, on the cache line owned
+	 * by the lib as the consumer of the lane
+	 */
+	alignas(64) std::atomic<uint32_t> driverClientReadOffset;
 
 
 	/**************************************************
@@ -121,51 +250,289 @@ struct SharedMemoryHeader {
 	**************************************************/
 
 	/** @brief The offset in bytes from the start of the shared memory to the start of the client-driver lane */
-	uint32_t clientDriverLaneStart;
+	alignas(64) uint32_t clientDriverLaneStart;
 
 	/** @brief The total size in bytes allocated for the client-driver lane */
 	uint32_t clientDriverLaneSize;
 
 	/**
 	 * @brief The total number of writes made by the lib to the client-driver lane, which is compared to a local
-	 * read count by the driver to decide when new packets can be read 
+	 * read count by the driver to decide when new packets can be read. Starts the cache line owned by the lib as the
+	 * producer of the lane
 	 */
-	std::atomic<uint64_t> clientDriverWriteCount;
+	alignas(64) std::atomic<uint64_t> clientDriverWriteCount;
 
 	/** @brief The current offset in bytes that the lib is writing to the client-driver lane at */
 	std::atomic<uint32_t> clientDriverWriteOffset;
 
-	/** @brief The current offset in bytes that the driver has read at from the client-driver lane */
-	std::atomic<uint32_t> clientDriverReadOffset;
+	/**
+	 * @brief The current offset in bytes that the driver has read at from the client-driver lane, on the cache line
+	 * owned by the driver as the consumer of the lane
+	 */
+	alignas(64) std::atomic<uint32_t> clientDriverReadOffset;
+
+
+	/**************************************************
+	* @brief Command acknowledgement metadata
+	**************************************************/
+
+	/** @brief The offset in bytes from the start of the shared memory to the start of the command status ring */
+	alignas(64) uint32_t commandStatusRingStart;
+
+	/**
+	 * @brief The number of client-driver lane packets the driver has processed, where every command with a lower
+	 * version has either written its status to the command status ring or was dropped. Scheduled commands first
+	 * write CommandStatus_Scheduled, which is replaced by their final status once their apply time is reached
+	 */
+	std::atomic<uint64_t> commandAckCount;
+
+	/**
+	 * @brief Incremented by the driver every time plugins override device state, which replaces state set by client
+	 * commands without the client knowing, so clients stop treating identical commands as redundant
+	 */
+	std::atomic<uint64_t> pluginOverrideCount;
+
+
+	/**************************************************
+	* @brief Animation blob metadata
+	**************************************************/
+
+	/**
+	 * @brief The offset in bytes from the start of the shared memory to the start of the animation blob region, which
+	 * holds MAX_ANIMATION_TRACKS upload slots of ANIMATION_TRACK_SLOT_SIZE bytes each
+	 */
+	alignas(64) uint32_t animationBlobStart;
+
+
+	/**************************************************
+	* @brief Mapping metadata
+	**************************************************/
+
+	/** @brief The SharedMemoryMappingFlag's describing how the driver mapped the shared memory */
+	uint32_t mappingFlags;
+
+	/** @brief The size in bytes of the shared memory, rounded up to whole large pages if they are used */
+	uint32_t mappingSize;
+
+
+	/**************************************************
+	* @brief Client presence metadata
+	**************************************************/
+
+	/**
+	 * @brief The steady clock time in nanoseconds of the last lib poll, or 0 if no client ever attached. Written only
+	 * by the lib, so it sits on its own cache line
+	 */
+	alignas(64) std::atomic<int64_t> clientHeartbeatNanoseconds;
+
+	/** @brief Incremented by the lib every time a client attaches, so a client restarting quickly is still noticed */
+	std::atomic<uint32_t> clientGeneration;
+
+
+	/**************************************************
+	* @brief Device registry metadata
+	**************************************************/
+
+	/** @brief The offset in bytes from the start of the shared memory to the start of the DeviceRegistry */
+	alignas(64) uint32_t deviceRegistryStart;
+
+	/**
+	 * @brief Guards the device registry like a seqlock. Odd while the driver is adding to or removing from the
+	 * registry, and advanced to the next even value once it is done, so clients copy the registry only when this
+	 * changed and retry if it changed during the copy
+	 */
+	std::atomic<uint32_t> deviceRegistryVersion;
+
+
+	/**************************************************
+	* @brief Haptics lane metadata
+	**************************************************/
+
+	/** @brief The offset in bytes from the start of the shared memory to the start of the haptics lane */
+	alignas(64) uint32_t hapticLaneStart;
+
+	/**
+	 * @brief The number of records claimed in the haptics lane, where record N lives at index N modulo
+	 * HAPTIC_LANE_SIZE. Claimed by the driver with a fetch-add, on its own cache line
+	 */
+	alignas(64) std::atomic<uint64_t> hapticWriteCount;
+};
+
+/**
+ * @brief A device slot in the device registry, written when the driver first sees the device and cleared back to
+ * all zeroes when OpenVR deactivates it
+ */
+struct DeviceRegistryDevice {
+	/** @brief True once the driver has seen the device */
+	bool registered;
+
+	/** @brief The DeviceClass of the device */
+	uint8_t deviceClass;
+
+	/** @brief The DeviceRole of the device */
+	uint8_t role;
+
+	/** @brief The null terminated serial number, truncated to fit */
+	char serialNumber[REGISTRY_STRING_SIZE];
+
+	/** @brief The null terminated model number, truncated to fit */
+	char modelNumber[REGISTRY_STRING_SIZE];
+};
+
+/**
+ * @brief A component in the device registry, written when the device creates it and removed along with its device
+ */
+struct DeviceRegistryComponent {
+	/** @brief The OpenVR component handle */
+	uint64_t componentHandle;
+
+	/** @brief The device index of the device */
+	uint8_t deviceIndex;
+
+	/** @brief The DeviceComponentType of the component */
+	uint8_t type;
+
+	/** @brief The ScalarType, only used by scalar components */
+	uint8_t scalarType;
+
+	/** @brief The ScalarUnits, only used by scalar components */
+	uint8_t scalarUnits;
+
+	/** @brief Offset into the path table of the input path */
+	uint16_t pathOffset;
+
+	/** @brief Offset into the path table of the skeleton path, only used by skeleton components */
+	uint16_t skeletonPathOffset;
+
+	/** @brief Offset into the path table of the base pose path, only used by skeleton components */
+	uint16_t basePosePathOffset;
+
+	/** @brief The SkeletalTrackingLevel, only used by skeleton components */
+	uint8_t skeletalTrackingLevel;
+
+	/** @brief The number of grip limit transforms in the grip limit slot */
+	uint8_t gripLimitTransformCount;
+
+	/** @brief The index into <gripLimitTransforms> of the DeviceRegistry, or NO_GRIP_LIMIT_SLOT */
+	uint16_t gripLimitSlot;
+};
+
+static_assert(sizeof(DeviceRegistryComponent) == 24, "Registry components must stay compact");
+
+/**
+ * @brief The device registry, describing every active device and component so clients can look them up without
+ * querying OpenVR. Removing a device clears its slot, frees the grip limit slots of its components and compacts the
+ * remaining components down in creation order, so component indices are not stable across changes. Every change,
+ * additions and removals alike, happens inside one odd period of deviceRegistryVersion in the SharedMemoryHeader,
+ * which describes how it is read
+ */
+struct DeviceRegistry {
+	/** @brief The number of used entries in <components> */
+	uint32_t componentCount;
+
+	/**
+	 * @brief The number of slots in <gripLimitTransforms> handed out so far, including slots freed by removed devices,
+	 * which the driver reuses before handing out new ones
+	 */
+	uint32_t gripLimitSlotCount;
+
+	/** @brief The device slots, indexed by device index */
+	DeviceRegistryDevice devices[MAX_REGISTRY_DEVICES];
+
+	/** @brief The components in the order they were created */
+	DeviceRegistryComponent components[MAX_REGISTRY_COMPONENTS];
+
+	/** @brief The grip limit transforms of skeleton components */
+	BoneTransform gripLimitTransforms[MAX_REGISTRY_GRIP_LIMITS][31];
+};
+
+/**
+ * @brief A single vibration in the haptics lane. The lane is a ring of fixed size records rather than framed packets,
+ * so a reader lapped by the driver simply skips to the oldest record still in the ring
+ */
+struct HapticEventRecord {
+	/**
+	 * @brief One more than the number of the record, written last with release ordering, or
+	 * HAPTIC_RECORD_WRITING_SEQUENCE while the record is being written
+	 */
+	std::atomic<uint64_t> sequence;
+
+	/** @brief The steady clock time in nanoseconds when the driver intercepted the vibration */
+	int64_t timestampNanoseconds;
+
+	/** @brief The OpenVR component handle of the haptic component */
+	uint64_t componentHandle;
+
+	/** @brief The device index of the device */
+	uint8_t deviceIndex;
+
+	/** @brief The HapticEventFlag's of the vibration */
+	uint8_t flags;
+
+	/** @brief Offset into the path table of the path of the haptic component */
+	uint16_t pathOffset;
+
+	float durationSeconds;
+	float frequency;
+	float amplitude;
+};
+
+static_assert(sizeof(HapticEventRecord) == 40, "Haptic event records must stay compact");
+
+/**
+ * @brief The status of a processed client command, stored in the command status ring at its version modulo
+ * COMMAND_STATUS_RING_SIZE
+ */
+struct CommandStatusEntry {
+	/** @brief The lane version of the command, written last so readers can detect torn or overwritten entries */
+	std::atomic<uint64_t> version;
+
+	/** @brief The client sequence id of the command */
+	uint64_t sequence;
+
+	/** @brief The CommandStatus of the command */
+	uint32_t status;
+
+	/** @brief The steady clock time in nanoseconds when the command was applied, shared by all processes */
+	int64_t appliedTimeNanoseconds;
 };
 
 /**
  * @brief Represents the metadata for a single state snapshot in the driver-client lane. Each ObjectEntry is
  * immediately followed a <X>Serialized struct matching the type, containing type specific information
  */
-struct ObjectEntry {
-	/** @brief Used to check if the packet is aligned as expected in shared memory to the read header */
+struct alignas(8) ObjectEntry {
+	/**
+	 * @brief Used to check if the packet is aligned as expected in shared memory to the read header. Written last by
+	 * the writer, so it also marks the entry as fully written
+	 */
 	uint32_t alignmentCheck = ALIGNMENT_CONSTANT;
 
-	/** @brief The type of Object that is being serialized */
-	ObjectType type;
+	/** @brief The size in bytes of the entry and its serialized data, before padding to FRAME_ALIGNMENT */
+	uint16_t frameSize;
+
+	/** @brief The ObjectType that is being serialized */
+	uint8_t type;
+
+	/** @brief True if this object is currently active/valid, false if it should be removed */
+	bool valid;
 
 	/** @brief The device index of the device */
-	uint32_t deviceIndex;
+	uint8_t deviceIndex;
 
 	/** @brief Offset into the path table identifying the target input */
-	uint32_t inputPathOffset;
+	uint16_t inputPathOffset;
 
-	/** @brief Version number for ordering and packet age */
-	uint64_t version;
-
-	/** @brief True if this object is currently active/valid, false if it should be removed */
-	bool valid;
+	/** @brief The low 32 bits of the version, for ordering and packet age, widened again by the reader */
+	uint32_t version;
 
-	/** @brief True/1 if this object has successfully and fully finish writing to shared memory */
-	alignas(64) std::atomic<uint64_t> committed;
+	/** @brief The CRC32C of the entry and serialized data around this field, see computeFrameChecksum */
+	uint32_t checksum;
 };
 
+static_assert(sizeof(ObjectEntry) == 24, "Object entries must stay compact");
+static_assert(PATH_TABLE_SIZE <= UINT16_MAX, "Path offsets must fit in the 16 bit inputPathOffset field");
+
 /**
  * @brief Serialized representation of a device pose, containing both the current and overwritten pose values
  */
@@ -175,6 +542,12 @@ struct DevicePoseSerialized {
 
 	/** @brief The overwritten pose as managed by Conduit */
 	DevicePose overwrittenPose;
+
+	/**
+	 * @brief The steady clock time in nanoseconds when the vendor driver reported <pose>, shared by all processes. The
+	 * pose itself is from poseTimeOffset seconds later
+	 */
+	int64_t updateTimeNanoseconds;
 };
 
 /**
@@ -235,23 +608,40 @@ struct DeviceInputEyeTrackingSerialized {
 /**
  * @brief Header for client-to-driver command packets, containing metadata about the command
  */
-struct ClientCommandHeader {
-	/** @brief Used to verify proper alignment when reading from shared memory */
+struct alignas(8) ClientCommandHeader {
+	/**
+	 * @brief Used to verify proper alignment when reading from shared memory. Written last by the writer, so it also
+	 * marks the command as fully written
+	 */
 	uint32_t alignmentCheck = ALIGNMENT_CONSTANT;
 
-	/** @brief The type of command being sent */
-	ClientCommandType type;
+	/** @brief The size in bytes of the header and its command params, before padding to FRAME_ALIGNMENT */
+	uint16_t frameSize;
+
+	/** @brief The ClientCommandType of the command being sent */
+	uint8_t type;
 
 	/** @brief The index of the target device */
-	uint32_t deviceIndex;
+	uint8_t deviceIndex;
 
-	/** @brief Version number for ordering and packet age */
-	uint64_t version;
+	/** @brief The low 32 bits of the version, for ordering and packet age, widened again by the reader */
+	uint32_t version;
 
-	/** @brief Indicates whether the command has been fully written and is ready to be read */
-	alignas(64) std::atomic<uint64_t> committed;
+	/** @brief The CRC32C of the header and command params around this field, see computeFrameChecksum */
+	uint32_t checksum;
+
+	/** @brief The client sequence id of the command, echoed in its status entry, or 0 for batch markers */
+	uint64_t sequence;
+
+	/**
+	 * @brief The steady clock time in nanoseconds at which the driver should apply the command, or 0 to apply it as
+	 * soon as it is read
+	 */
+	int64_t applyTimeNanoseconds;
 };
 
+static_assert(sizeof(ClientCommandHeader) == 32, "Command headers must stay compact");
+
 /**
  * @brief Parameters for the SetUseOverriddenStateDevicePose command
  */
@@ -266,6 +656,8 @@ struct CommandParams_SetUseOverriddenStateDevicePose {
 struct CommandParams_SetOverriddenStateDevicePose {
 	/** @brief The pose value to use when override is enabled */
 	DevicePose overriddenPose;
+	/** @brief The PoseOverrideField's taken from <overriddenPose>, where the rest follow the natural pose */
+	uint32_t fieldMask;
 };
 
 /**
@@ -306,6 +698,11 @@ struct CommandParams_SetOverriddenStateDeviceInputSkeleton {
 	SkeletonInput overriddenValue;
 	/** @brief Offset into the path table identifying the target input */
 	uint32_t inputPathOffset;
+	/**
+	 * @brief Bit i set takes bone i from <overriddenValue>, where the rest follow the natural skeleton. Unless it is
+	 * ALL_SKELETON_BONES, the natural motion range and bone count are kept
+	 */
+	uint32_t boneMask;
 };
 
 /**
@@ -328,6 +725,146 @@ struct CommandParams_SetOverriddenStateDeviceInputEyeTracking {
 	uint32_t inputPathOffset;
 };
 
+/**
+ * @brief Parameters for the SetPoseTransformRules command
+ */
+struct CommandParams_SetPoseTransformRules {
+	/** @brief The number of rules in <rules> that are used, where 0 clears all rules of the device */
+	uint32_t ruleCount;
+	/** @brief The rules to apply in order to each natural pose of the device */
+	PoseTransformRule rules[MAX_POSE_TRANSFORM_RULES];
+};
+
+/**
+ * @brief Parameters for the SetInputTransformRules command
+ */
+struct CommandParams_SetInputTransformRules {
+	/** @brief Offset into the path table identifying the target input */
+	uint32_t inputPathOffset;
+	/** @brief The number of rules in <rules> that are used, where 0 clears all rules of the input */
+	uint32_t ruleCount;
+	/** @brief The rules to apply in order to each natural value of the input */
+	InputTransformRule rules[MAX_INPUT_TRANSFORM_RULES];
+};
+
+/**
+ * @brief Parameters for the LoadInputFilterProgram command
+ */
+struct CommandParams_LoadInputFilterProgram {
+	/** @brief Offset into the path table identifying the boolean or scalar input the program filters */
+	uint32_t inputPathOffset;
+	/** @brief The number of instructions in <instructions> that are used, where 0 unloads the program of the input */
+	uint32_t instructionCount;
+	/** @brief The program bytecode */
+	FilterInstruction instructions[MAX_FILTER_INSTRUCTIONS];
+	/** @brief The number of bindings in <bindingDeviceIndexes> and <bindingPathOffsets> that are used */
+	uint32_t bindingCount;
+	/** @brief The device index of each binding */
+	uint32_t bindingDeviceIndexes[MAX_FILTER_BINDINGS];
+	/** @brief Offset into the path table identifying the input of each binding */
+	uint32_t bindingPathOffsets[MAX_FILTER_BINDINGS];
+};
+
+/**
+ * @brief Parameters for the SetPoseSmoothingFilter command
+ */
+struct CommandParams_SetPoseSmoothingFilter {
+	/** @brief The filter to apply to each natural pose of the device, where SmoothingFilter_None disables it */
+	SmoothingFilterConfig config;
+};
+
+/**
+ * @brief Parameters for the SetScalarSmoothingFilter command
+ */
+struct CommandParams_SetScalarSmoothingFilter {
+	/** @brief Offset into the path table identifying the target scalar input */
+	uint32_t inputPathOffset;
+	/** @brief The filter to apply to each natural value of the input, where SmoothingFilter_None disables it */
+	SmoothingFilterConfig config;
+};
+
+/**
+ * @brief Parameters for the BeginBatch command, which opens a transaction frame. Commands up to the matching
+ * CommitBatch are staged by the driver and applied together
+ */
+struct CommandParams_BeginBatch {
+	/** @brief The number of commands between this command and the matching CommitBatch */
+	uint32_t commandCount;
+};
+
+/**
+ * @brief Parameters for the CommitBatch command, which closes a transaction frame
+ */
+struct CommandParams_CommitBatch {
+	/** @brief The number of commands in the batch, which must match the staged count or the batch is discarded */
+	uint32_t commandCount;
+};
+
+/**
+ * @brief Parameters for the LoadAnimationTrack command, which makes the driver copy a keyframe track out of its upload
+ * slot in the animation blob region. The slot is free to be rewritten once the command completes
+ */
+struct CommandParams_LoadAnimationTrack {
+	/** @brief The id of the track, which is also the index of its upload slot */
+	uint32_t trackId;
+	/** @brief The type of the track, deciding which keyframe struct the slot holds */
+	AnimationTrackType type;
+	/** @brief The number of keyframes in the slot, sorted by time */
+	uint32_t keyframeCount;
+};
+
+/**
+ * @brief Parameters for the PlayPoseAnimation command
+ */
+struct CommandParams_PlayPoseAnimation {
+	/** @brief The id of the pose track to play, or NO_ANIMATION_TRACK to stop playback */
+	uint32_t trackId;
+	/** @brief The playback configuration, where only <blendOutSeconds> is used when stopping */
+	AnimationPlaybackConfig config;
+};
+
+/**
+ * @brief Parameters for the PlayInputAnimation command
+ */
+struct CommandParams_PlayInputAnimation {
+	/** @brief Offset into the path table identifying the target scalar or skeleton input */
+	uint32_t inputPathOffset;
+	/** @brief The id of the track to play, which must match the input type, or NO_ANIMATION_TRACK to stop playback */
+	uint32_t trackId;
+	/** @brief The playback configuration, where only <blendOutSeconds> is used when stopping */
+	AnimationPlaybackConfig config;
+};
+
+/**
+ * @brief Parameters for the SetPoseExtrapolation command
+ */
+struct CommandParams_SetPoseExtrapolation {
+	/** @brief The dead reckoning to apply to the overridden pose of the device */
+	PoseExtrapolationConfig config;
+};
+
+/**
+ * @brief Parameters for the InjectHapticPulse command
+ */
+struct CommandParams_InjectHapticPulse {
+	/** @brief Offset into the path table identifying the target haptic component */
+	uint32_t inputPathOffset;
+	/** @brief The vibration to deliver to the device, as VREvent_HapticVibration_t would describe it */
+	float durationSeconds;
+	float frequency;
+	float amplitude;
+};
+
+/**
+ * @brief Parameters for the SetHapticSuppression command
+ */
+struct CommandParams_SetHapticSuppression {
+	/** @brief Offset into the path table identifying the target haptic component */
+	uint32_t inputPathOffset;
+	/** @brief True to keep vibrations sent by applications from reaching the device, they are still published */
+	bool suppressed;
+};
+
 /**
  * @brief Parsed data from an ObjectEntry, used for processing after reading from shared memory
  */
@@ -358,6 +895,10 @@ struct ClientCommandHeaderData {
 	uint32_t deviceIndex;
 	/** @brief Version number for ordering and packet age */
 	uint64_t version;
+	/** @brief The client sequence id of the command */
+	uint64_t sequence;
+	/** @brief The steady clock time in nanoseconds at which to apply the command, or 0 to apply it immediately */
+	int64_t applyTimeNanoseconds;
 };
 
 /**
@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "DeviceTypes.h"
+#include "Utils.h"
+
+/**
+ * Benchmarks the batch pose conversions and the skeleton bone widening and narrowing against the field by field
+ * scalar conversions they replaced, which are kept here as the reference. Every result of the SIMD path is first
+ * checked against the reference, then both paths are timed over a full set of devices and a full hand of bones.
+ * Returns nonzero if the two paths disagree
+ */
+
+/** @brief The number of poses converted per batch, one for every device OpenVR supports */
+static const uint32_t POSE_BATCH_SIZE = 64;
+
+/** @brief The number of bones in a hand skeleton */
+static const uint32_t BONE_COUNT = 31;
+
+/** @brief The number of batches each conversion is timed over */
+static const uint32_t BENCHMARK_ITERATIONS = 100000;
+
+static uint32_t failureCount = 0;
+
+static void check(bool condition, const char* description) {
+	if (!condition) failureCount++;
+	std::printf("  [%s] %s\n", condition ? "PASS" : "FAIL", description);
+}
+
+/*
+ * Scalar reference
+ */
+
+static DevicePose ScalarFromDriverPose(const vr::DriverPose_t& pose) {
+	DevicePose cp{};
+	cp.poseTimeOffset = pose.poseTimeOffset;
+
+	cp.qWorldFromDriverRotation = {
+		pose.qWorldFromDriverRotation.w,
+		pose.qWorldFromDriverRotation.x,
+		pose.qWorldFromDriverRotation.y,
+		pose.qWorldFromDriverRotation.z
+	};
+	std::copy(
+		std::begin(pose.vecWorldFromDriverTranslation),
+		std::end(pose.vecWorldFromDriverTranslation),
+		cp.vecWorldFromDriverTranslation
+	);
+
+	cp.qDriverFromHeadRotation = {
+		pose.qDriverFromHeadRotation.w,
+		pose.qDriverFromHeadRotation.x,
+		pose.qDriverFromHeadRotation.y,
+		pose.qDriverFromHeadRotation.z
+	};
+	std::copy(
+		std::begin(pose.vecDriverFromHeadTranslation),
+		std::end(pose.vecDriverFromHeadTranslation),
+		cp.vecDriverFromHeadTranslation
+	);
+
+	std::copy(std::begin(pose.vecPosition), std::end(pose.vecPosition), cp.vecPosition);
+	std::copy(std::begin(pose.vecVelocity), std::end(pose.vecVelocity), cp.vecVelocity);
+	std::copy(std::begin(pose.vecAcceleration), std::end(pose.vecAcceleration), cp.vecAcceleration);
+
+	cp.qRotation = { pose.qRotation.w, pose.qRotation.x, pose.qRotation.y, pose.qRotation.z };
+
+	std::copy(std::begin(pose.vecAngularVelocity), std::end(pose.vecAngularVelocity), cp.vecAngularVelocity);
+	std::copy(
+		std::begin(pose.vecAngularAcceleration),
+		std::end(pose.vecAngularAcceleration),
+		cp.vecAngularAcceleration
+	);
+
+	cp.result = static_cast<DeviceTrackingResult>(pose.result);
+
+	cp.poseIsValid = pose.poseIsValid;
+	cp.willDriftInYaw = pose.willDriftInYaw;
+	cp.shouldApplyHeadModel = pose.shouldApplyHeadModel;
+	cp.deviceIsConnected = pose.deviceIsConnected;
+
+	return cp;
+}
+
+static vr::DriverPose_t ScalarToDriverPose(const DevicePose& cp) {
+	vr::DriverPose_t pose{};
+	pose.poseTimeOffset = cp.poseTimeOffset;
+
+	pose.qWorldFromDriverRotation = {
+		cp.qWorldFromDriverRotation.w,
+		cp.qWorldFromDriverRotation.x,
+		cp.qWorldFromDriverRotation.y,
+		cp.qWorldFromDriverRotation.z
+	};
+	std::copy(
+		std::begin(cp.vecWorldFromDriverTranslation),
+		std::end(cp.vecWorldFromDriverTranslation),
+		pose.vecWorldFromDriverTranslation
+	);
+
+	pose.qDriverFromHeadRotation = {
+		cp.qDriverFromHeadRotation.w,
+		cp.qDriverFromHeadRotation.x,
+		cp.qDriverFromHeadRotation.y,
+		cp.qDriverFromHeadRotation.z
+	};
+	std::copy(
+		std::begin(cp.vecDriverFromHeadTranslation),
+		std::end(cp.vecDriverFromHeadTranslation),
+		pose.vecDriverFromHeadTranslation
+	);
+
+	std::copy(std::begin(cp.vecPosition), std::end(cp.vecPosition), pose.vecPosition);
+	std::copy(std::begin(cp.vecVelocity), std::end(cp.vecVelocity), pose.vecVelocity);
+	std::copy(std::begin(cp.vecAcceleration), std::end(cp.vecAcceleration), pose.vecAcceleration);
+
+	pose.qRotation = { cp.qRotation.w, cp.qRotation.x, cp.qRotation.y, cp.qRotation.z };
+
+	std::copy(std::begin(cp.vecAngularVelocity), std::end(cp.vecAngularVelocity), pose.vecAngularVelocity);
+	std::copy(
+		std::begin(cp.vecAngularAcceleration),
+		std::end(cp.vecAngularAcceleration),
+		pose.vecAngularAcceleration
+	);
+
+	pose.result = static_cast<vr::ETrackingResult>(cp.result);
+
+	pose.poseIsValid = cp.poseIsValid;
+	pose.willDriftInYaw = cp.willDriftInYaw;
+	pose.shouldApplyHeadModel = cp.shouldApplyHeadModel;
+	pose.deviceIsConnected = cp.deviceIsConnected;
+
+	return pose;
+}
+
+static void ScalarToVRBoneTransforms(const SkeletonInput& input, vr::VRBoneTransform_t* outTransforms) {
+	for (uint32_t i = 0; i < input.boneTransformCount; i++) {
+		const BoneTransform& bt = input.boneTransforms[i];
+		outTransforms[i].position = {
+			static_cast<float>(bt.position.v[0]),
+			static_cast<float>(bt.position.v[1]),
+			static_cast<float>(bt.position.v[2]),
+			static_cast<float>(bt.position.v[3])
+		};
+		outTransforms[i].orientation = {
+			static_cast<float>(bt.orientation.w),
+			static_cast<float>(bt.orientation.x),
+			static_cast<float>(bt.orientation.y),
+			static_cast<float>(bt.orientation.z)
+		};
+	}
+}
+
+static void ScalarFromVRBoneTransforms(const vr::VRBoneTransform_t* transforms, uint32_t count, SkeletonInput& out) {
+	out.boneTransformCount = count;
+	for (uint32_t i = 0; i < count; i++) {
+		const vr::VRBoneTransform_t& bt = transforms[i];
+		out.boneTransforms[i].position = { bt.position.v[0], bt.position.v[1], bt.position.v[2], bt.position.v[3] };
+		out.boneTransforms[i].orientation = { bt.orientation.w, bt.orientation.x, bt.orientation.y, bt.orientation.z };
+	}
+}
+
+/*
+ * Inputs
+ */
+
+static vr::DriverPose_t MakeDriverPose(uint32_t seed) {
+	// Every double gets its own value, so a field copied to the wrong place can't go unnoticed
+	vr::DriverPose_t pose = {};
+	double* values = reinterpret_cast<double*>(&pose);
+	for (size_t i = 0; i < offsetof(vr::DriverPose_t, result) / sizeof(double); i++) values[i] = seed * 100.0 + i;
+
+	pose.result = vr::TrackingResult_Running_OK;
+	pose.poseIsValid = true;
+	pose.willDriftInYaw = (seed & 1) != 0;
+	pose.shouldApplyHeadModel = (seed & 2) != 0;
+	pose.deviceIsConnected = true;
+	return pose;
+}
+
+static void MakeBoneTransforms(vr::VRBoneTransform_t* transforms) {
+	for (uint32_t bone = 0; bone < BONE_COUNT; bone++) {
+		float base = bone * 0.125f;
+		transforms[bone].position = { { base, base + 0.25f, base + 0.5f, 1.0f } };
+		transforms[bone].orientation = { 1.0f - base * 0.01f, base * 0.01f, -base * 0.02f, base * 0.03f };
+	}
+}
+
+static bool SamePose(const DevicePose& a, const DevicePose& b) {
+	return memcmp(&a, &b, offsetof(DevicePose, result)) == 0 &&
+		a.result == b.result &&
+		a.poseIsValid == b.poseIsValid &&
+		a.willDriftInYaw == b.willDriftInYaw &&
+		a.shouldApplyHeadModel == b.shouldApplyHeadModel &&
+		a.deviceIsConnected == b.deviceIsConnected;
+}
+
+static bool SameDriverPose(const vr::DriverPose_t& a, const vr::DriverPose_t& b) {
+	return memcmp(&a, &b, offsetof(vr::DriverPose_t, result)) == 0 &&
+		a.result == b.result &&
+		a.poseIsValid == b.poseIsValid &&
+		a.willDriftInYaw == b.willDriftInYaw &&
+		a.shouldApplyHeadModel == b.shouldApplyHeadModel &&
+		a.deviceIsConnected == b.deviceIsConnected;
+}
+
+/*
+ * Checks
+ */
+
+static void CheckAgainstScalar(
+	const std::vector<vr::DriverPose_t>& driverPoses,
+	const vr::VRBoneTransform_t* transforms
+) {
+	std::printf("The SIMD path matches the scalar path\n");
+
+	std::vector<DevicePose> poses(POSE_BATCH_SIZE);
+	FromDriverPoses(driverPoses.data(), POSE_BATCH_SIZE, poses.data());
+
+	bool fromMatches = true;
+	for (uint32_t i = 0; i < POSE_BATCH_SIZE; i++) {
+		fromMatches = fromMatches && SamePose(poses[i], ScalarFromDriverPose(driverPoses[i]));
+	}
+	check(fromMatches, "FromDriverPoses matches the field by field conversion");
+
+	std::vector<vr::DriverPose_t> roundTrip(POSE_BATCH_SIZE);
+	ToDriverPoses(poses.data(), POSE_BATCH_SIZE, roundTrip.data());
+
+	bool toMatches = true;
+	for (uint32_t i = 0; i < POSE_BATCH_SIZE; i++) {
+		toMatches = toMatches && SameDriverPose(roundTrip[i], ScalarToDriverPose(poses[i]));
+		toMatches = toMatches && SameDriverPose(roundTrip[i], driverPoses[i]);
+	}
+	check(toMatches, "ToDriverPoses matches the field by field conversion and round trips");
+
+	SkeletonInput widened = {};
+	SkeletonInput scalarWidened = {};
+	FromVRBoneTransforms(transforms, BONE_COUNT, widened);
+	ScalarFromVRBoneTransforms(transforms, BONE_COUNT, scalarWidened);
+	check(
+		widened.boneTransformCount == BONE_COUNT &&
+			memcmp(widened.boneTransforms, scalarWidened.boneTransforms, sizeof(widened.boneTransforms)) == 0,
+		"widening bones matches the per bone conversion"
+	);
+
+	vr::VRBoneTransform_t narrowed[BONE_COUNT] = {};
+	vr::VRBoneTransform_t scalarNarrowed[BONE_COUNT] = {};
+	ToVRBoneTransforms(widened, narrowed);
+	ScalarToVRBoneTransforms(widened, scalarNarrowed);
+	check(
+		memcmp(narrowed, scalarNarrowed, sizeof(narrowed)) == 0 &&
+			memcmp(narrowed, transforms, sizeof(narrowed)) == 0,
+		"narrowing bones matches the per bone conversion and round trips"
+	);
+}
+
+/*
+ * Benchmark
+ */
+
+/**
+ * @brief Times <convert> over BENCHMARK_ITERATIONS calls after a warm up
+ * @return The average time per call in nanoseconds
+ */
+template <typename Convert>
+static double TimePerCall(Convert convert) {
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS / 10; i++) convert();
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) convert();
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+	return elapsed.count() / BENCHMARK_ITERATIONS;
+}
+
+static void PrintComparison(const char* name, double scalarNanoseconds, double simdNanoseconds) {
+	std::printf(
+		"%-28s %10.1f %10.1f %8.2fx\n",
+		name,
+		scalarNanoseconds,
+		simdNanoseconds,
+		scalarNanoseconds / simdNanoseconds
+	);
+}
+
+static void BenchmarkConversions(
+	const std::vector<vr::DriverPose_t>& driverPoses,
+	const vr::VRBoneTransform_t* transforms
+) {
+	std::printf("Cost per batch of %u poses or %u bones\n", POSE_BATCH_SIZE, BONE_COUNT);
+	std::printf("conversion                    scalar ns    simd ns  speedup\n");
+
+	std::vector<DevicePose> poses(POSE_BATCH_SIZE);
+	std::vector<vr::DriverPose_t> outPoses(POSE_BATCH_SIZE);
+	SkeletonInput skeleton = {};
+	vr::VRBoneTransform_t outTransforms[BONE_COUNT];
+
+	// The outputs are read back after every call, so the compiler can't drop the conversions
+	volatile double sink = 0.0;
+
+	double scalar = TimePerCall([&] {
+		for (uint32_t i = 0; i < POSE_BATCH_SIZE; i++) poses[i] = ScalarFromDriverPose(driverPoses[i]);
+		sink = poses[POSE_BATCH_SIZE - 1].vecPosition[0];
+	});
+	double simd = TimePerCall([&] {
+		FromDriverPoses(driverPoses.data(), POSE_BATCH_SIZE, poses.data());
+		sink = poses[POSE_BATCH_SIZE - 1].vecPosition[0];
+	});
+	PrintComparison("FromDriverPoses", scalar, simd);
+
+	scalar = TimePerCall([&] {
+		for (uint32_t i = 0; i < POSE_BATCH_SIZE; i++) outPoses[i] = ScalarToDriverPose(poses[i]);
+		sink = outPoses[POSE_BATCH_SIZE - 1].vecPosition[0];
+	});
+	simd = TimePerCall([&] {
+		ToDriverPoses(poses.data(), POSE_BATCH_SIZE, outPoses.data());
+		sink = outPoses[POSE_BATCH_SIZE - 1].vecPosition[0];
+	});
+	PrintComparison("ToDriverPoses", scalar, simd);
+
+	scalar = TimePerCall([&] {
+		ScalarFromVRBoneTransforms(transforms, BONE_COUNT, skeleton);
+		sink = skeleton.boneTransforms[BONE_COUNT - 1].orientation.z;
+	});
+	simd = TimePerCall([&] {
+		FromVRBoneTransforms(transforms, BONE_COUNT, skeleton);
+		sink = skeleton.boneTransforms[BONE_COUNT - 1].orientation.z;
+	});
+	PrintComparison("FromVRBoneTransforms (widen)", scalar, simd);
+
+	scalar = TimePerCall([&] {
+		ScalarToVRBoneTransforms(skeleton, outTransforms);
+		sink = outTransforms[BONE_COUNT - 1].orientation.z;
+	});
+	simd = TimePerCall([&] {
+		ToVRBoneTransforms(skeleton, outTransforms);
+		sink = outTransforms[BONE_COUNT - 1].orientation.z;
+	});
+	PrintComparison("ToVRBoneTransforms (narrow)", scalar, simd);
+}
+
+int main() {
+	std::vector<vr::DriverPose_t> driverPoses(POSE_BATCH_SIZE);
+	for (uint32_t i = 0; i < POSE_BATCH_SIZE; i++) driverPoses[i] = MakeDriverPose(i);
+
+	vr::VRBoneTransform_t transforms[BONE_COUNT];
+	MakeBoneTransforms(transforms);
+
+	CheckAgainstScalar(driverPoses, transforms);
+	BenchmarkConversions(driverPoses, transforms);
+
+	std::printf("%u checks failed\n", failureCount);
+	return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#include <windows.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+
+#include "CommandScheduler.h"
+#include "DeviceStateModelDriver.h"
+#include "DeviceTypes.h"
+#include "InputFilterEngine.h"
+#include "ObjectSchemas.h"
+#include "SharedDeviceMemoryDriver.h"
+
+/**
+ * Benchmarks driver subsystems that run inside the update hooks on their own, without a mock runtime. Each section
+ * checks that the subsystem does what is timed before reporting its cost per call. The shared memory is created for
+ * the command scheduler, which acknowledges the commands it applies. Returns nonzero if any check failed
+ */
+
+/** @brief The number of calls each configuration is timed over */
+static const uint32_t BENCHMARK_ITERATIONS = 1000000;
+
+static uint32_t failureCount = 0;
+
+static void check(bool condition, const char* description) {
+	if (!condition) failureCount++;
+	std::printf("  [%s] %s\n", condition ? "PASS" : "FAIL", description);
+}
+
+/**
+ * @brief Times <call> over BENCHMARK_ITERATIONS calls after a warm up, passing the iteration to each call
+ * @return The average time per call in nanoseconds
+ */
+template <typename Call>
+static double TimePerCall(Call call) {
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS / 10; i++) call(i);
+
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) call(i);
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+	return elapsed.count() / BENCHMARK_ITERATIONS;
+}
+
+/*
+ * Input filter programs
+ */
+
+/** @brief The scalar input the filter program is loaded for */
+static const vr::VRInputComponentHandle_t FILTERED_TRIGGER = 0x100;
+
+/** @brief The scalar input read through the only binding of the program */
+static const vr::VRInputComponentHandle_t BOUND_GRIP = 0x101;
+
+/** @brief A scalar input without a program */
+static const vr::VRInputComponentHandle_t UNFILTERED_INPUT = 0x102;
+
+/**
+ * @brief A trigger program as a client would write one: a dead zone rescaled to the full range, a squared response
+ * curve and exponential smoothing kept in a register, forced fully pressed while the bound grip is held
+ */
+static const FilterInstruction TRIGGER_PROGRAM[] = {
+	{ Filter_LoadInput },
+	{ Filter_Push, 0, 0.05 },
+	{ Filter_Sub },
+	{ Filter_Push, 0, 0.0 },
+	{ Filter_Max },
+	{ Filter_Push, 0, 1.0 / 0.95 },
+	{ Filter_Mul },
+	{ Filter_Dup },
+	{ Filter_Mul },
+	{ Filter_LoadRegister, 0 },
+	{ Filter_Sub },
+	{ Filter_Push, 0, 0.5 },
+	{ Filter_Mul },
+	{ Filter_LoadRegister, 0 },
+	{ Filter_Add },
+	{ Filter_Dup },
+	{ Filter_StoreRegister, 0 },
+	{ Filter_LoadBinding, 0 },
+	{ Filter_Push, 0, 0.5 },
+	{ Filter_Greater },
+	{ Filter_JumpIfZero, 23 },
+	{ Filter_Push, 0, 1.0 },
+	{ Filter_Max },
+	{ Filter_Return }
+};
+
+static void BenchmarkFilterPrograms() {
+	std::printf("InputFilterEngine::filterScalar with a %zu instruction trigger program\n", std::size(TRIGGER_PROGRAM));
+
+	InputFilterEngine& engine = InputFilterEngine::getInstance();
+	bool loaded = engine.loadProgram(
+		FILTERED_TRIGGER,
+		false,
+		TRIGGER_PROGRAM,
+		static_cast<uint32_t>(std::size(TRIGGER_PROGRAM)),
+		&BOUND_GRIP,
+		1
+	);
+	check(loaded, "the program passes verification");
+
+	// The smoothing register starts at 0, so the first output is half of the curved value
+	float value = 0.8f;
+	bool filtered = engine.filterScalar(FILTERED_TRIGGER, value, 0.0);
+	double curved = (0.8f - 0.05) / 0.95;
+	check(filtered && std::abs(value - curved * curved * 0.5) < 1e-6, "the first sample is filtered as expected");
+
+	value = 0.8f;
+	check(!engine.filterScalar(UNFILTERED_INPUT, value, 0.0) && value == 0.8f, "inputs without a program pass");
+
+	// The output is read back after every call, so the compiler can't drop the calls
+	volatile float sink = 0.0f;
+
+	double withoutProgram = TimePerCall([&](uint32_t i) {
+		float sample = (i % 100) * 0.01f;
+		engine.filterScalar(UNFILTERED_INPUT, sample, 0.0);
+		sink = sample;
+	});
+	double withProgram = TimePerCall([&](uint32_t i) {
+		float sample = (i % 100) * 0.01f;
+		engine.filterScalar(FILTERED_TRIGGER, sample, 0.0);
+		sink = sample;
+	});
+
+	std::printf("  an input without a program, while another has one: %.1f ns\n", withoutProgram);
+	std::printf("  the input with the program: %.1f ns\n", withProgram);
+
+	engine.loadProgram(FILTERED_TRIGGER, false, nullptr, 0, nullptr, 0);
+}
+
+/*
+ * Command scheduler
+ */
+
+/** @brief The device the scheduled commands target, registered without a runtime */
+static const uint32_t SCHEDULED_DEVICE_INDEX = 1;
+
+/** @brief The number of commands scheduled for each configuration */
+static const uint32_t SCHEDULED_COMMAND_COUNT = 1024;
+
+/** @brief The number of times the due commands are scheduled and applied */
+static const uint32_t DUE_ROUNDS = 200;
+
+/**
+ * @brief Schedules a command that turns the pose override of SCHEDULED_DEVICE_INDEX on or off
+ * @param version The lane version of the command, which breaks ties between equal apply times
+ * @param applyTime The steady clock time to apply the command at
+ * @param useOverriddenState The state the command sets
+ * @return True if the command was scheduled, false if the scheduler is full
+ */
+static bool ScheduleOverrideToggle(uint64_t version, int64_t applyTime, bool useOverriddenState) {
+	ClientCommandHeaderData header = {};
+	header.successful = true;
+	header.type = Command_SetUseOverriddenStateDevicePose;
+	header.deviceIndex = SCHEDULED_DEVICE_INDEX;
+	header.version = version;
+	header.applyTimeNanoseconds = applyTime;
+
+	std::unique_ptr<uint8_t[]> params(new uint8_t[sizeof(CommandParams_SetUseOverriddenStateDevicePose)]);
+	reinterpret_cast<CommandParams_SetUseOverriddenStateDevicePose*>(params.get())->useOverriddenState =
+		useOverriddenState;
+
+	return CommandScheduler::getInstance().schedule(header, std::move(params));
+}
+
+static void BenchmarkCommandScheduler() {
+	std::printf("CommandScheduler::applyDueCommands with %u scheduled commands\n", SCHEDULED_COMMAND_COUNT);
+
+	CommandScheduler& scheduler = CommandScheduler::getInstance();
+	DeviceStateModel::getInstance().addDevicePose(SCHEDULED_DEVICE_INDEX);
+	ModelDevicePoseSerialized* pose = DeviceStateModel::getInstance().getDevicePose(SCHEDULED_DEVICE_INDEX);
+
+	double emptyHeap = TimePerCall([&](uint32_t) { scheduler.applyDueCommands(); });
+
+	// Every command of a round is already due, and only the last one turns the override on. Commands scheduled straight
+	// into the scheduler have no status entry to update, which leaves acknowledging them out of the timing
+	uint64_t version = 0;
+	double dueTotal = 0.0;
+	bool allApplied = true;
+	for (uint32_t round = 0; round < DUE_ROUNDS; round++) {
+		int64_t applyTime = CommandScheduler::now();
+		for (uint32_t i = 0; i < SCHEDULED_COMMAND_COUNT; i++) {
+			ScheduleOverrideToggle(++version, applyTime, i == SCHEDULED_COMMAND_COUNT - 1);
+		}
+		pose->useOverriddenState = false;
+
+		auto start = std::chrono::steady_clock::now();
+		scheduler.applyDueCommands();
+		dueTotal += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		allApplied = allApplied && pose->useOverriddenState;
+	}
+	check(allApplied, "a single call applies every due command in order");
+
+	// Left scheduled until the process exits, they only come due an hour from now
+	bool allScheduled = true;
+	int64_t futureTime = CommandScheduler::now() + 3600LL * 1000000000LL;
+	for (uint32_t i = 0; i < SCHEDULED_COMMAND_COUNT; i++) {
+		allScheduled = allScheduled && ScheduleOverrideToggle(++version, futureTime + i, false);
+	}
+	check(allScheduled, "the future commands are scheduled");
+
+	pose->useOverriddenState = true;
+	double futureHeap = TimePerCall([&](uint32_t) { scheduler.applyDueCommands(); });
+	check(pose->useOverriddenState, "commands that aren't due are left alone");
+
+	std::printf("  empty heap: %.1f ns\n", emptyHeap);
+	std::printf("  heap of future commands: %.1f ns\n", futureHeap);
+	std::printf(
+		"  heap of due commands: %.1f ns per call, %.1f ns per command\n",
+		dueTotal / DUE_ROUNDS,
+		dueTotal / DUE_ROUNDS / SCHEDULED_COMMAND_COUNT
+	);
+}
+
+int main() {
+	// Creating the shared memory would clobber the mapping of a running driver
+	HANDLE existingMapping = OpenFileMappingA(FILE_MAP_READ, FALSE, SHM_NAME);
+	if (existingMapping) {
+		CloseHandle(existingMapping);
+		std::printf("The Conduit shared memory already exists, close SteamVR before running the benchmarks\n");
+		return 2;
+	}
+
+	if (!SharedDeviceMemoryDriver::getInstance().initialize(false, false)) {
+		std::printf("Failed to initialize the shared memory\n");
+		return 2;
+	}
+
+	BenchmarkFilterPrograms();
+	BenchmarkCommandScheduler();
+
+	std::printf("%u checks failed\n", failureCount);
+	return failureCount == 0 ? 0 : 1;
+}
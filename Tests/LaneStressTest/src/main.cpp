@@ -0,0 +1,406 @@
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LaneFraming.h"
+#include "ObjectSchemas.h"
+#include "SharedDeviceMemoryDriver.h"
+
+/**
+ * Stress tests the driver-client lane with many producers, as when several vendor drivers update devices from their
+ * own threads. Every producer writes boolean frames carrying its own sequence number, while a strict reader checks
+ * each published frame for its magic, size, checksum and version, and that the sequences of every producer only ever
+ * increase. Gaps in a sequence are frames the writer dropped because the lane was full, anything else the reader
+ * can't account for is corruption. Reports throughput and write latency per producer count, including more producers
+ * than hardware threads, where a producer preempted between reserving and publishing its frame holds up every
+ * producer behind it. The whole run is repeated with the default mapping and with the locked mapping, where the
+ * shared memory is backed by large pages when available and prefaulted and locked, each in its own process since the
+ * driver maps the shared memory once. Each run ends with a ping-pong between a single producer and the reader, where
+ * the producer waits for the reader to release every frame before writing the next, timing the round trip through
+ * the lane cursors. Returns nonzero if any frame was corrupted
+ */
+
+/** @brief The number of frames each producer writes per run */
+static const uint32_t WRITES_PER_PRODUCER = 100000;
+
+/** @brief The number of frames a single producer sends one at a time in the ping-pong run */
+static const uint32_t PING_PONG_ROUND_TRIPS = 100000;
+
+/** @brief The most producers a run uses, since producer ids are written to the 8 bit device index */
+static const uint32_t MAX_PRODUCERS = 64;
+
+/** @brief The input path every producer writes to */
+static const std::string STRESS_PATH = "/input/stress/click";
+
+/** @brief The size of every frame in the lane */
+static const uint32_t STRESS_FRAME_SIZE = sizeof(ObjectEntry) + sizeof(DeviceInputBooleanSerialized);
+
+/** @brief The size of a boolean override frame in the client-driver lane, for the packets per lap report */
+static const uint32_t COMMAND_FRAME_SIZE =
+	sizeof(ClientCommandHeader) + sizeof(CommandParams_SetOverriddenStateDeviceInputBoolean);
+
+/**
+ * @brief Returns how many frames of a size fit in one lap of a lane, before the writer reaches the padding at its end
+ * and wraps
+ */
+static uint32_t GetFramesPerLap(uint32_t frameSize) {
+	uint32_t stride = getFrameStride(frameSize);
+	return (LANE_SIZE - LANE_PADDING_SIZE + stride - 1) / stride;
+}
+
+/** @brief The reader side of the lane, kept across runs since the lane is never reset */
+struct LaneReader {
+	SharedMemoryHeader* header = nullptr;
+	uint8_t* lane = nullptr;
+	uint32_t readOffset = 0;
+	uint64_t readCount = 0;
+};
+
+/** @brief What the reader found during a single run */
+struct RunResult {
+	uint64_t framesRead = 0;
+	uint64_t framesDropped = 0;
+	uint64_t framesCorrupted = 0;
+};
+
+/**
+ * @brief Reads every frame published until <producersDone> is set and the lane is drained, checking each one
+ * @param producerCount The number of producers of the run, so device indices past it are corruption
+ */
+static void ReadLane(
+	LaneReader& reader,
+	uint32_t producerCount,
+	const std::atomic<bool>& producersDone,
+	RunResult& result
+) {
+	std::vector<int64_t> lastSequences(producerCount, -1);
+	uint8_t frame[STRESS_FRAME_SIZE];
+
+	while (true) {
+		uint64_t writeCount = reader.header->driverClientWriteCount.load(std::memory_order_acquire);
+		if (reader.readCount == writeCount) {
+			if (producersDone.load(std::memory_order_acquire) &&
+				reader.header->driverClientWriteCount.load(std::memory_order_acquire) == writeCount) break;
+
+			std::this_thread::yield();
+			continue;
+		}
+
+		while (reader.readCount < writeCount) {
+			// The writer left a wrap marker here and continued from the start of the lane
+			if (reader.readOffset >= LANE_SIZE - LANE_PADDING_SIZE) {
+				uint32_t marker;
+				memcpy(&marker, reader.lane + reader.readOffset, sizeof(marker));
+				if (marker != WRAP_MARKER_CONSTANT) {
+					std::printf("  Missing wrap marker at offset %u\n", reader.readOffset);
+					result.framesCorrupted++;
+					return;
+				}
+				reader.readOffset = 0;
+			}
+
+			// The frame is checked on a copy, so a writer overwriting it mid read shows up as a bad checksum
+			memcpy(frame, reader.lane + reader.readOffset, STRESS_FRAME_SIZE);
+			ObjectEntry* entry = reinterpret_cast<ObjectEntry*>(frame);
+			DeviceInputBooleanSerialized* data = reinterpret_cast<DeviceInputBooleanSerialized*>(entry + 1);
+
+			const char* problem = nullptr;
+			if (entry->alignmentCheck != ALIGNMENT_CONSTANT) problem = "bad magic";
+			else if (entry->frameSize != STRESS_FRAME_SIZE) problem = "bad frame size";
+			else if (entry->checksum != computeFrameChecksum(entry)) problem = "bad checksum";
+			else if (widenFrameVersion(entry->version, reader.readCount) != reader.readCount) problem = "out of order";
+			else if (entry->type != Object_InputBoolean || entry->deviceIndex >= producerCount) problem = "bad entry";
+
+			int64_t sequence = static_cast<int64_t>(data->value.timeOffset);
+			if (!problem && sequence <= lastSequences[entry->deviceIndex]) problem = "sequence went backwards";
+
+			if (problem) {
+				std::printf("  Frame %llu at offset %u: %s\n", reader.readCount, reader.readOffset, problem);
+				result.framesCorrupted++;
+				return;
+			}
+
+			result.framesDropped += sequence - lastSequences[entry->deviceIndex] - 1;
+			lastSequences[entry->deviceIndex] = sequence;
+			result.framesRead++;
+
+			reader.readOffset = (reader.readOffset + getFrameStride(STRESS_FRAME_SIZE)) % LANE_SIZE;
+			reader.readCount++;
+			reader.header->driverClientReadOffset.store(reader.readOffset, std::memory_order_release);
+		}
+	}
+
+	// Frames dropped after the last one that made it into the lane
+	for (int64_t lastSequence : lastSequences) result.framesDropped += WRITES_PER_PRODUCER - 1 - lastSequence;
+}
+
+/**
+ * @brief Writes WRITES_PER_PRODUCER frames through the driver, timing every write
+ * @param producer The id of the producer, written as the device index
+ * @param latencies Receives the duration of every write in nanoseconds
+ */
+static void ProduceFrames(uint32_t producer, std::vector<int64_t>& latencies) {
+	SharedDeviceMemoryDriver& driver = SharedDeviceMemoryDriver::getInstance();
+	DeviceInputBooleanSerialized packet = {};
+
+	for (uint32_t sequence = 0; sequence < WRITES_PER_PRODUCER; sequence++) {
+		packet.value.value = (sequence & 1) != 0;
+		packet.value.timeOffset = static_cast<double>(sequence);
+
+		auto start = std::chrono::steady_clock::now();
+		driver.syncDeviceInputBooleanUpdateToSharedMemory(&packet, producer, STRESS_PATH);
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		latencies[sequence] = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+	}
+}
+
+/**
+ * @brief Runs a single producer count against the reader and prints its line of the report
+ * @return True if no frame was corrupted
+ */
+static bool RunProducers(LaneReader& reader, uint32_t producerCount) {
+	std::vector<std::vector<int64_t>> latencies(producerCount, std::vector<int64_t>(WRITES_PER_PRODUCER));
+	std::atomic<bool> producersDone = false;
+	RunResult result;
+
+	auto start = std::chrono::steady_clock::now();
+	std::thread readerThread(ReadLane, std::ref(reader), producerCount, std::cref(producersDone), std::ref(result));
+
+	std::vector<std::thread> producers;
+	for (uint32_t producer = 0; producer < producerCount; producer++) {
+		producers.emplace_back(ProduceFrames, producer, std::ref(latencies[producer]));
+	}
+	for (std::thread& producer : producers) producer.join();
+
+	producersDone.store(true, std::memory_order_release);
+	readerThread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<int64_t> allLatencies;
+	allLatencies.reserve(static_cast<size_t>(producerCount) * WRITES_PER_PRODUCER);
+	for (const std::vector<int64_t>& producerLatencies : latencies) {
+		allLatencies.insert(allLatencies.end(), producerLatencies.begin(), producerLatencies.end());
+	}
+	std::sort(allLatencies.begin(), allLatencies.end());
+
+	std::printf(
+		"%9u %12.0f %10.1f %10llu %9llu %9lld %9lld %11lld\n",
+		producerCount,
+		result.framesRead / seconds,
+		result.framesRead * static_cast<double>(getFrameStride(STRESS_FRAME_SIZE)) / seconds / 1000000.0,
+		result.framesDropped,
+		result.framesCorrupted,
+		allLatencies[allLatencies.size() / 2],
+		allLatencies[allLatencies.size() * 99 / 100],
+		allLatencies.back()
+	);
+
+	return result.framesCorrupted == 0;
+}
+
+/** @brief The argument a child process is started with to run with the default mapping */
+static const char* DEFAULT_MAPPING_ARGUMENT = "--default-mapping";
+
+/** @brief The argument a child process is started with to run with the locked mapping */
+static const char* LOCKED_MAPPING_ARGUMENT = "--locked-mapping";
+
+/**
+ * @brief Releases every frame as soon as it is published, without checking it, until <done> is set. Spins instead of
+ * yielding, so the round trip measures the lane cursors rather than the scheduler
+ */
+static void EchoLane(LaneReader& reader, const std::atomic<bool>& done) {
+	while (!done.load(std::memory_order_acquire)) {
+		uint64_t writeCount = reader.header->driverClientWriteCount.load(std::memory_order_acquire);
+		if (reader.readCount == writeCount) continue;
+
+		for (; reader.readCount < writeCount; reader.readCount++) {
+			if (reader.readOffset >= LANE_SIZE - LANE_PADDING_SIZE) reader.readOffset = 0;
+			reader.readOffset = (reader.readOffset + getFrameStride(STRESS_FRAME_SIZE)) % LANE_SIZE;
+		}
+
+		reader.header->driverClientReadOffset.store(reader.readOffset, std::memory_order_release);
+	}
+}
+
+/**
+ * @brief Sends PING_PONG_ROUND_TRIPS frames from a single producer, each one only once the reader released the one
+ * before, and prints the round trip latency
+ */
+static void RunPingPong(LaneReader& reader) {
+	SharedDeviceMemoryDriver& driver = SharedDeviceMemoryDriver::getInstance();
+	DeviceInputBooleanSerialized packet = {};
+	std::vector<int64_t> latencies(PING_PONG_ROUND_TRIPS);
+
+	std::atomic<bool> done = false;
+	std::thread readerThread(EchoLane, std::ref(reader), std::cref(done));
+
+	for (uint32_t sequence = 0; sequence < PING_PONG_ROUND_TRIPS; sequence++) {
+		packet.value.value = (sequence & 1) != 0;
+		packet.value.timeOffset = static_cast<double>(sequence);
+
+		// Every frame moves the read offset, so a changed offset means the reader released this frame
+		uint32_t readOffset = reader.header->driverClientReadOffset.load(std::memory_order_acquire);
+
+		auto start = std::chrono::steady_clock::now();
+		driver.syncDeviceInputBooleanUpdateToSharedMemory(&packet, 0, STRESS_PATH);
+		while (reader.header->driverClientReadOffset.load(std::memory_order_acquire) == readOffset) {}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		latencies[sequence] = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+	}
+
+	done.store(true, std::memory_order_release);
+	readerThread.join();
+
+	std::sort(latencies.begin(), latencies.end());
+	std::printf(
+		"Ping-pong, 1 producer, %u round trips: p50 %lld ns, p99 %lld ns, max %lld ns\n",
+		PING_PONG_ROUND_TRIPS,
+		latencies[latencies.size() / 2],
+		latencies[latencies.size() * 99 / 100],
+		latencies.back()
+	);
+}
+
+/**
+ * @brief Runs every producer count against a freshly created shared memory and prints the report
+ * @param lockedMapping Whether the driver backs the shared memory with large pages and prefaults and locks it
+ * @return The exit code of the run
+ */
+static int RunStressTest(bool lockedMapping) {
+	if (!SharedDeviceMemoryDriver::getInstance().initialize(lockedMapping, false)) {
+		std::printf("Failed to initialize the shared memory\n");
+		return 2;
+	}
+
+	// The reader maps the shared memory separately, as a client app would
+	HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, SHM_NAME);
+	void* sharedMemory = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0) : nullptr;
+	if (!sharedMemory) {
+		std::printf("Failed to map the shared memory: %lu\n", GetLastError());
+		return 2;
+	}
+
+	LaneReader reader;
+	reader.header = static_cast<SharedMemoryHeader*>(sharedMemory);
+	reader.lane = static_cast<uint8_t*>(sharedMemory) + reader.header->driverClientLaneStart;
+	reader.readOffset = reader.header->driverClientWriteOffset.load(std::memory_order_acquire);
+	reader.readCount = reader.header->driverClientWriteCount.load(std::memory_order_acquire);
+	reader.header->driverClientReadOffset.store(reader.readOffset, std::memory_order_release);
+
+	std::vector<uint32_t> producerCounts = { 1, 2, 4, 8, 16 };
+	uint32_t oversubscribed = std::min(std::max(std::thread::hardware_concurrency(), 1u) * 2, MAX_PRODUCERS);
+	if (oversubscribed > producerCounts.back()) producerCounts.push_back(oversubscribed);
+
+	uint32_t mappingFlags = reader.header->mappingFlags;
+	std::printf(
+		"%s mapping (%s, %s), %u frames per producer, %u hardware threads\n",
+		lockedMapping ? "Locked" : "Default",
+		(mappingFlags & SharedMemoryMapping_LargePages) ? "large pages" : "regular pages",
+		(mappingFlags & SharedMemoryMapping_Locked) ? "locked" : "not locked",
+		WRITES_PER_PRODUCER,
+		std::thread::hardware_concurrency()
+	);
+	std::printf(
+		"Boolean updates: %u bytes with a %zu byte entry, %u per lap of the driver-client lane\n",
+		STRESS_FRAME_SIZE,
+		sizeof(ObjectEntry),
+		GetFramesPerLap(STRESS_FRAME_SIZE)
+	);
+	std::printf(
+		"Boolean overrides: %u bytes with a %zu byte header, %u per lap of the client-driver lane\n",
+		COMMAND_FRAME_SIZE,
+		sizeof(ClientCommandHeader),
+		GetFramesPerLap(COMMAND_FRAME_SIZE)
+	);
+	std::printf("producers     frames/s       MB/s    dropped corrupted    p50 ns    p99 ns      max ns\n");
+
+	bool passed = true;
+	for (uint32_t producerCount : producerCounts) {
+		if (!RunProducers(reader, producerCount)) {
+			passed = false;
+			break;
+		}
+	}
+
+	if (passed) RunPingPong(reader);
+
+	UnmapViewOfFile(sharedMemory);
+	CloseHandle(mapping);
+
+	std::printf(passed ? "No frames were corrupted\n\n" : "Frames were corrupted\n\n");
+	return passed ? 0 : 1;
+}
+
+/**
+ * @brief Runs this executable again with a single argument, sharing this console, and waits for it to exit
+ * @param argument The argument to pass
+ * @return The exit code of the child process, or 2 if it could not be started
+ */
+static int RunChildProcess(const char* argument) {
+	char executablePath[MAX_PATH];
+	GetModuleFileNameA(nullptr, executablePath, MAX_PATH);
+
+	std::string commandLine = std::string("\"") + executablePath + "\" " + argument;
+
+	STARTUPINFOA startupInfo = {};
+	startupInfo.cb = sizeof(startupInfo);
+	startupInfo.dwFlags = STARTF_USESTDHANDLES;
+	startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+	startupInfo.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+	startupInfo.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+	PROCESS_INFORMATION processInfo = {};
+	if (!CreateProcessA(
+		nullptr,
+		commandLine.data(),
+		nullptr,
+		nullptr,
+		TRUE,
+		0,
+		nullptr,
+		nullptr,
+		&startupInfo,
+		&processInfo
+	)) {
+		std::printf("Failed to start the %s run: %lu\n", argument, GetLastError());
+		return 2;
+	}
+
+	WaitForSingleObject(processInfo.hProcess, INFINITE);
+
+	DWORD exitCode = 2;
+	GetExitCodeProcess(processInfo.hProcess, &exitCode);
+	CloseHandle(processInfo.hThread);
+	CloseHandle(processInfo.hProcess);
+
+	return static_cast<int>(exitCode);
+}
+
+int main(int argc, char* argv[]) {
+	// Creating the shared memory would clobber the mapping of a running driver
+	HANDLE existingMapping = OpenFileMappingA(FILE_MAP_READ, FALSE, SHM_NAME);
+	if (existingMapping) {
+		CloseHandle(existingMapping);
+		std::printf("The Conduit shared memory already exists, close SteamVR before running the test\n");
+		return 2;
+	}
+
+	if (argc > 1 && strcmp(argv[1], DEFAULT_MAPPING_ARGUMENT) == 0) return RunStressTest(false);
+	if (argc > 1 && strcmp(argv[1], LOCKED_MAPPING_ARGUMENT) == 0) return RunStressTest(true);
+
+	// Each mapping runs in its own process, one after the other, so they never share the machine
+	std::fflush(stdout);
+	int defaultResult = RunChildProcess(DEFAULT_MAPPING_ARGUMENT);
+	int lockedResult = RunChildProcess(LOCKED_MAPPING_ARGUMENT);
+
+	return (std::max)(defaultResult, lockedResult);
+}
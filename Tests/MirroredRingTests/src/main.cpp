@@ -0,0 +1,114 @@
+#include <windows.h>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "LaneFraming.h"
+#include "MirroredRing.h"
+#include "ObjectSchemas.h"
+
+/**
+ * Tests the mirrored lane layout on its own. A section of LANE_SIZE bytes is mapped twice back to back through
+ * mapMirroredView, a frame is written across the end of the first view and read back in one piece, and hasLaneSpace
+ * is checked at the offsets where the mirrored and padded layouts differ. The section is unnamed, so the tests can
+ * also run alongside SteamVR. Returns nonzero if any check failed
+ */
+
+/** @brief The size in bytes of the frame written across the lane end, a header and its params */
+static const uint32_t STRADDLING_FRAME_SIZE = 1024;
+
+/** @brief How many bytes of the frame are written before the lane end, the rest continues at the lane start */
+static const uint32_t BYTES_BEFORE_LANE_END = 256;
+
+static uint32_t failureCount = 0;
+
+static void check(bool condition, const char* description) {
+	if (!condition) failureCount++;
+	std::printf("  [%s] %s\n", condition ? "PASS" : "FAIL", description);
+}
+
+/*
+ * Tests
+ */
+
+static void TestFrameAcrossLaneEnd(uint8_t* lane) {
+	std::printf("A frame written across the lane end reads back in one piece\n");
+
+	alignas(ClientCommandHeader) uint8_t frame[STRADDLING_FRAME_SIZE];
+	ClientCommandHeader* header = new (frame) ClientCommandHeader();
+	header->frameSize = STRADDLING_FRAME_SIZE;
+	header->type = Command_SetUseOverriddenStateDevicePose;
+	header->version = 1;
+	for (uint32_t i = sizeof(ClientCommandHeader); i < STRADDLING_FRAME_SIZE; i++) frame[i] = static_cast<uint8_t>(i);
+	header->checksum = computeFrameChecksum(header);
+
+	// Written through the first view only, the way writers do once the lane is mirrored
+	uint32_t writeOffset = LANE_SIZE - BYTES_BEFORE_LANE_END;
+	writeFrame(lane + writeOffset, frame, STRADDLING_FRAME_SIZE);
+
+	const ClientCommandHeader* read = reinterpret_cast<const ClientCommandHeader*>(lane + writeOffset);
+	check(read->alignmentCheck == ALIGNMENT_CONSTANT, "the magic is read back at the write offset");
+	check(
+		read->frameSize == STRADDLING_FRAME_SIZE && computeFrameChecksum(read) == read->checksum,
+		"the checksum of the whole frame matches"
+	);
+	check(memcmp(read, frame, STRADDLING_FRAME_SIZE) == 0, "every byte is read back contiguously");
+	check(
+		memcmp(lane, frame + BYTES_BEFORE_LANE_END, STRADDLING_FRAME_SIZE - BYTES_BEFORE_LANE_END) == 0,
+		"the bytes past the lane end are at the start of the lane"
+	);
+
+	// The mirroring goes both ways, so writes through the start of the lane show up past the end of the first view
+	lane[0] ^= 0xFF;
+	check(lane[LANE_SIZE] == lane[0], "writes to the lane start are seen through the second view");
+	lane[0] ^= 0xFF;
+}
+
+static void TestMirroredLaneSpace() {
+	std::printf("hasLaneSpace of a mirrored lane at its boundaries\n");
+
+	// A frame may never fill the lane completely, since equal offsets mean an empty lane
+	check(hasLaneSpace(0, 0, LANE_SIZE - FRAME_ALIGNMENT, true), "an empty lane fits all but one alignment");
+	check(!hasLaneSpace(0, 0, LANE_SIZE, true), "an empty lane doesn't fit a frame of its whole size");
+
+	check(hasLaneSpace(1024, 1024 + 64, 64 - FRAME_ALIGNMENT, true), "a frame stopping short of the reader fits");
+	check(!hasLaneSpace(1024, 1024 + 64, 64, true), "a frame reaching the reader doesn't fit");
+
+	uint32_t nearEnd = LANE_SIZE - 64;
+	check(hasLaneSpace(nearEnd, 0, 64 - FRAME_ALIGNMENT, true), "a frame ending just short of a reader at 0 fits");
+	check(!hasLaneSpace(nearEnd, 0, 64, true), "a frame reaching a reader at 0 doesn't fit");
+
+	// Inside the padding the padded layout first wraps to the start of the lane, where the reader is in the way
+	check(hasLaneSpace(nearEnd, 256, 288, true), "a frame straddling the lane end fits up to the reader");
+	check(!hasLaneSpace(nearEnd, 256, 288, false), "the padded layout refuses the same frame");
+	check(!hasLaneSpace(nearEnd, 256, 320, true), "a frame straddling the lane end past the reader doesn't fit");
+
+	check(
+		hasLaneSpace(0, LANE_SIZE - FRAME_ALIGNMENT, LANE_SIZE - 2 * FRAME_ALIGNMENT, true),
+		"a reader just before the lane end leaves the rest of the lane"
+	);
+}
+
+int main() {
+	HANDLE section = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, LANE_SIZE, nullptr);
+	if (!section) {
+		std::printf("Failed to create the section: %lu\n", GetLastError());
+		return 2;
+	}
+
+	uint8_t* lane = mapMirroredView(section, LANE_SIZE);
+	if (!lane) {
+		std::printf("Failed to map the mirrored views, which needs Windows 10 version 1803: %lu\n", GetLastError());
+		CloseHandle(section);
+		return 2;
+	}
+
+	TestFrameAcrossLaneEnd(lane);
+	TestMirroredLaneSpace();
+
+	unmapMirroredView(lane, LANE_SIZE);
+	CloseHandle(section);
+
+	std::printf("%u checks failed\n", failureCount);
+	return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,785 @@
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommandScheduler.h"
+#include "ConduitPluginApi.h"
+#include "DeviceStateCommandSender.h"
+#include "DeviceStateModelDriver.h"
+#include "HookFunctions.h"
+#include "HookUpdateQueue.h"
+#include "IDeviceStateEventReceiver.h"
+#include "LaneFraming.h"
+#include "ObjectSchemas.h"
+#include "PluginManager.h"
+#include "SharedDeviceMemoryDriver.h"
+
+/**
+ * Tests the driver plugin path against a mock OpenVR runtime. The original function pointers the hooks forward to are
+ * replaced by recording mocks, and the hooks are then called directly, the way the vendor driver would call them once
+ * they are installed. Plugins are linked into this process and registered through PluginManager::registerPlugin().
+ * Ends with benchmarks of the hook overhead per loaded plugin, and with and without a client attached. The lib is
+ * linked in as well and attached last, since its poll thread keeps it attached until the process exits, to time
+ * what a client sees end to end and to compare a plugin override against the same override made by a client. Returns
+ * nonzero if any check failed
+ */
+
+/** @brief The device the tests update, registered without a runtime so its properties are never read */
+static const uint32_t TEST_DEVICE_INDEX = 1;
+
+/** @brief The property container the mock runtime hands out for the test device */
+static const vr::PropertyContainerHandle_t TEST_CONTAINER = 0x1000;
+
+/** @brief The input the tests update */
+static const char* TRIGGER_PATH = "/input/trigger/click";
+
+/** @brief The input the override latency benchmark mirrors the trigger onto */
+static const char* BUTTON_PATH = "/input/a/click";
+
+/** @brief The number of calls in a row a plugin may overrun its budget, MAX_PLUGIN_BUDGET_OVERRUNS in the driver */
+static const uint32_t MAX_BUDGET_OVERRUNS = 8;
+
+/** @brief The number of hook calls each configuration of the benchmark is timed over */
+static const uint32_t BENCHMARK_ITERATIONS = 200000;
+
+/** @brief The number of vibrations timed from the event hook to the lib listener */
+static const uint32_t HAPTIC_EVENT_COUNT = 200;
+
+/** @brief The number of trigger changes timed until they are mirrored onto the button, kept even */
+static const uint32_t OVERRIDE_ROUND_COUNT = 200;
+
+/** @brief The time between the button updates that wait for an override, standing in for the vendor driver's rate */
+static const std::chrono::microseconds BUTTON_UPDATE_INTERVAL(10);
+
+static uint32_t failureCount = 0;
+
+static void check(bool condition, const char* description) {
+	if (!condition) failureCount++;
+	std::printf("  [%s] %s\n", condition ? "PASS" : "FAIL", description);
+}
+
+/*
+ * Mock runtime
+ */
+
+static std::atomic<vr::VRInputComponentHandle_t> nextComponentHandle = 0x100;
+static std::atomic<uint32_t> runtimeBooleanCalls = 0;
+static std::atomic<bool> runtimeBooleanValue = false;
+static std::atomic<uint32_t> runtimePoseCalls = 0;
+static vr::DriverPose_t runtimePose = {};
+
+/** @brief The event the mock runtime hands out on the next PollNextEvent() call, if <runtimeEventPending> is set */
+static vr::VREvent_t runtimeEvent = {};
+static bool runtimeEventPending = false;
+
+static vr::PropertyContainerHandle_t MockTrackedDeviceToPropertyContainer(
+	void* _this,
+	vr::TrackedDeviceIndex_t nDevice
+) {
+	return TEST_CONTAINER + nDevice;
+}
+
+static vr::EVRInputError MockCreateBooleanComponent(
+	void* _this,
+	vr::PropertyContainerHandle_t ulContainer,
+	const char* pchName,
+	vr::VRInputComponentHandle_t* pHandle
+) {
+	*pHandle = nextComponentHandle.fetch_add(1);
+	return vr::VRInputError_None;
+}
+
+static vr::EVRInputError MockUpdateBooleanComponent(
+	void* _this,
+	vr::VRInputComponentHandle_t ulComponent,
+	bool bNewValue,
+	double fTimeOffset
+) {
+	runtimeBooleanValue.store(bNewValue);
+	runtimeBooleanCalls.fetch_add(1);
+	return vr::VRInputError_None;
+}
+
+static vr::EVRInputError MockCreateHapticComponent(
+	void* _this,
+	vr::PropertyContainerHandle_t ulContainer,
+	const char* pchName,
+	vr::VRInputComponentHandle_t* pHandle
+) {
+	*pHandle = nextComponentHandle.fetch_add(1);
+	return vr::VRInputError_None;
+}
+
+static bool MockPollNextEvent(void* _this, vr::VREvent_t* pEvent, uint32_t uncbVREvent) {
+	if (!runtimeEventPending) return false;
+
+	runtimeEventPending = false;
+	memcpy(pEvent, &runtimeEvent, (std::min)(static_cast<size_t>(uncbVREvent), sizeof(vr::VREvent_t)));
+	return true;
+}
+
+static void MockTrackedDevicePoseUpdated(
+	void* _this,
+	uint32_t unWhichDevice,
+	const vr::DriverPose_t& newPose,
+	uint32_t unPoseStructSize
+) {
+	runtimePose = newPose;
+	runtimePoseCalls.fetch_add(1);
+}
+
+/*
+ * Mock plugins
+ */
+
+/** @brief The callbacks and counters of a plugin linked into the test, handed to every callback as its user data */
+struct MockPlugin {
+	ConduitPluginCallbacks callbacks = {};
+
+	/** @brief How long each callback spins, to overrun the budget */
+	std::chrono::microseconds callbackDuration = std::chrono::microseconds(0);
+
+	/**
+	 * @brief What the boolean callback does besides counting. Mirror copies the value of every other input onto the
+	 * override of <overrideComponent>
+	 */
+	enum class BooleanAction { None, Invert, SetOverride, ClearOverride, Mirror } booleanAction = BooleanAction::None;
+
+	/** @brief The component the boolean callback overrides */
+	uint64_t overrideComponent = 0;
+
+	std::atomic<uint32_t> callCount = 0;
+	std::atomic<uint32_t> activeCalls = 0;
+	std::atomic<uint32_t> shutdownCount = 0;
+	std::atomic<uint32_t> shutdownsDuringCallback = 0;
+	std::atomic<uint32_t> callsAfterShutdown = 0;
+
+	/** @brief The natural pose read through the host API during the last pose callback */
+	ConduitDevicePose naturalPose = {};
+	bool naturalPoseRead = false;
+};
+
+static const ConduitHostApi* hostApi = nullptr;
+static MockPlugin* registeringPlugin = nullptr;
+
+static void SpinFor(std::chrono::microseconds duration) {
+	auto end = std::chrono::steady_clock::now() + duration;
+	while (std::chrono::steady_clock::now() < end) {}
+}
+
+static void EnterCallback(MockPlugin& plugin) {
+	plugin.activeCalls.fetch_add(1);
+	plugin.callCount.fetch_add(1);
+	if (plugin.shutdownCount.load() != 0) plugin.callsAfterShutdown.fetch_add(1);
+	if (plugin.callbackDuration.count() > 0) SpinFor(plugin.callbackDuration);
+}
+
+static int32_t MockOnBooleanInput(void* userData, uint64_t componentHandle, int32_t* value, double* timeOffset) {
+	MockPlugin& plugin = *static_cast<MockPlugin*>(userData);
+	EnterCallback(plugin);
+
+	int32_t changed = 0;
+	switch (plugin.booleanAction) {
+	case MockPlugin::BooleanAction::Invert:
+		*value = !*value;
+		changed = 1;
+		break;
+	case MockPlugin::BooleanAction::SetOverride:
+		hostApi->setOverriddenBoolean(plugin.overrideComponent, 1, 1);
+		break;
+	case MockPlugin::BooleanAction::ClearOverride:
+		hostApi->setOverriddenBoolean(plugin.overrideComponent, 0, 0);
+		break;
+	case MockPlugin::BooleanAction::Mirror:
+		if (componentHandle == plugin.overrideComponent) break;
+		hostApi->setOverriddenBoolean(plugin.overrideComponent, *value, 1);
+		break;
+	default:
+		break;
+	}
+
+	plugin.activeCalls.fetch_sub(1);
+	return changed;
+}
+
+static int32_t MockOnDevicePose(void* userData, uint32_t deviceIndex, ConduitDevicePose* pose) {
+	MockPlugin& plugin = *static_cast<MockPlugin*>(userData);
+	EnterCallback(plugin);
+
+	plugin.naturalPoseRead = hostApi->getNaturalDevicePose(deviceIndex, &plugin.naturalPose) != 0;
+	pose->position[1] += 1.0;
+
+	plugin.activeCalls.fetch_sub(1);
+	return 1;
+}
+
+static int32_t MockOnBooleanInputTrivial(void* userData, uint64_t componentHandle, int32_t* value, double* timeOffset) {
+	return 0;
+}
+
+static void MockShutdown(void* userData) {
+	MockPlugin& plugin = *static_cast<MockPlugin*>(userData);
+	if (plugin.activeCalls.load() != 0) plugin.shutdownsDuringCallback.fetch_add(1);
+	plugin.shutdownCount.fetch_add(1);
+}
+
+static int32_t MockPluginInit(uint32_t apiVersion, const ConduitHostApi* host, ConduitPluginCallbacks* callbacks) {
+	hostApi = host;
+	*callbacks = registeringPlugin->callbacks;
+	callbacks->userData = registeringPlugin;
+	callbacks->shutdown = MockShutdown;
+	return 1;
+}
+
+static bool RegisterMockPlugin(MockPlugin& plugin, const char* name) {
+	plugin.callbacks.name = name;
+	registeringPlugin = &plugin;
+	return PluginManager::getInstance().registerPlugin(name, MockPluginInit);
+}
+
+/*
+ * Hook calls
+ */
+
+static vr::VRInputComponentHandle_t triggerHandle = 0;
+
+static void UpdateTrigger(bool value) {
+	overrideUpdateBooleanComponent(nullptr, triggerHandle, value, 0.0);
+}
+
+static vr::VRInputComponentHandle_t buttonHandle = 0;
+
+static void UpdateButton(bool value) {
+	overrideUpdateBooleanComponent(nullptr, buttonHandle, value, 0.0);
+}
+
+static vr::DriverPose_t MakePose(double x) {
+	vr::DriverPose_t pose = {};
+	pose.poseIsValid = true;
+	pose.deviceIsConnected = true;
+	pose.result = vr::TrackingResult_Running_OK;
+	pose.qRotation.w = 1.0;
+	pose.qWorldFromDriverRotation.w = 1.0;
+	pose.qDriverFromHeadRotation.w = 1.0;
+	pose.vecPosition[0] = x;
+	return pose;
+}
+
+static void UpdatePose(double x) {
+	overrideTrackedDevicePoseUpdated(nullptr, TEST_DEVICE_INDEX, MakePose(x), sizeof(vr::DriverPose_t));
+}
+
+/** @brief The shared memory header as the lib maps it, used to stand in for a client */
+static SharedMemoryHeader* clientHeader = nullptr;
+
+/**
+ * @brief Attaches or detaches a client the way the lib does, through its heartbeat, and lets the driver notice
+ * @param attached Whether a client should be attached
+ */
+static void SetClientAttached(bool attached) {
+	if (attached) clientHeader->clientGeneration.fetch_add(1, std::memory_order_release);
+	clientHeader->clientHeartbeatNanoseconds.store(attached ? CommandScheduler::now() : 0, std::memory_order_release);
+	SharedDeviceMemoryDriver::getInstance().pollForClientUpdates();
+}
+
+/*
+ * Tests
+ */
+
+static void TestPassThrough() {
+	std::printf("Values pass through unchanged without plugins\n");
+
+	UpdateTrigger(true);
+	check(runtimeBooleanValue.load(), "the runtime receives the natural boolean");
+
+	UpdatePose(0.5);
+	check(
+		runtimePose.vecPosition[0] == 0.5 && runtimePose.vecPosition[1] == 0.0,
+		"the runtime receives the natural pose"
+	);
+}
+
+static void TestPluginChangesValues() {
+	std::printf("Plugin changes reach the runtime\n");
+
+	MockPlugin plugin;
+	plugin.booleanAction = MockPlugin::BooleanAction::Invert;
+	plugin.callbacks.onBooleanInput = MockOnBooleanInput;
+	plugin.callbacks.onDevicePose = MockOnDevicePose;
+	check(RegisterMockPlugin(plugin, "Changes values"), "the plugin registers");
+
+	UpdateTrigger(true);
+	check(!runtimeBooleanValue.load(), "the runtime receives the inverted boolean");
+
+	UpdatePose(0.25);
+	check(runtimePose.vecPosition[1] == 1.0, "the runtime receives the moved pose");
+
+	PluginManager::getInstance().unloadPlugins();
+	check(plugin.shutdownCount.load() == 1, "unloading shuts the plugin down once");
+}
+
+static void TestNaturalPoseWithoutClient() {
+	std::printf("getNaturalDevicePose follows the vendor driver without a client attached\n");
+
+	MockPlugin plugin;
+	plugin.callbacks.onDevicePose = MockOnDevicePose;
+	RegisterMockPlugin(plugin, "Natural pose");
+
+	UpdatePose(2.0);
+	check(plugin.naturalPoseRead && plugin.naturalPose.position[0] == 2.0, "the first pose is read back");
+
+	UpdatePose(3.0);
+	check(plugin.naturalPoseRead && plugin.naturalPose.position[0] == 3.0, "a later pose replaces it");
+	check(plugin.naturalPose.position[1] == 0.0, "the pose read back is the one before the plugin moved it");
+
+	PluginManager::getInstance().unloadPlugins();
+}
+
+static void TestOverrideAppliesOnNextHook() {
+	std::printf("Overrides set by a plugin apply from the next hook call\n");
+
+	MockPlugin plugin;
+	plugin.overrideComponent = triggerHandle;
+	plugin.callbacks.onBooleanInput = MockOnBooleanInput;
+	RegisterMockPlugin(plugin, "Overrides");
+
+	plugin.booleanAction = MockPlugin::BooleanAction::SetOverride;
+	UpdateTrigger(false);
+	check(!runtimeBooleanValue.load(), "the hook that set the override still sends the natural value");
+
+	plugin.booleanAction = MockPlugin::BooleanAction::None;
+	UpdateTrigger(false);
+	check(runtimeBooleanValue.load(), "the next hook sends the overridden value");
+
+	plugin.booleanAction = MockPlugin::BooleanAction::ClearOverride;
+	UpdateTrigger(false);
+	plugin.booleanAction = MockPlugin::BooleanAction::None;
+	UpdateTrigger(false);
+	check(!runtimeBooleanValue.load(), "clearing the override restores the natural value");
+
+	PluginManager::getInstance().unloadPlugins();
+}
+
+static void TestBudgetOverrunDisablesPlugin() {
+	std::printf("A plugin that keeps overrunning its budget is disabled\n");
+
+	MockPlugin plugin;
+	plugin.callbacks.budgetMicroseconds = 1;
+	plugin.callbackDuration = std::chrono::microseconds(50);
+	plugin.callbacks.onBooleanInput = MockOnBooleanInput;
+	RegisterMockPlugin(plugin, "Overruns");
+
+	uint32_t runtimeCallsBefore = runtimeBooleanCalls.load();
+	for (uint32_t i = 0; i < MAX_BUDGET_OVERRUNS * 2; i++) UpdateTrigger(true);
+
+	check(plugin.callCount.load() == MAX_BUDGET_OVERRUNS, "the plugin is not called once disabled");
+	check(plugin.shutdownCount.load() == 1, "the disabled plugin is shut down once");
+	check(
+		runtimeBooleanCalls.load() - runtimeCallsBefore == MAX_BUDGET_OVERRUNS * 2,
+		"every update still reaches the runtime"
+	);
+
+	PluginManager::getInstance().unloadPlugins();
+	check(plugin.shutdownCount.load() == 1, "unloading does not shut it down again");
+}
+
+static void TestShutdownWaitsForCallbacks() {
+	std::printf("A plugin disabled by one hook thread is shut down only after every callback returned\n");
+
+	MockPlugin plugin;
+	plugin.callbacks.budgetMicroseconds = 1;
+	plugin.callbackDuration = std::chrono::microseconds(20);
+	plugin.callbacks.onBooleanInput = MockOnBooleanInput;
+	RegisterMockPlugin(plugin, "Concurrent overruns");
+
+	std::vector<std::thread> hookThreads;
+	for (uint32_t thread = 0; thread < 4; thread++) {
+		hookThreads.emplace_back([] {
+			for (uint32_t i = 0; i < 2000; i++) UpdateTrigger((i & 1) != 0);
+		});
+	}
+	for (std::thread& thread : hookThreads) thread.join();
+
+	check(plugin.shutdownCount.load() == 1, "the plugin is shut down once");
+	check(plugin.shutdownsDuringCallback.load() == 0, "shutdown never runs alongside a callback");
+	check(plugin.callsAfterShutdown.load() == 0, "no callback runs after shutdown");
+
+	PluginManager::getInstance().unloadPlugins();
+}
+
+static void TestUnloadWaitsForCallbacks() {
+	std::printf("Unloading waits for hook threads still inside a plugin callback\n");
+
+	MockPlugin plugin;
+	plugin.callbacks.budgetMicroseconds = 1000000;
+	plugin.callbackDuration = std::chrono::microseconds(20000);
+	plugin.callbacks.onBooleanInput = MockOnBooleanInput;
+	RegisterMockPlugin(plugin, "Slow callback");
+
+	std::thread hookThread([] { UpdateTrigger(true); });
+	while (plugin.activeCalls.load() == 0) std::this_thread::yield();
+
+	PluginManager::getInstance().unloadPlugins();
+	check(plugin.activeCalls.load() == 0, "unloading returns only once the callback returned");
+	check(plugin.shutdownsDuringCallback.load() == 0, "shutdown never runs alongside the callback");
+	check(plugin.shutdownCount.load() == 1, "the plugin is shut down once");
+
+	hookThread.join();
+}
+
+static void TestIdleHookSkipsPublishing() {
+	std::printf("Hooks publish nothing while no client is attached\n");
+
+	SetClientAttached(false);
+	uint64_t writeCount = clientHeader->driverClientWriteCount.load(std::memory_order_acquire);
+
+	UpdateTrigger(true);
+	UpdateTrigger(false);
+
+	ModelDeviceInputBooleanSerialized* input = DeviceStateModel::getInstance().getBooleanInput(triggerHandle);
+	check(
+		clientHeader->driverClientWriteCount.load(std::memory_order_acquire) == writeCount,
+		"nothing is written to the driver-client lane"
+	);
+	check(input != nullptr && !input->data.value.value, "the model keeps the latest natural value");
+	check(!runtimeBooleanValue.load(), "the runtime still receives every update");
+}
+
+/*
+ * Benchmark
+ */
+
+static double TimeBooleanHook() {
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) UpdateTrigger((i & 1) != 0);
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+	return elapsed.count() / BENCHMARK_ITERATIONS;
+}
+
+static void BenchmarkHookOverhead() {
+	std::printf("Boolean hook cost per call, with trivial plugins that leave the value alone\n");
+
+	// Warms up the caches and the model lookups before anything is timed
+	TimeBooleanHook();
+
+	MockPlugin plugins[4];
+	uint32_t loadedCount = 0;
+	for (uint32_t pluginCount : { 0u, 1u, 4u }) {
+		while (loadedCount < pluginCount) {
+			plugins[loadedCount].callbacks.onBooleanInput = MockOnBooleanInputTrivial;
+			RegisterMockPlugin(plugins[loadedCount], "Trivial");
+			loadedCount++;
+		}
+
+		std::printf("  %u plugins: %.1f ns\n", pluginCount, TimeBooleanHook());
+	}
+
+	PluginManager::getInstance().unloadPlugins();
+}
+
+/**
+ * @brief Consumes the driver-client lane as fast as it is written until <consuming> is cleared, so the publishing
+ * paths are timed writing to a lane with space rather than dropping. Only safe with a single writer at a time
+ */
+static void ConsumeLane(const std::atomic<bool>& consuming) {
+	while (consuming.load(std::memory_order_acquire)) {
+		uint32_t writeOffset = clientHeader->driverClientWriteOffset.load(std::memory_order_acquire);
+		clientHeader->driverClientReadOffset.store(writeOffset, std::memory_order_release);
+		std::this_thread::yield();
+	}
+}
+
+static void BenchmarkPublishingPaths() {
+	std::printf("Boolean hook cost per call, without plugins, by how the value is published\n");
+
+	std::atomic<bool> consuming = true;
+	std::thread consumer(ConsumeLane, std::cref(consuming));
+
+	SetClientAttached(false);
+	TimeBooleanHook();
+	double idleNanoseconds = TimeBooleanHook();
+	std::printf("  no client attached: %.1f ns\n", idleNanoseconds);
+
+	// No worker is running yet, so the queue of this thread is full after HOOK_UPDATE_QUEUE_SIZE calls and every
+	// later call publishes from the hook itself
+	SetClientAttached(true);
+	TimeBooleanHook();
+	std::printf("  client attached, full queue: %.1f ns\n", TimeBooleanHook());
+
+	// The worker never returns, it is left running until the process exits
+	std::thread([] { HookUpdateQueue::getInstance().run(); }).detach();
+	TimeBooleanHook();
+	double drainedNanoseconds = TimeBooleanHook();
+	std::printf("  client attached, queue drained by the worker: %.1f ns\n", drainedNanoseconds);
+	std::printf("  the idle path saves %.1f ns per call\n", drainedNanoseconds - idleNanoseconds);
+
+	SetClientAttached(false);
+	consuming.store(false, std::memory_order_release);
+	consumer.join();
+}
+
+/*
+ * Lib client
+ */
+
+static DeviceStateCommandSender librarySender;
+
+/**
+ * @brief A lib event listener that records when vibrations arrive and, while <mirroringTrigger> is set, mirrors the
+ * trigger onto the override of the button the way a client would, flushing right away for the lowest latency
+ */
+class LibraryListener : public IDeviceStateEventReceiver {
+public:
+	std::atomic<uint32_t> hapticEventCount = 0;
+	std::atomic<int64_t> lastHapticEventNanoseconds = 0;
+	std::atomic<bool> mirroringTrigger = false;
+
+	void DeviceHapticEvent(uint32_t deviceIndex, std::string path, HapticEvent event) override {
+		lastHapticEventNanoseconds.store(CommandScheduler::now(), std::memory_order_relaxed);
+		hapticEventCount.fetch_add(1, std::memory_order_release);
+	}
+
+	void DeviceInputBooleanAdded(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputBooleanRemoved(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputScalarAdded(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputScalarRemoved(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputSkeletonAdded(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputSkeletonRemoved(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputPoseAdded(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputPoseRemoved(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputEyeTrackingAdded(uint32_t deviceIndex, const std::string& path) override {}
+	void DeviceInputEyeTrackingRemoved(uint32_t deviceIndex, const std::string& path) override {}
+	void DevicePoseChanged(uint32_t deviceIndex, DevicePose oldPose, DevicePose newPose) override {}
+	void DeviceInputBooleanChanged(
+		uint32_t deviceIndex,
+		std::string path,
+		BooleanInput oldInput,
+		BooleanInput newInput
+	) override {
+		if (!mirroringTrigger.load(std::memory_order_acquire) || deviceIndex != TEST_DEVICE_INDEX) return;
+		if (path != TRIGGER_PATH || newInput.value == oldInput.value) return;
+
+		librarySender.setOverriddenBooleanInputState(deviceIndex, BUTTON_PATH, newInput);
+		librarySender.flushCommands();
+	}
+	void DeviceInputScalarChanged(
+		uint32_t deviceIndex,
+		std::string path,
+		ScalarInput oldInput,
+		ScalarInput newInput
+	) override {}
+	void DeviceInputSkeletonChanged(
+		uint32_t deviceIndex,
+		std::string path,
+		SkeletonInput oldInput,
+		SkeletonInput newInput
+	) override {}
+	void DeviceInputPoseChanged(
+		uint32_t deviceIndex,
+		std::string path,
+		PoseInput oldInput,
+		PoseInput newInput
+	) override {}
+	void DeviceInputEyeTrackingChanged(
+		uint32_t deviceIndex,
+		std::string path,
+		EyeTrackingInput oldInput,
+		EyeTrackingInput newInput
+	) override {}
+};
+
+static LibraryListener libraryListener;
+
+/**
+ * @brief Initializes the lib against the shared memory of this process and waits for the driver to see it attached
+ * @return True if the lib attached
+ */
+static bool AttachLibrary() {
+	int result = librarySender.initialize();
+	if (result != 0) {
+		std::printf("Failed to initialize the lib: %d\n", result);
+		return false;
+	}
+	librarySender.addEventListener(libraryListener);
+
+	// The lib poll thread publishes its first heartbeat right away, which the driver notices on its next poll
+	SharedDeviceMemoryDriver& driver = SharedDeviceMemoryDriver::getInstance();
+	for (uint32_t attempt = 0; attempt < 1000 && !driver.isClientAttached(); attempt++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		driver.pollForClientUpdates();
+	}
+
+	return driver.isClientAttached();
+}
+
+static vr::VRInputComponentHandle_t hapticHandle = 0;
+
+/** @brief Prints the p50, p99 and max of <latencies>, given in nanoseconds */
+static void PrintLatencies(const char* label, std::vector<int64_t>& latencies) {
+	if (latencies.empty()) return;
+
+	std::sort(latencies.begin(), latencies.end());
+	std::printf(
+		"  %s: p50 %.1f us, p99 %.1f us, max %.1f us over %zu\n",
+		label,
+		latencies[latencies.size() / 2] / 1000.0,
+		latencies[latencies.size() * 99 / 100] / 1000.0,
+		latencies.back() / 1000.0,
+		latencies.size()
+	);
+}
+
+static void BenchmarkHapticLatency() {
+	std::printf("Vibration latency from the event hook to the lib listener\n");
+
+	runtimeEvent = {};
+	runtimeEvent.eventType = vr::VREvent_Input_HapticVibration;
+	runtimeEvent.data.hapticVibration.componentHandle = hapticHandle;
+	runtimeEvent.data.hapticVibration.fDurationSeconds = 0.01f;
+	runtimeEvent.data.hapticVibration.fFrequency = 160.0f;
+	runtimeEvent.data.hapticVibration.fAmplitude = 0.5f;
+
+	std::vector<int64_t> latencies;
+	bool allForwarded = true;
+	for (uint32_t i = 0; i < HAPTIC_EVENT_COUNT; i++) {
+		uint32_t deliveredCount = libraryListener.hapticEventCount.load(std::memory_order_acquire);
+		runtimeEventPending = true;
+
+		vr::VREvent_t event = {};
+		int64_t start = CommandScheduler::now();
+		allForwarded = overridePollNextEvent(nullptr, &event, sizeof(event)) &&
+			event.eventType == vr::VREvent_Input_HapticVibration && allForwarded;
+
+		// Bounded, so a vibration the lib never delivers fails the check below instead of hanging the tests
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+		while (libraryListener.hapticEventCount.load(std::memory_order_acquire) == deliveredCount &&
+			std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+
+		if (libraryListener.hapticEventCount.load(std::memory_order_acquire) == deliveredCount) break;
+		latencies.push_back(libraryListener.lastHapticEventNanoseconds.load(std::memory_order_relaxed) - start);
+	}
+
+	check(allForwarded, "every vibration still reaches the vendor driver");
+	check(latencies.size() == HAPTIC_EVENT_COUNT, "every vibration is delivered to the lib listener");
+	PrintLatencies("vibrations", latencies);
+}
+
+/**
+ * @brief Alternates the trigger OVERRIDE_ROUND_COUNT times, each time updating the button every
+ * BUTTON_UPDATE_INTERVAL until the runtime receives the new trigger value on it
+ * @return The latency of each round in nanoseconds, up to the first round whose override never arrived
+ */
+static std::vector<int64_t> TimeMirroredOverrides() {
+	std::vector<int64_t> latencies;
+	for (uint32_t round = 0; round < OVERRIDE_ROUND_COUNT; round++) {
+		bool triggerValue = (round & 1) == 0;
+		int64_t start = CommandScheduler::now();
+		UpdateTrigger(triggerValue);
+
+		// The natural button value is always false, so only its override can carry the trigger value. Bounded, so an
+		// override that never arrives fails the check instead of hanging the tests
+		bool arrived = false;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+		while (!arrived && std::chrono::steady_clock::now() < deadline) {
+			UpdateButton(false);
+			arrived = runtimeBooleanValue.load() == triggerValue;
+			if (!arrived) SpinFor(BUTTON_UPDATE_INTERVAL);
+		}
+
+		if (!arrived) break;
+		latencies.push_back(CommandScheduler::now() - start);
+	}
+
+	return latencies;
+}
+
+static void BenchmarkOverrideLatency() {
+	std::printf("Override latency from a trigger change to the button it is mirrored onto\n");
+
+	// Both loops start from a released trigger and a button overridden to released, and end there again
+	MockPlugin plugin;
+	plugin.booleanAction = MockPlugin::BooleanAction::Mirror;
+	plugin.overrideComponent = buttonHandle;
+	plugin.callbacks.onBooleanInput = MockOnBooleanInput;
+	RegisterMockPlugin(plugin, "Mirror");
+	UpdateTrigger(false);
+	UpdateButton(false);
+
+	std::vector<int64_t> pluginLatencies = TimeMirroredOverrides();
+	PluginManager::getInstance().unloadPlugins();
+
+	// The plugin left the button override in use, which the client turns on again as it would on its own. The
+	// listener only acts on changes, so the lib first catches up with the released trigger
+	librarySender.setUseOverriddenBooleanInputState(TEST_DEVICE_INDEX, BUTTON_PATH, true);
+	librarySender.flushCommands();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	libraryListener.mirroringTrigger.store(true, std::memory_order_release);
+
+	std::vector<int64_t> clientLatencies = TimeMirroredOverrides();
+	libraryListener.mirroringTrigger.store(false, std::memory_order_release);
+
+	check(pluginLatencies.size() == OVERRIDE_ROUND_COUNT, "every plugin override reaches the runtime");
+	check(clientLatencies.size() == OVERRIDE_ROUND_COUNT, "every client override reaches the runtime");
+	PrintLatencies("plugin callback and host API", pluginLatencies);
+	PrintLatencies("lib listener and command", clientLatencies);
+}
+
+int main() {
+	// Creating the shared memory would clobber the mapping of a running driver
+	HANDLE existingMapping = OpenFileMappingA(FILE_MAP_READ, FALSE, SHM_NAME);
+	if (existingMapping) {
+		CloseHandle(existingMapping);
+		std::printf("The Conduit shared memory already exists, close SteamVR before running the tests\n");
+		return 2;
+	}
+
+	if (!SharedDeviceMemoryDriver::getInstance().initialize(false, false)) {
+		std::printf("Failed to initialize the shared memory\n");
+		return 2;
+	}
+
+	HANDLE clientMapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, SHM_NAME);
+	void* clientMemory = clientMapping ? MapViewOfFile(clientMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0) : nullptr;
+	if (!clientMemory) {
+		std::printf("Failed to map the shared memory: %lu\n", GetLastError());
+		return 2;
+	}
+	clientHeader = static_cast<SharedMemoryHeader*>(clientMemory);
+
+	originalTrackedDeviceToPropertyContainer = MockTrackedDeviceToPropertyContainer;
+	originalCreateBooleanComponent = MockCreateBooleanComponent;
+	originalUpdateBooleanComponent = MockUpdateBooleanComponent;
+	originalTrackedDevicePoseUpdated = MockTrackedDevicePoseUpdated;
+	originalCreateHapticComponent = MockCreateHapticComponent;
+	originalPollNextEvent = MockPollNextEvent;
+
+	// The pose hook reads the device properties from the runtime on first sighting, so the pose is registered first
+	DeviceStateModel::getInstance().addDevicePose(TEST_DEVICE_INDEX);
+	vr::PropertyContainerHandle_t container = overrideTrackedDeviceToPropertyContainer(nullptr, TEST_DEVICE_INDEX);
+	overrideCreateBooleanComponent(nullptr, container, TRIGGER_PATH, &triggerHandle);
+	overrideCreateBooleanComponent(nullptr, container, BUTTON_PATH, &buttonHandle);
+	overrideCreateHapticComponent(nullptr, container, "/output/haptic", &hapticHandle);
+
+	TestPassThrough();
+	TestPluginChangesValues();
+	TestNaturalPoseWithoutClient();
+	TestOverrideAppliesOnNextHook();
+	TestBudgetOverrunDisablesPlugin();
+	TestShutdownWaitsForCallbacks();
+	TestUnloadWaitsForCallbacks();
+	TestIdleHookSkipsPublishing();
+	BenchmarkHookOverhead();
+	BenchmarkPublishingPaths();
+
+	if (!AttachLibrary()) return 2;
+	BenchmarkHapticLatency();
+	BenchmarkOverrideLatency();
+
+	std::printf("%u checks failed\n", failureCount);
+	return failureCount == 0 ? 0 : 1;
+}
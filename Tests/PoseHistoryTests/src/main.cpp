@@ -0,0 +1,255 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "DeviceTypes.h"
+#include "PoseHistoryManager.h"
+
+/**
+ * Tests and benchmarks the pose history of the lib on its own, recording poses straight into PoseHistoryManager
+ * instead of through the shared memory. The tests cover interpolation, histories that wrapped around their ring and
+ * pose times that went backwards, then every device is given a full history and the queries are timed. Returns
+ * nonzero if any check failed
+ */
+
+/** @brief The steady clock time of the first recorded pose, far from 0, which the resampler treats as unset */
+static const int64_t FIRST_POSE_NANOSECONDS = 1000000000000LL;
+
+/** @brief The time between recorded poses, a 1 kHz device */
+static const int64_t POSE_PERIOD_NANOSECONDS = 1000000;
+
+/** @brief The history every device is given, 2 seconds at 1 kHz */
+static const PoseHistoryConfig HISTORY_CONFIG = { 2.0, 1000.0 };
+
+/** @brief The number of poses the ring of HISTORY_CONFIG holds, 2001 poses rounded up to a power of two */
+static const uint32_t HISTORY_CAPACITY = 2048;
+
+/** @brief The number of poses recorded into each history, enough for the ring to wrap around */
+static const uint32_t RECORDED_POSE_COUNT = HISTORY_CAPACITY + 500;
+
+/** @brief The rotation in radians around the Y axis each recorded pose adds */
+static const double ROTATION_STEP = 0.001;
+
+/** @brief The number of queries each configuration of the benchmark is timed over */
+static const uint32_t BENCHMARK_ITERATIONS = 1000000;
+
+static uint32_t failureCount = 0;
+
+static void check(bool condition, const char* description) {
+	if (!condition) failureCount++;
+	std::printf("  [%s] %s\n", condition ? "PASS" : "FAIL", description);
+}
+
+/*
+ * Recorded poses
+ */
+
+/** @brief The time of the recorded pose <poseNumber> */
+static int64_t PoseTime(double poseNumber) {
+	return FIRST_POSE_NANOSECONDS + static_cast<int64_t>(std::llround(poseNumber * POSE_PERIOD_NANOSECONDS));
+}
+
+/** @brief A pose at X = <x>, rotated <x> * ROTATION_STEP around the Y axis, so every pose differs from the last */
+static DevicePose MakePose(double x) {
+	DevicePose pose;
+	pose.poseIsValid = true;
+	pose.vecPosition[0] = x;
+	pose.qRotation.w = std::cos(x * ROTATION_STEP / 2.0);
+	pose.qRotation.y = std::sin(x * ROTATION_STEP / 2.0);
+	return pose;
+}
+
+/** @brief Records RECORDED_POSE_COUNT poses into the history of a device, pose n at PoseTime(n) and X = n */
+static void RecordPoses(uint32_t deviceIndex) {
+	PoseHistoryManager& manager = PoseHistoryManager::getInstance();
+	for (uint32_t i = 0; i < RECORDED_POSE_COUNT; i++) manager.recordPose(deviceIndex, PoseTime(i), MakePose(i));
+}
+
+/** @brief Whether <sample> is the pose MakePose(<x>) would have been at PoseTime(<x>) */
+static bool SampleMatches(const PoseHistorySample& sample, double x) {
+	DevicePose expected = MakePose(x);
+	return sample.timestampNanoseconds == PoseTime(x) &&
+		std::abs(sample.vecPosition[0] - x) < 1e-9 &&
+		std::abs(sample.qRotation.w - expected.qRotation.w) < 1e-9 &&
+		std::abs(sample.qRotation.y - expected.qRotation.y) < 1e-9;
+}
+
+/*
+ * Tests
+ */
+
+static void TestWrappedHistory() {
+	std::printf("getPoseAt on a history that wrapped around its ring\n");
+
+	PoseHistoryManager& manager = PoseHistoryManager::getInstance();
+	check(manager.enable(0, HISTORY_CONFIG), "the history is enabled");
+	RecordPoses(0);
+
+	// Pose n is in ring slot n % HISTORY_CAPACITY, so the oldest pose kept is the first one not overwritten
+	uint32_t oldest = RECORDED_POSE_COUNT - HISTORY_CAPACITY;
+	uint32_t newest = RECORDED_POSE_COUNT - 1;
+	PoseHistorySample sample;
+
+	check(!manager.getPoseAt(0, PoseTime(oldest) - 1, sample), "times before the oldest pose kept are refused");
+	check(manager.getPoseAt(0, PoseTime(oldest), sample) && SampleMatches(sample, oldest), "the oldest pose is kept");
+
+	bool matched = manager.getPoseAt(0, PoseTime(HISTORY_CAPACITY - 0.5), sample);
+	check(matched && SampleMatches(sample, HISTORY_CAPACITY - 0.5), "poses are interpolated across the ring end");
+
+	matched = manager.getPoseAt(0, PoseTime(1000.25), sample);
+	check(matched && SampleMatches(sample, 1000.25), "positions and rotations are interpolated between poses");
+
+	matched = manager.getPoseAt(0, PoseTime(newest + 10), sample);
+	check(
+		matched && sample.vecPosition[0] == newest && sample.timestampNanoseconds == PoseTime(newest + 10),
+		"times after the newest pose hold it"
+	);
+}
+
+static void TestClampedTimestamps() {
+	std::printf("Pose times that go backwards are clamped to the newest pose\n");
+
+	PoseHistoryManager& manager = PoseHistoryManager::getInstance();
+	manager.enable(1, HISTORY_CONFIG);
+
+	// The third pose jitters back to before the second, so it is recorded at the time of the second instead
+	manager.recordPose(1, PoseTime(0), MakePose(0));
+	manager.recordPose(1, PoseTime(10), MakePose(10));
+	manager.recordPose(1, PoseTime(5), MakePose(20));
+	manager.recordPose(1, PoseTime(20), MakePose(30));
+
+	PoseHistorySample sample;
+	manager.getPoseAt(1, PoseTime(5), sample);
+	check(std::abs(sample.vecPosition[0] - 5.0) < 1e-9, "poses before the clamped one are left alone");
+
+	manager.getPoseAt(1, PoseTime(10), sample);
+	check(sample.vecPosition[0] == 20.0, "the clamped pose takes the time of the newest pose and wins at it");
+
+	manager.getPoseAt(1, PoseTime(15), sample);
+	check(std::abs(sample.vecPosition[0] - 25.0) < 1e-9, "later times interpolate from the clamped pose");
+
+	// Pose history times are only ever clamped forwards, so the oldest pose still bounds the queries
+	check(!manager.getPoseAt(1, PoseTime(0) - 1, sample), "times before the oldest pose are still refused");
+
+	manager.disable(1);
+}
+
+static void TestResampling() {
+	std::printf("resample emits every period up to the newest pose\n");
+
+	PoseHistoryManager& manager = PoseHistoryManager::getInstance();
+	uint32_t oldest = RECORDED_POSE_COUNT - HISTORY_CAPACITY;
+	uint32_t newest = RECORDED_POSE_COUNT - 1;
+
+	// Halfway between poses, so every sample is interpolated
+	PoseResamplerState state;
+	state.sampleRate = 1000.0;
+	state.nextTimestampNanoseconds = PoseTime(oldest + 0.5);
+
+	std::vector<PoseHistorySample> samples;
+	uint32_t emitted = manager.resample(0, state, samples);
+	check(emitted == newest - oldest && samples.size() == emitted, "one sample is emitted per period");
+
+	bool allMatched = true;
+	for (uint32_t i = 0; i < samples.size(); i++) {
+		allMatched = allMatched && SampleMatches(samples[i], oldest + i + 0.5);
+	}
+	check(allMatched, "every sample is interpolated at its own time");
+
+	check(manager.resample(0, state, samples) == 0, "nothing is emitted again until a newer pose is recorded");
+
+	manager.recordPose(0, PoseTime(newest + 1), MakePose(newest + 1));
+	samples.clear();
+	emitted = manager.resample(0, state, samples);
+	check(emitted == 1 && SampleMatches(samples[0], newest + 0.5), "a newer pose lets the next sample through");
+
+	// The caller fell behind by more than the history holds, so whole periods are skipped up to the oldest pose,
+	// which is one later now that the newer pose pushed the previous oldest out of the ring
+	PoseResamplerState behindState;
+	behindState.sampleRate = 1000.0;
+	behindState.nextTimestampNanoseconds = PoseTime(0);
+	samples.clear();
+	manager.resample(0, behindState, samples);
+	check(!samples.empty() && SampleMatches(samples[0], oldest + 1), "a caller that fell behind stays on its grid");
+}
+
+/*
+ * Benchmark
+ */
+
+/**
+ * @brief Times <call> over BENCHMARK_ITERATIONS calls, passing the iteration to each call
+ * @return The average time per call in nanoseconds
+ */
+template <typename Call>
+static double TimePerCall(Call call) {
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) call(i);
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+	return elapsed.count() / BENCHMARK_ITERATIONS;
+}
+
+static void BenchmarkQueries() {
+	std::printf(
+		"Pose history queries with %u devices of %.0f s at %.0f Hz\n",
+		MAX_REGISTRY_DEVICES,
+		HISTORY_CONFIG.durationSeconds,
+		HISTORY_CONFIG.maxUpdateRate
+	);
+
+	PoseHistoryManager& manager = PoseHistoryManager::getInstance();
+	for (uint32_t device = 0; device < MAX_REGISTRY_DEVICES; device++) {
+		manager.enable(device, HISTORY_CONFIG);
+		RecordPoses(device);
+	}
+
+	uint32_t oldest = RECORDED_POSE_COUNT - HISTORY_CAPACITY;
+	uint32_t newest = RECORDED_POSE_COUNT - 1;
+
+	// Spread over the whole history and every device, so the queries don't all hit the same cache lines
+	volatile double sink = 0.0;
+	bool allFound = true;
+	double getPoseAt = TimePerCall([&](uint32_t i) {
+		PoseHistorySample sample;
+		double poseNumber = oldest + (i * 7919ULL % (newest - oldest)) + 0.37;
+		allFound = manager.getPoseAt(i % MAX_REGISTRY_DEVICES, PoseTime(poseNumber), sample) && allFound;
+		sink = sample.vecPosition[0];
+	});
+	check(allFound, "every query is inside a history");
+
+	// The whole history of one device at a time, reusing the output so only the resampling is timed
+	std::vector<PoseHistorySample> samples;
+	samples.reserve(HISTORY_CAPACITY);
+	uint64_t sampleCount = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS / HISTORY_CAPACITY; i++) {
+		PoseResamplerState state;
+		state.sampleRate = HISTORY_CONFIG.maxUpdateRate;
+		state.nextTimestampNanoseconds = PoseTime(oldest + 0.5);
+
+		samples.clear();
+		sampleCount += manager.resample(i % MAX_REGISTRY_DEVICES, state, samples);
+		sink = samples.back().vecPosition[0];
+	}
+	double resampleTotal = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("  getPoseAt: %.1f ns per query\n", getPoseAt);
+	std::printf(
+		"  resample of a full history at %.0f Hz: %.1f ns per sample\n",
+		HISTORY_CONFIG.maxUpdateRate,
+		resampleTotal / sampleCount
+	);
+
+	for (uint32_t device = 0; device < MAX_REGISTRY_DEVICES; device++) manager.disable(device);
+}
+
+int main() {
+	TestWrappedHistory();
+	TestClampedTimestamps();
+	TestResampling();
+	BenchmarkQueries();
+
+	std::printf("%u checks failed\n", failureCount);
+	return failureCount == 0 ? 0 : 1;
+}